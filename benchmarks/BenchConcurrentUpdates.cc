@@ -0,0 +1,176 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+/*
+ * Measures the throughput (updates/second) of meter updates issued concurrently by an increasing number of
+ * threads, sharing the same client, using both UDP and HTTP transports.
+ *
+ * Each measurement is performed in two modes:
+ *  - serialised, where all updates are performed under a single lock (i.e. as previously done by ConfiguredClient)
+ *  - concurrent, where the updates rely only on the thread-safety of the client
+ *
+ * Usage: ecflow_light_concurrent_updates_benchmark [updates_per_thread [server_delay_us]]
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LocalHTTPServer.h"
+#include "ecflow/light/ClientAPI.h"
+#include "ecflow/light/TinyREST.h"
+
+using namespace ecflow::light;
+
+namespace {
+
+/**
+ * UDPSink receives (and discards) all datagrams sent to an ephemeral port on the loopback interface
+ */
+class UDPSink {
+public:
+    UDPSink() : socket_{::socket(AF_INET, SOCK_DGRAM, 0)}, port_{0}, stopping_{false}, received_{0}, sink_{} {
+        sockaddr_in address{};
+        address.sin_family      = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port        = 0;
+        ::bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+
+        socklen_t length = sizeof(address);
+        ::getsockname(socket_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+
+        sink_ = std::thread([this]() {
+            char buffer[2048];
+            pollfd fd{socket_, POLLIN, 0};
+            while (!stopping_) {
+                if (::poll(&fd, 1, 50) > 0 && ::recv(socket_, buffer, sizeof(buffer), 0) > 0) {
+                    ++received_;
+                }
+            }
+        });
+    }
+    ~UDPSink() {
+        stopping_ = true;
+        sink_.join();
+        ::close(socket_);
+    }
+
+    [[nodiscard]] std::string port() const { return std::to_string(port_); }
+
+private:
+    int socket_;
+    uint16_t port_;
+    std::atomic<bool> stopping_;
+    std::atomic<size_t> received_;
+    std::thread sink_;
+};
+
+/**
+ * Run 'update' from each of the threads, and return the overall number of updates per second
+ */
+double measure(size_t threads, size_t updates, bool serialised, const std::function<void()>& update) {
+    std::mutex lock;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t != threads; ++t) {
+        workers.emplace_back([&]() {
+            for (size_t i = 0; i != updates; ++i) {
+                if (serialised) {
+                    std::scoped_lock guard(lock);
+                    update();
+                }
+                else {
+                    update();
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    return static_cast<double>(threads * updates) / elapsed.count();
+}
+
+Request make_update() {
+    auto environment = Environment::an_environment()
+                           .with("ECF_NAME", "/path/to/task")
+                           .with("ECF_PASS", "qwerty")
+                           .with("ECF_TRYNO", "1")
+                           .with("ECF_RID", "12345");
+    auto options = Options::options().with("command", "meter").with("name", "progress").with("value", "42");
+    return Request::make_request<UpdateNodeAttribute>(environment, options);
+}
+
+void report(const std::string& transport, size_t threads, double serialised, double concurrent) {
+    std::cout << std::setw(10) << transport << std::setw(10) << threads << std::setw(16) << std::fixed
+              << std::setprecision(1) << serialised << std::setw(16) << concurrent << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t updates = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    auto delay     = std::chrono::microseconds(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000);
+
+    std::cout << "Updates per thread: " << updates << ", server delay: " << delay.count() << "us" << std::endl;
+    std::cout << std::setw(10) << "transport" << std::setw(10) << "threads" << std::setw(16) << "serialised/s"
+              << std::setw(16) << "concurrent/s" << std::endl;
+
+    const std::vector<size_t> thread_counts = {1, 2, 4, 8, 16};
+
+    {
+        UDPSink sink;
+        auto cfg = ClientCfg::make_cfg(ClientCfg::KindLibrary, ClientCfg::ProtocolUDP, "127.0.0.1", sink.port(), "1.0");
+        LibraryUDPClientAPI client(cfg, Environment::an_environment());
+        auto request = make_update();
+        auto update  = [&]() { std::ignore = client.process(request); };
+
+        for (auto threads : thread_counts) {
+            report("udp", threads, measure(threads, updates, true, update), measure(threads, updates, false, update));
+        }
+    }
+
+    {
+        testing::LocalHTTPServer server(delay);
+        auto host = net::Host::with_scheme(net::Host::SchemeHTTP, "127.0.0.1", server.port());
+        net::TinyRESTClient client(net::TinyRESTClient::DefaultIdleTimeout);
+
+        net::Request<net::Method::PUT> request{net::Target{"/v1/suites/path/to/task/attributes"}};
+        request.add_header_field(net::Field{"Content-Type", "application/json"});
+        request.add_body(net::Body{R"({"type":"meter","name":"progress","value":"42"})"});
+        auto update = [&]() { std::ignore = client.submit(host, request).get(); };
+
+        // Notice: each update is a full round trip, and thus fewer updates are performed
+        size_t http_updates = std::max(updates / 10, size_t{1});
+        for (auto threads : thread_counts) {
+            report("http", threads, measure(threads, http_updates, true, update),
+                   measure(threads, http_updates, false, update));
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,78 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+/*
+ * Measures the throughput (requests/second) of TinyRESTClient against a local HTTP stand-in, for an increasing
+ * number of concurrent requests.
+ *
+ * Usage: ecflow_light_http_client_benchmark [requests [server_delay_us]]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "LocalHTTPServer.h"
+#include "ecflow/light/TinyREST.h"
+
+using namespace ecflow::light;
+
+namespace {
+
+double measure(size_t in_flight, size_t requests, std::chrono::microseconds delay) {
+    testing::LocalHTTPServer server(delay);
+    auto host = net::Host::with_scheme(net::Host::SchemeHTTP, "127.0.0.1", server.port());
+
+    net::TinyRESTClient client(net::TinyRESTClient::DefaultIdleTimeout, in_flight);
+
+    net::Request<net::Method::PUT> request{net::Target{"/v1/suites/path/to/task/attributes"}};
+    request.add_header_field(net::Field{"Content-Type", "application/json"});
+    request.add_body(net::Body{R"({"type":"meter","name":"progress","value":"42"})"});
+
+    std::vector<std::future<net::Response>> responses;
+    responses.reserve(requests);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i != requests; ++i) {
+        responses.push_back(client.submit(host, request));
+    }
+    size_t failed = 0;
+    for (auto& response : responses) {
+        if (response.get().header().status() != net::Status::Code::OK) {
+            ++failed;
+        }
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    if (failed > 0) {
+        std::cerr << "Warning: " << failed << " request(s) failed" << std::endl;
+    }
+    return static_cast<double>(requests) / elapsed.count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t requests = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    auto delay      = std::chrono::microseconds(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000);
+
+    std::cout << "Requests: " << requests << ", server delay: " << delay.count() << "us" << std::endl;
+    std::cout << std::setw(10) << "in-flight" << std::setw(16) << "requests/s" << std::endl;
+    for (size_t in_flight : {1, 8, 64}) {
+        std::cout << std::setw(10) << in_flight << std::setw(16) << std::fixed << std::setprecision(1)
+                  << measure(in_flight, requests, delay) << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+/*
+ * Measures the throughput (requests/second) of formatting UDP requests, comparing the JSONWriter based formatting
+ * against the previous std::ostringstream based formatting (reproduced here as baseline).
+ *
+ * Usage: ecflow_light_json_writer_benchmark [requests]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "ecflow/light/Dispatcher.h"
+
+using namespace ecflow::light;
+
+namespace {
+
+std::string baseline_envelope(const ClientCfg& cfg, const TaskContext& context) {
+    std::ostringstream oss;
+    oss << R"({"method":"put","version":")" << cfg.version << R"(","header":{"task_rid":")" << context.rid()
+        << R"(","task_password":")" << context.password() << R"(","task_try_no":)" << context.try_no()
+        << R"(},"payload":)";
+    return oss.str();
+}
+
+std::string baseline_payload(const TaskContext& context, const Options& options) {
+    std::ostringstream oss;
+    oss << R"({"command":")" << options.get(Field::Command) << R"(","path":")" << context.name() << R"(","name":")"
+        << options.get(Field::Name) << R"(","value":")" << options.get(Field::Value) << R"("})";
+    return oss.str();
+}
+
+std::string baseline_request(const ClientCfg& cfg, const UpdateNodeAttribute& request) {
+    std::ostringstream oss;
+    oss << baseline_envelope(cfg, request.context()) << baseline_payload(request.context(), request.options()) << "}";
+    return oss.str();
+}
+
+std::string baseline_request(const ClientCfg& cfg, const UpdateNodeAttributes& request) {
+    std::string datagram = baseline_envelope(cfg, request.context()) + "[";
+    for (const auto& attribute : request.attributes()) {
+        if (datagram.back() != '[') {
+            datagram += ",";
+        }
+        datagram += baseline_payload(request.context(), attribute);
+    }
+    return datagram + "]}";
+}
+
+template <typename F>
+double measure(size_t requests, F&& format) {
+    size_t total = 0;
+    auto start   = std::chrono::steady_clock::now();
+    for (size_t i = 0; i != requests; ++i) {
+        total += format();
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    // Use the total size, to prevent the formatting being optimised away
+    if (total == 0) {
+        std::cerr << "Warning: nothing formatted" << std::endl;
+    }
+    return static_cast<double>(requests) / elapsed.count();
+}
+
+void report(const std::string& name, double baseline, double writer) {
+    std::cout << std::setw(10) << name << std::setw(16) << std::fixed << std::setprecision(1) << baseline
+              << std::setw(16) << writer << std::setw(10) << std::setprecision(2) << writer / baseline << "x"
+              << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t requests = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    auto environment = Environment::an_environment()
+                           .with("ECF_NAME", "/suite/family/task")
+                           .with("ECF_PASS", "qwerty")
+                           .with("ECF_TRYNO", "1")
+                           .with("ECF_RID", "12345");
+
+    ClientCfg cfg = ClientCfg::make_cfg(ClientCfg::KindLibrary, ClientCfg::ProtocolUDP, "localhost", "0", "1.0");
+    UDPDispatcher dispatcher(cfg);
+
+    UpdateNodeAttribute single(environment,
+                               Options::options().with("command", "meter").with("name", "progress").with("value", "42"));
+
+    UpdateNodeAttributes::attributes_t attributes;
+    for (int i = 0; i != 10; ++i) {
+        attributes.push_back(
+            Options::options().with("command", "meter").with("name", "progress").with("value", std::to_string(i)));
+    }
+    UpdateNodeAttributes batch(environment, attributes);
+
+    std::cout << "Requests: " << requests << std::endl;
+    std::cout << std::setw(10) << "request" << std::setw(16) << "baseline/s" << std::setw(16) << "writer/s"
+              << std::setw(11) << "speedup" << std::endl;
+
+    report("single",
+           measure(requests, [&] { return baseline_request(cfg, single).size(); }),
+           measure(requests, [&] { return dispatcher.format_request(single).size(); }));
+    report("batch",
+           measure(requests / 10, [&] { return baseline_request(cfg, batch).size(); }),
+           measure(requests / 10, [&] { return dispatcher.format_request(batch).front().size(); }));
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+/*
+ * Measures the throughput (MB/second) of following a synthetic log file, written to the given directory, comparing
+ * the LogFollower (i.e. literal prefiltering, with a single pass over each line) against evaluating each rule's
+ * regular expression on every line (reproduced here as baseline).
+ *
+ * As the baseline is considerably slower, it only processes a sample of the log (the first 64 MB, at most).
+ *
+ * Usage: ecflow_light_log_follower_benchmark [megabytes [directory]]
+ */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ecflow/light/LogFollower.h"
+
+using namespace ecflow::light;
+
+namespace {
+
+/**
+ * CountingClientAPI counts (and otherwise discards) all requests
+ */
+class CountingClientAPI : public ClientAPI {
+public:
+    [[nodiscard]] Response process(const Request& /* request */) const override {
+        ++requests;
+        return Response{"OK"};
+    }
+
+    mutable std::atomic<size_t> requests{0};
+};
+
+std::vector<FollowRule> make_rules() {
+    return {
+        FollowRule::make_rule(R"(Step (\d+) of \d+)", "meter", "step"),
+        FollowRule::make_rule(R"(Writing (\S+)\.grib)", "label", "output"),
+        FollowRule::make_rule(R"(Reading (\S+)\.nc)", "label", "input"),
+        FollowRule::make_rule(R"(Iteration (\d+) converged)", "meter", "iteration"),
+        FollowRule::make_rule(R"(^ERROR: )", "event", "failed"),
+        FollowRule::make_rule(R"(^WARNING: .*memory)", "event", "low_memory"),
+        FollowRule::make_rule(R"(Checkpoint \d+ saved)", "event", "checkpoint"),
+        FollowRule::make_rule(R"(Phase: (\w+))", "label", "phase"),
+    };
+}
+
+/**
+ * @return a block of synthetic log lines, where 3 in every 50 lines match a rule
+ */
+std::string make_block() {
+    std::string block;
+    for (size_t i = 0; block.size() < 1024 * 1024; ++i) {
+        block += "2023-10-16 12:34:56.789 [rank " + std::to_string(i % 128) + "] ";
+        switch (i % 50) {
+            case 0:
+                block += "Step " + std::to_string(i % 240) + " of 240 completed\n";
+                break;
+            case 10:
+                block += "Writing fc_" + std::to_string(i) + ".grib (42 fields)\n";
+                break;
+            case 20:
+                block += "Phase: integration\n";
+                break;
+            default:
+                block += "Computing spectral transforms for field " + std::to_string(i) + " on level 137\n";
+                break;
+        }
+    }
+    return block;
+}
+
+void report(const std::string& name, double megabytes, double seconds, size_t matches) {
+    std::cout << std::setw(10) << name << std::setw(12) << std::fixed << std::setprecision(1) << megabytes
+              << std::setw(14) << megabytes / seconds << std::setw(14) << matches << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t megabytes      = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2048;
+    std::string directory = argc > 2 ? argv[2] : "/tmp";
+    std::string path      = directory + "/ecflow_light_log_follower_benchmark." + std::to_string(::getpid());
+
+    auto context = TaskContext::make(Environment::an_environment().with("ECF_NAME", "/suite/family/task"));
+    auto rules   = make_rules();
+    auto block   = make_block();
+
+    {
+        std::ofstream log(path, std::ios::binary);
+        for (size_t i = 0; i != megabytes; ++i) {
+            log.write(block.data(), static_cast<std::streamsize>(block.size()));
+        }
+        if (!log) {
+            std::cerr << "Unable to write synthetic log '" << path << "'" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    double size = static_cast<double>(megabytes * block.size()) / (1024 * 1024);
+
+    std::cout << "Log: " << path << " (" << megabytes << " MB), rules: " << rules.size() << std::endl;
+    std::cout << std::setw(10) << "method" << std::setw(12) << "MB" << std::setw(14) << "MB/s" << std::setw(14)
+              << "matches" << std::endl;
+
+    // Baseline, evaluating all regular expressions on each line of a sample
+    {
+        std::vector<std::regex> patterns;
+        for (const auto& rule : rules) {
+            patterns.emplace_back(rule.pattern, std::regex::ECMAScript | std::regex::optimize);
+        }
+
+        size_t sample  = std::min<size_t>(megabytes, 64);
+        size_t matches = 0;
+        auto start     = std::chrono::steady_clock::now();
+        for (size_t i = 0; i != sample; ++i) {
+            std::string_view data = block;
+            while (!data.empty()) {
+                auto eol              = data.find('\n');
+                std::string_view line = data.substr(0, eol);
+                for (const auto& pattern : patterns) {
+                    std::match_results<std::string_view::const_iterator> match;
+                    matches += std::regex_search(std::begin(line), std::end(line), match, pattern) ? 1 : 0;
+                }
+                data.remove_prefix(eol + 1);
+            }
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+        report("baseline", static_cast<double>(sample * block.size()) / (1024 * 1024), elapsed.count(), matches);
+    }
+
+    // LogFollower, reading the whole file (notice: once stopped, following reads the file and returns)
+    {
+        CountingClientAPI client;
+        LogFollower follower{path, rules, client, context};
+        follower.stop();
+
+        auto start = std::chrono::steady_clock::now();
+        follower.follow();
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+        report("follower", size, elapsed.count(), follower.matches());
+        std::cout << "Lines: " << follower.lines() << ", requests: " << client.requests << std::endl;
+    }
+
+    std::remove(path.c_str());
+    return EXIT_SUCCESS;
+}
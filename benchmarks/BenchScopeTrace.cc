@@ -0,0 +1,101 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+/*
+ * Measures the cost (nanoseconds/call) of tracing a function, as done by each C API entry point, when debug logging
+ * is disabled. Compares an untraced function, the ScopeTrace based tracing, and the previous tracing (reproduced
+ * here as baseline) which formats both messages regardless of the debug logging being enabled.
+ *
+ * Usage: ecflow_light_scope_trace_benchmark [calls]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "ecflow/light/Log.h"
+
+using namespace ecflow::light;
+
+namespace {
+
+class BaselineScopeTrace {
+public:
+    template <typename... ARGS>
+    BaselineScopeTrace(std::string location, std::string scope, ARGS... args) :
+        location_{std::move(location)}, scope_{std::move(scope)} {
+        std::ostringstream oss;
+        oss << "Entering " << scope_ << "(";
+        ((oss << "<" << args << ">"), ...);
+        oss << ") at " << location_;
+        Log::debug() << oss.str();
+    }
+    ~BaselineScopeTrace() {
+        std::ostringstream oss;
+        oss << "Exiting " << scope_ << " at " << location_;
+        Log::debug() << oss.str();
+    }
+
+private:
+    std::string location_;
+    std::string scope_;
+};
+
+volatile int sink = 0;
+
+[[gnu::noinline]] void untraced(const char* name, int value) {
+    sink = sink + value + static_cast<int>(name[0]);
+}
+
+[[gnu::noinline]] void traced(const char* name, int value) {
+    ECFLOW_LIGHT_TRACE_FUNCTION(name, value);
+    sink = sink + value + static_cast<int>(name[0]);
+}
+
+[[gnu::noinline]] void baseline_traced(const char* name, int value) {
+    BaselineScopeTrace tracer(std::string(__FILE__) + ":" + std::to_string(__LINE__), __func__, name, value);
+    sink = sink + value + static_cast<int>(name[0]);
+}
+
+template <typename F>
+double measure(size_t calls, F&& call) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i != calls; ++i) {
+        call("progress", static_cast<int>(i));
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+    return elapsed.count() / static_cast<double>(calls);
+}
+
+void report(const std::string& name, double ns) {
+    std::cout << std::setw(10) << name << std::setw(16) << std::fixed << std::setprecision(2) << ns << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t calls = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+
+    if (debug_enabled()) {
+        std::cerr << "Warning: debug logging is enabled, and thus the measurements include logging" << std::endl;
+    }
+
+    std::cout << "Calls: " << calls << std::endl;
+    std::cout << std::setw(10) << "trace" << std::setw(16) << "ns/call" << std::endl;
+
+    report("none", measure(calls, untraced));
+    report("scope", measure(calls, traced));
+    report("baseline", measure(calls, baseline_traced));
+
+    return EXIT_SUCCESS;
+}
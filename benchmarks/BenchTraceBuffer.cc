@@ -0,0 +1,78 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+/*
+ * Measures the cost (nanoseconds/request) of tracing a request, comparing the binary trace record with the per-packet
+ * log line (reproduced here as baseline) written synchronously, and flushed, to /dev/null.
+ *
+ * Usage: ecflow_light_trace_buffer_benchmark [requests]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "ecflow/light/TraceBuffer.h"
+
+using namespace ecflow::light;
+
+namespace {
+
+template <typename F>
+double measure(size_t requests, F&& call) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i != requests; ++i) {
+        call(i);
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+    return elapsed.count() / static_cast<double>(requests);
+}
+
+void report(const std::string& name, double ns) {
+    std::cout << std::setw(10) << name << std::setw(16) << std::fixed << std::setprecision(2) << ns << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t requests = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    auto environment = Environment::an_environment()
+                           .with("ECF_RID", "12345")
+                           .with("ECF_NAME", "/path/to/task")
+                           .with("ECF_PASS", "custom_password")
+                           .with("ECF_TRYNO", "1");
+    auto request = Request::make_request<UpdateNodeAttribute>(
+        environment, Options::options().with("command", "meter").with("name", "progress").with("value", "42"));
+    std::string packet =
+        R"({"method":"put","version":"1.0","header":{"task_rid":"12345","task_password":"custom_password",)"
+        R"("task_try_no":1},"payload":{"command":"meter","path":"/path/to/task","name":"progress","value":"42"}})";
+
+    TraceBuffer buffer{16 * 1024};
+    std::ofstream sink("/dev/null");
+
+    std::cout << "Requests: " << requests << std::endl;
+    std::cout << std::setw(10) << "trace" << std::setw(16) << "ns/request" << std::endl;
+
+    report("record", measure(requests, [&](size_t i) {
+               auto record       = TraceRecord::make_record(request);
+               record.bytes      = static_cast<uint32_t>(packet.size());
+               record.latency_us = static_cast<uint32_t>(i);
+               buffer.record(record);
+           }));
+    report("baseline", measure(requests, [&](size_t) {
+               sink << "Dispatching UDP Request: " << packet << ", to 127.0.0.1:8080" << std::endl;
+           }));
+
+    return EXIT_SUCCESS;
+}
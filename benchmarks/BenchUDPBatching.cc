@@ -0,0 +1,164 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+/*
+ * Measures the throughput (datagrams/second) and the number of system calls of UDPSocket, sending bursts of
+ * datagrams with each batching mechanism (sendto, sendmmsg, and sendmmsg with GSO) to a local recvmmsg sink.
+ *
+ * Usage: ecflow_light_udp_batching_benchmark [datagrams [burst]]
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ecflow/light/UDPSocket.h"
+
+using namespace ecflow::light;
+
+namespace {
+
+/**
+ * Sink is a UDP socket, bound to an ephemeral port on the loopback interface, that receives (and discards)
+ * datagrams using recvmmsg
+ */
+class Sink {
+public:
+    Sink() : socket_{::socket(AF_INET, SOCK_DGRAM, 0)}, port_{0}, received_{0}, stopping_{false}, receiver_{} {
+        int size = 64 * 1024 * 1024;
+        ::setsockopt(socket_, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+        sockaddr_in address{};
+        address.sin_family      = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port        = 0;
+        ::bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+
+        socklen_t length = sizeof(address);
+        ::getsockname(socket_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+
+        receiver_ = std::thread([this]() { run(); });
+    }
+
+    ~Sink() {
+        stopping_ = true;
+        receiver_.join();
+        ::close(socket_);
+    }
+
+    [[nodiscard]] std::string port() const { return std::to_string(port_); }
+    [[nodiscard]] uint64_t received() const { return received_.load(); }
+
+    /**
+     * Wait until the given number of datagrams is received, or no more datagrams arrive
+     */
+    void wait_for(uint64_t count) const {
+        uint64_t last = received();
+        while (last < count) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            uint64_t current = received();
+            if (current == last) {
+                break;
+            }
+            last = current;
+        }
+    }
+
+private:
+    void run() {
+        constexpr size_t batch = 256;
+        std::vector<std::array<char, 2048>> buffers(batch);
+        std::vector<iovec> iovecs(batch);
+        std::vector<mmsghdr> messages(batch);
+        for (size_t i = 0; i != batch; ++i) {
+            iovecs[i]                      = iovec{buffers[i].data(), buffers[i].size()};
+            messages[i].msg_hdr.msg_iov    = &iovecs[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        pollfd fd{socket_, POLLIN, 0};
+        while (!stopping_) {
+            if (::poll(&fd, 1, 10) <= 0) {
+                continue;
+            }
+            int result = ::recvmmsg(socket_, messages.data(), batch, MSG_DONTWAIT, nullptr);
+            if (result > 0) {
+                received_ += static_cast<uint64_t>(result);
+            }
+        }
+    }
+
+    int socket_;
+    uint16_t port_;
+    std::atomic<uint64_t> received_;
+    std::atomic<bool> stopping_;
+    std::thread receiver_;
+};
+
+void measure(const std::string& name, net::UDPSocket::Batching batching, size_t count, size_t burst,
+             bool same_size) {
+    Sink sink;
+    net::UDPSocket socket("127.0.0.1", sink.port(), std::chrono::seconds(0), batching);
+
+    std::vector<std::string> datagrams;
+    for (size_t i = 0; i != burst; ++i) {
+        std::string datagram = "meter progress " + std::to_string(i * 7919);
+        datagram.resize(same_size ? 32 : 24 + i % 16, '.');
+        datagrams.push_back(datagram);
+    }
+    std::vector<std::string_view> views(std::begin(datagrams), std::end(datagrams));
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t sent = 0; sent < count; sent += burst) {
+        socket.send(views);
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+    sink.wait_for(socket.sent());
+
+    std::cout << std::setw(24) << name << std::setw(8) << (same_size ? "same" : "mixed") << std::setw(16)
+              << std::fixed << std::setprecision(1) << static_cast<double>(socket.sent()) / elapsed.count()
+              << std::setw(16) << std::setprecision(3)
+              << static_cast<double>(socket.syscalls()) / static_cast<double>(socket.sent() + socket.dropped())
+              << std::setw(12) << socket.dropped() << std::setw(12) << sink.received() << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    size_t burst = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64;
+
+    using Batching = net::UDPSocket::Batching;
+
+    std::cout << "Datagrams: " << count << ", burst: " << burst << std::endl;
+    std::cout << std::setw(24) << "mechanism" << std::setw(8) << "sizes" << std::setw(16) << "datagrams/s"
+              << std::setw(16) << "syscalls/dgram" << std::setw(12) << "dropped" << std::setw(12) << "received"
+              << std::endl;
+    for (bool same_size : {true, false}) {
+        measure("sendto", Batching::None, count, burst, same_size);
+        measure("sendmmsg", Batching::Messages, count, burst, same_size);
+        measure("sendmmsg+GSO", Batching::Segments, count, burst, same_size);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,76 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+/*
+ * Measures the size and the encoding throughput (requests/second) of UDP datagrams, comparing the JSON (version 1)
+ * and the binary (version 2) wire formats.
+ *
+ * Usage: ecflow_light_wire_format_benchmark [requests]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "ecflow/light/Dispatcher.h"
+
+using namespace ecflow::light;
+
+namespace {
+
+double measure(size_t requests, const UDPDispatcher& dispatcher, const UpdateNodeAttribute& request) {
+    size_t total = 0;
+    auto start   = std::chrono::steady_clock::now();
+    for (size_t i = 0; i != requests; ++i) {
+        total += dispatcher.format_request(request).size();
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    // Use the total size, to prevent the formatting being optimised away
+    if (total == 0) {
+        std::cerr << "Warning: nothing formatted" << std::endl;
+    }
+    return static_cast<double>(requests) / elapsed.count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t requests = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    // Notice: the requests concern the current task (as when using the library API), whose fragments are cached
+    ::setenv("ECF_NAME", "/suite/family/task", 1);
+    ::setenv("ECF_PASS", "qwerty", 1);
+    ::setenv("ECF_TRYNO", "1", 1);
+    ::setenv("ECF_RID", "12345", 1);
+    const auto& context = TaskContext::current();
+
+    UpdateNodeAttribute meter(context,
+                              Options::options().with("command", "meter").with("name", "progress").with("value", "42"));
+    UpdateNodeAttribute label(
+        context, Options::options().with("command", "label").with("name", "message").with("value", "running"));
+
+    std::cout << "Requests: " << requests << std::endl;
+    std::cout << std::setw(10) << "request" << std::setw(10) << "version" << std::setw(10) << "bytes"
+              << std::setw(16) << "requests/s" << std::endl;
+    for (const auto* version : {"1.0", "2.0"}) {
+        ClientCfg cfg = ClientCfg::make_cfg(ClientCfg::KindLibrary, ClientCfg::ProtocolUDP, "localhost", "0", version);
+        UDPDispatcher dispatcher(cfg);
+        for (const auto& [name, request] : {std::pair{"meter", &meter}, std::pair{"label", &label}}) {
+            std::cout << std::setw(10) << name << std::setw(10) << version << std::setw(10)
+                      << dispatcher.format_request(*request).size() << std::setw(16) << std::fixed
+                      << std::setprecision(1) << measure(requests, dispatcher, *request) << std::endl;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -11,12 +11,27 @@
 #include "ecflow/light/API.h"
 #include "ecflow/light/InternalAPI.h"
 
+#include <chrono>
 #include <memory>
 
+#include "ecflow/light/AsyncSender.h"
 #include "ecflow/light/ClientAPI.h"
+#include "ecflow/light/Deadline.h"
 #include "ecflow/light/Exception.h"
 #include "ecflow/light/Log.h"
 
+namespace {
+
+bool is_valid_budget(long budget_us) {
+    if (budget_us < 0) {
+        ecflow::light::Log::error() << "Invalid budget detected: " << budget_us << "us" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
 extern "C" {
 
 int ecflow_light_update_meter(const char* name, int value) {
@@ -53,22 +68,108 @@ int ecflow_light_update_event(const char* name, int value) {
     return ecflow::light::update_event(name, value);
 }
 
+int ecflow_light_batch_begin(void) {
+    ECFLOW_LIGHT_TRACE_FUNCTION0;
+    return ecflow::light::batch_begin();
+}
+
+int ecflow_light_batch_commit(void) {
+    ECFLOW_LIGHT_TRACE_FUNCTION0;
+    return ecflow::light::batch_commit();
+}
+
+int ecflow_light_update_meter_within(const char* name, int value, long budget_us) {
+    if (!is_valid_budget(budget_us)) {
+        return EXIT_FAILURE;
+    }
+
+    ecflow::light::Deadline::Scope deadline{std::chrono::microseconds(budget_us)};
+    return ecflow_light_update_meter(name, value);
+}
+
+int ecflow_light_update_label_within(const char* name, const char* value, long budget_us) {
+    if (!is_valid_budget(budget_us)) {
+        return EXIT_FAILURE;
+    }
+
+    ecflow::light::Deadline::Scope deadline{std::chrono::microseconds(budget_us)};
+    return ecflow_light_update_label(name, value);
+}
+
+int ecflow_light_update_event_within(const char* name, int value, long budget_us) {
+    if (!is_valid_budget(budget_us)) {
+        return EXIT_FAILURE;
+    }
+
+    ecflow::light::Deadline::Scope deadline{std::chrono::microseconds(budget_us)};
+    return ecflow_light_update_event(name, value);
+}
+
+int ecflow_light_batch_commit_within(long budget_us) {
+    if (!is_valid_budget(budget_us)) {
+        return EXIT_FAILURE;
+    }
+
+    ecflow::light::Deadline::Scope deadline{std::chrono::microseconds(budget_us)};
+    return ecflow_light_batch_commit();
+}
+
 }  // extern "C"
 
 namespace ecflow::light {
 
-int update_meter(const std::string& name, int value) {
-    try {
-        const Environment& environment = Environment::environment();
-        Options options =
-            Options::options().with("command", "meter").with("name", name).with("value", std::to_string(value));
+namespace {
 
-        Request request = Request::make_request<UpdateNodeAttribute>(environment, options /*, "meter", name, value*/);
+/**
+ * Batch holds the updates collected on the current thread, between batch_begin and batch_commit
+ */
+struct Batch {
+    size_t depth = 0;
+    UpdateNodeAttributes::attributes_t attributes;
 
-        Response response = ConfiguredClient::instance().process(request);
+    [[nodiscard]] bool active() const { return depth > 0; }
+
+    static Batch& current() {
+        thread_local Batch batch;
+        return batch;
+    }
+};
+
+void process_attribute(const Options& options) {
+    if (Batch& batch = Batch::current(); batch.active()) {
+        batch.attributes.push_back(options);
+        return;
+    }
+
+    Request request = Request::make_request<UpdateNodeAttribute>(TaskContext::current(), options);
+
+    Response response = ConfiguredClient::instance().process(request);
 
+    if (debug_enabled()) {
         Log::debug() << "Response: " << response << std::endl;
     }
+}
+
+}  // namespace
+
+int update_meter(std::string_view name, int value) {
+    try {
+        if (AsyncSender* sender = AsyncSender::instance(); sender && !Batch::current().active()) {
+            // Records that do not fit the (compact) asynchronous record are sent synchronously
+            if (auto record = UpdateRecord::make_meter(name, value); record && sender->submit(record.value())) {
+                return EXIT_SUCCESS;
+            }
+        }
+
+        Options options =
+            Options::options().with(Field::Command, "meter").with(Field::Name, name).with(Field::Value, value);
+
+        process_attribute(options);
+    }
+    catch (DeadlineExceeded& e) {
+        Log::error() << "Deadline exceeded: " << e.what() << std::endl;
+        return ECFLOW_LIGHT_DEADLINE_EXCEEDED;
+    }
     catch (eckit::Exception& e) {
         Log::error() << "Error detected: " << e.what() << std::endl;
         return EXIT_FAILURE;
@@ -80,16 +181,22 @@ int update_meter(const std::string& name, int value) {
     return EXIT_SUCCESS;
 }
 
-int update_label(const std::string& name, const std::string& value) {
+int update_label(std::string_view name, std::string_view value) {
     try {
-        const Environment& environment = Environment::environment();
-        Options options = Options::options().with("command", "label").with("name", name).with("value", value);
-
-        Request request = Request::make_request<UpdateNodeAttribute>(environment, options /*, "label", name, value*/);
+        if (AsyncSender* sender = AsyncSender::instance(); sender && !Batch::current().active()) {
+            if (auto record = UpdateRecord::make_label(name, value); record && sender->submit(record.value())) {
+                return EXIT_SUCCESS;
+            }
+        }
 
-        Response response = ConfiguredClient::instance().process(request);
+        Options options =
+            Options::options().with(Field::Command, "label").with(Field::Name, name).with(Field::Value, value);
 
-        Log::debug() << "Response: " << response << std::endl;
+        process_attribute(options);
+    }
+    catch (DeadlineExceeded& e) {
+        Log::error() << "Deadline exceeded: " << e.what() << std::endl;
+        return ECFLOW_LIGHT_DEADLINE_EXCEEDED;
     }
     catch (eckit::Exception& e) {
         Log::error() << "Error detected: " << e.what() << std::endl;
@@ -102,17 +209,71 @@ int update_label(const std::string& name, const std::string& value) {
     return EXIT_SUCCESS;
 }
 
-int update_event(const std::string& name, bool value) {
+int update_event(std::string_view name, bool value) {
     try {
-        const Environment& environment = Environment::environment();
-        Options options =
-            Options::options().with("command", "event").with("name", name).with("value", value ? "1" : "0");
+        if (AsyncSender* sender = AsyncSender::instance(); sender && !Batch::current().active()) {
+            if (auto record = UpdateRecord::make_event(name, value); record && sender->submit(record.value())) {
+                return EXIT_SUCCESS;
+            }
+        }
+
+        Options options = Options::options()
+                              .with(Field::Command, "event")
+                              .with(Field::Name, name)
+                              .with(Field::Value, value ? "1" : "0");
+
+        process_attribute(options);
+    }
+    catch (DeadlineExceeded& e) {
+        Log::error() << "Deadline exceeded: " << e.what() << std::endl;
+        return ECFLOW_LIGHT_DEADLINE_EXCEEDED;
+    }
+    catch (eckit::Exception& e) {
+        Log::error() << "Error detected: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch (...) {
+        Log::error() << "Unknown error detected" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int batch_begin() {
+    ++Batch::current().depth;
+    return EXIT_SUCCESS;
+}
 
-        Request request = Request::make_request<UpdateNodeAttribute>(environment, options /*, "event", name, value*/);
+int batch_commit() {
+    Batch& batch = Batch::current();
+    if (!batch.active()) {
+        Log::error() << "Unable to commit batch, as no batch has been started" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (--batch.depth > 0) {
+        // Only the outermost commit sends the collected updates
+        return EXIT_SUCCESS;
+    }
+
+    UpdateNodeAttributes::attributes_t attributes;
+    attributes.swap(batch.attributes);
+    if (attributes.empty()) {
+        return EXIT_SUCCESS;
+    }
+
+    try {
+        Request request = Request::make_request<UpdateNodeAttributes>(TaskContext::current(), std::move(attributes));
 
         Response response = ConfiguredClient::instance().process(request);
 
-        Log::debug() << "Response: " << response << std::endl;
+        if (debug_enabled()) {
+            Log::debug() << "Response: " << response << std::endl;
+        }
+    }
+    catch (DeadlineExceeded& e) {
+        Log::error() << "Deadline exceeded: " << e.what() << std::endl;
+        return ECFLOW_LIGHT_DEADLINE_EXCEEDED;
     }
     catch (eckit::Exception& e) {
         Log::error() << "Error detected: " << e.what() << std::endl;
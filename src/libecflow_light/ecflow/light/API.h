@@ -15,33 +15,109 @@
 extern "C" {
 #endif
 
+/**
+ * Returned when a call could not be completed within the allowed time (i.e. the budget given to the call, or the
+ * timeout of a configured client), allowing to tell it apart from a failed communication (i.e. EXIT_FAILURE).
+ */
+#define ECFLOW_LIGHT_DEADLINE_EXCEEDED 2
+
 /**
  * Informs the ecFlow server that the named meter has been updated to the given value.
  *
  * @param name the name of the meter to be updated
  * @param value the new value of the meter (i.e. an integer, expected to be in the meter range)
- * @return EXIT_FAILURE if communication failed; EXIT_SUCCESS, otherwise
+ * @return ECFLOW_LIGHT_DEADLINE_EXCEEDED if a client timeout was reached; EXIT_FAILURE if communication failed;
+ *         EXIT_SUCCESS, otherwise
  */
 int ecflow_light_update_meter(const char* name, int value);
 
+/**
+ * Informs the ecFlow server that the named meter has been updated to the given value, within the given budget.
+ *
+ * Connecting, sending and retrying are all bounded by the budget (as is the timeout of each configured client).
+ *
+ * @param name the name of the meter to be updated
+ * @param value the new value of the meter (i.e. an integer, expected to be in the meter range)
+ * @param budget_us the maximum time (in microseconds) allowed for the call
+ * @return ECFLOW_LIGHT_DEADLINE_EXCEEDED if the budget was exceeded; EXIT_FAILURE if communication failed;
+ *         EXIT_SUCCESS, otherwise
+ */
+int ecflow_light_update_meter_within(const char* name, int value, long budget_us);
+
 /**
  * Informs the ecFlow server that the named label has been updated to the given value.
  *
  * @param name the name of the label to be updated
  * @param value the new value of the label (i.e. a string)
- * @return EXIT_FAILURE if communication failed; EXIT_SUCCESS, otherwise
+ * @return ECFLOW_LIGHT_DEADLINE_EXCEEDED if a client timeout was reached; EXIT_FAILURE if communication failed;
+ *         EXIT_SUCCESS, otherwise
  */
 int ecflow_light_update_label(const char* name, const char* value);
 
+/**
+ * Informs the ecFlow server that the named label has been updated to the given value, within the given budget.
+ *
+ * @param name the name of the label to be updated
+ * @param value the new value of the label (i.e. a string)
+ * @param budget_us the maximum time (in microseconds) allowed for the call
+ * @return ECFLOW_LIGHT_DEADLINE_EXCEEDED if the budget was exceeded; EXIT_FAILURE if communication failed;
+ *         EXIT_SUCCESS, otherwise
+ */
+int ecflow_light_update_label_within(const char* name, const char* value, long budget_us);
+
 /**
  * Informs the ecFlow server that the named event has been updated to the given value.
  *
  * @param name the name of the label to be updated
  * @param value the new value of the label (i.e. 0 to clear the event; any other value to set the event)
- * @return EXIT_FAILURE if communication failed; EXIT_SUCCESS, otherwise
+ * @return ECFLOW_LIGHT_DEADLINE_EXCEEDED if a client timeout was reached; EXIT_FAILURE if communication failed;
+ *         EXIT_SUCCESS, otherwise
  */
 int ecflow_light_update_event(const char* name, int value);
 
+/**
+ * Informs the ecFlow server that the named event has been updated to the given value, within the given budget.
+ *
+ * @param name the name of the event to be updated
+ * @param value the new value of the event (i.e. 0 to clear the event; any other value to set the event)
+ * @param budget_us the maximum time (in microseconds) allowed for the call
+ * @return ECFLOW_LIGHT_DEADLINE_EXCEEDED if the budget was exceeded; EXIT_FAILURE if communication failed;
+ *         EXIT_SUCCESS, otherwise
+ */
+int ecflow_light_update_event_within(const char* name, int value, long budget_us);
+
+/**
+ * Starts a batch of updates on the calling thread.
+ *
+ * Until the matching call to ecflow_light_batch_commit, the meter, label and event updates requested by the
+ * calling thread are collected instead of being sent. Batches can be nested, in which case only the outermost
+ * commit sends the collected updates.
+ *
+ * @return EXIT_SUCCESS
+ */
+int ecflow_light_batch_begin(void);
+
+/**
+ * Commits the batch of updates started on the calling thread, sending all collected updates in as few messages
+ * as the configured clients allow (e.g. a single UDP datagram, or a single HTTP request).
+ *
+ * The collected updates are always sent synchronously, even when the asynchronous mode is enabled.
+ *
+ * @return ECFLOW_LIGHT_DEADLINE_EXCEEDED if a client timeout was reached; EXIT_FAILURE if no batch was started or
+ *         communication failed; EXIT_SUCCESS, otherwise
+ */
+int ecflow_light_batch_commit(void);
+
+/**
+ * Commits the batch of updates started on the calling thread (as per ecflow_light_batch_commit), within the given
+ * budget.
+ *
+ * @param budget_us the maximum time (in microseconds) allowed for the call
+ * @return ECFLOW_LIGHT_DEADLINE_EXCEEDED if the budget was exceeded; EXIT_FAILURE if no batch was started or
+ *         communication failed; EXIT_SUCCESS, otherwise
+ */
+int ecflow_light_batch_commit_within(long budget_us);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -0,0 +1,252 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include "ecflow/light/Acknowledged.h"
+
+#include <algorithm>
+#include <array>
+
+#include "ecflow/light/Log.h"
+
+namespace ecflow::light {
+
+// *** RTO Estimator ***********************************************************
+// *****************************************************************************
+
+void RTOEstimator::sample(duration_t rtt) {
+    if (!sampled_) {
+        srtt_    = rtt;
+        rttvar_  = rtt / 2;
+        sampled_ = true;
+    }
+    else {
+        auto deviation = srtt_ > rtt ? srtt_ - rtt : rtt - srtt_;
+        rttvar_        = (3 * rttvar_ + deviation) / 4;
+        srtt_          = (7 * srtt_ + rtt) / 8;
+    }
+    rto_ = std::clamp(srtt_ + 4 * rttvar_, MinimumRTO, MaximumRTO);
+}
+
+// *** Retransmit Window *******************************************************
+// *****************************************************************************
+
+RetransmitWindow::RetransmitWindow(size_t capacity) :
+    capacity_{std::max(capacity, size_t{1})}, next_{1}, entries_{}, superseded_{0}, abandoned_{0} {}
+
+uint64_t RetransmitWindow::open(std::string_view key) {
+    if (!key.empty()) {
+        auto found = std::find_if(std::begin(entries_), std::end(entries_),
+                                  [&key](const Entry& entry) { return entry.key == key; });
+        if (found != std::end(entries_)) {
+            entries_.erase(found);
+            ++superseded_;
+        }
+    }
+    if (entries_.size() >= capacity_) {
+        entries_.pop_front();
+        ++abandoned_;
+    }
+    return next_++;
+}
+
+void RetransmitWindow::record(uint64_t sequence, std::string_view key, std::string packet, time_point_t now,
+                              RTOEstimator::duration_t rto) {
+    entries_.push_back(Entry{sequence, std::string(key), std::move(packet), now, now + rto, 1});
+}
+
+size_t RetransmitWindow::acknowledge(uint64_t sequence, time_point_t now, RTOEstimator& estimator) {
+    const Entry* newest = nullptr;
+    size_t removed      = 0;
+    for (auto& entry : entries_) {
+        if (entry.sequence > sequence) {
+            break;
+        }
+        newest = &entry;
+        ++removed;
+    }
+    if (newest != nullptr && newest->transmissions == 1) {
+        estimator.sample(std::chrono::duration_cast<RTOEstimator::duration_t>(now - newest->sent_at));
+    }
+    entries_.erase(std::begin(entries_), std::begin(entries_) + static_cast<std::ptrdiff_t>(removed));
+    return removed;
+}
+
+std::vector<const RetransmitWindow::Entry*> RetransmitWindow::due(time_point_t now, RTOEstimator::duration_t rto) {
+    auto exhausted = std::remove_if(std::begin(entries_), std::end(entries_), [now](const Entry& entry) {
+        return entry.deadline <= now && entry.transmissions >= MaximumTransmissions;
+    });
+    abandoned_ += static_cast<uint64_t>(std::distance(exhausted, std::end(entries_)));
+    entries_.erase(exhausted, std::end(entries_));
+
+    std::vector<const Entry*> due;
+    for (auto& entry : entries_) {
+        if (entry.deadline <= now) {
+            // Notice: the timeout is doubled on each retransmission (i.e. exponential backoff)
+            auto backoff   = std::min(rto * (1 << entry.transmissions), RTOEstimator::MaximumRTO);
+            entry.deadline = now + backoff;
+            ++entry.transmissions;
+            due.push_back(&entry);
+        }
+    }
+    return due;
+}
+
+uint64_t RetransmitWindow::base() const {
+    return entries_.empty() ? next_ : entries_.front().sequence;
+}
+
+std::optional<RetransmitWindow::time_point_t> RetransmitWindow::next_deadline() const {
+    std::optional<time_point_t> earliest;
+    for (const auto& entry : entries_) {
+        if (!earliest || entry.deadline < earliest.value()) {
+            earliest = entry.deadline;
+        }
+    }
+    return earliest;
+}
+
+// *** Acknowledged Sender *****************************************************
+// *****************************************************************************
+
+namespace {
+
+// Maximum period waiting for acknowledgements, before checking for retransmissions (or stopping)
+constexpr auto PollPeriod = std::chrono::milliseconds(20);
+
+}  // namespace
+
+AcknowledgedSender::AcknowledgedSender(net::UDPSocket& socket, size_t window, std::chrono::milliseconds linger) :
+    socket_{socket},
+    linger_{linger},
+    lock_{},
+    wakeup_{},
+    drained_{},
+    window_{window},
+    estimator_{},
+    acknowledged_{0},
+    retransmitted_{0},
+    stopping_{false},
+    receiver_{} {
+    receiver_ = std::thread([this]() { run(); });
+}
+
+AcknowledgedSender::~AcknowledgedSender() {
+    if (!wait_acknowledged(linger_)) {
+        Log::warning() << "Stopping acknowledged UDP sender, with " << pending() << " unacknowledged datagram(s)"
+                       << std::endl;
+    }
+    {
+        std::scoped_lock lock(lock_);
+        stopping_.store(true, std::memory_order_release);
+    }
+    wakeup_.notify_all();
+    receiver_.join();
+}
+
+bool AcknowledgedSender::send(std::string_view key, std::string_view packet) {
+    bool sent = false;
+    {
+        std::scoped_lock lock(lock_);
+        auto sequence = window_.open(key);
+        sent          = transmit(sequence, packet);
+        window_.record(sequence, key, std::string(packet), RetransmitWindow::clock_t::now(), estimator_.rto());
+    }
+    wakeup_.notify_one();
+    return sent;
+}
+
+bool AcknowledgedSender::wait_acknowledged(std::chrono::milliseconds timeout) {
+    std::unique_lock lock(lock_);
+    return drained_.wait_for(lock, timeout, [this]() { return window_.pending() == 0; });
+}
+
+size_t AcknowledgedSender::pending() const {
+    std::scoped_lock lock(lock_);
+    return window_.pending();
+}
+
+uint64_t AcknowledgedSender::superseded() const {
+    std::scoped_lock lock(lock_);
+    return window_.superseded();
+}
+
+uint64_t AcknowledgedSender::abandoned() const {
+    std::scoped_lock lock(lock_);
+    return window_.abandoned();
+}
+
+RTOEstimator::duration_t AcknowledgedSender::rto() const {
+    std::scoped_lock lock(lock_);
+    return estimator_.rto();
+}
+
+void AcknowledgedSender::run() {
+    while (!stopping_.load(std::memory_order_acquire)) {
+        auto timeout = PollPeriod;
+        {
+            std::unique_lock lock(lock_);
+            // Notice: without pending datagrams, there is nothing to wait for until the next datagram is sent
+            wakeup_.wait(lock,
+                         [this]() { return stopping_.load(std::memory_order_acquire) || window_.pending() > 0; });
+            if (auto deadline = window_.next_deadline(); deadline) {
+                auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline.value() -
+                                                                              RetransmitWindow::clock_t::now());
+                timeout = std::clamp(remaining, std::chrono::milliseconds(0), PollPeriod);
+            }
+        }
+        if (stopping_.load(std::memory_order_acquire)) {
+            break;
+        }
+
+        if (socket_.wait_readable(timeout)) {
+            collect_acknowledgements();
+        }
+        retransmit();
+    }
+}
+
+void AcknowledgedSender::collect_acknowledgements() {
+    std::array<char, 512> buffer{};
+    while (auto received = socket_.receive(buffer.data(), buffer.size())) {
+        auto sequence = parse_acknowledgement(std::string_view(buffer.data(), received.value()));
+        if (!sequence) {
+            continue;
+        }
+
+        std::scoped_lock lock(lock_);
+        auto removed = window_.acknowledge(sequence.value(), RetransmitWindow::clock_t::now(), estimator_);
+        acknowledged_.fetch_add(removed, std::memory_order_relaxed);
+        if (window_.pending() == 0) {
+            drained_.notify_all();
+        }
+    }
+}
+
+void AcknowledgedSender::retransmit() {
+    std::scoped_lock lock(lock_);
+    for (const auto* entry : window_.due(RetransmitWindow::clock_t::now(), estimator_.rto())) {
+        Log::debug() << "Retransmitting UDP datagram #" << entry->sequence << " (transmission "
+                     << entry->transmissions << ")" << std::endl;
+        transmit(entry->sequence, entry->packet);
+        retransmitted_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (window_.pending() == 0) {
+        drained_.notify_all();
+    }
+}
+
+bool AcknowledgedSender::transmit(uint64_t sequence, std::string_view packet) {
+    std::string datagram;
+    datagram.reserve(packet.size() + 32);
+    write_sequenced(datagram, packet, Sequence{sequence, std::min(window_.base(), sequence)});
+    return socket_.send(datagram.data(), datagram.size());
+}
+
+}  // namespace ecflow::light
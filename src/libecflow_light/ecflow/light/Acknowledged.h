@@ -0,0 +1,207 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#ifndef ECFLOW_LIGHT_ACKNOWLEDGED_H
+#define ECFLOW_LIGHT_ACKNOWLEDGED_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "ecflow/light/UDPSocket.h"
+#include "ecflow/light/WireFormat.h"
+
+namespace ecflow::light {
+
+// *** RTO Estimator ***********************************************************
+// *****************************************************************************
+
+/**
+ * RTOEstimator computes the retransmission timeout from the measured round-trip times, as per RFC 6298 (i.e. a
+ * smoothed RTT plus four times its variation), bounded by [MinimumRTO, MaximumRTO].
+ */
+class RTOEstimator {
+public:
+    using duration_t = std::chrono::microseconds;
+
+    static constexpr duration_t InitialRTO = std::chrono::milliseconds(200);
+    static constexpr duration_t MinimumRTO = std::chrono::milliseconds(5);
+    static constexpr duration_t MaximumRTO = std::chrono::seconds(2);
+
+    RTOEstimator() : srtt_{0}, rttvar_{0}, rto_{InitialRTO}, sampled_{false} {}
+
+    void sample(duration_t rtt);
+
+    [[nodiscard]] duration_t rto() const { return rto_; }
+    [[nodiscard]] duration_t srtt() const { return srtt_; }
+
+private:
+    duration_t srtt_;
+    duration_t rttvar_;
+    duration_t rto_;
+    bool sampled_;
+};
+
+// *** Retransmit Window *******************************************************
+// *****************************************************************************
+
+/**
+ * RetransmitWindow keeps the datagrams sent, but not yet acknowledged, ordered by sequence number.
+ *
+ * An entry with a key (i.e. a meter or label update) is superseded by a newer entry with the same key, and is thus
+ * never retransmitted. When the window is full, the oldest entry is abandoned. An entry not acknowledged within
+ * the RTO is retransmitted, doubling its timeout each time, and abandoned after MaximumTransmissions.
+ *
+ * Notice: the window is not thread-safe.
+ */
+class RetransmitWindow {
+public:
+    using clock_t      = std::chrono::steady_clock;
+    using time_point_t = clock_t::time_point;
+
+    static constexpr uint32_t MaximumTransmissions = 6;
+
+    struct Entry {
+        uint64_t sequence;
+        std::string key;
+        std::string packet;
+        time_point_t sent_at;
+        time_point_t deadline;
+        uint32_t transmissions;
+    };
+
+    explicit RetransmitWindow(size_t capacity);
+
+    /**
+     * Opens a new entry, superseding any entry with the same (non-empty) key
+     *
+     * @return the sequence number of the new entry
+     */
+    uint64_t open(std::string_view key);
+
+    /**
+     * Records the packet (i.e. without sequence numbers) sent for the entry just opened
+     */
+    void record(uint64_t sequence, std::string_view key, std::string packet, time_point_t now,
+                RTOEstimator::duration_t rto);
+
+    /**
+     * Removes all entries up to the given (cumulative) sequence number, sampling the RTT of the newest of these if
+     * sent only once (i.e. as per Karn's algorithm)
+     *
+     * @return the number of entries removed
+     */
+    size_t acknowledge(uint64_t sequence, time_point_t now, RTOEstimator& estimator);
+
+    /**
+     * @return the entries due to be retransmitted, updating their deadline (entries exceeding the maximum number
+     *         of transmissions are abandoned)
+     */
+    std::vector<const Entry*> due(time_point_t now, RTOEstimator::duration_t rto);
+
+    /**
+     * @return the base sequence number, i.e. all entries below were either acknowledged, superseded or abandoned
+     */
+    [[nodiscard]] uint64_t base() const;
+    [[nodiscard]] std::optional<time_point_t> next_deadline() const;
+
+    [[nodiscard]] size_t pending() const { return entries_.size(); }
+    [[nodiscard]] uint64_t superseded() const { return superseded_; }
+    [[nodiscard]] uint64_t abandoned() const { return abandoned_; }
+
+private:
+    size_t capacity_;
+    uint64_t next_;
+    std::deque<Entry> entries_;
+    uint64_t superseded_;
+    uint64_t abandoned_;
+};
+
+// *** Acknowledged Sender *****************************************************
+// *****************************************************************************
+
+/**
+ * AcknowledgedSender sends datagrams over the given socket, adding sequence numbers and keeping them in a
+ * retransmit window until acknowledged by the receiver.
+ *
+ * The sequence numbers are added on each transmission, so that a retransmitted datagram carries the current base
+ * (i.e. allowing the receiver to skip any entries superseded since the original transmission).
+ *
+ * A dedicated thread collects the acknowledgements and retransmits the entries whose RTO expired. On destruction,
+ * the sender waits (at most for the linger period) for the pending datagrams to be acknowledged.
+ */
+class AcknowledgedSender {
+public:
+    static constexpr auto DefaultLinger = std::chrono::milliseconds(500);
+
+    AcknowledgedSender(net::UDPSocket& socket, size_t window, std::chrono::milliseconds linger = DefaultLinger);
+    ~AcknowledgedSender();
+
+    // AcknowledgedSender object cannot be copied!
+    AcknowledgedSender(const AcknowledgedSender&)            = delete;
+    AcknowledgedSender& operator=(const AcknowledgedSender&) = delete;
+
+    /**
+     * Sends the datagram (i.e. the packet, as sent without sequence numbers), with the next sequence number.
+     *
+     * The key identifies the attribute being updated (for meters and labels), so that only its newest value is
+     * ever retransmitted; an empty key means the datagram is never superseded.
+     *
+     * @return true, if the datagram was sent (it is retransmitted, if dropped)
+     */
+    bool send(std::string_view key, std::string_view packet);
+
+    /**
+     * Waits until all pending datagrams are acknowledged (or abandoned), or the timeout expires
+     *
+     * @return true, if no datagrams are pending
+     */
+    bool wait_acknowledged(std::chrono::milliseconds timeout);
+
+    [[nodiscard]] size_t pending() const;
+    [[nodiscard]] uint64_t acknowledged() const { return acknowledged_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t retransmitted() const { return retransmitted_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t superseded() const;
+    [[nodiscard]] uint64_t abandoned() const;
+    [[nodiscard]] RTOEstimator::duration_t rto() const;
+
+private:
+    void run();
+    void collect_acknowledgements();
+    void retransmit();
+    bool transmit(uint64_t sequence, std::string_view packet);
+
+    net::UDPSocket& socket_;
+    std::chrono::milliseconds linger_;
+
+    mutable std::mutex lock_;
+    std::condition_variable wakeup_;
+    std::condition_variable drained_;
+    RetransmitWindow window_;
+    RTOEstimator estimator_;
+
+    std::atomic<uint64_t> acknowledged_;
+    std::atomic<uint64_t> retransmitted_;
+    std::atomic<bool> stopping_;
+
+    std::thread receiver_;
+};
+
+}  // namespace ecflow::light
+
+#endif
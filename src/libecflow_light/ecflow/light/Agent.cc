@@ -0,0 +1,205 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include "ecflow/light/Agent.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <type_traits>
+
+#include "ecflow/light/Log.h"
+
+namespace ecflow::light {
+
+static_assert(std::is_trivially_copyable_v<AgentMessage>, "AgentMessage must be trivially copyable");
+
+namespace {
+
+sockaddr_un make_address(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        ECFLOW_LIGHT_THROW(AgentError, Message("Unable to use agent socket '", path, "', as the path is too long"));
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+int open_socket() {
+    int fd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        ECFLOW_LIGHT_THROW(AgentError, Message("Unable to create agent socket, due to: ", std::strerror(errno)));
+    }
+    return fd;
+}
+
+/**
+ * @return true, if an agent is listening on the given address
+ */
+bool is_listening(const sockaddr_un& address) {
+    int fd     = open_socket();
+    int result = ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+    ::close(fd);
+    return result == 0;
+}
+
+}  // namespace
+
+Agent::Agent(std::string path, const ClientAPI& target) :
+    path_{std::move(path)},
+    target_{target},
+    fd_{-1},
+    parent_{::getppid()},
+    stopping_{false},
+    received_{0},
+    failed_{0} {
+    auto address = make_address(path_);
+
+    if (::access(path_.c_str(), F_OK) == 0) {
+        if (is_listening(address)) {
+            ECFLOW_LIGHT_THROW(AgentError, Message("Unable to start agent, as another agent listens on '", path_, "'"));
+        }
+        // Notice: a stale socket is left behind by an agent that was not able to remove it (e.g. it was killed)
+        Log::warning() << "Replacing stale agent socket '" << path_ << "'" << std::endl;
+        ::unlink(path_.c_str());
+    }
+
+    fd_ = open_socket();
+    if (::bind(fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        int error = errno;
+        ::close(fd_);
+        ECFLOW_LIGHT_THROW(AgentError, Message("Unable to bind agent socket '", path_, "', due to: ",
+                                               std::strerror(error)));
+    }
+
+    Log::debug() << "Agent listening on '" << path_ << "'" << std::endl;
+}
+
+Agent::~Agent() {
+    ::close(fd_);
+    ::unlink(path_.c_str());
+    Log::debug() << "Agent stopped, after receiving " << received() << " update(s) (" << failed()
+                 << " failed to be forwarded)" << std::endl;
+}
+
+void Agent::serve() {
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        if (::getppid() != parent_) {
+            Log::debug() << "Agent stopping, as the parent process finished" << std::endl;
+            break;
+        }
+
+        pollfd descriptor{fd_, POLLIN, 0};
+        int ready = ::poll(&descriptor, 1, static_cast<int>(IdlePeriod.count()));
+        if (ready < 0 && errno != EINTR) {
+            ECFLOW_LIGHT_THROW(AgentError, Message("Unable to wait for updates, due to: ", std::strerror(errno)));
+        }
+        if (ready > 0) {
+            forward(receive());
+        }
+    }
+}
+
+std::vector<UpdateRecord> Agent::receive() {
+    std::vector<UpdateRecord> records;
+    while (records.size() < MaximumBatch) {
+        AgentMessage message;
+        ssize_t size = ::recv(fd_, &message, sizeof(message), MSG_DONTWAIT | MSG_TRUNC);
+        if (size < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (static_cast<size_t>(size) != sizeof(message) || message.marker != AgentMessage::Marker) {
+            Log::warning() << "Discarding invalid update (" << size << " bytes) handed over to agent" << std::endl;
+            continue;
+        }
+        records.push_back(message.record);
+    }
+    received_.fetch_add(records.size(), std::memory_order_relaxed);
+    return records;
+}
+
+void Agent::forward(const std::vector<UpdateRecord>& records) {
+    if (records.empty()) {
+        return;
+    }
+
+    try {
+        const auto& context = TaskContext::current();
+        if (records.size() == 1) {
+            Response response = target_.process(records.front().to_request(context));
+            if (debug_enabled()) {
+                Log::debug() << "Response: " << response << std::endl;
+            }
+            return;
+        }
+
+        UpdateNodeAttributes::attributes_t attributes;
+        attributes.reserve(records.size());
+        for (const auto& record : records) {
+            attributes.push_back(record.to_options());
+        }
+        Response response = target_.process(Request::make_request<UpdateNodeAttributes>(context, attributes));
+        if (debug_enabled()) {
+            Log::debug() << "Response: " << response << std::endl;
+        }
+    }
+    catch (eckit::Exception& e) {
+        failed_.fetch_add(records.size(), std::memory_order_relaxed);
+        Log::error() << "Error detected: " << e.what() << std::endl;
+    }
+    catch (...) {
+        failed_.fetch_add(records.size(), std::memory_order_relaxed);
+        Log::error() << "Unknown error detected" << std::endl;
+    }
+}
+
+bool Agent::handover(const std::string& path, const UpdateRecord& record) {
+    if (path.empty() || path.size() >= sizeof(sockaddr_un::sun_path)) {
+        return false;
+    }
+    auto address = make_address(path);
+
+    int fd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    AgentMessage message;
+    message.record = record;
+
+    auto send = [fd, &message]() {
+        return ::send(fd, &message, sizeof(message), MSG_DONTWAIT | MSG_NOSIGNAL) == ssize_t(sizeof(message));
+    };
+
+    // Notice: connecting fails immediately (e.g. ENOENT, ECONNREFUSED) when no agent is listening
+    bool accepted = false;
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0) {
+        accepted = send();
+        if (!accepted && errno == EAGAIN) {
+            // The agent is busy (i.e. its queue is full), so wait briefly for it to catch up
+            pollfd descriptor{fd, POLLOUT, 0};
+            if (::poll(&descriptor, 1, static_cast<int>(HandoverTimeout.count())) > 0) {
+                accepted = send();
+            }
+        }
+    }
+    ::close(fd);
+    return accepted;
+}
+
+}  // namespace ecflow::light
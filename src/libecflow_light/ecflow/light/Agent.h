@@ -0,0 +1,113 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#ifndef ECFLOW_LIGHT_AGENT_H
+#define ECFLOW_LIGHT_AGENT_H
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ecflow/light/AsyncSender.h"
+#include "ecflow/light/ClientAPI.h"
+#include "ecflow/light/Exception.h"
+
+namespace ecflow::light {
+
+struct AgentError : public eckit::Exception {
+    AgentError(const std::string& msg, const eckit::CodeLocation& loc) : eckit::Exception(msg, loc) {}
+};
+
+// *** Agent *******************************************************************
+// *****************************************************************************
+
+/**
+ * AgentMessage is the datagram handed over to the agent: a single update record, preceded by a marker that
+ * identifies the format (and thus allows to discard datagrams sent by an incompatible version).
+ */
+struct AgentMessage {
+    uint32_t marker = Marker;
+    UpdateRecord record;
+
+    static constexpr uint32_t Marker = 0x45'43'4C'01;  // i.e. "ECL", version 1
+};
+
+/**
+ * Agent forwards, on behalf of the current task, the updates handed over by other processes of the same job.
+ *
+ * The agent listens on a Unix domain (datagram) socket, bound to the given path. Each received update is forwarded
+ * to the target client, and updates received together are forwarded as a single batch. Handing over an update
+ * takes a single system call, and thus avoids the (comparatively) expensive initialisation of each process.
+ *
+ * The agent serves until stopped, or until its parent process (i.e. the job) finishes.
+ */
+class Agent {
+public:
+    /**
+     * Creates the agent, binding the socket to the given path.
+     *
+     * A stale socket (i.e. left behind by an agent that no longer runs) is replaced, but an error is thrown if
+     * another agent is still listening on the path.
+     */
+    Agent(std::string path, const ClientAPI& target);
+    ~Agent();
+
+    // Agent object cannot be copied!
+    Agent(const Agent&)            = delete;
+    Agent& operator=(const Agent&) = delete;
+
+    /**
+     * Receive and forward the updates, until stopped or the parent process finishes
+     */
+    void serve();
+
+    /**
+     * Request the agent to stop serving (notice: safe to call from a signal handler)
+     */
+    void stop() { stopping_.store(true, std::memory_order_relaxed); }
+
+    [[nodiscard]] uint64_t received() const { return received_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t failed() const { return failed_.load(std::memory_order_relaxed); }
+
+    /**
+     * Hand over the update to the agent listening on the given path.
+     *
+     * @return true, if the agent accepted the update; false, if no agent is listening (or it is not able to keep up)
+     */
+    static bool handover(const std::string& path, const UpdateRecord& record);
+
+    // The agent periodically wakes up, checking if it should stop
+    static constexpr auto IdlePeriod = std::chrono::milliseconds(100);
+    // Maximum time spent waiting for a busy agent to accept an update
+    static constexpr auto HandoverTimeout = std::chrono::milliseconds(100);
+    // Maximum number of updates forwarded as a single batch
+    static constexpr size_t MaximumBatch = 64;
+
+private:
+    std::vector<UpdateRecord> receive();
+    void forward(const std::vector<UpdateRecord>& records);
+
+    std::string path_;
+    const ClientAPI& target_;
+    int fd_;
+    pid_t parent_;
+
+    std::atomic<bool> stopping_;
+    std::atomic<uint64_t> received_;
+    std::atomic<uint64_t> failed_;
+};
+
+}  // namespace ecflow::light
+
+#endif
@@ -0,0 +1,289 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include "ecflow/light/AsyncSender.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "ecflow/light/Deadline.h"
+#include "ecflow/light/Exception.h"
+#include "ecflow/light/Log.h"
+#include "ecflow/light/UDPSocket.h"
+
+namespace ecflow::light {
+
+// *** Update Record ***********************************************************
+// *****************************************************************************
+
+std::optional<UpdateRecord> UpdateRecord::make_meter(std::string_view name, int value) {
+    UpdateRecord record;
+    record.kind  = Kind::Meter;
+    record.value = value;
+    if (!record.assign(name, {})) {
+        return std::nullopt;
+    }
+    return record;
+}
+
+std::optional<UpdateRecord> UpdateRecord::make_label(std::string_view name, std::string_view value) {
+    UpdateRecord record;
+    record.kind = Kind::Label;
+    if (!record.assign(name, value)) {
+        return std::nullopt;
+    }
+    return record;
+}
+
+std::optional<UpdateRecord> UpdateRecord::make_event(std::string_view name, bool value) {
+    UpdateRecord record;
+    record.kind  = Kind::Event;
+    record.value = value ? 1 : 0;
+    if (!record.assign(name, {})) {
+        return std::nullopt;
+    }
+    return record;
+}
+
+bool UpdateRecord::assign(std::string_view name, std::string_view text) {
+    if (name.size() > MaxNameSize || text.size() > MaxTextSize) {
+        return false;
+    }
+    std::memcpy(name_, name.data(), name.size());
+    name_size_ = static_cast<uint16_t>(name.size());
+    std::memcpy(text_, text.data(), text.size());
+    text_size_ = static_cast<uint16_t>(text.size());
+    return true;
+}
+
+Options UpdateRecord::to_options() const {
+    Options options = Options::options().with(Field::Name, name());
+    switch (kind) {
+        case Kind::Meter:
+            options = options.with(Field::Command, "meter").with(Field::Value, value);
+            break;
+        case Kind::Label:
+            options = options.with(Field::Command, "label").with(Field::Value, text());
+            break;
+        case Kind::Event:
+            options = options.with(Field::Command, "event").with(Field::Value, value ? "1" : "0");
+            break;
+    }
+    return options;
+}
+
+Request UpdateRecord::to_request(const std::shared_ptr<const TaskContext>& context) const {
+    return Request::make_request<UpdateNodeAttribute>(context, to_options());
+}
+
+// *** Async Sender ************************************************************
+// *****************************************************************************
+
+namespace {
+
+// The sender thread periodically wakes up, even when not notified, as a safeguard
+constexpr auto IdlePeriod = std::chrono::milliseconds(50);
+// Maximum number of queued records sent together (i.e. whose UDP datagrams are sent as a single burst)
+constexpr uint64_t MaximumBurst = 64;
+
+}  // namespace
+
+AsyncSender::AsyncSender(const AsyncCfg& cfg, const ClientAPI& target, bool bursts) :
+    cfg_{cfg},
+    target_{target},
+    bursts_{bursts},
+    queue_{cfg.capacity},
+    stopping_{false},
+    sleeping_{false},
+    pending_{0},
+    dropped_{0},
+    failed_{0},
+    released_{0},
+    waiting_{0},
+    lock_{},
+    wakeup_{},
+    drained_{},
+    space_{},
+    sender_{} {
+    sender_ = std::thread([this]() { run(); });
+    Log::debug() << "Async sender started, with queue capacity " << queue_.capacity() << std::endl;
+}
+
+AsyncSender::~AsyncSender() {
+    if (!flush(std::chrono::milliseconds(cfg_.flush_timeout_ms))) {
+        Log::warning() << "Async sender unable to flush within " << cfg_.flush_timeout_ms << "ms, discarding "
+                       << pending_.load() << " update(s)" << std::endl;
+    }
+
+    stopping_.store(true, std::memory_order_release);
+    {
+        std::scoped_lock lock(lock_);
+        wakeup_.notify_all();
+        space_.notify_all();
+    }
+    if (sender_.joinable()) {
+        sender_.join();
+    }
+
+    if (auto dropped = dropped_.load(); dropped > 0) {
+        Log::warning() << "Async sender dropped " << dropped << " update(s), due to queue overflow" << std::endl;
+    }
+}
+
+AsyncSender* AsyncSender::instance() {
+    // Notice: the ConfiguredClient (and the context of the current task) are created before the sender, and thus
+    //         are destroyed only after the sender has been flushed and stopped
+    static std::unique_ptr<AsyncSender> theInstance = []() -> std::unique_ptr<AsyncSender> {
+        const ConfiguredClient& client = ConfiguredClient::instance();
+        if (!client.configuration().async.enabled) {
+            return nullptr;
+        }
+        TaskContext::current();
+        // Notice: deferred datagrams are always reported as sent, and thus are never deferred when dropped datagrams
+        //         must be spooled, or sent to another client
+        bool bursts = !client.tracks_outcome();
+        if (!bursts) {
+            Log::debug() << "Async sender bursts disabled, as the outcome of each request is tracked" << std::endl;
+        }
+        return std::make_unique<AsyncSender>(client.configuration().async, client, bursts);
+    }();
+    return theInstance.get();
+}
+
+bool AsyncSender::submit(const UpdateRecord& record) {
+    if (stopping_.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    // Account for the record before pushing it, so that flush never misses a record in the queue
+    pending_.fetch_add(1, std::memory_order_acq_rel);
+
+    for (;;) {
+        // Notice: the number of released records is taken before pushing, so that no release is ever missed
+        uint64_t released = released_.load(std::memory_order_seq_cst);
+        if (queue_.try_push(record)) {
+            break;
+        }
+        if (cfg_.overflow == AsyncCfg::OverflowBlock) {
+            if (stopping_.load(std::memory_order_acquire)) {
+                pending_.fetch_sub(1, std::memory_order_acq_rel);
+                return false;
+            }
+            if (Deadline::expired()) {
+                pending_.fetch_sub(1, std::memory_order_acq_rel);
+                ECFLOW_LIGHT_THROW(DeadlineExceeded, Message("Deadline exceeded while waiting for queue capacity"));
+            }
+            wakeup();
+            wait_for_space(released);
+        }
+        else {
+            UpdateRecord discarded;
+            if (queue_.try_pop(discarded)) {
+                pending_.fetch_sub(1, std::memory_order_acq_rel);
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    wakeup();
+    return true;
+}
+
+bool AsyncSender::flush(std::chrono::milliseconds timeout) {
+    wakeup();
+    std::unique_lock lock(lock_);
+    return drained_.wait_for(lock, timeout, [this]() { return pending_.load(std::memory_order_acquire) == 0; });
+}
+
+void AsyncSender::run() {
+    UpdateRecord record;
+    while (!stopping_.load(std::memory_order_acquire)) {
+        if (queue_.try_pop(record)) {
+            uint64_t count = 0;
+            {
+                // Notice: the datagrams of the queued records are deferred, and sent together at the end of the burst
+                std::optional<net::UDPSocket::Burst> burst;
+                if (bursts_) {
+                    burst.emplace();
+                }
+                do {
+                    release_space();
+                    send(record);
+                } while (++count != MaximumBurst && queue_.try_pop(record));
+            }
+            if (pending_.fetch_sub(count, std::memory_order_acq_rel) == count) {
+                std::scoped_lock lock(lock_);
+                drained_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock lock(lock_);
+        sleeping_.store(true, std::memory_order_seq_cst);
+        wakeup_.wait_for(lock, IdlePeriod, [this]() {
+            return stopping_.load(std::memory_order_acquire) || pending_.load(std::memory_order_acquire) > 0;
+        });
+        sleeping_.store(false, std::memory_order_relaxed);
+    }
+}
+
+void AsyncSender::send(const UpdateRecord& record) {
+    try {
+        Request request   = record.to_request(TaskContext::current());
+        Response response = target_.process(request);
+
+        if (debug_enabled()) {
+            Log::debug() << "Response: " << response << std::endl;
+        }
+    }
+    catch (eckit::Exception& e) {
+        failed_.fetch_add(1, std::memory_order_relaxed);
+        Log::error() << "Error detected: " << e.what() << std::endl;
+    }
+    catch (...) {
+        failed_.fetch_add(1, std::memory_order_relaxed);
+        Log::error() << "Unknown error detected" << std::endl;
+    }
+}
+
+void AsyncSender::wait_for_space(uint64_t released) {
+    std::unique_lock lock(lock_);
+    waiting_.fetch_add(1, std::memory_order_seq_cst);
+    auto has_space = [this, released]() {
+        return stopping_.load(std::memory_order_acquire) || released_.load(std::memory_order_seq_cst) != released;
+    };
+    // Notice: the wait is bounded by the deadline of the calling thread (if any), checked again by the caller
+    if (auto deadline = Deadline::current(); deadline) {
+        space_.wait_until(lock, *deadline, has_space);
+    }
+    else {
+        space_.wait(lock, has_space);
+    }
+    waiting_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void AsyncSender::release_space() {
+    released_.fetch_add(1, std::memory_order_seq_cst);
+    // Only pay for the notification when a caller is blocked, waiting for space
+    if (waiting_.load(std::memory_order_seq_cst) > 0) {
+        std::scoped_lock lock(lock_);
+        space_.notify_all();
+    }
+}
+
+void AsyncSender::wakeup() {
+    // Only pay for the notification when the sender thread is (about to be) sleeping
+    if (sleeping_.exchange(false, std::memory_order_seq_cst)) {
+        std::scoped_lock lock(lock_);
+        wakeup_.notify_one();
+    }
+}
+
+}  // namespace ecflow::light
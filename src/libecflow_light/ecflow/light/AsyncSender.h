@@ -0,0 +1,158 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#ifndef ECFLOW_LIGHT_ASYNCSENDER_H
+#define ECFLOW_LIGHT_ASYNCSENDER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+
+#include "ecflow/light/BoundedQueue.h"
+#include "ecflow/light/ClientAPI.h"
+#include "ecflow/light/Configuration.h"
+#include "ecflow/light/Requests.h"
+
+namespace ecflow::light {
+
+// *** Update Record ***********************************************************
+// *****************************************************************************
+
+/**
+ * UpdateRecord is a compact, fixed size, representation of an attribute update.
+ *
+ * Records are trivially copyable, and thus can be stored directly in the cells of a BoundedQueue
+ * without any heap allocation on the caller's thread.
+ */
+struct UpdateRecord {
+    enum class Kind : uint8_t
+    {
+        Meter,
+        Label,
+        Event
+    };
+
+    static constexpr size_t MaxNameSize = 128;
+    static constexpr size_t MaxTextSize = 256;
+
+    /**
+     * The following factory functions return an empty optional when the name (or text) do not fit the record
+     */
+    static std::optional<UpdateRecord> make_meter(std::string_view name, int value);
+    static std::optional<UpdateRecord> make_label(std::string_view name, std::string_view value);
+    static std::optional<UpdateRecord> make_event(std::string_view name, bool value);
+
+    [[nodiscard]] std::string_view name() const { return {name_, name_size_}; }
+    [[nodiscard]] std::string_view text() const { return {text_, text_size_}; }
+
+    [[nodiscard]] Options to_options() const;
+    [[nodiscard]] Request to_request(const std::shared_ptr<const TaskContext>& context) const;
+
+    Kind kind = Kind::Meter;
+    int value = 0;
+
+private:
+    bool assign(std::string_view name, std::string_view text);
+
+    uint16_t name_size_ = 0;
+    uint16_t text_size_ = 0;
+    char name_[MaxNameSize];
+    char text_[MaxTextSize];
+};
+
+// *** Async Sender ************************************************************
+// *****************************************************************************
+
+/**
+ * AsyncSender decouples the caller from the network exchange.
+ *
+ * Updates are stored in a bounded lock-free queue, and a dedicated sender thread drains the queue
+ * into the target client. When the queue is full, the overflow policy either discards the oldest
+ * queued update (drop-oldest) or makes the caller wait until space becomes available (block).
+ *
+ * Unless the target acts on the outcome of each request (e.g. spooling the dropped updates), the UDP datagrams of
+ * the records drained together are deferred, and sent as a single burst.
+ *
+ * On destruction (i.e. at program exit, for the configured instance) the pending updates are flushed,
+ * waiting at most for the configured flush timeout.
+ */
+class AsyncSender {
+public:
+    AsyncSender(const AsyncCfg& cfg, const ClientAPI& target, bool bursts = true);
+    ~AsyncSender();
+
+    // AsyncSender object cannot be copied!
+    AsyncSender(const AsyncSender&)            = delete;
+    AsyncSender& operator=(const AsyncSender&) = delete;
+
+    /**
+     * Retrieve the process-wide sender, based on the configuration of the ConfiguredClient.
+     *
+     * @return the sender, or nullptr if the asynchronous mode is not enabled
+     */
+    static AsyncSender* instance();
+
+    /**
+     * Submit the given record to be sent by the sender thread.
+     *
+     * When the queue is full and the overflow policy is to block, waits for capacity until the deadline (if any) of
+     * the calling thread, and then throws DeadlineExceeded.
+     *
+     * @return true if the record was accepted; false, if the sender is stopping
+     */
+    bool submit(const UpdateRecord& record);
+
+    /**
+     * Wait until all submitted records have been processed, or the timeout expires.
+     *
+     * @return true if all records were processed; false, otherwise
+     */
+    bool flush(std::chrono::milliseconds timeout);
+
+    [[nodiscard]] uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t failed() const { return failed_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    void send(const UpdateRecord& record);
+    void wakeup();
+    void wait_for_space(uint64_t released);
+    void release_space();
+
+    AsyncCfg cfg_;
+    const ClientAPI& target_;
+    bool bursts_;
+    BoundedQueue<UpdateRecord> queue_;
+
+    std::atomic<bool> stopping_;
+    std::atomic<bool> sleeping_;
+    std::atomic<uint64_t> pending_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<uint64_t> failed_;
+    std::atomic<uint64_t> released_;  // i.e. number of records popped, signalling space to the blocked callers
+    std::atomic<uint32_t> waiting_;   // i.e. number of callers blocked, waiting for space
+
+    std::mutex lock_;
+    std::condition_variable wakeup_;
+    std::condition_variable drained_;
+    std::condition_variable space_;
+
+    std::thread sender_;
+};
+
+}  // namespace ecflow::light
+
+#endif
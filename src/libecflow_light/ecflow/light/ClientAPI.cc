@@ -10,7 +10,15 @@
 
 #include "ecflow/light/ClientAPI.h"
 
+#include <netdb.h>
+#include <sys/socket.h>
+
+#include <algorithm>
 #include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
 #include <memory>
 #include <optional>
 #include <regex>
@@ -20,6 +28,7 @@
 #include "ecflow/light/Conversion.h"
 #include "ecflow/light/Exception.h"
 #include "ecflow/light/Log.h"
+#include "ecflow/light/StringUtils.h"
 #include "ecflow/light/TinyREST.h"
 
 namespace ecflow::light {
@@ -35,51 +44,1022 @@ Response PhonyClientAPI::process(const Request& request) const {
 // *** Client (Composite) **********************************************************
 // *****************************************************************************
 
+namespace {
+
+/**
+ * Outcome of processing a request by one of the clients of a fan-out
+ */
+struct Outcome {
+    bool done = false;
+    std::optional<Response> response;
+    std::exception_ptr error;
+};
+
+Outcome attempt(const ClientAPI& api, const Request& request) {
+    Outcome outcome;
+    try {
+        outcome.response = api.process(request);
+    }
+    catch (...) {
+        outcome.error = std::current_exception();
+    }
+    outcome.done = true;
+    return outcome;
+}
+
+/**
+ * Collects the outcomes of all clients of a fan-out, allowing to wait until the completion policy is satisfied
+ *
+ * Notice: the completion is shared with the secondary clients, as these might still be processing the request
+ *         after the caller has returned (e.g. when using fire-and-forget)
+ */
+class Completion {
+public:
+    explicit Completion(size_t count) : lock_{}, updated_{}, outcomes_(count), finished_{0}, succeeded_{0} {}
+
+    void set(size_t index, Outcome outcome) {
+        {
+            std::scoped_lock lock(lock_);
+            finished_ += 1;
+            succeeded_ += outcome.response ? 1 : 0;
+            outcomes_[index] = std::move(outcome);
+        }
+        updated_.notify_all();
+    }
+
+    std::vector<Outcome> wait(bool any_success, std::optional<Deadline::time_point_t> deadline) {
+        std::unique_lock lock(lock_);
+        auto satisfied = [this, any_success] {
+            return finished_ == outcomes_.size() || (any_success && succeeded_ > 0);
+        };
+        if (deadline) {
+            updated_.wait_until(lock, *deadline, satisfied);
+        }
+        else {
+            updated_.wait(lock, satisfied);
+        }
+        return outcomes_;
+    }
+
+    std::vector<Outcome> outcomes() {
+        std::scoped_lock lock(lock_);
+        return outcomes_;
+    }
+
+private:
+    std::mutex lock_;
+    std::condition_variable updated_;
+    std::vector<Outcome> outcomes_;
+    size_t finished_;
+    size_t succeeded_;
+};
+
+Response merge(const std::vector<Outcome>& outcomes) {
+    auto success = std::find_if(std::begin(outcomes), std::end(outcomes),
+                                [](const Outcome& outcome) { return outcome.response.has_value(); });
+    if (success != std::end(outcomes)) {
+        return success->response.value();
+    }
+
+    // Notice: a client still processing the request, once all others failed, means the deadline was reached
+    if (std::any_of(std::begin(outcomes), std::end(outcomes), [](const Outcome& outcome) { return !outcome.done; })) {
+        ECFLOW_LIGHT_THROW(DeadlineExceeded, Message("Deadline exceeded while waiting for clients"));
+    }
+
+    auto failure = std::find_if(std::begin(outcomes), std::end(outcomes),
+                                [](const Outcome& outcome) { return outcome.error != nullptr; });
+    if (failure != std::end(outcomes)) {
+        std::rethrow_exception(failure->error);
+    }
+
+    throw std::runtime_error("No Responses available");
+}
+
+}  // namespace
+
+/**
+ * Worker processes the requests of a secondary client, in the order they are submitted
+ */
+class CompositeClientAPI::Worker {
+public:
+    explicit Worker(const ClientAPI& api) : api_{api}, lock_{}, updated_{}, tasks_{}, stopping_{false}, thread_{} {
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    ~Worker() {
+        {
+            std::scoped_lock lock(lock_);
+            stopping_ = true;
+        }
+        updated_.notify_all();
+        // Notice: pending tasks are still processed before the thread finishes
+        thread_.join();
+    }
+
+    /**
+     * @return true, if the task was submitted; or false, if the deadline was reached while waiting for capacity
+     */
+    bool submit(std::function<void(const ClientAPI&)> task, std::optional<Deadline::time_point_t> deadline) {
+        {
+            std::unique_lock lock(lock_);
+            // Avoid unbounded growth when the client is persistently slower than the rate of requests
+            auto available = [this] { return tasks_.size() < Capacity; };
+            if (deadline) {
+                if (!updated_.wait_until(lock, *deadline, available)) {
+                    return false;
+                }
+            }
+            else {
+                updated_.wait(lock, available);
+            }
+            tasks_.push_back(std::move(task));
+        }
+        updated_.notify_all();
+        return true;
+    }
+
+private:
+    void run() {
+        for (;;) {
+            std::function<void(const ClientAPI&)> task;
+            {
+                std::unique_lock lock(lock_);
+                updated_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            updated_.notify_all();
+            task(api_);
+        }
+    }
+
+    static constexpr size_t Capacity = 1024;
+
+    const ClientAPI& api_;
+
+    std::mutex lock_;
+    std::condition_variable updated_;
+    std::deque<std::function<void(const ClientAPI&)>> tasks_;
+    bool stopping_;
+
+    std::thread thread_;
+};
+
+CompositeClientAPI::CompositeClientAPI(std::string completion) :
+    completion_{std::move(completion)}, apis_{}, workers_{} {}
+
+CompositeClientAPI::~CompositeClientAPI() = default;
+
 void CompositeClientAPI::add(std::unique_ptr<ClientAPI>&& api) {
+    if (!apis_.empty()) {
+        workers_.push_back(std::make_unique<Worker>(*api));
+    }
     apis_.push_back(std::move(api));
 }
 
 Response CompositeClientAPI::process(const Request& request) const {
-    std::vector<Response> responses;
-    std::for_each(std::begin(apis_), std::end(apis_), [&](const auto& api) {
-        Response response = api->process(request);
-        responses.push_back(response);
+    if (apis_.empty()) {
+        throw std::runtime_error("No Responses available");
+    }
+
+    if (apis_.size() == 1) {
+        return apis_.front()->process(request);
+    }
+
+    auto completion = std::make_shared<Completion>(apis_.size());
+    auto deadline   = Deadline::current();
+
+    // Secondary clients are handed the request first, so that they proceed concurrently with the primary client
+    for (size_t index = 1; index < apis_.size(); ++index) {
+        auto task = [index, request, completion, deadline](const ClientAPI& api) {
+            // Notice: the deadline of the caller is established again on the worker thread
+            Deadline::Scope scope{deadline};
+            Outcome outcome = attempt(api, request);
+            if (outcome.error) {
+                try {
+                    std::rethrow_exception(outcome.error);
+                }
+                catch (const std::exception& e) {
+                    Log::error() << "Unable to process request by client #" << index << ", due to: " << e.what()
+                                 << std::endl;
+                }
+                catch (...) {
+                    Log::error() << "Unable to process request by client #" << index << ", due to unknown error"
+                                 << std::endl;
+                }
+            }
+            completion->set(index, std::move(outcome));
+        };
+        if (!workers_[index - 1]->submit(std::move(task), deadline)) {
+            Outcome outcome;
+            outcome.done  = true;
+            auto reason   = Message("Deadline exceeded while submitting request to client #", index);
+            outcome.error = std::make_exception_ptr(DeadlineExceeded(reason.str(), Here()));
+            completion->set(index, std::move(outcome));
+        }
+    }
+
+    completion->set(0, attempt(*apis_.front(), request));
+
+    if (completion_ == FanOutCfg::CompletionFireAndForget) {
+        auto outcomes = completion->outcomes();
+        // Consider only the primary client, as the secondary clients might not have finished
+        return merge({outcomes.front()});
+    }
+
+    return merge(completion->wait(completion_ == FanOutCfg::CompletionFirstSuccess, deadline));
+}
+
+// *** Client (Failover) *******************************************************
+// *****************************************************************************
+
+FailoverClientAPI::FailoverClientAPI(const RoutingCfg& cfg) : cfg_{cfg}, apis_{}, lock_{}, health_{} {}
+
+void FailoverClientAPI::add(std::unique_ptr<ClientAPI>&& api) {
+    std::scoped_lock lock(lock_);
+    apis_.push_back(std::move(api));
+    health_.emplace_back();
+}
+
+std::vector<FailoverClientAPI::Health> FailoverClientAPI::health() const {
+    std::scoped_lock lock(lock_);
+    return health_;
+}
+
+std::pair<std::vector<size_t>, bool> FailoverClientAPI::candidates() const {
+    std::scoped_lock lock(lock_);
+
+    std::vector<size_t> healthy;
+    std::vector<size_t> unhealthy;
+    for (size_t index = 0; index < health_.size(); ++index) {
+        (health_[index].healthy(cfg_) ? healthy : unhealthy).push_back(index);
+    }
+
+    // Unhealthy clients are ordered by success rate, and then latency (with the rank breaking any ties)
+    std::stable_sort(std::begin(unhealthy), std::end(unhealthy), [this](size_t lhs, size_t rhs) {
+        const auto& l = health_[lhs];
+        const auto& r = health_[rhs];
+        return l.success_rate != r.success_rate ? l.success_rate > r.success_rate : l.latency_ms < r.latency_ms;
     });
-    if (responses.empty()) {
+
+    std::vector<size_t> order;
+    order.reserve(health_.size());
+    order.insert(std::end(order), std::begin(healthy), std::end(healthy));
+    order.insert(std::end(order), std::begin(unhealthy), std::end(unhealthy));
+
+    // Probe the best ranked unhealthy client that ranks better than the chosen client, if it is due
+    auto now = std::chrono::steady_clock::now();
+    for (size_t index = 0; !order.empty() && index < order.front(); ++index) {
+        auto& health = health_[index];
+        if (!health.healthy(cfg_) && health.probe_at <= now) {
+            health.probe_at = now + std::chrono::milliseconds(cfg_.probe_ms);
+            order.erase(std::find(std::begin(order), std::end(order), index));
+            order.insert(std::begin(order), index);
+            return {order, true};
+        }
+    }
+
+    return {order, false};
+}
+
+void FailoverClientAPI::record(size_t index, bool success, std::chrono::steady_clock::duration latency,
+                               bool probe) const {
+    std::scoped_lock lock(lock_);
+    auto& health = health_[index];
+
+    bool was_healthy = health.healthy(cfg_);
+    double elapsed   = std::chrono::duration<double, std::milli>(latency).count();
+
+    // A successful probe restores the client, regardless of its past failures
+    health.success_rate = (probe && success) ? 1.0 : (1 - Smoothing) * health.success_rate + Smoothing * success;
+    health.latency_ms   = (probe && success) ? elapsed : (1 - Smoothing) * health.latency_ms + Smoothing * elapsed;
+
+    if (bool is_healthy = health.healthy(cfg_); is_healthy != was_healthy) {
+        if (is_healthy) {
+            Log::info() << "Client #" << index << " is healthy again" << std::endl;
+        }
+        else {
+            Log::warning() << "Client #" << index << " is unhealthy (success rate: " << health.success_rate
+                           << ", latency: " << health.latency_ms << "ms), failing over to other clients" << std::endl;
+            health.probe_at = std::chrono::steady_clock::now() + std::chrono::milliseconds(cfg_.probe_ms);
+        }
+    }
+}
+
+Response FailoverClientAPI::process(const Request& request) const {
+    if (apis_.empty()) {
         throw std::runtime_error("No Responses available");
     }
-    return responses.back();  // TODO: What should happen in this case?!
+
+    auto [order, probing] = candidates();
+
+    std::exception_ptr error;
+    std::optional<Response> dropped;
+    for (size_t index : order) {
+        bool probe = probing && index == order.front();
+
+        auto start = std::chrono::steady_clock::now();
+        try {
+            Response response = apis_[index]->process(request);
+            bool success      = response.outcome != Response::Outcome::Dropped;
+            record(index, success, std::chrono::steady_clock::now() - start, probe);
+            if (success) {
+                return response;
+            }
+            Log::warning() << "Request dropped by client #" << index << ", trying next client" << std::endl;
+            if (!dropped) {
+                dropped = std::move(response);
+            }
+        }
+        catch (const DeadlineExceeded&) {
+            // Notice: once the caller's deadline is reached, other clients are not tried (nor penalised)
+            if (Deadline::expired()) {
+                throw;
+            }
+            record(index, false, std::chrono::steady_clock::now() - start, probe);
+            error = error ? error : std::current_exception();
+        }
+        catch (const std::exception& e) {
+            record(index, false, std::chrono::steady_clock::now() - start, probe);
+            Log::warning() << "Unable to process request by client #" << index << ", due to: " << e.what()
+                           << ", trying next client" << std::endl;
+            error = error ? error : std::current_exception();
+        }
+
+        Deadline::check("failing over to next client");
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return dropped.value();
+}
+
+// *** Client (Balancing) ******************************************************
+// *****************************************************************************
+
+namespace {
+
+/**
+ * Split the endpoint into host and port, using the default port when none is given (e.g. "host", "host:port",
+ * "[::1]:port")
+ */
+std::pair<std::string, std::string> split_endpoint(const std::string& endpoint, const std::string& default_port) {
+    if (!endpoint.empty() && endpoint.front() == '[') {
+        auto closing = endpoint.find(']');
+        if (closing == std::string::npos) {
+            ECFLOW_LIGHT_THROW(BadValue, Message("Invalid endpoint '", endpoint, "'. Expected '[address]:port'"));
+        }
+        auto host = endpoint.substr(1, closing - 1);
+        if (closing + 1 < endpoint.size() && endpoint[closing + 1] == ':') {
+            return {host, endpoint.substr(closing + 2)};
+        }
+        return {host, default_port};
+    }
+    // Notice: an endpoint with several ':' is an IPv6 address without port
+    if (auto colon = endpoint.find(':'); colon != std::string::npos && colon == endpoint.rfind(':')) {
+        return {endpoint.substr(0, colon), endpoint.substr(colon + 1)};
+    }
+    return {endpoint, default_port};
+}
+
+std::vector<std::string> resolve_all(const std::string& host, const std::string& port, const std::string& protocol) {
+    addrinfo hints{};
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = protocol == ClientCfg::ProtocolUDP ? SOCK_DGRAM : SOCK_STREAM;
+
+    addrinfo* addresses = nullptr;
+    if (int error = ::getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses); error != 0) {
+        ECFLOW_LIGHT_THROW(BadValue,
+                           Message("Unable to resolve '", host, ":", port, "', due to: ", ::gai_strerror(error)));
+    }
+
+    std::vector<std::string> resolved;
+    for (auto* address = addresses; address != nullptr; address = address->ai_next) {
+        char name[NI_MAXHOST];
+        if (::getnameinfo(address->ai_addr, address->ai_addrlen, name, sizeof(name), nullptr, 0, NI_NUMERICHOST) ==
+            0) {
+            if (std::find(std::begin(resolved), std::end(resolved), name) == std::end(resolved)) {
+                resolved.emplace_back(name);
+            }
+        }
+    }
+    ::freeaddrinfo(addresses);
+    return resolved;
+}
+
+uint64_t fnv1a(std::string_view text) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : text) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t mix(uint64_t value) {
+    // Notice: finalizer of splitmix64, so that similar names produce unrelated scores
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+}  // namespace
+
+BalancingClientAPI::BalancingClientAPI(const ClientCfg& cfg) :
+    eject_failures_{cfg.eject_failures},
+    eject_cooloff_{std::chrono::milliseconds(cfg.eject_ms)},
+    lock_{},
+    endpoints_{} {}
+
+std::vector<ClientCfg> BalancingClientAPI::endpoints_of(const ClientCfg& cfg) {
+    std::vector<std::pair<std::string, std::string>> hosts;
+    if (cfg.endpoints.empty()) {
+        hosts.emplace_back(cfg.host, cfg.port);
+    }
+    for (const auto& endpoint : cfg.endpoints) {
+        hosts.push_back(split_endpoint(endpoint, cfg.port));
+    }
+
+    std::vector<ClientCfg> expanded;
+    for (const auto& [host, port] : hosts) {
+        std::vector<std::string> addresses{host};
+        if (cfg.resolve_all) {
+            addresses = resolve_all(host, port, cfg.protocol);
+        }
+        for (const auto& address : addresses) {
+            ClientCfg endpoint = cfg;
+            // Notice: IPv6 addresses must be enclosed in brackets, when used in a URL
+            bool is_ipv6  = address.find(':') != std::string::npos && address.front() != '[';
+            bool bracket  = cfg.protocol == ClientCfg::ProtocolHTTP && is_ipv6;
+            endpoint.host = bracket ? "[" + address + "]" : address;
+            endpoint.port = port;
+            endpoint.endpoints.clear();
+            endpoint.resolve_all = false;
+            expanded.push_back(std::move(endpoint));
+        }
+    }
+    return expanded;
+}
+
+uint64_t BalancingClientAPI::score(std::string_view task, std::string_view endpoint) {
+    return mix(fnv1a(task) ^ mix(fnv1a(endpoint)));
+}
+
+void BalancingClientAPI::add(std::string endpoint, std::unique_ptr<ClientAPI>&& api) {
+    std::scoped_lock lock(lock_);
+    auto hash = mix(fnv1a(endpoint));
+    endpoints_.push_back(Endpoint{std::move(endpoint), hash, std::move(api), 0, std::nullopt});
+}
+
+std::vector<std::string> BalancingClientAPI::ejected() const {
+    std::scoped_lock lock(lock_);
+    std::vector<std::string> ejected;
+    for (const auto& endpoint : endpoints_) {
+        if (endpoint.ejected_until) {
+            ejected.push_back(endpoint.name);
+        }
+    }
+    return ejected;
+}
+
+std::vector<size_t> BalancingClientAPI::candidates(std::string_view task) const {
+    std::scoped_lock lock(lock_);
+
+    auto task_hash = fnv1a(task);
+    std::vector<std::pair<uint64_t, size_t>> scores;
+    scores.reserve(endpoints_.size());
+    for (size_t index = 0; index < endpoints_.size(); ++index) {
+        scores.emplace_back(mix(task_hash ^ endpoints_[index].hash), index);
+    }
+    std::sort(std::begin(scores), std::end(scores), std::greater<>{});
+
+    // Available endpoints (including those ejected, but due to be tried again) come first, in order of score
+    auto now = std::chrono::steady_clock::now();
+    std::vector<size_t> available;
+    std::vector<size_t> ejected;
+    for (const auto& [score, index] : scores) {
+        const auto& until = endpoints_[index].ejected_until;
+        (!until || *until <= now ? available : ejected).push_back(index);
+    }
+    available.insert(std::end(available), std::begin(ejected), std::end(ejected));
+    return available;
+}
+
+void BalancingClientAPI::record(size_t index, bool success) const {
+    std::scoped_lock lock(lock_);
+    auto& endpoint = endpoints_[index];
+
+    if (success) {
+        if (endpoint.ejected_until) {
+            Log::info() << "Endpoint '" << endpoint.name << "' recovered, bringing it back" << std::endl;
+        }
+        endpoint.failures      = 0;
+        endpoint.ejected_until = std::nullopt;
+        return;
+    }
+
+    endpoint.failures += 1;
+    if (eject_failures_ > 0 && endpoint.failures >= eject_failures_) {
+        if (!endpoint.ejected_until) {
+            Log::warning() << "Endpoint '" << endpoint.name << "' ejected, after " << endpoint.failures
+                           << " consecutive failures" << std::endl;
+        }
+        endpoint.ejected_until = std::chrono::steady_clock::now() + eject_cooloff_;
+    }
+}
+
+Response BalancingClientAPI::process(const Request& request) const {
+    if (endpoints_.empty()) {
+        throw std::runtime_error("No Responses available");
+    }
+
+    if (endpoints_.size() == 1) {
+        return endpoints_.front().api->process(request);
+    }
+
+    std::exception_ptr error;
+    std::optional<Response> dropped;
+    for (size_t index : candidates(request.context().name())) {
+        const auto& endpoint = endpoints_[index];
+        try {
+            Response response = endpoint.api->process(request);
+            bool success      = response.outcome != Response::Outcome::Dropped;
+            record(index, success);
+            if (success) {
+                return response;
+            }
+            Log::warning() << "Request dropped by endpoint '" << endpoint.name << "', trying next endpoint"
+                           << std::endl;
+            if (!dropped) {
+                dropped = std::move(response);
+            }
+        }
+        catch (const DeadlineExceeded&) {
+            // Notice: once the caller's deadline is reached, other endpoints are not tried (nor penalised)
+            if (Deadline::expired()) {
+                throw;
+            }
+            record(index, false);
+            error = error ? error : std::current_exception();
+        }
+        catch (const std::exception& e) {
+            record(index, false);
+            Log::warning() << "Unable to process request by endpoint '" << endpoint.name << "', due to: " << e.what()
+                           << ", trying next endpoint" << std::endl;
+            error = error ? error : std::current_exception();
+        }
+
+        Deadline::check("trying next endpoint");
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return dropped.value();
+}
+
+// *** Client (Coalescing) *****************************************************
+// *****************************************************************************
+
+namespace {
+
+/**
+ * Determines if a request can be coalesced, and if so collects the key and the contents of each of its updates
+ */
+struct CoalescingKey : public RequestDispatcher {
+    void dispatch_request(const UpdateNodeStatus& request [[maybe_unused]]) override { barrier = true; }
+
+    void dispatch_request(const UpdateNodeAttribute& request) override {
+        collect(request.shared_context(), request.options());
+    }
+
+    void dispatch_request(const UpdateNodeAttributes& request) override {
+        for (const auto& attribute : request.attributes()) {
+            collect(request.shared_context(), attribute);
+        }
+    }
+
+    void collect(const std::shared_ptr<const TaskContext>& context, const Options& options) {
+        auto command = options.get(Field::Command);
+        if (command == "meter" || command == "label" || command == "event") {
+            auto key = stringify(context->name(), ":", command, ":", options.get(Field::Name));
+            entries.emplace_back(std::move(key), UpdateNodeAttribute{context, options});
+        }
+        else {
+            barrier = true;
+        }
+    }
+
+    bool barrier = false;
+    std::vector<std::pair<std::string, UpdateNodeAttribute>> entries;
+};
+
+/**
+ * Creates a single request for all updates in the given range, assuming that all refer to the same node
+ */
+template <typename Iterator>
+Request make_batch(Iterator first, Iterator last) {
+    if (std::distance(first, last) == 1) {
+        return Request::make_request<UpdateNodeAttribute>(*first);
+    }
+
+    UpdateNodeAttributes::attributes_t attributes;
+    for (auto current = first; current != last; ++current) {
+        attributes.push_back(current->options());
+    }
+    return Request::make_request<UpdateNodeAttributes>(first->shared_context(), std::move(attributes));
+}
+
+}  // namespace
+
+CoalescingClientAPI::CoalescingClientAPI(const CoalescingCfg& cfg, const ClientAPI& target) :
+    cfg_{cfg},
+    target_{target},
+    dispatch_lock_{},
+    lock_{},
+    wakeup_{},
+    pending_{},
+    index_{},
+    deadline_{},
+    stopping_{false},
+    flusher_{} {
+    flusher_ = std::thread([this]() { run(); });
+}
+
+CoalescingClientAPI::~CoalescingClientAPI() {
+    {
+        std::scoped_lock lock(lock_);
+        stopping_ = true;
+        wakeup_.notify_all();
+    }
+    if (flusher_.joinable()) {
+        flusher_.join();
+    }
+    flush();
+}
+
+Response CoalescingClientAPI::process(const Request& request) const {
+    CoalescingKey key;
+    request.dispatch(key);
+
+    if (key.barrier) {
+        // Barrier: all pending updates are forwarded before the request itself
+        std::scoped_lock dispatch_lock(dispatch_lock_);
+        flush_pending();
+        return target_.process(request);
+    }
+
+    std::scoped_lock lock(lock_);
+    for (auto& [name, update] : key.entries) {
+        if (auto found = index_.find(name); found != std::end(index_)) {
+            // Last write wins, while keeping the position of the first update
+            pending_[found->second] = std::move(update);
+        }
+        else {
+            index_.emplace(std::move(name), pending_.size());
+            pending_.push_back(std::move(update));
+        }
+    }
+
+    if (!deadline_) {
+        deadline_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(cfg_.window_ms);
+        wakeup_.notify_one();
+    }
+
+    return Response{"OK"};
+}
+
+void CoalescingClientAPI::flush() const {
+    std::scoped_lock dispatch_lock(dispatch_lock_);
+    flush_pending();
+}
+
+void CoalescingClientAPI::run() const {
+    std::unique_lock lock(lock_);
+    while (!stopping_) {
+        if (!deadline_) {
+            wakeup_.wait(lock);
+            continue;
+        }
+
+        if (auto deadline = deadline_.value(); std::chrono::steady_clock::now() < deadline) {
+            wakeup_.wait_until(lock, deadline);
+            continue;
+        }
+
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+void CoalescingClientAPI::flush_pending() const {
+    std::vector<UpdateNodeAttribute> survivors;
+    {
+        std::scoped_lock lock(lock_);
+        survivors.swap(pending_);
+        index_.clear();
+        deadline_.reset();
+    }
+
+    // Survivors are forwarded together, as a single batch for each node
+    for (auto first = std::begin(survivors); first != std::end(survivors); /* ... */) {
+        const auto& path = first->context().name();
+        auto last        = std::find_if(first, std::end(survivors), [&path](const UpdateNodeAttribute& update) {
+            return update.context().name() != path;
+        });
+
+        try {
+            Response response = target_.process(make_batch(first, last));
+            if (debug_enabled()) {
+                Log::debug() << "Response: " << response << std::endl;
+            }
+        }
+        catch (eckit::Exception& e) {
+            Log::error() << "Error detected: " << e.what() << std::endl;
+        }
+        catch (...) {
+            Log::error() << "Unknown error detected" << std::endl;
+        }
+
+        first = last;
+    }
+}
+
+// *** Client (Spooling) *******************************************************
+// *****************************************************************************
+
+namespace {
+
+/**
+ * Forwards the request to the target
+ *
+ * @return the response; or nothing, if the request could not be delivered (and thus can be sent again later).
+ *         Any other error is propagated to the caller.
+ */
+std::optional<Response> deliver(const ClientAPI& target, const Request& request) {
+    auto undelivered = [](std::string_view reason) {
+        Log::warning() << "Unable to deliver request, due to: " << reason << std::endl;
+        return std::nullopt;
+    };
+
+    try {
+        Response response = target.process(request);
+        if (response.outcome == Response::Outcome::Dropped) {
+            return undelivered("datagram dropped");
+        }
+        return response;
+    }
+    catch (const UnreachableServer& e) {
+        return undelivered(e.what());
+    }
+    catch (const net::UDPSocketError& e) {
+        return undelivered(e.what());
+    }
+    catch (const UnableToSpawnProcess& e) {
+        return undelivered(e.what());
+    }
+    catch (const DeadlineExceeded& e) {
+        return undelivered(e.what());
+    }
+}
+
+}  // namespace
+
+SpoolingClientAPI::SpoolingClientAPI(const SpoolCfg& cfg, std::unique_ptr<SpoolJournal> journal,
+                                     const ClientAPI& target) :
+    cfg_{cfg},
+    target_{target},
+    replay_lock_{},
+    delivery_lock_{},
+    lock_{},
+    wakeup_{},
+    journal_{std::move(journal)},
+    stopping_{false},
+    replayer_{} {
+    replayer_ = std::thread([this]() { run(); });
+}
+
+SpoolingClientAPI::~SpoolingClientAPI() {
+    {
+        std::scoped_lock lock(lock_);
+        stopping_ = true;
+        wakeup_.notify_all();
+    }
+    if (replayer_.joinable()) {
+        replayer_.join();
+    }
+    // Notice: any updates still pending are kept in the journal, and replayed by the next process of the task
+    if (!replay()) {
+        Log::warning() << "Spool '" << journal_->path().string() << "' holds pending updates, kept for later"
+                       << std::endl;
+    }
+}
+
+Response SpoolingClientAPI::process(const Request& request) const {
+    auto entries = SpoolEntry::entries_of(request);
+    if (!entries) {
+        return target_.process(request);
+    }
+
+    // Notice: checking the journal, delivering and spooling happen as a whole, otherwise a newer update could be
+    //         delivered while an older one (whose delivery failed) is still to be spooled, and later replayed over it
+    std::scoped_lock delivery_lock(delivery_lock_);
+    {
+        std::scoped_lock lock(lock_);
+        if (!journal_->empty()) {
+            // Notice: while older updates are pending, newer updates are spooled behind them to preserve the order
+            spool(entries.value());
+            return Response{"SPOOLED", Response::Outcome::Spooled};
+        }
+    }
+
+    if (auto response = deliver(target_, request); response) {
+        return response.value();
+    }
+
+    std::scoped_lock lock(lock_);
+    spool(entries.value());
+    return Response{"SPOOLED", Response::Outcome::Spooled};
+}
+
+bool SpoolingClientAPI::replay() const {
+    std::scoped_lock replay_lock(replay_lock_);
+
+    std::vector<SpoolJournal::Record> records;
+    {
+        std::scoped_lock lock(lock_);
+        records = journal_->pending();
+    }
+
+    auto forward = [this](const Request& request) {
+        try {
+            return deliver(target_, request).has_value();
+        }
+        catch (const eckit::Exception& e) {
+            // Notice: an update rejected for any other reason is discarded, as sending it again would not succeed
+            Log::error() << "Discarding spooled update, due to: " << e.what() << std::endl;
+            return true;
+        }
+    };
+
+    auto mark = [this](uint64_t sequence) {
+        std::scoped_lock lock(lock_);
+        journal_->mark_replayed(sequence);
+    };
+
+    // Attribute updates between status updates are compacted, keeping only the newest value of each attribute
+    std::vector<UpdateNodeAttribute> survivors;
+    std::unordered_map<std::string, size_t> index;
+
+    auto flush = [&survivors, &index, &forward]() {
+        for (auto first = std::begin(survivors); first != std::end(survivors); /* ... */) {
+            const auto& path = first->context().name();
+            auto last = std::find_if(first, std::end(survivors), [&path](const UpdateNodeAttribute& update) {
+                return update.context().name() != path;
+            });
+            if (!forward(make_batch(first, last))) {
+                return false;
+            }
+            first = last;
+        }
+        survivors.clear();
+        index.clear();
+        return true;
+    };
+
+    uint64_t covered = 0;
+    for (const auto& record : records) {
+        covered = record.sequence;
+
+        SpoolEntry entry;
+        try {
+            entry = SpoolEntry::decode(record.sequence, record.payload);
+        }
+        catch (const InvalidSpoolEntry& e) {
+            Log::error() << "Discarding spooled update #" << record.sequence << ", due to: " << e.what()
+                         << std::endl;
+            continue;
+        }
+
+        if (entry.kind == SpoolEntry::Kind::Status) {
+            if (!flush() || !forward(Request::make_request<UpdateNodeStatus>(entry.context, entry.options))) {
+                return false;
+            }
+            mark(record.sequence);
+            continue;
+        }
+
+        auto key = entry.key();
+        if (auto found = index.find(key); found != std::end(index)) {
+            survivors[found->second] = UpdateNodeAttribute{entry.context, entry.options};
+        }
+        else {
+            index.emplace(std::move(key), survivors.size());
+            survivors.emplace_back(entry.context, entry.options);
+        }
+    }
+
+    if (!flush()) {
+        return false;
+    }
+    if (covered > 0) {
+        mark(covered);
+        Log::info() << "Replayed " << records.size() << " spooled update(s)" << std::endl;
+    }
+    return true;
+}
+
+bool SpoolingClientAPI::empty() const {
+    std::scoped_lock lock(lock_);
+    return journal_->empty();
+}
+
+void SpoolingClientAPI::run() const {
+    std::unique_lock lock(lock_);
+    while (!stopping_) {
+        if (journal_->empty()) {
+            wakeup_.wait(lock);
+            continue;
+        }
+
+        lock.unlock();
+        bool replayed = replay();
+        lock.lock();
+
+        if (!replayed) {
+            // Notice: newly spooled updates do not trigger a replay, until the retry period expires
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(cfg_.retry_ms);
+            wakeup_.wait_until(lock, deadline, [this]() { return stopping_; });
+        }
+    }
+}
+
+void SpoolingClientAPI::spool(const std::vector<SpoolEntry>& entries) const {
+    std::string payload;
+    for (const auto& entry : entries) {
+        payload.clear();
+        entry.encode(payload);
+        journal_->append(payload);
+    }
+    wakeup_.notify_one();
 }
 
 // *** Configured Client *******************************************************
 // *****************************************************************************
 
-ConfiguredClient::ConfiguredClient() : clients_{}, lock_{} {
-    Configuration cfg = Configuration::make_cfg();
+namespace {
 
-    const Environment& environment = Environment::environment();
+/**
+ * Create the client, spreading the requests among its endpoints when more than one is configured
+ */
+template <typename API>
+std::unique_ptr<ClientAPI> make_client(const ClientCfg& client, const Environment& environment) {
+    auto endpoints = BalancingClientAPI::endpoints_of(client);
+    if (endpoints.size() == 1) {
+        return std::make_unique<API>(endpoints.front(), environment);
+    }
 
+    auto balancing = std::make_unique<BalancingClientAPI>(client);
+    for (const auto& endpoint : endpoints) {
+        Log::debug() << "Endpoint '" << endpoint.host << ":" << endpoint.port << "' registered" << std::endl;
+        balancing->add(endpoint.host + ":" + endpoint.port, std::make_unique<API>(endpoint, environment));
+    }
+    return balancing;
+}
+
+template <typename Router>
+std::unique_ptr<const ClientAPI> make_router(std::unique_ptr<Router> router, const Configuration& cfg,
+                                             const Environment& environment, bool await_outcome) {
     // Setup configured API based on the configuration
     if (cfg.clients.empty()) {
         Log::warning() << "No Clients registered";
     }
     else {
-        for (const auto& client : cfg.clients) {
+        for (ClientCfg client : cfg.clients) {
+            client.await_outcome = await_outcome;
             if (client.kind == ClientCfg::KindLibrary && client.protocol == ClientCfg::ProtocolUDP) {
                 Log::debug() << "Library (UDP) Client registered" << std::endl;
-                clients_.add(std::make_unique<LibraryUDPClientAPI>(client, environment));
+                router->add(make_client<LibraryUDPClientAPI>(client, environment));
             }
             else if (client.kind == ClientCfg::KindLibrary && client.protocol == ClientCfg::ProtocolHTTP) {
                 Log::debug() << "Library (HTTP) Client registered" << std::endl;
-                clients_.add(std::make_unique<LibraryHTTPClientAPI>(client, environment));
+                router->add(make_client<LibraryHTTPClientAPI>(client, environment));
             }
             else if (client.kind == ClientCfg::KindCLI && client.protocol == ClientCfg::ProtocolTCP) {
                 Log::debug() << "CLI (TCP) Client registered" << std::endl;
-                clients_.add(std::make_unique<CommandLineTCPClientAPI>(client, environment));
+                router->add(std::make_unique<CommandLineTCPClientAPI>(client, environment));
             }
             else if (client.kind == ClientCfg::KindPhony && client.protocol == ClientCfg::ProtocolNone) {
                 Log::debug() << "(Phony) Client registered" << std::endl;
-                clients_.add(std::make_unique<PhonyClientAPI>());
+                router->add(std::make_unique<PhonyClientAPI>());
             }
             else {
                 Log::error() << "Invalid client '" << client.kind << "' detected, using protocol '" << client.protocol
@@ -87,11 +1067,88 @@ ConfiguredClient::ConfiguredClient() : clients_{}, lock_{} {
             }
         }
     }
+    return router;
+}
+
+}  // namespace
+
+ConfiguredClient::ConfiguredClient() :
+    cfg_{Configuration::make_cfg()}, trace_{}, clients_{}, spooling_{}, coalescing_{}, tracks_outcome_{false} {
+    const Configuration& cfg = cfg_;
+
+    const Environment& environment = Environment::environment();
+
+    // Notice: the context of the current task is created before the clients, and thus outlives any update
+    //         flushed (or replayed) by the clients at exit
+    TaskContext::current();
+
+    if (cfg.trace.enabled()) {
+        trace_ = std::make_unique<TraceBuffer>(cfg.trace.capacity, cfg.trace.path);
+        TraceBuffer::install(trace_.get());
+    }
+
+    std::unique_ptr<SpoolJournal> journal;
+    if (cfg.spool.enabled()) {
+        if (auto task = environment.get_optional("ECF_NAME"); task) {
+            try {
+                auto path = SpoolJournal::path_of(cfg.spool.directory, task->value);
+                journal   = std::make_unique<SpoolJournal>(path, cfg.spool.capacity);
+                Log::debug() << "Spool enabled, using '" << path.string() << "'" << std::endl;
+            }
+            catch (const UnableToOpenSpool& e) {
+                Log::error() << "Spool disabled, due to: " << e.what() << std::endl;
+            }
+        }
+        else {
+            Log::warning() << "Spool disabled, as 'ECF_NAME' is not defined" << std::endl;
+        }
+    }
+
+    // Notice: when the outcome of each request is acted upon, the clients await every request (even if pipelined)
+    bool await_outcome = journal != nullptr || cfg.routing.mode == RoutingCfg::ModeFailover ||
+                         std::any_of(std::begin(cfg.clients), std::end(cfg.clients), [](const ClientCfg& client) {
+                             return !client.endpoints.empty() || client.resolve_all;
+                         });
+
+    if (cfg.routing.mode == RoutingCfg::ModeFailover) {
+        Log::debug() << "Failover routing enabled, probing unhealthy clients every " << cfg.routing.probe_ms << "ms"
+                     << std::endl;
+        clients_ = make_router(std::make_unique<FailoverClientAPI>(cfg.routing), cfg, environment, await_outcome);
+    }
+    else {
+        auto router = std::make_unique<CompositeClientAPI>(cfg.fanout.completion);
+        clients_    = make_router(std::move(router), cfg, environment, await_outcome);
+    }
+
+    if (journal) {
+        spooling_ = std::make_unique<SpoolingClientAPI>(cfg.spool, std::move(journal), *clients_);
+    }
+
+    tracks_outcome_ = await_outcome ||
+                      std::any_of(std::begin(cfg.clients), std::end(cfg.clients), [](const ClientCfg& client) {
+                          return client.protocol == ClientCfg::ProtocolHTTP && client.max_in_flight > 1;
+                      });
+
+    if (cfg.coalescing.enabled()) {
+        Log::debug() << "Coalescing enabled, using window of " << cfg.coalescing.window_ms << "ms" << std::endl;
+        coalescing_ = std::make_unique<CoalescingClientAPI>(cfg.coalescing, target());
+    }
 }
 
 Response ConfiguredClient::process(const Request& request) const {
-    std::scoped_lock lock(lock_);
-    return clients_.process(request);
+    if (coalescing_) {
+        // All requests are forwarded through the coalescing stage, which serialises the access to the clients
+        return coalescing_->process(request);
+    }
+
+    return target().process(request);
+}
+
+const ClientAPI& ConfiguredClient::target() const {
+    if (spooling_) {
+        return *spooling_;
+    }
+    return *clients_;
 }
 
 }  // namespace ecflow::light
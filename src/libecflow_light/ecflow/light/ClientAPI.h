@@ -11,21 +11,31 @@
 #ifndef ECFLOW_LIGHT_CLIENTAPI_H
 #define ECFLOW_LIGHT_CLIENTAPI_H
 
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <regex>
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <eckit/exception/Exceptions.h>
 
 #include "ecflow/light/Configuration.h"
+#include "ecflow/light/Deadline.h"
 #include "ecflow/light/Exception.h"
 #include "ecflow/light/Log.h"
 #include "ecflow/light/Requests.h"
 #include "ecflow/light/Dispatcher.h"
+#include "ecflow/light/Spool.h"
+#include "ecflow/light/TraceBuffer.h"
 
 namespace ecflow::light {
 
@@ -52,16 +62,252 @@ public:
 // *** Client (Composite) **********************************************************
 // *****************************************************************************
 
+/**
+ * CompositeClientAPI fans out each request to all registered clients.
+ *
+ * The first (i.e. primary) client processes the request on the caller thread, while each of the other (i.e.
+ * secondary) clients is served by a dedicated worker, so that all clients process the request concurrently and
+ * each client still receives the requests in the order they were issued.
+ *
+ * The completion policy determines when the request is considered processed:
+ *  - wait-all, waits for all clients to finish
+ *  - first-success, waits until any client succeeds (or all clients have failed)
+ *  - fire-and-forget, waits only for the primary client
+ *
+ * The resulting response is the response of the first successful client (in configuration order) among those
+ * that finished; when no client succeeded, the error of the first failing client is rethrown.
+ *
+ * The deadline of the caller (if any) applies to all clients, and bounds the wait for the secondary clients; when
+ * no client succeeded and some are still processing the request at the deadline, DeadlineExceeded is thrown.
+ */
 class CompositeClientAPI : public ClientAPI {
 public:
-    ~CompositeClientAPI() override = default;
+    explicit CompositeClientAPI(std::string completion = FanOutCfg::CompletionWaitAll);
+    ~CompositeClientAPI() override;
+
+    // CompositeClientAPI object cannot be copied!
+    CompositeClientAPI(const CompositeClientAPI&)            = delete;
+    CompositeClientAPI& operator=(const CompositeClientAPI&) = delete;
+
+    void add(std::unique_ptr<ClientAPI>&& api);
+
+    [[nodiscard]] Response process(const Request& request) const override;
+
+private:
+    class Worker;
+
+    std::string completion_;
+    std::vector<std::unique_ptr<ClientAPI>> apis_;
+    // Notice: workers_[i] serves apis_[i + 1], and (being declared last) are stopped before the clients are destroyed
+    std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+// *** Client (Failover) *******************************************************
+// *****************************************************************************
+
+/**
+ * FailoverClientAPI sends each request to a single client, chosen according to the rank (i.e. the order of
+ * registration) and the health of the registered clients, and falls back to the other clients only on failure.
+ *
+ * The success rate and the latency of each client are tracked as exponentially weighted moving averages. A client is
+ * healthy while its success rate is at least 50% and (when 'slow_ms' is given) its latency is below 'slow_ms'.
+ * Requests are sent to the best ranked healthy client; when none is healthy, to the client with the highest success
+ * rate (and then the lowest latency). When the chosen client fails (including exceeding its timeout), or drops the
+ * request, the remaining clients are tried in the same order.
+ *
+ * An unhealthy client that ranks better than the chosen client is probed every 'probe_ms': the next request is sent
+ * to it first, and a successful probe restores its health.
+ */
+class FailoverClientAPI : public ClientAPI {
+public:
+    struct Health {
+        double success_rate = 1.0;
+        double latency_ms   = 0.0;
+        std::chrono::steady_clock::time_point probe_at{};
+
+        [[nodiscard]] bool healthy(const RoutingCfg& cfg) const {
+            return success_rate >= 0.5 && (cfg.slow_ms == 0 || latency_ms <= cfg.slow_ms);
+        }
+    };
+
+    // Weight of the latest outcome, in the moving averages of the success rate and latency
+    static constexpr double Smoothing = 0.3;
+
+    explicit FailoverClientAPI(const RoutingCfg& cfg);
 
     void add(std::unique_ptr<ClientAPI>&& api);
 
     [[nodiscard]] Response process(const Request& request) const override;
 
+    /**
+     * @return the health of each client, in order of registration
+     */
+    [[nodiscard]] std::vector<Health> health() const;
+
 private:
+    /**
+     * @return the indices of the clients, in the order these should be tried; and whether the first is a probe
+     */
+    std::pair<std::vector<size_t>, bool> candidates() const;
+    void record(size_t index, bool success, std::chrono::steady_clock::duration latency, bool probe) const;
+
+    RoutingCfg cfg_;
     std::vector<std::unique_ptr<ClientAPI>> apis_;
+
+    mutable std::mutex lock_;
+    mutable std::vector<Health> health_;
+};
+
+// *** Client (Balancing) ******************************************************
+// *****************************************************************************
+
+/**
+ * BalancingClientAPI spreads the requests among several clients, each connected to a different endpoint.
+ *
+ * The endpoint of each request is chosen by rendezvous hashing of the task name (i.e. ECF_NAME), so that all
+ * requests of the same task are sent to the same endpoint (and thus remain ordered), and only the tasks assigned
+ * to an endpoint are moved when that endpoint becomes unavailable.
+ *
+ * An endpoint is ejected after 'eject_failures' consecutive failures (or dropped requests), and the requests are
+ * then sent to the next endpoint of each task. After 'eject_ms' the ejected endpoint is tried again, and is
+ * brought back by the first successful request. When all endpoints are ejected, these are still tried in order.
+ */
+class BalancingClientAPI : public ClientAPI {
+public:
+    explicit BalancingClientAPI(const ClientCfg& cfg);
+
+    /**
+     * Expand the configuration into one configuration per endpoint, considering the alternative endpoints and
+     * (optionally) all resolved addresses of each host.
+     *
+     * @return the configuration of each endpoint; or the given configuration, if it has a single endpoint
+     */
+    static std::vector<ClientCfg> endpoints_of(const ClientCfg& cfg);
+
+    /**
+     * Calculate the (stable) score of the endpoint for the given task; the endpoint with highest score is preferred
+     */
+    static uint64_t score(std::string_view task, std::string_view endpoint);
+
+    void add(std::string endpoint, std::unique_ptr<ClientAPI>&& api);
+
+    [[nodiscard]] Response process(const Request& request) const override;
+
+    /**
+     * @return the endpoints currently ejected, in order of registration
+     */
+    [[nodiscard]] std::vector<std::string> ejected() const;
+
+private:
+    struct Endpoint {
+        std::string name;
+        uint64_t hash;
+        std::unique_ptr<ClientAPI> api;
+        // Notice: the following are guarded by the lock
+        size_t failures;
+        std::optional<std::chrono::steady_clock::time_point> ejected_until;
+    };
+
+    std::vector<size_t> candidates(std::string_view task) const;
+    void record(size_t index, bool success) const;
+
+    size_t eject_failures_;
+    std::chrono::milliseconds eject_cooloff_;
+
+    mutable std::mutex lock_;
+    mutable std::vector<Endpoint> endpoints_;
+};
+
+// *** Client (Coalescing) *****************************************************
+// *****************************************************************************
+
+/**
+ * CoalescingClientAPI holds meter, label and event updates during a configurable window, keeping only the newest
+ * value for each (ECF_NAME, attribute kind, attribute name), and then forwards the surviving updates together.
+ *
+ * Any other request (e.g. UpdateNodeStatus, or queue commands) acts as a barrier: all pending updates are
+ * forwarded before the request itself, so that the order observed by the server is preserved.
+ */
+class CoalescingClientAPI : public ClientAPI {
+public:
+    CoalescingClientAPI(const CoalescingCfg& cfg, const ClientAPI& target);
+    ~CoalescingClientAPI() override;
+
+    [[nodiscard]] Response process(const Request& request) const override;
+
+    /**
+     * Forward all pending updates to the target, regardless of the coalescing window
+     */
+    void flush() const;
+
+private:
+    void run() const;
+    void flush_pending() const;
+
+    CoalescingCfg cfg_;
+    const ClientAPI& target_;
+
+    // Notice: the dispatch lock serialises the access to the target and, when both locks are required,
+    //         must always be acquired before the lock protecting the pending updates
+    mutable std::mutex dispatch_lock_;
+    mutable std::mutex lock_;
+    mutable std::condition_variable wakeup_;
+    mutable std::vector<UpdateNodeAttribute> pending_;
+    mutable std::unordered_map<std::string, size_t> index_;
+    mutable std::optional<std::chrono::steady_clock::time_point> deadline_;
+    mutable bool stopping_;
+
+    std::thread flusher_;
+};
+
+// *** Client (Spooling) *******************************************************
+// *****************************************************************************
+
+/**
+ * SpoolingClientAPI keeps the updates that could not be delivered (i.e. the server was unreachable, or the datagram
+ * was dropped) in a durable journal, and replays these in the background once the target is reachable again.
+ *
+ * While updates are pending in the journal, any new (spoolable) update is appended to the journal as well, so that
+ * the order observed by the server is preserved. Requests that cannot be spooled (e.g. queue commands, which
+ * require the server response) are always forwarded directly to the target.
+ *
+ * On replay, only the newest value of each meter, label and event is sent, while status updates (e.g. init,
+ * complete, abort) act as barriers and are sent in order.
+ */
+class SpoolingClientAPI : public ClientAPI {
+public:
+    SpoolingClientAPI(const SpoolCfg& cfg, std::unique_ptr<SpoolJournal> journal, const ClientAPI& target);
+    ~SpoolingClientAPI() override;
+
+    [[nodiscard]] Response process(const Request& request) const override;
+
+    /**
+     * Replay all pending updates to the target, stopping at the first update that cannot be delivered
+     *
+     * @return true, if no updates are pending
+     */
+    bool replay() const;
+
+    [[nodiscard]] bool empty() const;
+
+private:
+    void run() const;
+    void spool(const std::vector<SpoolEntry>& entries) const;
+
+    SpoolCfg cfg_;
+    const ClientAPI& target_;
+
+    // Notice: the replay lock serialises the replay of the journal, and the delivery lock serialises the direct
+    //         delivery of updates (so that an older update is never spooled after a newer one is delivered); when
+    //         also required, either must always be acquired before the lock protecting the journal
+    mutable std::mutex replay_lock_;
+    mutable std::mutex delivery_lock_;
+    mutable std::mutex lock_;
+    mutable std::condition_variable wakeup_;
+    std::unique_ptr<SpoolJournal> journal_;
+    mutable bool stopping_;
+
+    std::thread replayer_;
 };
 
 // *** Client (Common) *********************************************************
@@ -70,17 +316,58 @@ private:
 template <typename Dispatcher>
 class BaseClientAPI : public ClientAPI {
 public:
-    explicit BaseClientAPI(ClientCfg cfg, Environment env) : cfg{std::move(cfg)}, env{std::move(env)} {};
+    explicit BaseClientAPI(ClientCfg cfg, Environment env) :
+        cfg{std::move(cfg)}, env{std::move(env)}, transport{Dispatcher::make_transport(this->cfg)} {};
     ~BaseClientAPI() override = default;
 
     [[nodiscard]] Response process(const Request& request) const override {
-        Dispatcher dispatcher{cfg};
+        // Notice: the timeout of the client applies within the deadline (if any) of the caller
+        std::optional<Deadline::Scope> deadline;
+        if (cfg.timeout_ms > 0) {
+            deadline.emplace(std::chrono::milliseconds(cfg.timeout_ms));
+        }
+        Deadline::check("dispatching request");
+
+        Dispatcher dispatcher{cfg, transport};
+        if (TraceBuffer* trace = TraceBuffer::installed(); trace) {
+            return traced_dispatch(*trace, dispatcher, request);
+        }
         return dispatcher.call_dispatch(request);
     }
 
 private:
+    static Response traced_dispatch(TraceBuffer& trace, Dispatcher& dispatcher, const Request& request) {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+
+        TraceRecord record  = TraceRecord::make_record(request);
+        record.transport    = Dispatcher::Transport;
+        record.timestamp_us = duration_cast<microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+        auto start    = std::chrono::steady_clock::now();
+        auto complete = [&](TraceRecord::Outcome outcome) {
+            auto latency      = duration_cast<microseconds>(std::chrono::steady_clock::now() - start).count();
+            record.latency_us = static_cast<uint32_t>(latency);
+            record.bytes      = static_cast<uint32_t>(dispatcher.bytes());
+            record.outcome    = outcome;
+            trace.record(record);
+        };
+
+        try {
+            Response response = dispatcher.call_dispatch(request);
+            complete(TraceRecord::outcome_of(response));
+            return response;
+        }
+        catch (...) {
+            complete(TraceRecord::Outcome::Failed);
+            throw;
+        }
+    }
+
     ClientCfg cfg;
     Environment env;
+    // Notice: the transport (e.g. socket) is reused by all dispatchers created by this client
+    mutable typename Dispatcher::transport_t transport;
 };
 
 using LibraryHTTPClientAPI    = BaseClientAPI<HTTPDispatcher>;
@@ -90,6 +377,12 @@ using CommandLineTCPClientAPI = BaseClientAPI<CLIDispatcher>;
 // *** Configured Client *******************************************************
 // *****************************************************************************
 
+/**
+ * ConfiguredClient holds the clients setup according to the configuration.
+ *
+ * The configuration and the set of clients are never modified after construction, and each client (i.e. its
+ * transport) is thread-safe, so that requests issued concurrently by several threads are processed concurrently.
+ */
 class ConfiguredClient : public ClientAPI {
 public:
     static ConfiguredClient& instance() {
@@ -99,11 +392,28 @@ public:
 
     [[nodiscard]] Response process(const Request& request) const override;
 
+    [[nodiscard]] const Configuration& configuration() const { return cfg_; }
+
+    /**
+     * @return true, if the outcome of each request is acted upon (i.e. by the spool, the failover routing, or the
+     *         balancing among several endpoints) or reported asynchronously (i.e. by a pipelined HTTP client), and
+     *         thus datagrams must never be deferred
+     */
+    [[nodiscard]] bool tracks_outcome() const { return tracks_outcome_; }
+
 private:
     ConfiguredClient();
 
-    CompositeClientAPI clients_;
-    mutable std::mutex lock_;
+    [[nodiscard]] const ClientAPI& target() const;
+
+    const Configuration cfg_;
+    // Notice: the trace buffer is destroyed (and thus dumped) only after all clients are stopped
+    std::unique_ptr<TraceBuffer> trace_;
+    // Notice: either a CompositeClientAPI or a FailoverClientAPI, according to the routing mode
+    std::unique_ptr<const ClientAPI> clients_;
+    std::unique_ptr<const SpoolingClientAPI> spooling_;
+    std::unique_ptr<const CoalescingClientAPI> coalescing_;
+    bool tracks_outcome_;
 };
 
 }  // namespace ecflow::light
@@ -0,0 +1,256 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include "ecflow/light/CommandBatch.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include <eckit/parser/JSONParser.h>
+
+#include "ecflow/light/Conversion.h"
+#include "ecflow/light/Log.h"
+
+namespace ecflow::light {
+
+// *** Command Batch ***********************************************************
+// *****************************************************************************
+
+std::vector<std::string> tokenize(std::string_view line) {
+    std::vector<std::string> words;
+
+    size_t i = 0;
+    while (i < line.size()) {
+        // Skip separators
+        while (i < line.size() && std::isspace(static_cast<unsigned char>(line[i]))) {
+            ++i;
+        }
+        if (i == line.size() || line[i] == '#') {
+            break;
+        }
+
+        std::string word;
+        while (i < line.size() && !std::isspace(static_cast<unsigned char>(line[i]))) {
+            char c = line[i++];
+            if (c == '"') {
+                for (;;) {
+                    if (i == line.size()) {
+                        ECFLOW_LIGHT_THROW(InvalidCommand, Message("Unterminated double quote"));
+                    }
+                    c = line[i++];
+                    if (c == '"') {
+                        break;
+                    }
+                    if (c == '\\' && i < line.size() && (line[i] == '"' || line[i] == '\\')) {
+                        c = line[i++];
+                    }
+                    word.push_back(c);
+                }
+            }
+            else if (c == '\'') {
+                auto closing = line.find('\'', i);
+                if (closing == std::string_view::npos) {
+                    ECFLOW_LIGHT_THROW(InvalidCommand, Message("Unterminated single quote"));
+                }
+                word.append(line.substr(i, closing - i));
+                i = closing + 1;
+            }
+            else {
+                word.push_back(c);
+            }
+        }
+        words.push_back(std::move(word));
+    }
+
+    return words;
+}
+
+namespace {
+
+void expect_arguments(const std::vector<std::string>& words, size_t minimum, size_t maximum, const char* usage) {
+    size_t arguments = words.size() - 1;
+    if (arguments < minimum || arguments > maximum) {
+        ECFLOW_LIGHT_THROW(InvalidCommand, Message("Invalid arguments for '", words[0], "'. Expected: ", usage));
+    }
+}
+
+}  // namespace
+
+CommandBatch::CommandBatch(const ClientAPI& target, std::shared_ptr<const TaskContext> context,
+                           std::ostream& output) :
+    target_{target}, context_{std::move(context)}, output_{output}, pending_{}, processed_{0}, failed_{0} {}
+
+size_t CommandBatch::process(std::istream& input) {
+    std::string command;
+    size_t line = 0;
+    while (std::getline(input, command)) {
+        process(++line, command);
+    }
+    flush();
+    return failed_;
+}
+
+void CommandBatch::process(size_t line, std::string_view command) {
+    try {
+        auto words = tokenize(command);
+        if (words.empty()) {
+            return;
+        }
+        processed_ += 1;
+
+        // Notice: the command might also be given as the corresponding option (e.g. '--meter')
+        std::string_view verb = words[0];
+        if (verb.substr(0, 2) == "--") {
+            verb.remove_prefix(2);
+        }
+
+        if (verb == "meter") {
+            expect_arguments(words, 2, 2, "meter <name> <value>");
+            add(line, Options::options()
+                          .with(Field::Command, "meter")
+                          .with(Field::Name, words[1])
+                          .with(Field::Value, convert_to<int>(words[2])));
+        }
+        else if (verb == "label") {
+            expect_arguments(words, 2, 2, "label <name> <value>");
+            add(line, Options::options()
+                          .with(Field::Command, "label")
+                          .with(Field::Name, words[1])
+                          .with(Field::Value, words[2]));
+        }
+        else if (verb == "event") {
+            expect_arguments(words, 1, 2, "event <name> [set|clear]");
+            std::string value = words.size() > 2 ? words[2] : "set";
+            if (value != "set" && value != "clear") {
+                ECFLOW_LIGHT_THROW(InvalidCommand, Message("Incorrect event value '", value,
+                                                           "' found. Expected either 'set' or 'clear'"));
+            }
+            add(line, Options::options()
+                          .with(Field::Command, "event")
+                          .with(Field::Name, words[1])
+                          .with(Field::Value, value == "set" ? "1" : "0"));
+        }
+        else if (verb == "queue") {
+            expect_arguments(words, 2, 4, "queue <name> <action> [<step>] [<path>]");
+            Options options = Options::options()
+                                  .with(Field::Command, "queue")
+                                  .with(Field::Name, words[1])
+                                  .with(Field::QueueAction, words[2]);
+            if (words.size() > 3) {
+                options = options.with(Field::QueueStep, words[3]);
+            }
+            if (words.size() > 4) {
+                options = options.with(Field::QueuePath, words[4]);
+            }
+            flush();
+            bool report = words[2] == "active" || words[2] == "no_of_aborted";
+            send(line, Request::make_request<UpdateNodeAttribute>(context_, options), report);
+        }
+        else if (verb == "init" || verb == "complete" || verb == "abort") {
+            Options options = Options::options().with(Field::Action, verb);
+            if (verb == "init") {
+                expect_arguments(words, 1, 1, "init <process id>");
+            }
+            else if (verb == "complete") {
+                expect_arguments(words, 0, 0, "complete");
+            }
+            else {
+                expect_arguments(words, 0, 1, "abort [<reason>]");
+                options = options.with(Field::AbortWhy, words.size() > 1 ? words[1] : "");
+            }
+            flush();
+            send(line, Request::make_request<UpdateNodeStatus>(context_, options), false);
+        }
+        else {
+            ECFLOW_LIGHT_THROW(InvalidCommand, Message("Unknown command '", words[0], "'"));
+        }
+    }
+    catch (eckit::Exception& e) {
+        fail(line, e.what());
+    }
+}
+
+void CommandBatch::add(size_t line, Options options) {
+    // Keep only the latest value of each attribute
+    auto same_attribute = [&options](const Pending& pending) {
+        return pending.options.get(Field::Command) == options.get(Field::Command) &&
+               pending.options.get(Field::Name) == options.get(Field::Name);
+    };
+    if (auto found = std::find_if(std::begin(pending_), std::end(pending_), same_attribute);
+        found != std::end(pending_)) {
+        found->lines.push_back(line);
+        found->options = std::move(options);
+        return;
+    }
+
+    if (pending_.size() == MaximumBatch) {
+        flush();
+    }
+    pending_.push_back(Pending{{line}, std::move(options)});
+}
+
+void CommandBatch::flush() {
+    if (pending_.empty()) {
+        return;
+    }
+
+    std::vector<Pending> pending;
+    pending.swap(pending_);
+
+    UpdateNodeAttributes::attributes_t attributes;
+    attributes.reserve(pending.size());
+    for (const auto& update : pending) {
+        attributes.push_back(update.options);
+    }
+
+    try {
+        Response response = target_.process(Request::make_request<UpdateNodeAttributes>(context_, attributes));
+        if (debug_enabled()) {
+            Log::debug() << "Response: " << response << std::endl;
+        }
+    }
+    catch (eckit::Exception& e) {
+        for (const auto& update : pending) {
+            for (size_t line : update.lines) {
+                fail(line, e.what());
+            }
+        }
+    }
+}
+
+void CommandBatch::send(size_t line, const Request& request, bool report) {
+    try {
+        Response response = target_.process(request);
+        if (debug_enabled()) {
+            Log::debug() << "Response: " << response << std::endl;
+        }
+
+        if (report) {
+            // Output the selected step, or the number of aborted steps, as provided in the response
+            eckit::Value value = eckit::JSONParser::decodeString(response.response);
+            if (value.contains("step")) {
+                output_ << value["step"].as<std::string>() << std::endl;
+            }
+            if (value.contains("no_of_aborted")) {
+                output_ << value["no_of_aborted"].as<std::string>() << std::endl;
+            }
+        }
+    }
+    catch (eckit::Exception& e) {
+        fail(line, e.what());
+    }
+}
+
+void CommandBatch::fail(size_t line, const std::string& reason) {
+    failed_ += 1;
+    Log::error() << "Line " << line << ": " << reason << std::endl;
+}
+
+}  // namespace ecflow::light
@@ -0,0 +1,113 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#ifndef ECFLOW_LIGHT_COMMANDBATCH_H
+#define ECFLOW_LIGHT_COMMANDBATCH_H
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ecflow/light/ClientAPI.h"
+#include "ecflow/light/Exception.h"
+#include "ecflow/light/Requests.h"
+
+namespace ecflow::light {
+
+struct InvalidCommand : public eckit::Exception {
+    InvalidCommand(const std::string& msg, const eckit::CodeLocation& loc) : eckit::Exception(msg, loc) {}
+};
+
+// *** Command Batch ***********************************************************
+// *****************************************************************************
+
+/**
+ * Split the line into words, separated by whitespace.
+ *
+ * Words can be quoted: within double quotes, '\"' and '\\' are replaced by the escaped character; within single
+ * quotes, all characters are kept as is. A '#' at the beginning of a word starts a comment, which extends to the
+ * end of the line. Throws InvalidCommand if a quote is not closed.
+ */
+std::vector<std::string> tokenize(std::string_view line);
+
+/**
+ * CommandBatch processes the commands read from a stream (e.g. a file, or stdin), one per line:
+ *
+ *   meter <name> <value>
+ *   label <name> <value>
+ *   event <name> [set|clear]
+ *   queue <name> <action> [<step>] [<path>]
+ *   init <process id>
+ *   complete
+ *   abort [<reason>]
+ *
+ * Consecutive attribute updates (meter, label and event) are sent together, as a single request, and only the
+ * latest value of each attribute is kept. The pending updates are sent before any other command, so that all
+ * commands are processed in order.
+ *
+ * Each invalid, or failed, command is reported (identified by its line number), and processing continues.
+ */
+class CommandBatch {
+public:
+    CommandBatch(const ClientAPI& target, std::shared_ptr<const TaskContext> context, std::ostream& output);
+
+    /**
+     * Process all commands from the input
+     *
+     * @return the number of commands that failed
+     */
+    size_t process(std::istream& input);
+
+    /**
+     * Process a single command, given the line number (used to report failures)
+     */
+    void process(size_t line, std::string_view command);
+
+    /**
+     * Add the attribute update (i.e. meter, label or event), given the line number (used to report failures)
+     */
+    void add(size_t line, Options options);
+
+    /**
+     * Send the pending attribute updates
+     */
+    void flush();
+
+    // Number of commands processed (i.e. excluding empty lines and comments), including those that failed
+    [[nodiscard]] size_t processed() const { return processed_; }
+    [[nodiscard]] size_t failed() const { return failed_; }
+
+    // Maximum number of attribute updates sent as a single request
+    static constexpr size_t MaximumBatch = 256;
+
+private:
+    struct Pending {
+        std::vector<size_t> lines;
+        Options options;
+    };
+
+    void send(size_t line, const Request& request, bool report);
+    void fail(size_t line, const std::string& reason);
+
+    const ClientAPI& target_;
+    std::shared_ptr<const TaskContext> context_;
+    std::ostream& output_;
+
+    std::vector<Pending> pending_;
+    size_t processed_;
+    size_t failed_;
+};
+
+}  // namespace ecflow::light
+
+#endif
@@ -10,15 +10,18 @@
 
 #include "ecflow/light/Configuration.h"
 
+#include <algorithm>
 #include <regex>
 
 #include <eckit/config/LocalConfiguration.h>
 #include <eckit/config/YAMLConfiguration.h>
 #include <eckit/filesystem/PathName.h>
 
+#include "ecflow/light/Conversion.h"
 #include "ecflow/light/Environment.h"
 #include "ecflow/light/Exception.h"
 #include "ecflow/light/Log.h"
+#include "ecflow/light/WireFormat.h"
 
 namespace ecflow::light {
 
@@ -32,12 +35,237 @@ std::ostream& operator<<(std::ostream& os, const ClientCfg& cfg) {
     os << R"("protocol":")" << cfg.protocol << R"(",)";
     os << R"("host":")" << cfg.host << R"(",)";
     os << R"("port":")" << cfg.port << R"(",)";
-    os << R"("version":")" << cfg.version << R"(")";
+    os << R"("version":")" << cfg.version << R"(",)";
+    os << R"("endpoints":[)";
+    for (size_t i = 0; i < cfg.endpoints.size(); ++i) {
+        os << (i == 0 ? "" : ",") << R"(")" << cfg.endpoints[i] << R"(")";
+    }
+    os << R"(],)";
+    os << R"("resolve_all":)" << (cfg.resolve_all ? "true" : "false") << R"(,)";
+    os << R"("ejection":{)";
+    os << R"("failures":)" << cfg.eject_failures << R"(,)";
+    os << R"("cooloff_ms":)" << cfg.eject_ms << R"(},)";
+    os << R"("timeout_ms":)" << cfg.timeout_ms << R"(,)";
+    os << R"("resolve_ttl":)" << cfg.resolve_ttl << R"(,)";
+    os << R"("idle_timeout":)" << cfg.idle_timeout << R"(,)";
+    os << R"("max_in_flight":)" << cfg.max_in_flight << R"(,)";
+    os << R"("executable":")" << cfg.executable << R"(",)";
+    os << R"("max_children":)" << cfg.max_children << R"(,)";
+    os << R"("acknowledged":)" << (cfg.acknowledged ? "true" : "false") << R"(,)";
+    os << R"("retransmit_window":)" << cfg.retransmit_window << R"(,)";
+    os << R"("retry":{)";
+    os << R"("attempts":)" << cfg.retry_attempts << R"(,)";
+    os << R"("backoff_ms":)" << cfg.retry_backoff_ms << R"(,)";
+    os << R"("max_backoff_ms":)" << cfg.retry_max_backoff_ms << R"(,)";
+    os << R"("jitter":)" << cfg.retry_jitter << R"(},)";
+    os << R"("circuit_breaker":{)";
+    os << R"("failures":)" << cfg.breaker_failures << R"(,)";
+    os << R"("cooloff_ms":)" << cfg.breaker_cooloff_ms << R"(})";
     // Omitting task specific configuration parameters
     os << R"(})";
     return os;
 }
 
+std::ostream& operator<<(std::ostream& os, const AsyncCfg& cfg) {
+    os << R"({)";
+    os << R"("enabled":)" << (cfg.enabled ? "true" : "false") << R"(,)";
+    os << R"("capacity":)" << cfg.capacity << R"(,)";
+    os << R"("overflow":")" << cfg.overflow << R"(",)";
+    os << R"("flush_timeout_ms":)" << cfg.flush_timeout_ms;
+    os << R"(})";
+    return os;
+}
+
+namespace {
+
+bool is_enabled(const std::string& value) {
+    return value == "1" || value == "true" || value == "on" || value == "yes";
+}
+
+void apply_retry_cfg(const eckit::LocalConfiguration& yaml_cfg, ClientCfg& cfg) {
+    if (yaml_cfg.has("attempts")) {
+        long attempts = 0;
+        yaml_cfg.get("attempts", attempts);
+        if (attempts <= 0) {
+            ECFLOW_LIGHT_THROW(BadValue, Message("Invalid retry attempts '", attempts, "'. Expected positive value"));
+        }
+        cfg.retry_attempts = static_cast<uint32_t>(attempts);
+    }
+    if (yaml_cfg.has("backoff_ms")) {
+        long backoff = 0;
+        yaml_cfg.get("backoff_ms", backoff);
+        cfg.retry_backoff_ms = static_cast<uint32_t>(std::max(backoff, 0L));
+    }
+    if (yaml_cfg.has("max_backoff_ms")) {
+        long backoff = 0;
+        yaml_cfg.get("max_backoff_ms", backoff);
+        cfg.retry_max_backoff_ms = static_cast<uint32_t>(std::max(backoff, 0L));
+    }
+    if (yaml_cfg.has("jitter")) {
+        double jitter = 0.0;
+        yaml_cfg.get("jitter", jitter);
+        if (jitter < 0.0 || jitter > 1.0) {
+            ECFLOW_LIGHT_THROW(BadValue, Message("Invalid retry jitter '", jitter, "'. Expected value in [0, 1]"));
+        }
+        cfg.retry_jitter = jitter;
+    }
+}
+
+void apply_circuit_breaker_cfg(const eckit::LocalConfiguration& yaml_cfg, ClientCfg& cfg) {
+    if (yaml_cfg.has("failures")) {
+        long failures = 0;
+        yaml_cfg.get("failures", failures);
+        cfg.breaker_failures = static_cast<size_t>(std::max(failures, 0L));
+    }
+    if (yaml_cfg.has("cooloff_ms")) {
+        long cooloff = 0;
+        yaml_cfg.get("cooloff_ms", cooloff);
+        cfg.breaker_cooloff_ms = static_cast<uint32_t>(std::max(cooloff, 0L));
+    }
+}
+
+void apply_ejection_cfg(const eckit::LocalConfiguration& yaml_cfg, ClientCfg& cfg) {
+    if (yaml_cfg.has("failures")) {
+        long failures = 0;
+        yaml_cfg.get("failures", failures);
+        cfg.eject_failures = static_cast<size_t>(std::max(failures, 0L));
+    }
+    if (yaml_cfg.has("cooloff_ms")) {
+        long cooloff = 0;
+        yaml_cfg.get("cooloff_ms", cooloff);
+        cfg.eject_ms = static_cast<uint32_t>(std::max(cooloff, 0L));
+    }
+}
+
+AsyncCfg make_async_cfg(const eckit::LocalConfiguration& yaml_cfg) {
+    AsyncCfg cfg{};
+
+    if (yaml_cfg.has("enabled")) {
+        yaml_cfg.get("enabled", cfg.enabled);
+    }
+    if (yaml_cfg.has("capacity")) {
+        long capacity = 0;
+        yaml_cfg.get("capacity", capacity);
+        if (capacity <= 0) {
+            ECFLOW_LIGHT_THROW(BadValue, Message("Invalid async capacity '", capacity, "'. Expected positive value"));
+        }
+        cfg.capacity = static_cast<size_t>(capacity);
+    }
+    if (yaml_cfg.has("overflow")) {
+        yaml_cfg.get("overflow", cfg.overflow);
+        if (cfg.overflow != AsyncCfg::OverflowDropOldest && cfg.overflow != AsyncCfg::OverflowBlock) {
+            ECFLOW_LIGHT_THROW(BadValue, Message("Invalid async overflow policy '", cfg.overflow, "'. Expected '",
+                                                 AsyncCfg::OverflowDropOldest, "' or '", AsyncCfg::OverflowBlock,
+                                                 "'"));
+        }
+    }
+    if (yaml_cfg.has("flush_timeout_ms")) {
+        long timeout = 0;
+        yaml_cfg.get("flush_timeout_ms", timeout);
+        cfg.flush_timeout_ms = static_cast<uint32_t>(std::max(timeout, 0L));
+    }
+
+    return cfg;
+}
+
+CoalescingCfg make_coalescing_cfg(const eckit::LocalConfiguration& yaml_cfg) {
+    CoalescingCfg cfg{};
+
+    if (yaml_cfg.has("window_ms")) {
+        long window = 0;
+        yaml_cfg.get("window_ms", window);
+        cfg.window_ms = static_cast<uint32_t>(std::max(window, 0L));
+    }
+
+    return cfg;
+}
+
+FanOutCfg make_fanout_cfg(const eckit::LocalConfiguration& yaml_cfg) {
+    FanOutCfg cfg{};
+
+    if (yaml_cfg.has("completion")) {
+        yaml_cfg.get("completion", cfg.completion);
+        if (cfg.completion != FanOutCfg::CompletionWaitAll && cfg.completion != FanOutCfg::CompletionFirstSuccess &&
+            cfg.completion != FanOutCfg::CompletionFireAndForget) {
+            ECFLOW_LIGHT_THROW(BadValue, Message("Invalid fan-out completion policy '", cfg.completion, "'. Expected '",
+                                                 FanOutCfg::CompletionWaitAll, "', '",
+                                                 FanOutCfg::CompletionFirstSuccess, "' or '",
+                                                 FanOutCfg::CompletionFireAndForget, "'"));
+        }
+    }
+
+    return cfg;
+}
+
+RoutingCfg make_routing_cfg(const eckit::LocalConfiguration& yaml_cfg) {
+    RoutingCfg cfg{};
+
+    if (yaml_cfg.has("mode")) {
+        yaml_cfg.get("mode", cfg.mode);
+        if (cfg.mode != RoutingCfg::ModeBroadcast && cfg.mode != RoutingCfg::ModeFailover) {
+            ECFLOW_LIGHT_THROW(BadValue, Message("Invalid routing mode '", cfg.mode, "'. Expected '",
+                                                 RoutingCfg::ModeBroadcast, "' or '", RoutingCfg::ModeFailover, "'"));
+        }
+    }
+    if (yaml_cfg.has("slow_ms")) {
+        long slow = 0;
+        yaml_cfg.get("slow_ms", slow);
+        cfg.slow_ms = static_cast<uint32_t>(std::max(slow, 0L));
+    }
+    if (yaml_cfg.has("probe_ms")) {
+        long probe = 0;
+        yaml_cfg.get("probe_ms", probe);
+        cfg.probe_ms = static_cast<uint32_t>(std::max(probe, 0L));
+    }
+
+    return cfg;
+}
+
+SpoolCfg make_spool_cfg(const eckit::LocalConfiguration& yaml_cfg, const Environment& environment) {
+    SpoolCfg cfg{};
+
+    if (yaml_cfg.has("directory")) {
+        yaml_cfg.get("directory", cfg.directory);
+        cfg.directory = replace_env_var(cfg.directory, environment);
+    }
+    if (yaml_cfg.has("size_kb")) {
+        long size = 0;
+        yaml_cfg.get("size_kb", size);
+        if (size <= 0) {
+            ECFLOW_LIGHT_THROW(BadValue, Message("Invalid spool size '", size, "'. Expected positive value"));
+        }
+        cfg.capacity = static_cast<size_t>(size) * 1024;
+    }
+    if (yaml_cfg.has("retry_ms")) {
+        long retry = 0;
+        yaml_cfg.get("retry_ms", retry);
+        cfg.retry_ms = static_cast<uint32_t>(std::max(retry, 1L));
+    }
+
+    return cfg;
+}
+
+TraceCfg make_trace_cfg(const eckit::LocalConfiguration& yaml_cfg, const Environment& environment) {
+    TraceCfg cfg{};
+
+    if (yaml_cfg.has("path")) {
+        yaml_cfg.get("path", cfg.path);
+        cfg.path = replace_env_var(cfg.path, environment);
+    }
+    if (yaml_cfg.has("capacity")) {
+        long capacity = 0;
+        yaml_cfg.get("capacity", capacity);
+        if (capacity <= 0) {
+            ECFLOW_LIGHT_THROW(BadValue, Message("Invalid trace capacity '", capacity, "'. Expected positive value"));
+        }
+        cfg.capacity = static_cast<size_t>(capacity);
+    }
+
+    return cfg;
+}
+
+}  // namespace
+
 Configuration Configuration::make_cfg() {
     Configuration cfg{};
 
@@ -82,21 +310,99 @@ Configuration Configuration::make_cfg() {
             std::string host     = get("host");
             std::string port     = get("port");
             std::string version  = get("version", "1.0");
+            std::string timeout  = get("timeout_ms", "0");
+            std::string ttl      = get("resolve_ttl", std::to_string(ClientCfg::DefaultResolveTTL));
+            std::string idle     = get("idle_timeout", std::to_string(ClientCfg::DefaultIdleTimeout));
+            std::string inflight = get("max_in_flight", std::to_string(ClientCfg::DefaultMaxInFlight));
+            std::string exe      = get("executable", ClientCfg::DefaultExecutable);
+            std::string children = get("max_children", std::to_string(ClientCfg::DefaultMaxChildren));
+            std::string window   = get("retransmit_window", std::to_string(ClientCfg::DefaultRetransmitWindow));
 
             // Replace environment variables
             host = replace_env_var(host, environment);
             port = replace_env_var(port, environment);
 
             cfg.clients.push_back(ClientCfg::make_cfg(kind, protocol, host, port, version));
+            cfg.clients.back().timeout_ms        = convert_to<uint32_t>(timeout);
+            cfg.clients.back().resolve_ttl       = convert_to<uint32_t>(ttl);
+            cfg.clients.back().idle_timeout      = convert_to<uint32_t>(idle);
+            cfg.clients.back().max_in_flight     = std::max(convert_to<size_t>(inflight), size_t{1});
+            cfg.clients.back().executable        = replace_env_var(exe, environment);
+            cfg.clients.back().max_children      = std::max(convert_to<size_t>(children), size_t{1});
+            cfg.clients.back().retransmit_window = std::max(convert_to<size_t>(window), size_t{1});
+            if (client.has("endpoints")) {
+                client.get("endpoints", cfg.clients.back().endpoints);
+                for (auto& endpoint : cfg.clients.back().endpoints) {
+                    endpoint = replace_env_var(endpoint, environment);
+                }
+            }
+            if (client.has("resolve_all")) {
+                client.get("resolve_all", cfg.clients.back().resolve_all);
+            }
+            if (client.has("ejection")) {
+                apply_ejection_cfg(client.getSubConfiguration("ejection"), cfg.clients.back());
+            }
+            if (client.has("acknowledged")) {
+                client.get("acknowledged", cfg.clients.back().acknowledged);
+            }
+            if (client.has("retry")) {
+                apply_retry_cfg(client.getSubConfiguration("retry"), cfg.clients.back());
+            }
+            if (client.has("circuit_breaker")) {
+                apply_circuit_breaker_cfg(client.getSubConfiguration("circuit_breaker"), cfg.clients.back());
+            }
+
+            if (protocol == ClientCfg::ProtocolUDP) {
+                // Notice: validate the version early, as it selects the wire format of the datagrams
+                wire_format_of(version);
+            }
 
             Log::debug() << "Client configuration: " << cfg.clients.back() << std::endl;
         }
+
+        if (yaml_cfg.has("async")) {
+            cfg.async = make_async_cfg(yaml_cfg.getSubConfiguration("async"));
+        }
+        if (yaml_cfg.has("coalescing")) {
+            cfg.coalescing = make_coalescing_cfg(yaml_cfg.getSubConfiguration("coalescing"));
+            Log::debug() << "Coalescing window: " << cfg.coalescing.window_ms << "ms" << std::endl;
+        }
+        if (yaml_cfg.has("fanout")) {
+            cfg.fanout = make_fanout_cfg(yaml_cfg.getSubConfiguration("fanout"));
+            Log::debug() << "Fan-out completion: " << cfg.fanout.completion << std::endl;
+        }
+        if (yaml_cfg.has("routing")) {
+            cfg.routing = make_routing_cfg(yaml_cfg.getSubConfiguration("routing"));
+            Log::debug() << "Routing mode: " << cfg.routing.mode << std::endl;
+        }
+        if (yaml_cfg.has("spool")) {
+            cfg.spool = make_spool_cfg(yaml_cfg.getSubConfiguration("spool"), environment);
+            Log::debug() << "Spool directory: '" << cfg.spool.directory << "'" << std::endl;
+        }
+        if (yaml_cfg.has("trace")) {
+            cfg.trace = make_trace_cfg(yaml_cfg.getSubConfiguration("trace"), environment);
+        }
     }
     else {
         ECFLOW_LIGHT_THROW(InvalidEnvironment,
                            Message("Unable to load YAML configuration as 'IFS_ECF_CONFIG_PATH' is not defined"));
     }
 
+    // Environment variable takes precedence over YAML, allowing to toggle asynchronous mode per task
+    if (auto async = environment.get_optional("ECFLOW_LIGHT_ASYNC"); async) {
+        cfg.async.enabled = is_enabled(async->value);
+    }
+    Log::debug() << "Async configuration: " << cfg.async << std::endl;
+
+    // Environment variable takes precedence over YAML, allowing to trace the requests of a particular task
+    if (auto trace = environment.get_optional("ECFLOW_LIGHT_TRACE"); trace) {
+        cfg.trace.path = trace->value;
+    }
+    if (cfg.trace.enabled()) {
+        Log::debug() << "Trace dump: '" << cfg.trace.path << "', keeping " << cfg.trace.capacity << " record(s)"
+                     << std::endl;
+    }
+
     return cfg;
 }
 
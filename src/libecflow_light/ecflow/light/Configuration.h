@@ -11,6 +11,8 @@
 #ifndef ECFLOW_LIGHT_CONFIGURATION_H
 #define ECFLOW_LIGHT_CONFIGURATION_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -50,6 +52,59 @@ public:
     std::string port;
     std::string version;
 
+    // Alternative endpoints (each as 'host' or 'host:port') among which requests are spread; when given, these
+    // replace the host (and, for endpoints without a port, the port is used)
+    std::vector<std::string> endpoints;
+    // Expand the host (or each endpoint) into all of its resolved addresses, spreading requests among them
+    bool resolve_all = false;
+    // Consecutive failed requests that eject an endpoint (0 disables), and period (in milliseconds) after which an
+    // ejected endpoint is tried again
+    size_t eject_failures = DefaultEjectFailures;
+    uint32_t eject_ms     = DefaultEjectCooloff;
+    // Maximum time (in milliseconds) allowed to process each request, including retries; 0 means no timeout
+    uint32_t timeout_ms = 0;
+    // Period (in seconds) after which the host address is resolved again; 0 means resolve only once
+    uint32_t resolve_ttl = DefaultResolveTTL;
+    // Period (in seconds) after which an idle connection is closed
+    uint32_t idle_timeout = DefaultIdleTimeout;
+    // Maximum number of requests performed concurrently; 1 means each request is performed synchronously
+    size_t max_in_flight = DefaultMaxInFlight;
+    // Await each request, even when pipelined, so that its outcome is reported (i.e. not configured, but set when
+    // the outcome of each request is acted upon by the spool or the routing)
+    bool await_outcome = false;
+    // Executable launched by the CLI client, and maximum number of simultaneously running processes
+    std::string executable = DefaultExecutable;
+    size_t max_children    = DefaultMaxChildren;
+    // Acknowledged UDP mode, and maximum number of datagrams kept for retransmission until acknowledged
+    bool acknowledged        = false;
+    size_t retransmit_window = DefaultRetransmitWindow;
+    // Maximum attempts of each HTTP request, and backoff (in milliseconds, randomly reduced by up to the jitter
+    // fraction) before each retry, doubling after each failed attempt
+    uint32_t retry_attempts       = DefaultRetryAttempts;
+    uint32_t retry_backoff_ms     = DefaultRetryBackoff;
+    uint32_t retry_max_backoff_ms = DefaultRetryMaxBackoff;
+    double retry_jitter           = DefaultRetryJitter;
+    // Consecutive failed HTTP requests that open the circuit (0 disables), and period (in milliseconds) during which
+    // requests then fail immediately
+    size_t breaker_failures     = DefaultBreakerFailures;
+    uint32_t breaker_cooloff_ms = DefaultBreakerCooloff;
+
+    static constexpr uint32_t DefaultResolveTTL      = 300;
+    static constexpr uint32_t DefaultIdleTimeout     = 60;
+    static constexpr size_t DefaultMaxInFlight       = 1;
+    static constexpr size_t DefaultMaxChildren       = 8;
+    static constexpr size_t DefaultRetransmitWindow  = 64;
+    static constexpr uint32_t DefaultRetryAttempts   = 3;
+    static constexpr uint32_t DefaultRetryBackoff    = 100;
+    static constexpr uint32_t DefaultRetryMaxBackoff = 2000;
+    static constexpr double DefaultRetryJitter       = 0.5;
+    static constexpr size_t DefaultBreakerFailures   = 5;
+    static constexpr uint32_t DefaultBreakerCooloff  = 10000;
+    static constexpr size_t DefaultEjectFailures     = 3;
+    static constexpr uint32_t DefaultEjectCooloff    = 10000;
+
+    static constexpr const char* DefaultExecutable = "ecflow_client";
+
     static constexpr const char* ProtocolHTTP = "http";
     static constexpr const char* ProtocolUDP  = "udp";
     static constexpr const char* ProtocolTCP  = "tcp";
@@ -60,8 +115,62 @@ public:
     static constexpr const char* KindPhony   = "phony";
 };
 
+struct AsyncCfg {
+    bool enabled              = false;
+    size_t capacity           = 1024;
+    std::string overflow      = OverflowDropOldest;
+    uint32_t flush_timeout_ms = 2000;
+
+    static constexpr const char* OverflowDropOldest = "drop-oldest";
+    static constexpr const char* OverflowBlock      = "block";
+};
+
+struct CoalescingCfg {
+    uint32_t window_ms = 0;  // 0 disables coalescing
+
+    [[nodiscard]] bool enabled() const { return window_ms > 0; }
+};
+
+struct FanOutCfg {
+    std::string completion = CompletionWaitAll;
+
+    static constexpr const char* CompletionWaitAll       = "wait-all";
+    static constexpr const char* CompletionFirstSuccess  = "first-success";
+    static constexpr const char* CompletionFireAndForget = "fire-and-forget";
+};
+
+struct RoutingCfg {
+    std::string mode  = ModeBroadcast;
+    uint32_t slow_ms  = 0;  // 0 means the latency doesn't affect the health of a client
+    uint32_t probe_ms = 5000;
+
+    static constexpr const char* ModeBroadcast = "broadcast";
+    static constexpr const char* ModeFailover  = "failover";
+};
+
+struct SpoolCfg {
+    std::string directory;  // empty disables spooling
+    size_t capacity   = 1024 * 1024;
+    uint32_t retry_ms = 1000;
+
+    [[nodiscard]] bool enabled() const { return !directory.empty(); }
+};
+
+struct TraceCfg {
+    std::string path;  // empty disables tracing
+    size_t capacity = 16 * 1024;
+
+    [[nodiscard]] bool enabled() const { return !path.empty(); }
+};
+
 struct Configuration {
     std::vector<ClientCfg> clients;
+    AsyncCfg async;
+    CoalescingCfg coalescing;
+    FanOutCfg fanout;
+    RoutingCfg routing;
+    SpoolCfg spool;
+    TraceCfg trace;
 
     static Configuration make_cfg();
 };
@@ -0,0 +1,113 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#ifndef ECFLOW_LIGHT_DEADLINE_H
+#define ECFLOW_LIGHT_DEADLINE_H
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <string_view>
+
+#include "ecflow/light/Exception.h"
+
+namespace ecflow::light {
+
+/**
+ * DeadlineExceeded signals that a call could not be completed within the time allowed, and thus is distinct from
+ * the failure to deliver the request.
+ */
+struct DeadlineExceeded : public eckit::Exception {
+    DeadlineExceeded(const std::string& msg, const eckit::CodeLocation& loc) : eckit::Exception(msg, loc) {}
+};
+
+// *** Deadline ****************************************************************
+// *****************************************************************************
+
+/**
+ * Deadline holds the point in time by which the call being processed on the current thread must complete.
+ *
+ * A deadline is established by creating a Deadline::Scope, and applies to the calling thread until the scope ends.
+ * Nested scopes can only bring the deadline closer (e.g. the timeout of a client applies within the budget of the
+ * call). The transports consult the deadline of the current thread to bound connecting, sending and retrying.
+ *
+ * Notice: work handed over to another thread (e.g. a secondary client of a fan-out) must establish the deadline
+ *         again on that thread, as the deadline is not automatically propagated.
+ */
+class Deadline {
+public:
+    using clock_t      = std::chrono::steady_clock;
+    using time_point_t = clock_t::time_point;
+
+    class Scope {
+    public:
+        explicit Scope(clock_t::duration budget) :
+            Scope(clock_t::now() + std::max(budget, clock_t::duration::zero())) {}
+
+        explicit Scope(std::optional<time_point_t> deadline) : previous_{slot()} {
+            if (deadline && (!previous_ || *deadline < *previous_)) {
+                slot() = deadline;
+            }
+        }
+
+        ~Scope() { slot() = previous_; }
+
+        // Scope object cannot be copied!
+        Scope(const Scope&)            = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        std::optional<time_point_t> previous_;
+    };
+
+    /**
+     * @return the deadline of the current thread; or nothing, if the current thread has no deadline
+     */
+    static std::optional<time_point_t> current() { return slot(); }
+
+    /**
+     * @return the time remaining until the deadline of the current thread (zero, once the deadline has passed); or
+     *         nothing, if the current thread has no deadline
+     */
+    static std::optional<std::chrono::milliseconds> remaining() { return remaining_until(slot()); }
+
+    static std::optional<std::chrono::milliseconds> remaining_until(std::optional<time_point_t> deadline) {
+        if (!deadline) {
+            return std::nullopt;
+        }
+        auto left = std::chrono::ceil<std::chrono::milliseconds>(*deadline - clock_t::now());
+        return std::max(left, std::chrono::milliseconds::zero());
+    }
+
+    [[nodiscard]] static bool expired() { return expired(slot()); }
+
+    [[nodiscard]] static bool expired(std::optional<time_point_t> deadline) {
+        return deadline && clock_t::now() >= *deadline;
+    }
+
+    /**
+     * Throws DeadlineExceeded if the deadline of the current thread has passed
+     */
+    static void check(std::string_view activity) {
+        if (expired()) {
+            ECFLOW_LIGHT_THROW(DeadlineExceeded, Message("Deadline exceeded while ", activity));
+        }
+    }
+
+private:
+    static std::optional<time_point_t>& slot() {
+        thread_local std::optional<time_point_t> deadline;
+        return deadline;
+    }
+};
+
+}  // namespace ecflow::light
+
+#endif
@@ -10,11 +10,14 @@
 
 #include "ecflow/light/Dispatcher.h"
 
-#include <eckit/net/UDPClient.h>
+#include <algorithm>
+#include <iterator>
+#include <unordered_set>
 
-#include "ecflow/light/Conversion.h"
 #include "ecflow/light/Exception.h"
+#include "ecflow/light/JSON.h"
 #include "ecflow/light/Token.h"
+#include "ecflow/light/WireFormat.h"
 
 namespace ecflow::light {
 
@@ -28,23 +31,63 @@ struct InvalidRequest : public eckit::Exception {
 // *** Client Dispatcher (CLI) *************************************************
 // *****************************************************************************
 
-CLIDispatcher::CLIDispatcher(const ClientCfg& cfg) : BaseRequestDispatcher<CLIDispatcher>(cfg) {}
+CLIDispatcher::transport_t CLIDispatcher::make_transport(const ClientCfg& cfg) {
+    return transport_t{cfg.executable, cfg.max_children};
+}
+
+CLIDispatcher::CLIDispatcher(const ClientCfg& cfg) :
+    BaseRequestDispatcher<CLIDispatcher>(cfg),
+    owned_{std::make_unique<transport_t>(cfg.executable, cfg.max_children)},
+    transport_{owned_.get()} {}
+
+CLIDispatcher::CLIDispatcher(const ClientCfg& cfg, transport_t& transport) :
+    BaseRequestDispatcher<CLIDispatcher>(cfg), owned_{}, transport_{&transport} {}
 
 void CLIDispatcher::dispatch_request(const UpdateNodeStatus& request [[maybe_unused]]) {
     ECFLOW_LIGHT_THROW(NotImplemented, Message("CLIDispatcher::dispatch(const UpdateNodeStatus&) not supported"));
 }
 
 void CLIDispatcher::dispatch_request(const UpdateNodeAttribute& request) {
-    std::ostringstream oss;
-    oss << R"(ecflow_client --)" << request.options().get("command").value << R"(=)"
-        << request.options().get("name").value << R"( ")" << request.options().get("value").value << R"(" &)";
+    response_ = exchange_request(format_arguments(request.options()));
+}
 
-    response_ = CLIDispatcher::exchange_request(cfg_, oss.str());
+void CLIDispatcher::dispatch_request(const UpdateNodeAttributes& request) {
+    // Each update requires a separate invocation, so only the latest value of each attribute is actually sent
+    const auto& attributes = request.attributes();
+
+    std::vector<const Options*> latest;
+    std::unordered_set<std::string> seen;
+    for (auto current = attributes.rbegin(); current != attributes.rend(); ++current) {
+        auto key = stringify(current->get(Field::Command), ":", current->get(Field::Name));
+        if (seen.insert(key).second) {
+            latest.push_back(&*current);
+        }
+    }
+
+    for (auto current = latest.rbegin(); current != latest.rend(); ++current) {
+        response_ = exchange_request(format_arguments(**current));
+    }
 }
 
-Response CLIDispatcher::exchange_request(const ClientCfg& cfg [[maybe_unused]], const std::string& request) {
-    Log::info() << "Dispatching CLI Request: " << request << std::endl;
-    ::system(request.c_str());
+std::vector<std::string> CLIDispatcher::format_arguments(const Options& options) {
+    return {stringify("--", options.get(Field::Command), "=", options.get(Field::Name)),
+            std::string(options.get(Field::Value))};
+}
+
+Response CLIDispatcher::exchange_request(const std::vector<std::string>& arguments) {
+    if (debug_enabled()) {
+        auto& out = Log::debug();
+        out << "Dispatching CLI Request: " << transport_->executable();
+        for (const auto& argument : arguments) {
+            out << " '" << argument << "'";
+        }
+        out << std::endl;
+    }
+
+    for (const auto& argument : arguments) {
+        bytes_ += argument.size();
+    }
+    transport_->spawn(arguments);
 
     return Response{"OK"};
 }
@@ -52,30 +95,151 @@ Response CLIDispatcher::exchange_request(const ClientCfg& cfg [[maybe_unused]],
 // *** Client Dispatcher (UDP) *************************************************
 // *****************************************************************************
 
-UDPDispatcher::UDPDispatcher(const ClientCfg& cfg) : BaseRequestDispatcher<UDPDispatcher>(cfg) {}
+UDPTransport::UDPTransport(const ClientCfg& cfg) :
+    socket{cfg.host, cfg.port, std::chrono::seconds(cfg.resolve_ttl)},
+    acknowledged{cfg.acknowledged ? std::make_unique<AcknowledgedSender>(socket, cfg.retransmit_window) : nullptr} {}
+
+UDPDispatcher::transport_t UDPDispatcher::make_transport(const ClientCfg& cfg) {
+    return transport_t{cfg};
+}
+
+UDPDispatcher::UDPDispatcher(const ClientCfg& cfg) :
+    BaseRequestDispatcher<UDPDispatcher>(cfg),
+    format_{wire_format_of(cfg.version)},
+    owned_{std::make_unique<transport_t>(cfg)},
+    transport_{owned_.get()} {}
+
+UDPDispatcher::UDPDispatcher(const ClientCfg& cfg, transport_t& transport) :
+    BaseRequestDispatcher<UDPDispatcher>(cfg), format_{wire_format_of(cfg.version)}, owned_{}, transport_{&transport} {}
+
+namespace {
+
+void write_envelope(std::string& buffer, const std::string& version, const TaskFragments& fragments) {
+    buffer += R"({"method":"put","version":)";
+    JSONWriter::append_string(buffer, version);
+    buffer += R"(,"header":{)";
+    buffer += fragments.udp_header;
+    buffer += R"(},"payload":)";
+}
+
+void write_payload(JSONWriter& json, const TaskFragments& fragments, const Options& options) {
+    json.begin_object()
+        .member("command", options.get(Field::Command))
+        .key("path")
+        .raw(fragments.path)
+        .member("name", options.get(Field::Name))
+        .member("value", options.get(Field::Value))
+        .end_object();
+}
+
+void write_update(std::string& buffer, const Options& options) {
+    BinaryEncoder::write_update(buffer, options.get(Field::Command), options.get(Field::Name),
+                                options.get(Field::Value));
+}
+
+/**
+ * Greedily packs the binary encoded updates, each datagram starting with the task header
+ */
+std::vector<std::string> pack_updates(const TaskFragments& fragments,
+                                      const UpdateNodeAttributes::attributes_t& attributes, size_t maximum_size) {
+    std::vector<std::string> datagrams;
+    std::string update;
+    for (const auto& attribute : attributes) {
+        update.clear();
+        write_update(update, attribute);
+
+        bool has_updates = !datagrams.empty() && datagrams.back().size() > fragments.udp_binary.size();
+        if (datagrams.empty() || (has_updates && datagrams.back().size() + update.size() > maximum_size)) {
+            datagrams.push_back(fragments.udp_binary);
+        }
+        datagrams.back() += update;
+    }
+    return datagrams;
+}
+
+Response response_of(bool sent) {
+    return sent ? Response{"OK"} : Response{"DROPPED", Response::Outcome::Dropped};
+}
+
+}  // namespace
 
 std::string UDPDispatcher::format_request(const UpdateNodeAttribute& request) const {
-    std::ostringstream oss;
-    // clang-format off
-    oss << R"({)"
-            << R"("method":"put",)"
-            << R"("version":")" << cfg_.version << R"(",)"
-            << R"("header":)"
-            << R"({)"
-                << R"("task_rid":")" << request.environment().get("ECF_RID").value << R"(",)"
-                << R"("task_password":")" << request.environment().get("ECF_PASS").value << R"(",)"
-                << R"("task_try_no":)" << request.environment().get("ECF_TRYNO").value
-            << R"(},)"
-            << R"("payload":)"
-            << R"({)"
-                << R"("command":")" << request.options().get("command").value << R"(",)"
-                << R"("path":")" << request.environment().get("ECF_NAME").value << R"(",)"
-                << R"("name":")" << request.options().get("name").value << R"(",)"
-                << R"("value":")"<< request.options().get("value").value << R"(")"
-            << R"(})"
-        << R"(})";
-    // clang-format on
-    return oss.str();
+    std::string& buffer = JSONWriter::thread_buffer();
+    write_request(buffer, request);
+    return buffer;
+}
+
+void UDPDispatcher::write_request(std::string& buffer, const UpdateNodeAttribute& request) const {
+    const auto& fragments = request.context().fragments();
+
+    if (format_ == WireFormat::Binary) {
+        buffer += fragments.udp_binary;
+        write_update(buffer, request.options());
+        return;
+    }
+
+    write_envelope(buffer, cfg_.version, fragments);
+    JSONWriter json(buffer);
+    write_payload(json, fragments, request.options());
+    buffer += '}';
+}
+
+std::vector<std::string> UDPDispatcher::format_request(const UpdateNodeAttributes& request) const {
+    const auto& fragments = request.context().fragments();
+
+    if (format_ == WireFormat::Binary) {
+        return pack_updates(fragments, request.attributes(), maximum_size());
+    }
+
+    std::string envelope;
+    write_envelope(envelope, cfg_.version, fragments);
+
+    std::vector<std::string> payloads;
+    payloads.reserve(request.attributes().size());
+    for (const auto& attribute : request.attributes()) {
+        JSONWriter json(payloads.emplace_back());
+        write_payload(json, fragments, attribute);
+    }
+
+    auto make_datagram = [&envelope](auto first, auto last) {
+        std::string datagram = envelope;
+        if (std::distance(first, last) == 1) {
+            datagram += *first;
+        }
+        else {
+            datagram += "[";
+            for (auto current = first; current != last; ++current) {
+                if (current != first) {
+                    datagram += ",";
+                }
+                datagram += *current;
+            }
+            datagram += "]";
+        }
+        datagram += "}";
+        return datagram;
+    };
+
+    // Greedily pack payloads, accounting for: envelope + '[' + payloads (with ',' separators) + ']' + '}' + '\0'
+    constexpr size_t datagram_overhead = 4;
+
+    std::vector<std::string> datagrams;
+    auto first           = std::begin(payloads);
+    size_t datagram_size = envelope.size() + datagram_overhead;
+    for (auto current = std::begin(payloads); current != std::end(payloads); ++current) {
+        size_t addition = current->size() + (current == first ? 0 : 1);
+        if (current != first && datagram_size + addition > maximum_size()) {
+            datagrams.push_back(make_datagram(first, current));
+            first         = current;
+            datagram_size = envelope.size() + datagram_overhead;
+            addition      = current->size();
+        }
+        datagram_size += addition;
+    }
+    if (first != std::end(payloads)) {
+        datagrams.push_back(make_datagram(first, std::end(payloads)));
+    }
+    return datagrams;
 }
 
 void UDPDispatcher::dispatch_request(const UpdateNodeStatus& request [[maybe_unused]]) {
@@ -83,114 +247,224 @@ void UDPDispatcher::dispatch_request(const UpdateNodeStatus& request [[maybe_unu
 }
 
 void UDPDispatcher::dispatch_request(const UpdateNodeAttribute& request) {
+    // Notice: the datagram is formatted, and sent, directly from the thread-local buffer
+    std::string& datagram = JSONWriter::thread_buffer();
+    write_request(datagram, request);
+
+    if (transport_->acknowledged) {
+        // Notice: only the newest value of each meter (or label) is ever retransmitted
+        const auto& options = request.options();
+        auto command        = options.get(Field::Command);
+        if (command == "meter" || command == "label") {
+            auto key = stringify(request.context().name(), ":", command, ":", options.get(Field::Name));
+            response_ = exchange_request(datagram, key);
+            return;
+        }
+    }
+    response_ = exchange_request(datagram, {});
+}
+
+void UDPDispatcher::dispatch_request(const UpdateNodeAttributes& request) {
     auto contents = format_request(request);
-    response_ = UDPDispatcher::exchange_request(cfg_, contents);
+    response_     = exchange_request(contents);
 }
 
-Response UDPDispatcher::exchange_request(const ClientCfg& cfg, const std::string& request) {
-    Log::info() << "Dispatching UDP Request: " << request << ", to " << cfg.host << ":" << cfg.port << std::endl;
+Response UDPDispatcher::exchange_request(const std::string& datagram, std::string_view key) {
+    check_size(datagram);
+    bytes_ += packet_size(datagram);
+    return response_of(send(datagram, key));
+}
 
-    const size_t packet_size = request.size() + 1;
-    if (packet_size > UDPPacketMaximumSize) {
-        ECFLOW_LIGHT_THROW(InvalidRequest, Message("Request too large. Maximum size expected is ", UDPPacketMaximumSize,
-                                                   ", but found: ", packet_size));
+Response UDPDispatcher::exchange_request(const std::vector<std::string>& datagrams) {
+    // Notice: all datagrams are checked before sending any, so that the batch is either sent or rejected
+    std::vector<std::string_view> packets;
+    packets.reserve(datagrams.size());
+    for (const auto& datagram : datagrams) {
+        check_size(datagram);
+        packets.emplace_back(datagram.data(), packet_size(datagram));
+        bytes_ += packets.back().size();
     }
 
-    int port = convert_to<int>(cfg.port);
-    eckit::net::UDPClient client(cfg.host, port);
-    client.send(request.data(), packet_size);
+    if (transport_->acknowledged) {
+        // Notice: each datagram of a batch carries several updates, and is thus never superseded
+        size_t sent = 0;
+        for (const auto& datagram : datagrams) {
+            sent += send(datagram, {}) ? 1 : 0;
+        }
+        return response_of(sent == packets.size());
+    }
 
-    return Response{"OK"};
+    // Notice: all datagrams are sent together, using as few system calls as possible
+    if (debug_enabled()) {
+        Log::debug() << "Dispatching " << packets.size() << " UDP Request(s), to " << cfg_.host << ":" << cfg_.port
+                     << std::endl;
+    }
+    size_t sent = transport_->socket.send(packets);
+
+    return response_of(sent == packets.size());
+}
+
+size_t UDPDispatcher::packet_size(const std::string& datagram) const {
+    // Notice: JSON datagrams are sent including the null terminator, while binary datagrams are sent as-is
+    return datagram.size() + (format_ == WireFormat::JSON ? 1 : 0);
+}
+
+size_t UDPDispatcher::maximum_size() const {
+    // Notice: in acknowledged mode, room is left for the sequence numbers added to each datagram
+    return UDPPacketMaximumSize - (cfg_.acknowledged ? SequenceOverhead : 0);
+}
+
+void UDPDispatcher::check_size(const std::string& datagram) const {
+    const size_t packet_size = this->packet_size(datagram);
+    if (packet_size > maximum_size()) {
+        ECFLOW_LIGHT_THROW(InvalidRequest, Message("Request too large. Maximum size expected is ", maximum_size(),
+                                                   ", but found: ", packet_size));
+    }
+}
+
+bool UDPDispatcher::send(const std::string& datagram, std::string_view key) {
+    if (debug_enabled()) {
+        if (format_ == WireFormat::JSON) {
+            Log::debug() << "Dispatching UDP Request: " << datagram << ", to " << cfg_.host << ":" << cfg_.port
+                         << std::endl;
+        }
+        else {
+            Log::debug() << "Dispatching UDP Request: <binary, " << datagram.size() << " bytes>, to " << cfg_.host
+                         << ":" << cfg_.port << std::endl;
+        }
+    }
+    if (transport_->acknowledged) {
+        return transport_->acknowledged->send(key, std::string_view(datagram.data(), packet_size(datagram)));
+    }
+    return transport_->socket.send(datagram.data(), packet_size(datagram));
 }
 
 // *** Client Dispatcher (HTTP) ************************************************
 // *****************************************************************************
 
-HTTPDispatcher::HTTPDispatcher(const ClientCfg& cfg) : BaseRequestDispatcher<HTTPDispatcher>(cfg) {}
+HTTPDispatcher::transport_t HTTPDispatcher::make_transport(const ClientCfg& cfg) {
+    net::RetryPolicy retry;
+    retry.max_attempts = static_cast<int>(cfg.retry_attempts);
+    retry.base_backoff = std::chrono::milliseconds(cfg.retry_backoff_ms);
+    retry.max_backoff  = std::chrono::milliseconds(std::max(cfg.retry_max_backoff_ms, cfg.retry_backoff_ms));
+    retry.jitter       = cfg.retry_jitter;
+
+    net::CircuitBreakerPolicy breaker;
+    breaker.failure_threshold = cfg.breaker_failures;
+    breaker.cooloff           = std::chrono::milliseconds(cfg.breaker_cooloff_ms);
+
+    return transport_t{std::chrono::seconds(cfg.idle_timeout), cfg.max_in_flight, retry, breaker};
+}
+
+HTTPDispatcher::HTTPDispatcher(const ClientCfg& cfg) :
+    BaseRequestDispatcher<HTTPDispatcher>(cfg),
+    owned_{std::make_unique<transport_t>(make_transport(cfg))},
+    transport_{owned_.get()} {}
+
+HTTPDispatcher::HTTPDispatcher(const ClientCfg& cfg, transport_t& transport) :
+    BaseRequestDispatcher<HTTPDispatcher>(cfg), owned_{}, transport_{&transport} {}
+
+namespace {
+
+void write_attribute(JSONWriter& json, const TaskFragments& fragments, const Options& options) {
+    json.begin_object()
+        .raw(fragments.http_task)
+        .member("type", options.get(Field::Command))
+        .member("name", options.get(Field::Name));
+    if (auto found = options.find(Field::QueueAction); found) {
+        json.member("queue_action", found.value());
+    }
+    if (auto found = options.find(Field::QueueStep); found) {
+        json.member("queue_step", found.value());
+    }
+    if (auto found = options.find(Field::QueuePath); found) {
+        json.member("queue_path", found.value());
+    }
+    if (auto found = options.find(Field::Value); found) {
+        json.member("value", found.value());
+    }
+    json.end_object();
+}
+
+}  // namespace
 
 void HTTPDispatcher::dispatch_request(const UpdateNodeStatus& request) {
-    // Build body
-    std::ostringstream oss;
-    auto action = request.options().get("action").value;
-    // clang-format off
-        oss << R"({)"
-                << R"("ECF_NAME":")" << request.environment().get("ECF_NAME").value << R"(",)"
-                << R"("ECF_PASS":")" << request.environment().get("ECF_PASS").value << R"(",)"
-                << R"("ECF_RID":")" << request.environment().get("ECF_RID").value << R"(",)"
-                << R"("ECF_TRYNO":")" << request.environment().get("ECF_TRYNO").value << R"(",)"
-                << R"("action":")" << action << R"(")";
-                if(action == "abort") {
-                    oss << R"(,"abort_why":")" << request.options().get("abort_why").value << R"(")";
-                } else if(action == "wait") {
-                    oss << R"(,"wait_expression":")" << request.options().get("wait_expression").value << R"(")";
-                }
-        oss << R"(})";
-    // clang-format on
-    auto body = oss.str();
+    const auto& context   = request.context();
+    const auto& fragments = context.fragments();
 
-    // Build Target
-    auto target = net::Target{stringify("/v1/suites", request.environment().get("ECF_NAME").value, "/status")};
+    // Build body
+    auto action = request.options().get(Field::Action);
 
-    net::Request<net::Method::PUT> low_level_request{target};
-    low_level_request.add_header_field(net::Field{"Accept", "application/json"});
-    low_level_request.add_header_field(net::Field{"Content-Type", "application/json"});
-    low_level_request.add_header_field(net::Field{"charsets", "utf-8"});
-    std::optional<Token> secret = Tokens().secret(net::URL(net::Host(cfg_.host, cfg_.port), net::Target("/v1")).str());
-    if (secret) {
-        low_level_request.add_header_field(net::Field{"Authorization", "Bearer " + secret.value().key});
+    std::string& body = JSONWriter::thread_buffer();
+    JSONWriter json(body);
+    json.begin_object().raw(fragments.http_task).member("action", action);
+    if (action == "abort") {
+        json.member("abort_why", request.options().get(Field::AbortWhy));
     }
-    low_level_request.add_body(net::Body{body});
+    else if (action == "wait") {
+        json.member("wait_expression", request.options().get(Field::WaitExpression));
+    }
+    json.end_object();
+
+    // Build Target
+    const auto& path = context.name();
+    auto target      = stringify("/v1/suites", path, "/status");
 
-    response_ = HTTPDispatcher::exchange_request(cfg_, low_level_request);
+    // Notice: status updates are always awaited, and only dispatched after all previous updates of the same task
+    response_ = exchange_request(make_request(cfg_, target, body), path, true);
 }
 
 void HTTPDispatcher::dispatch_request(const UpdateNodeAttribute& request) {
-    const auto& options     = request.options();
-    const auto& environment = request.environment();
+    const auto& context   = request.context();
+    const auto& fragments = context.fragments();
 
     // Build body
-    auto type = request.options().get("command").value;
-    std::ostringstream oss;
-    // clang-format off
-    oss << R"({)"
-        << R"("ECF_NAME":")" << environment.get("ECF_NAME").value << R"(",)"
-        << R"("ECF_PASS":")" << environment.get("ECF_PASS").value << R"(",)"
-        << R"("ECF_RID":")" << environment.get("ECF_RID").value << R"(",)"
-        << R"("ECF_TRYNO":")" << environment.get("ECF_TRYNO").value << R"(",)"
-        << R"("type":")" << type << R"(",)"
-        << R"("name":")" << options.get("name").value << R"(")";
-    // clang-format on
+    std::string& body = JSONWriter::thread_buffer();
+    JSONWriter json(body);
+    write_attribute(json, fragments, request.options());
 
-    if (auto found = options.find_value("queue_action"); found) {
-        oss << R"(,"queue_action":")" << found.value().value << R"(")";
-    }
-    if (auto found = options.find_value("queue_step"); found) {
-        oss << R"(,"queue_step":")" << found.value().value << R"(")";
-    }
-    if (auto found = options.find_value("queue_path"); found) {
-        oss << R"(,"queue_path":")" << found.value().value << R"(")";
-    }
-    if (auto found = options.find_value("value"); found) {
-        oss << R"(,"value":")" << found.value().value << R"(")";
-    }
-    oss << R"(})";
+    // Build Target
+    const auto& path = context.name();
+    auto target      = stringify("/v1/suites", path, "/attributes");
+
+    // Notice: queue commands reply with a value, and thus must be awaited
+    auto command = request.options().get(Field::Command);
+    bool await   = command != "meter" && command != "label" && command != "event";
+    response_    = exchange_request(make_request(cfg_, target, body), path, await);
+}
+
+void HTTPDispatcher::dispatch_request(const UpdateNodeAttributes& request) {
+    const auto& context   = request.context();
+    const auto& fragments = context.fragments();
 
-    auto body = oss.str();
+    // Build body, as an array with all attributes
+    std::string& body = JSONWriter::thread_buffer();
+    JSONWriter json(body);
+    json.begin_array();
+    for (const auto& attribute : request.attributes()) {
+        write_attribute(json, fragments, attribute);
+    }
+    json.end_array();
 
     // Build Target
-    auto target = net::Target{stringify("/v1/suites", environment.get("ECF_NAME").value, "/attributes")};
+    const auto& path = context.name();
+    auto target      = stringify("/v1/suites", path, "/attributes");
 
-    net::Request<net::Method::PUT> low_level_request{target};
+    response_ = exchange_request(make_request(cfg_, target, body), path, false);
+}
+
+net::Request<net::Method::PUT> HTTPDispatcher::make_request(const ClientCfg& cfg, const std::string& target,
+                                                            const std::string& body) {
+    net::Request<net::Method::PUT> low_level_request{net::Target{target}};
     low_level_request.add_header_field(net::Field{"Accept", "application/json"});
     low_level_request.add_header_field(net::Field{"Content-Type", "application/json"});
     low_level_request.add_header_field(net::Field{"charsets", "utf-8"});
-    std::optional<Token> secret = Tokens().secret(net::URL(net::Host(cfg_.host, cfg_.port), net::Target("/v1")).str());
-    if (secret) {
-        low_level_request.add_header_field(net::Field{"Authorization", "Bearer " + secret.value().key});
+    auto url = net::URL(net::Host(cfg.host, cfg.port), net::Target("/v1")).str();
+    if (auto authorization = TokenCache::instance().authorization(url); authorization) {
+        low_level_request.add_header_field(net::Field{"Authorization", std::move(*authorization)});
     }
     low_level_request.add_body(net::Body{body});
-
-    response_ = HTTPDispatcher::exchange_request(cfg_, low_level_request);
+    return low_level_request;
 }
 
 }  // namespace ecflow::light
@@ -11,6 +11,8 @@
 #ifndef ECFLOW_LIGHT_DISPATCHER_H
 #define ECFLOW_LIGHT_DISPATCHER_H
 
+#include <future>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <regex>
@@ -20,29 +22,47 @@
 
 #include <eckit/exception/Exceptions.h>
 
+#include "ecflow/light/Acknowledged.h"
 #include "ecflow/light/Configuration.h"
+#include "ecflow/light/Deadline.h"
 #include "ecflow/light/Exception.h"
 #include "ecflow/light/Log.h"
 #include "ecflow/light/Requests.h"
+#include "ecflow/light/Spawner.h"
+#include "ecflow/light/TraceBuffer.h"
+#include "ecflow/light/UDPSocket.h"
+#include "ecflow/light/WireFormat.h"
 
 namespace ecflow::light {
 
+/**
+ * UnreachableServer signals that a request could not be delivered (e.g. the server is down), and thus it might
+ * succeed when sent again later
+ */
+struct UnreachableServer : public eckit::Exception {
+    UnreachableServer(const std::string& msg, const eckit::CodeLocation& loc) : eckit::Exception(msg, loc) {}
+};
+
 // *** Client Dispatcher (Common) **********************************************
 // *****************************************************************************
 
 template <typename DISPATCHER>
 class BaseRequestDispatcher : public RequestDispatcher {
 public:
-    explicit BaseRequestDispatcher(const ClientCfg& cfg) : cfg_{cfg}, response_{} {}
+    explicit BaseRequestDispatcher(const ClientCfg& cfg) : cfg_{cfg}, response_{}, bytes_{0} {}
 
     Response call_dispatch(const Request& request) {
         request.dispatch(*this);
         return response_;
     }
 
+    // Number of bytes sent (e.g. the size of all datagrams), as recorded in the trace
+    [[nodiscard]] size_t bytes() const { return bytes_; }
+
 protected:
     const ClientCfg& cfg_;  // TODO: To remove as this is not used in this class anymore
     Response response_;
+    size_t bytes_;
 };
 
 // *** Client Dispatcher (CLI) *************************************************
@@ -50,31 +70,104 @@ protected:
 
 struct CLIDispatcher : public BaseRequestDispatcher<CLIDispatcher> {
 public:
+    using transport_t = Spawner;
+
+    static constexpr auto Transport = TraceRecord::Transport::CLI;
+
+    static transport_t make_transport(const ClientCfg& cfg);
+
+    /**
+     * Creates a dispatcher that uses its own spawner, thus waiting for the launched process on destruction
+     */
     explicit CLIDispatcher(const ClientCfg& cfg);
+    /**
+     * Creates a dispatcher that uses the given (long-lived) spawner
+     */
+    CLIDispatcher(const ClientCfg& cfg, transport_t& transport);
 
     void dispatch_request(const UpdateNodeStatus& request [[maybe_unused]]) override;
     void dispatch_request(const UpdateNodeAttribute& request) override;
+    void dispatch_request(const UpdateNodeAttributes& request) override;
+
+    /**
+     * Formats the arguments (excluding the executable) to update the attribute, e.g. {"--meter=name", "42"}
+     */
+    static std::vector<std::string> format_arguments(const Options& options);
 
 private:
-    static Response exchange_request(const ClientCfg& cfg, const std::string& request);
+    Response exchange_request(const std::vector<std::string>& arguments);
+
+    std::unique_ptr<transport_t> owned_;
+    transport_t* transport_;
 };
 
 // *** Client Dispatcher (UDP) *************************************************
 // *****************************************************************************
 
+/**
+ * UDPTransport holds the long-lived socket and, in acknowledged mode, the sender that keeps the datagrams for
+ * retransmission until acknowledged by the receiver.
+ */
+struct UDPTransport {
+    explicit UDPTransport(const ClientCfg& cfg);
+
+    net::UDPSocket socket;
+    std::unique_ptr<AcknowledgedSender> acknowledged;
+};
+
 class UDPDispatcher : public BaseRequestDispatcher<UDPDispatcher> {
 public:
-    explicit UDPDispatcher(const ClientCfg& cfg);
+    using transport_t = UDPTransport;
+
+    static constexpr auto Transport = TraceRecord::Transport::UDP;
 
+    static transport_t make_transport(const ClientCfg& cfg);
+
+    /**
+     * Creates a dispatcher that opens its own socket, used only for the lifetime of the dispatcher
+     */
+    explicit UDPDispatcher(const ClientCfg& cfg);
+    /**
+     * Creates a dispatcher that sends all datagrams using the given (long-lived) transport
+     */
+    UDPDispatcher(const ClientCfg& cfg, transport_t& transport);
+
+    /**
+     * Formats the update, as JSON or binary (depending on the configured version)
+     */
     std::string format_request(const UpdateNodeAttribute& request) const;
 
+    /**
+     * Formats the batch of updates into as few datagrams as possible.
+     *
+     * Each datagram packs as many updates as fit under the maximum UDP packet size. In JSON, these are carried as
+     * an array in the "payload" field, and a datagram with a single update uses the same format as an individual
+     * update; in binary, these simply follow the task header.
+     */
+    std::vector<std::string> format_request(const UpdateNodeAttributes& request) const;
+
     void dispatch_request(const UpdateNodeStatus& request) override;
     void dispatch_request(const UpdateNodeAttribute& request) override;
+    void dispatch_request(const UpdateNodeAttributes& request) override;
+
+    static constexpr size_t UDPPacketMaximumSize = 65'507;
+    // Maximum size of the sequence numbers added to each datagram, in acknowledged mode
+    static constexpr size_t SequenceOverhead = 64;
 
 private:
-    static Response exchange_request(const ClientCfg& cfg, const std::string& request);
+    void write_request(std::string& buffer, const UpdateNodeAttribute& request) const;
 
-    static constexpr size_t UDPPacketMaximumSize = 65'507;
+    [[nodiscard]] size_t packet_size(const std::string& datagram) const;
+    [[nodiscard]] size_t maximum_size() const;
+    void check_size(const std::string& datagram) const;
+    bool send(const std::string& datagram, std::string_view key);
+
+    Response exchange_request(const std::string& datagram, std::string_view key);
+    Response exchange_request(const std::vector<std::string>& datagrams);
+
+    WireFormat format_;
+    std::unique_ptr<transport_t> owned_;
+    transport_t* transport_;
 };
 
 // *** Client Dispatcher (HTTP) ************************************************
@@ -82,28 +175,79 @@ private:
 
 class HTTPDispatcher : public BaseRequestDispatcher<HTTPDispatcher> {
 public:
+    using transport_t = net::TinyRESTClient;
+
+    static constexpr auto Transport = TraceRecord::Transport::HTTP;
+
+    static transport_t make_transport(const ClientCfg& cfg);
+
+    /**
+     * Creates a dispatcher that uses its own REST client, used only for the lifetime of the dispatcher
+     */
     explicit HTTPDispatcher(const ClientCfg& cfg);
+    /**
+     * Creates a dispatcher that uses the given (long-lived) REST client, thus reusing its connections
+     */
+    HTTPDispatcher(const ClientCfg& cfg, transport_t& transport);
 
     void dispatch_request(const UpdateNodeStatus& request) override;
     void dispatch_request(const UpdateNodeAttribute& request) override;
+    void dispatch_request(const UpdateNodeAttributes& request) override;
 
 private:
+    static net::Request<net::Method::PUT> make_request(const ClientCfg& cfg, const std::string& target,
+                                                       const std::string& body);
+
+    /**
+     * Exchange the request, using the given key to order it with respect to other requests.
+     *
+     * When the transport is pipelined, a request that doesn't need to be awaited is only queued, and the
+     * response is discarded; unless the client is configured to await the outcome of every request.
+     */
     template <net::Method METHOD>
-    static Response exchange_request(const ClientCfg& cfg, const net::Request<METHOD>& request) {
-        net::Host host{cfg.host, cfg.port};
-
-        Log::debug() << "Dispatching HTTP Request: " << request.body().value() << " to host: " << host.str()
-                     << " and target: " << request.header().target().str() << std::endl;
-
-        net::TinyRESTClient rest;
-        net::Response response = rest.handle(host, request);
-
-        Log::debug() << "Collected HTTP Response: "
-                     << static_cast<std::underlying_type_t<net::Status::Code>>(response.header().status())
-                     << ", body: " << response.body() << std::endl;
+    Response exchange_request(const net::Request<METHOD>& request, const std::string& key, bool await) {
+        net::Host host{cfg_.host, cfg_.port};
+
+        if (debug_enabled()) {
+            Log::debug() << "Dispatching HTTP Request: " << request.body().value() << " to host: " << host.str()
+                         << " and target: " << request.header().target().str() << std::endl;
+        }
+
+        bytes_ += request.body().value().size();
+
+        if (!await && !cfg_.await_outcome && transport_->is_pipelined()) {
+            transport_->submit(host, request, key);
+            return Response{"QUEUED", Response::Outcome::Queued};
+        }
+
+        auto pending = transport_->submit(host, request, key);
+        if (auto deadline = Deadline::current(); deadline) {
+            if (pending.wait_until(*deadline) != std::future_status::ready) {
+                ECFLOW_LIGHT_THROW(DeadlineExceeded,
+                                   Message("Deadline exceeded while awaiting HTTP Response from host: ", host.str()));
+            }
+        }
+        net::Response response = pending.get();
+
+        auto status = static_cast<std::underlying_type_t<net::Status::Code>>(response.header().status());
+        if (debug_enabled()) {
+            Log::debug() << "Collected HTTP Response: " << status << ", body: " << response.body() << std::endl;
+        }
+
+        if (status >= 500) {
+            if (Deadline::expired()) {
+                ECFLOW_LIGHT_THROW(DeadlineExceeded, Message("Deadline exceeded while sending HTTP Request to host: ",
+                                                             host.str(), ", due to: ", response.body().value()));
+            }
+            ECFLOW_LIGHT_THROW(UnreachableServer, Message("Unable to deliver HTTP Request to host: ", host.str(),
+                                                          ", due to: ", response.body().value()));
+        }
 
         return Response{response.body().value()};
     }
+
+    std::unique_ptr<transport_t> owned_;
+    transport_t* transport_;
 };
 
 }  // namespace ecflow::light
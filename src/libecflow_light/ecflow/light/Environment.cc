@@ -10,12 +10,84 @@
 
 #include "ecflow/light/Environment.h"
 
+#include <algorithm>
+#include <cctype>
+#include <iterator>
 #include <regex>
 
+#include "ecflow/light/JSON.h"
 #include "ecflow/light/Log.h"
+#include "ecflow/light/WireFormat.h"
 
 namespace ecflow::light {
 
+namespace {
+
+std::optional<std::string> value_of(const Environment& environment, const Variable::name_t& name) {
+    if (auto variable = environment.get_optional(name); variable) {
+        return variable->value;
+    }
+    return std::nullopt;
+}
+
+}  // namespace
+
+TaskFragments::TaskFragments(const TaskContext& context) : udp_header{}, udp_binary{}, http_task{}, path{} {
+    {
+        JSONWriter json(udp_header);
+        json.member("task_rid", context.rid()).member("task_password", context.password());
+        // Notice: the try number is sent as a number, whenever possible
+        const auto& try_no = context.try_no();
+        auto is_digit      = [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; };
+        if (!try_no.empty() && std::all_of(std::begin(try_no), std::end(try_no), is_digit)) {
+            json.key("task_try_no").raw(try_no);
+        }
+        else {
+            json.member("task_try_no", try_no);
+        }
+    }
+    BinaryEncoder::write_task(udp_binary, context.rid(), context.password(), context.try_no(), context.name());
+    {
+        JSONWriter json(http_task);
+        json.member("ECF_NAME", context.name())
+            .member("ECF_PASS", context.password())
+            .member("ECF_RID", context.rid())
+            .member("ECF_TRYNO", context.try_no());
+    }
+    JSONWriter::append_string(path, context.name());
+}
+
+const std::shared_ptr<const TaskContext>& TaskContext::current() {
+    static const std::shared_ptr<const TaskContext> context = make(Environment::environment());
+    return context;
+}
+
+std::shared_ptr<const TaskContext> TaskContext::make(const Environment& environment) {
+    return std::shared_ptr<const TaskContext>(new TaskContext(environment));
+}
+
+TaskContext::TaskContext(const Environment& environment) :
+    name_{value_of(environment, "ECF_NAME")},
+    password_{value_of(environment, "ECF_PASS")},
+    rid_{value_of(environment, "ECF_RID")},
+    try_no_{value_of(environment, "ECF_TRYNO")},
+    fragments_{} {
+    // Notice: without the full identification of the task, the missing variable is only reported on use
+    if (name_ && password_ && rid_ && try_no_) {
+        fragments_.emplace(*this);
+    }
+}
+
+const TaskFragments& TaskContext::fragments() const {
+    if (!fragments_) {
+        get("ECF_NAME", name_);
+        get("ECF_PASS", password_);
+        get("ECF_RID", rid_);
+        get("ECF_TRYNO", try_no_);
+    }
+    return fragments_.value();
+}
+
 std::string replace_env_var(const std::string& parameter, const Environment& environment) {
     static std::regex regex(R"(\$ENV\{([^}]*)\})");
     std::smatch match;
@@ -11,6 +11,7 @@
 #ifndef ECFLOW_LIGHT_ENVIRONMENT_H
 #define ECFLOW_LIGHT_ENVIRONMENT_H
 
+#include <memory>
 #include <optional>
 #include <string>
 #include <unordered_map>
@@ -87,7 +88,10 @@ public:
                                              .from_environment("ECF_HOST")
                                              .from_environment("ECF_UDP_PORT")
                                              .from_environment("NO_ECF")
-                                             .from_environment("IFS_ECF_CONFIG_PATH");
+                                             .from_environment("IFS_ECF_CONFIG_PATH")
+                                             .from_environment("ECFLOW_LIGHT_ASYNC")
+                                             .from_environment("ECFLOW_LIGHT_AGENT")
+                                             .from_environment("ECFLOW_LIGHT_TRACE");
         return environment;
     }
 
@@ -164,6 +168,65 @@ private:
     dict_t environment_;
 };
 
+class TaskContext;
+
+/**
+ * TaskFragments holds the serialised members that depend only on the task, and are thus the same for all
+ * requests issued on behalf of the task.
+ */
+struct TaskFragments {
+    explicit TaskFragments(const TaskContext& context);
+
+    std::string udp_header;  // i.e. "task_rid":"...","task_password":"...","task_try_no":...
+    std::string udp_binary;  // i.e. binary header, followed by the task fields
+    std::string http_task;   // i.e. "ECF_NAME":"...","ECF_PASS":"...","ECF_RID":"...","ECF_TRYNO":"..."
+    std::string path;        // i.e. "/path/to/task"
+};
+
+/**
+ * TaskContext holds the identification of the task (i.e. ECF_NAME, ECF_PASS, ECF_RID, ECF_TRYNO).
+ *
+ * The context is captured once, and shared (read-only) by all requests issued on behalf of the task, so that
+ * creating a request never requires copying (or looking up) the environment. The serialised fragments of the
+ * task are computed together with the context, and thus live exactly as long as the requests using them.
+ */
+class TaskContext {
+public:
+    /**
+     * @return the context of the current task, captured from the environment on first use
+     */
+    static const std::shared_ptr<const TaskContext>& current();
+
+    static std::shared_ptr<const TaskContext> make(const Environment& environment);
+
+    [[nodiscard]] const std::string& name() const { return get("ECF_NAME", name_); }
+    [[nodiscard]] const std::string& password() const { return get("ECF_PASS", password_); }
+    [[nodiscard]] const std::string& rid() const { return get("ECF_RID", rid_); }
+    [[nodiscard]] const std::string& try_no() const { return get("ECF_TRYNO", try_no_); }
+
+    /**
+     * @return the serialised fragments of the task; throws EnvironmentVariableNotFound if any variable is missing
+     */
+    [[nodiscard]] const TaskFragments& fragments() const;
+
+private:
+    explicit TaskContext(const Environment& environment);
+
+    static const std::string& get(const char* variable_name, const std::optional<std::string>& value) {
+        if (!value) {
+            ECFLOW_LIGHT_THROW(EnvironmentVariableNotFound,
+                               Message("Environment Variable '", variable_name, "' not found"));
+        }
+        return value.value();
+    }
+
+    std::optional<std::string> name_;
+    std::optional<std::string> password_;
+    std::optional<std::string> rid_;
+    std::optional<std::string> try_no_;
+    std::optional<TaskFragments> fragments_;
+};
+
 /**
  * Replace occurrences of environment variables in the given 'parameter' string,
  * using the provided 'environment' for variable lookup.
@@ -11,7 +11,7 @@
 #ifndef ECFLOW_LIGHT_INTERNALAPI_H
 #define ECFLOW_LIGHT_INTERNALAPI_H
 
-#include <string>
+#include <string_view>
 
 namespace ecflow::light {
 
@@ -48,11 +48,15 @@ namespace ecflow::light {
  *  @return <em>EXIT_SUCCESS</em> when request what handled successfully;
  *          otherwise, <em>EXIT_FAILURE</em>.
  */
-int update_meter(const std::string& name, int value);
+int update_meter(std::string_view name, int value);
 
-int update_label(const std::string& name, const std::string& value);
+int update_label(std::string_view name, std::string_view value);
 
-int update_event(const std::string& name, bool value);
+int update_event(std::string_view name, bool value);
+
+int batch_begin();
+
+int batch_commit();
 
 }  // namespace ecflow::light
 
@@ -0,0 +1,171 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include "ecflow/light/JSON.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <charconv>
+
+#include "ecflow/light/Exception.h"
+
+namespace ecflow::light {
+
+namespace {
+
+constexpr bool needs_escape(char c) {
+    return static_cast<unsigned char>(c) < 0x20 || c == '"' || c == '\\';
+}
+
+void append_escaped(std::string& buffer, char c) {
+    switch (c) {
+        case '"':
+            buffer += R"(\")";
+            break;
+        case '\\':
+            buffer += R"(\\)";
+            break;
+        case '\b':
+            buffer += R"(\b)";
+            break;
+        case '\f':
+            buffer += R"(\f)";
+            break;
+        case '\n':
+            buffer += R"(\n)";
+            break;
+        case '\r':
+            buffer += R"(\r)";
+            break;
+        case '\t':
+            buffer += R"(\t)";
+            break;
+        default: {
+            constexpr const char* digits = "0123456789abcdef";
+            auto code                    = static_cast<unsigned char>(c);
+            buffer += R"(\u00)";
+            buffer += digits[code >> 4];
+            buffer += digits[code & 0x0F];
+        }
+    }
+}
+
+}  // namespace
+
+std::string& JSONWriter::thread_buffer() {
+    thread_local std::string buffer;
+    buffer.clear();
+    return buffer;
+}
+
+JSONWriter& JSONWriter::key(std::string_view name) {
+    separate();
+    append_string(buffer_, name);
+    buffer_ += ':';
+    after_key_ = true;
+    return *this;
+}
+
+JSONWriter& JSONWriter::value(std::string_view text) {
+    separate();
+    append_string(buffer_, text);
+    return *this;
+}
+
+JSONWriter& JSONWriter::value(int64_t number) {
+    separate();
+    // Notice: the buffer fits any 64-bit integer, and thus the conversion never fails
+    std::array<char, 24> digits{};
+    auto result = std::to_chars(digits.data(), digits.data() + digits.size(), number);
+    buffer_.append(digits.data(), static_cast<size_t>(result.ptr - digits.data()));
+    return *this;
+}
+
+JSONWriter& JSONWriter::raw(std::string_view fragment) {
+    separate();
+    buffer_ += fragment;
+    return *this;
+}
+
+void JSONWriter::append_string(std::string& buffer, std::string_view text) {
+    buffer += '"';
+    while (!text.empty()) {
+        size_t position = find_escape(text);
+        buffer.append(text.data(), position);
+        if (position == text.size()) {
+            break;
+        }
+        append_escaped(buffer, text[position]);
+        text.remove_prefix(position + 1);
+    }
+    buffer += '"';
+}
+
+size_t JSONWriter::find_escape(std::string_view text) {
+    const char* data = text.data();
+    size_t size      = text.size();
+    size_t position  = 0;
+
+#if defined(__SSE2__)
+    // Check 16 characters at a time, as most strings require no escaping at all
+    const __m128i quote     = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control   = _mm_set1_epi8(0x1F);
+    for (; position + 16 <= size; position += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position));
+        // Notice: (unsigned) characters up to 0x1F are the only ones unchanged by min(c, 0x1F)
+        __m128i found = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                                     _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));
+        if (int mask = _mm_movemask_epi8(found); mask != 0) {
+            return position + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+    }
+#endif
+
+    for (; position < size; ++position) {
+        if (needs_escape(data[position])) {
+            return position;
+        }
+    }
+    return size;
+}
+
+void JSONWriter::separate() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (!first_[depth_]) {
+        buffer_ += ',';
+    }
+    first_[depth_] = false;
+}
+
+JSONWriter& JSONWriter::open(char bracket) {
+    if (depth_ == MaximumDepth) {
+        ECFLOW_LIGHT_THROW(BadValue, Message("Unable to write JSON, as maximum depth (", MaximumDepth, ") exceeded"));
+    }
+    separate();
+    buffer_ += bracket;
+    first_[++depth_] = true;
+    return *this;
+}
+
+JSONWriter& JSONWriter::close(char bracket) {
+    if (depth_ > 0) {
+        --depth_;
+    }
+    buffer_ += bracket;
+    return *this;
+}
+
+}  // namespace ecflow::light
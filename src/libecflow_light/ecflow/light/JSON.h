@@ -0,0 +1,94 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#ifndef ECFLOW_LIGHT_JSON_H
+#define ECFLOW_LIGHT_JSON_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace ecflow::light {
+
+// *** JSON Writer *************************************************************
+// *****************************************************************************
+
+/**
+ * JSONWriter serialises JSON directly into a (caller provided) buffer, appending to its current contents.
+ *
+ * Separators between members (or elements) are added automatically, strings are always escaped, and integers are
+ * formatted independently of the locale. To avoid repeated (re)allocations, the buffer is typically the
+ * thread-local buffer, which keeps its capacity between uses.
+ *
+ * Members (or elements) written at the top level are also separated, allowing to write fragments (e.g. a set
+ * of members, to be later embedded into an object).
+ *
+ * Notice: the writer does not validate the structure (e.g. that each key is followed by a value).
+ */
+class JSONWriter {
+public:
+    explicit JSONWriter(std::string& buffer) : buffer_{buffer}, depth_{0}, first_{{true}}, after_key_{false} {}
+
+    /**
+     * @return the (cleared) buffer of the current thread
+     */
+    static std::string& thread_buffer();
+
+    JSONWriter& begin_object() { return open('{'); }
+    JSONWriter& end_object() { return close('}'); }
+    JSONWriter& begin_array() { return open('['); }
+    JSONWriter& end_array() { return close(']'); }
+
+    JSONWriter& key(std::string_view name);
+
+    JSONWriter& value(std::string_view text);
+    JSONWriter& value(const char* text) { return value(std::string_view{text}); }
+    JSONWriter& value(int64_t number);
+
+    /**
+     * Appends the given (already serialised) JSON fragment, handled as a single member (or element)
+     */
+    JSONWriter& raw(std::string_view fragment);
+
+    template <typename T>
+    JSONWriter& member(std::string_view name, const T& value) {
+        return key(name).value(value);
+    }
+
+    [[nodiscard]] const std::string& str() const { return buffer_; }
+
+    /**
+     * Appends the given text, as a quoted and escaped JSON string
+     */
+    static void append_string(std::string& buffer, std::string_view text);
+
+    /**
+     * @return the position of the first character of 'text' that requires escaping; or text.size(), if none
+     */
+    static size_t find_escape(std::string_view text);
+
+private:
+    static constexpr size_t MaximumDepth = 16;
+
+    void separate();
+    JSONWriter& open(char bracket);
+    JSONWriter& close(char bracket);
+
+    std::string& buffer_;
+    size_t depth_;
+    std::array<bool, MaximumDepth + 1> first_;
+    bool after_key_;
+};
+
+}  // namespace ecflow::light
+
+#endif
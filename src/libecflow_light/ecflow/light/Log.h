@@ -12,19 +12,30 @@
 #define ECFLOW_LIGHT_LOG_H
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <iostream>
-#include <sstream>
 #include <string>
 
 #include <eckit/log/Log.h>
 
+// Notice: tracing can be compiled out (i.e. building with ECFLOW_LIGHT_DISABLE_TRACE defined)
+#if defined(ECFLOW_LIGHT_DISABLE_TRACE)
+
+#define ECFLOW_LIGHT_TRACE_FUNCTION0 static_cast<void>(0)
+
+#define ECFLOW_LIGHT_TRACE_FUNCTION(...) static_cast<void>(0)
+
+#else
+
 #define ECFLOW_LIGHT_TRACE_FUNCTION0 \
     ecflow::light::ScopeTrace tracer_instancer_(ecflow::light::Location(__FILE__, __LINE__), __func__)
 
 #define ECFLOW_LIGHT_TRACE_FUNCTION(...) \
     ecflow::light::ScopeTrace tracer_instancer_(ecflow::light::Location(__FILE__, __LINE__), __func__, __VA_ARGS__)
 
+#endif
+
 namespace ecflow::light {
 
 // *** Logging  ****************************************************************
@@ -32,17 +43,47 @@ namespace ecflow::light {
 
 using Log = eckit::Log;
 
+namespace implementation_detail {
+
+// The state of the debug channel: unknown (i.e. not yet checked), disabled or enabled
+enum class DebugState : int { Unknown = -1, Disabled = 0, Enabled = 1 };
+
+inline std::atomic<DebugState> debug_state{DebugState::Unknown};
+
+inline bool check_debug_enabled() {
+    bool enabled = static_cast<bool>(Log::debug());
+    debug_state.store(enabled ? DebugState::Enabled : DebugState::Disabled, std::memory_order_relaxed);
+    return enabled;
+}
+
+}  // namespace implementation_detail
+
+/**
+ * @return true, if debug messages are logged
+ *
+ * Notice: the debug channel is only checked on first use (i.e. after eckit is initialised), so that guarding the
+ *         formatting of a debug message with this check costs a single branch when debug is disabled.
+ */
+inline bool debug_enabled() {
+    using implementation_detail::DebugState;
+    DebugState state = implementation_detail::debug_state.load(std::memory_order_relaxed);
+    if (state == DebugState::Disabled) {
+        return false;
+    }
+    return state == DebugState::Enabled || implementation_detail::check_debug_enabled();
+}
+
 // *** Location*****************************************************************
 // *****************************************************************************
 
 class Location {
 public:
-    Location(std::string file, uint32_t line) : file_{std::move(file)}, line_{line} {}
+    constexpr Location(const char* file, uint32_t line) : file_{file}, line_{line} {}
 
 private:
     friend std::ostream& operator<<(std::ostream& o, const Location& l);
 
-    std::string file_;
+    const char* file_;
     uint32_t line_;
 };
 
@@ -54,34 +95,44 @@ inline std::ostream& operator<<(std::ostream& o, const Location& l) {
 // *** Trace *******************************************************************
 // *****************************************************************************
 
+/**
+ * ScopeTrace logs (as debug) entering and exiting the scope, including the given arguments.
+ *
+ * Nothing is formatted when debug is disabled, in which case the trace costs a single branch.
+ */
 class ScopeTrace {
 public:
     template <typename... ARGS>
-    ScopeTrace(Location location, std::string scope, ARGS... args) :
-        location_{std::move(location)}, scope_{std::move(scope)} {
-
-        Log::debug() << begin_msg(location_, scope_, args...);
+    ScopeTrace(Location location, const char* scope, const ARGS&... args) :
+        location_{location}, scope_{scope}, enabled_{debug_enabled()} {
+        if (enabled_) {
+            enter(args...);
+        }
+    }
+    ~ScopeTrace() {
+        if (enabled_) {
+            exit();
+        }
     }
-    ~ScopeTrace() { Log::debug() << make_end_msg(location_, scope_); }
+
+    // ScopeTrace object cannot be copied!
+    ScopeTrace(const ScopeTrace&)            = delete;
+    ScopeTrace& operator=(const ScopeTrace&) = delete;
 
 private:
     template <typename... ARGS>
-    static std::string begin_msg(const Location& loc, const std::string& name, ARGS... args) {
-        std::ostringstream oss;
-        oss << "Entering " << name << "(";
-        ((oss << "<" << std::forward<ARGS>(args) << ">"), ...);
-        oss << ") at " << loc;
-        return oss.str();
+    void enter(const ARGS&... args) const {
+        auto& out = Log::debug();
+        out << "Entering " << scope_ << "(";
+        ((out << "<" << args << ">"), ...);
+        out << ") at " << location_ << std::endl;
     }
 
-    static std::string make_end_msg(const Location& loc, const std::string& name) {
-        std::ostringstream oss;
-        oss << "Exiting " << name << " at " << loc;
-        return oss.str();
-    }
+    void exit() const { Log::debug() << "Exiting " << scope_ << " at " << location_ << std::endl; }
 
     Location location_;
-    std::string scope_;
+    const char* scope_;
+    bool enabled_;
 };
 
 }  // namespace ecflow::light
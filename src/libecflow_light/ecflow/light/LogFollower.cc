@@ -0,0 +1,529 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include "ecflow/light/LogFollower.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <queue>
+
+#include <eckit/config/YAMLConfiguration.h>
+#include <eckit/filesystem/PathName.h>
+
+#include "ecflow/light/Conversion.h"
+#include "ecflow/light/Log.h"
+
+namespace ecflow::light {
+
+// *** Pattern Set *************************************************************
+// *****************************************************************************
+
+namespace {
+
+constexpr uint32_t NoNode = std::numeric_limits<uint32_t>::max();
+
+/**
+ * @return the position just after the group (or character class) starting at the given position
+ */
+size_t skip_group(std::string_view pattern, size_t i) {
+    int depth     = 0;
+    bool in_class = false;
+    for (; i < pattern.size(); ++i) {
+        char c = pattern[i];
+        if (c == '\\') {
+            ++i;
+        }
+        else if (in_class) {
+            in_class = c != ']';
+        }
+        else if (c == '[') {
+            in_class = true;
+            // Notice: a ']' right after the opening (or negation) is part of the class
+            if (i + 1 < pattern.size() && pattern[i + 1] == '^') {
+                ++i;
+            }
+            if (i + 1 < pattern.size() && pattern[i + 1] == ']') {
+                ++i;
+            }
+        }
+        else if (c == '(') {
+            ++depth;
+        }
+        else if (c == ')' && --depth == 0) {
+            return i + 1;
+        }
+        if (depth == 0 && !in_class) {
+            return i + 1;
+        }
+    }
+    return pattern.size();
+}
+
+}  // namespace
+
+PatternSet::PatternSet() :
+    patterns_{}, literals_{}, unconditional_{}, built_{false}, nodes_{}, found_{}, candidates_{} {}
+
+size_t PatternSet::add(const std::string& pattern) {
+    try {
+        patterns_.emplace_back(pattern, std::regex::ECMAScript | std::regex::optimize);
+    }
+    catch (std::regex_error& e) {
+        ECFLOW_LIGHT_THROW(InvalidRule, Message("Invalid pattern '", pattern, "', due to: ", e.what()));
+    }
+
+    size_t index = patterns_.size() - 1;
+    literals_.push_back(required_literal(pattern));
+    if (literals_.back().empty()) {
+        unconditional_.push_back(index);
+    }
+    built_ = false;
+    return index;
+}
+
+std::string PatternSet::required_literal(std::string_view pattern) {
+    // Notice: an alternative at the top level means that no single literal is required
+    for (size_t i = 0; i < pattern.size();) {
+        char c = pattern[i];
+        if (c == '|') {
+            return {};
+        }
+        i = (c == '\\') ? i + 2 : (c == '(' || c == '[') ? skip_group(pattern, i) : i + 1;
+    }
+
+    std::string longest;
+    std::string current;
+    auto end_run = [&longest, &current]() {
+        if (current.size() > longest.size()) {
+            longest = current;
+        }
+        current.clear();
+    };
+
+    size_t i = 0;
+    while (i < pattern.size()) {
+        // Determine the next atom, either a literal character or anything else (e.g. group, class, '.')
+        bool literal = false;
+        char c       = pattern[i];
+        if (c == '\\') {
+            if (i + 1 == pattern.size()) {
+                break;
+            }
+            char escaped = pattern[i + 1];
+            // Notice: only escaped punctuation (e.g. '\.') stands for itself; '\d', '\n', '\1', etc. do not
+            literal = std::ispunct(static_cast<unsigned char>(escaped)) != 0;
+            c       = escaped;
+            i += 2;
+        }
+        else if (c == '(' || c == '[') {
+            i = skip_group(pattern, i);
+        }
+        else {
+            literal = c != '.' && c != '^' && c != '$';
+            i += 1;
+        }
+
+        // Consider the quantifier, if any
+        bool optional = false;
+        bool repeated = false;
+        if (i < pattern.size()) {
+            char q = pattern[i];
+            if (q == '*' || q == '?') {
+                optional = true;
+                ++i;
+            }
+            else if (q == '+') {
+                repeated = true;
+                ++i;
+            }
+            else if (q == '{') {
+                auto closing = pattern.find('}', i);
+                optional     = i + 1 < pattern.size() && pattern[i + 1] == '0';
+                repeated     = !optional;
+                i            = closing == std::string_view::npos ? pattern.size() : closing + 1;
+            }
+            // Skip the lazy modifier
+            if ((optional || repeated) && i < pattern.size() && pattern[i] == '?') {
+                ++i;
+            }
+        }
+
+        if (literal && !optional) {
+            current.push_back(c);
+        }
+        if (!literal || optional || repeated) {
+            end_run();
+        }
+    }
+    end_run();
+
+    return longest;
+}
+
+const std::vector<size_t>& PatternSet::candidates(std::string_view line) const {
+    if (!built_) {
+        build();
+    }
+
+    uint32_t state = 0;
+    for (char c : line) {
+        state = nodes_[state].next[static_cast<unsigned char>(c)];
+        for (size_t index : nodes_[state].outputs) {
+            found_[index] = 1;
+        }
+    }
+
+    candidates_.clear();
+    for (size_t index = 0; index < found_.size(); ++index) {
+        if (found_[index] || literals_[index].empty()) {
+            candidates_.push_back(index);
+        }
+        found_[index] = 0;
+    }
+    return candidates_;
+}
+
+void PatternSet::build() const {
+    nodes_.assign(1, Node{});
+    nodes_[0].next.fill(NoNode);
+
+    // Build the trie of all literals...
+    for (size_t index = 0; index < literals_.size(); ++index) {
+        uint32_t state = 0;
+        for (char c : literals_[index]) {
+            auto& next = nodes_[state].next[static_cast<unsigned char>(c)];
+            if (next == NoNode) {
+                next = static_cast<uint32_t>(nodes_.size());
+                nodes_.push_back(Node{});
+                nodes_.back().next.fill(NoNode);
+            }
+            state = nodes_[state].next[static_cast<unsigned char>(c)];
+        }
+        if (!literals_[index].empty()) {
+            nodes_[state].outputs.push_back(index);
+        }
+    }
+
+    // ... and turn it into a complete automaton, following the failure links (in breadth first order)
+    std::queue<uint32_t> pending;
+    for (auto& next : nodes_[0].next) {
+        if (next == NoNode) {
+            next = 0;
+        }
+        else {
+            nodes_[next].fail = 0;
+            pending.push(next);
+        }
+    }
+    while (!pending.empty()) {
+        uint32_t state = pending.front();
+        pending.pop();
+
+        for (size_t c = 0; c < 256; ++c) {
+            uint32_t fallback = nodes_[nodes_[state].fail].next[c];
+            uint32_t next     = nodes_[state].next[c];
+            if (next == NoNode) {
+                nodes_[state].next[c] = fallback;
+            }
+            else {
+                nodes_[next].fail = fallback;
+                const auto& inherited = nodes_[fallback].outputs;
+                nodes_[next].outputs.insert(std::end(nodes_[next].outputs), std::begin(inherited), std::end(inherited));
+                pending.push(next);
+            }
+        }
+    }
+
+    found_.assign(patterns_.size(), 0);
+    candidates_.reserve(patterns_.size());
+    built_ = true;
+}
+
+// *** Log Follower ************************************************************
+// *****************************************************************************
+
+namespace {
+
+std::string expand(const std::string& value, const PatternSet::match_t& match) {
+    std::string expanded;
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (value[i] != '$' || i + 1 == value.size()) {
+            expanded.push_back(value[i]);
+        }
+        else if (value[i + 1] == '$') {
+            expanded.push_back('$');
+            ++i;
+        }
+        else if (std::isdigit(static_cast<unsigned char>(value[i + 1]))) {
+            size_t group = value[++i] - '0';
+            if (group < match.size()) {
+                expanded.append(match[group].first, match[group].second);
+            }
+        }
+        else {
+            expanded.push_back(value[i]);
+        }
+    }
+    return expanded;
+}
+
+}  // namespace
+
+FollowRule FollowRule::make_rule(std::string pattern, std::string command, std::string name, std::string value) {
+    if (command != "meter" && command != "label" && command != "event") {
+        ECFLOW_LIGHT_THROW(InvalidRule, Message("Unknown rule command '", command,
+                                                "' found. Expected one of 'meter', 'label' or 'event'"));
+    }
+    if (name.empty()) {
+        ECFLOW_LIGHT_THROW(InvalidRule, Message("No ", command, " name found, for pattern '", pattern, "'"));
+    }
+    return FollowRule{std::move(pattern), std::move(command), std::move(name), std::move(value)};
+}
+
+std::vector<FollowRule> FollowRule::load(const std::string& path) {
+    Log::debug() << "Loading follow rules from '" << path << "'" << std::endl;
+    eckit::YAMLConfiguration yaml_cfg{eckit::PathName(path)};
+
+    std::vector<FollowRule> rules;
+    for (const auto& rule : yaml_cfg.getSubConfigurations("rules")) {
+        auto get = [&rule](const std::string& name) {
+            std::string value;
+            if (rule.has(name)) {
+                rule.get(name, value);
+            }
+            return value;
+        };
+
+        std::string command;
+        for (const char* candidate : {"meter", "label", "event"}) {
+            if (rule.has(candidate)) {
+                if (!command.empty()) {
+                    ECFLOW_LIGHT_THROW(InvalidRule, Message("Multiple commands found, for pattern '",
+                                                            get("pattern"), "'"));
+                }
+                command = candidate;
+            }
+        }
+        if (command.empty()) {
+            ECFLOW_LIGHT_THROW(InvalidRule, Message("No 'meter', 'label' or 'event' found, for pattern '",
+                                                    get("pattern"), "'"));
+        }
+
+        rules.push_back(make_rule(get("pattern"), command, get(command), get("value")));
+    }
+    return rules;
+}
+
+LogFollower::LogFollower(std::string path, const std::vector<FollowRule>& rules, const ClientAPI& target,
+                         std::shared_ptr<const TaskContext> context) :
+    path_{std::move(path)},
+    rules_{rules},
+    patterns_{},
+    batch_{target, std::move(context), std::cout},
+    fd_{-1},
+    inotify_{-1},
+    watch_{-1},
+    inode_{0},
+    offset_{0},
+    parent_{::getppid()},
+    partial_{},
+    stopping_{false},
+    lines_{0},
+    matches_{0} {
+    for (const auto& rule : rules_) {
+        patterns_.add(rule.pattern);
+    }
+
+    // Notice: when inotify is not available, the file is polled periodically
+    inotify_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_ < 0) {
+        Log::warning() << "Unable to watch '" << path_ << "', due to: " << std::strerror(errno)
+                       << ". Polling instead." << std::endl;
+    }
+}
+
+LogFollower::~LogFollower() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    if (inotify_ >= 0) {
+        ::close(inotify_);
+    }
+    Log::debug() << "Follower stopped, after reading " << lines() << " line(s) (" << matches() << " matched)"
+                 << std::endl;
+}
+
+void LogFollower::follow() {
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        if (::getppid() != parent_) {
+            Log::debug() << "Follower stopping, as the parent process finished" << std::endl;
+            break;
+        }
+
+        drain();
+
+        if (watch_ >= 0) {
+            pollfd descriptor{inotify_, POLLIN, 0};
+            if (::poll(&descriptor, 1, static_cast<int>(IdlePeriod.count())) > 0) {
+                // Discard the events, as the file is read (and checked for replacement) regardless
+                alignas(inotify_event) char events[4096];
+                while (::read(inotify_, events, sizeof(events)) > 0) {
+                }
+            }
+        }
+        else {
+            ::poll(nullptr, 0, static_cast<int>(IdlePeriod.count()));
+        }
+    }
+
+    // Notice: read the lines written up until now, to ensure that no update is lost
+    drain();
+}
+
+void LogFollower::consume(std::string_view data) {
+    while (!data.empty()) {
+        auto eol = data.find('\n');
+        if (eol == std::string_view::npos) {
+            partial_.append(data);
+            return;
+        }
+
+        if (partial_.empty()) {
+            match(data.substr(0, eol));
+        }
+        else {
+            partial_.append(data.substr(0, eol));
+            match(partial_);
+            partial_.clear();
+        }
+        data.remove_prefix(eol + 1);
+    }
+}
+
+void LogFollower::match(std::string_view line) {
+    ++lines_;
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+
+    patterns_.match(line, [this](size_t index, const PatternSet::match_t& match) {
+        ++matches_;
+        const auto& rule = rules_[index];
+
+        std::string value = rule.value;
+        if (value.empty()) {
+            // By default, use the first captured group (or the whole match, if none) for meters and labels
+            value = rule.command == "event" ? "set" : match.size() > 1 ? "$1" : "$0";
+        }
+        value = expand(value, match);
+
+        try {
+            Options options = Options::options().with(Field::Command, rule.command).with(Field::Name, rule.name);
+            if (rule.command == "meter") {
+                options = options.with(Field::Value, convert_to<int>(value));
+            }
+            else if (rule.command == "label") {
+                options = options.with(Field::Value, value);
+            }
+            else if (value == "set" || value == "clear") {
+                options = options.with(Field::Value, value == "set" ? "1" : "0");
+            }
+            else {
+                ECFLOW_LIGHT_THROW(InvalidRule, Message("Incorrect event value '", value,
+                                                        "' found. Expected either 'set' or 'clear'"));
+            }
+            batch_.add(lines_, options);
+        }
+        catch (eckit::Exception& e) {
+            Log::warning() << "Line " << lines_ << ": unable to apply pattern '" << rule.pattern
+                           << "', due to: " << e.what() << std::endl;
+        }
+    });
+}
+
+bool LogFollower::reopen() {
+    int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        // Notice: the file might not have been created yet
+        return false;
+    }
+
+    struct stat status {};
+    ::fstat(fd, &status);
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_     = fd;
+    inode_  = status.st_ino;
+    offset_ = 0;
+    partial_.clear();
+
+    if (inotify_ >= 0) {
+        if (watch_ >= 0) {
+            ::inotify_rm_watch(inotify_, watch_);
+        }
+        watch_ = ::inotify_add_watch(inotify_, path_.c_str(), IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+    }
+
+    Log::debug() << "Following '" << path_ << "'" << std::endl;
+    return true;
+}
+
+void LogFollower::drain() {
+    if (fd_ < 0 && !reopen()) {
+        return;
+    }
+
+    std::vector<char> buffer(ChunkSize);
+    auto read_all = [this, &buffer]() {
+        ssize_t size = 0;
+        while ((size = ::read(fd_, buffer.data(), buffer.size())) > 0 || (size < 0 && errno == EINTR)) {
+            if (size > 0) {
+                offset_ += size;
+                consume(std::string_view(buffer.data(), static_cast<size_t>(size)));
+            }
+        }
+    };
+
+    // Detect truncation...
+    struct stat status {};
+    if (::fstat(fd_, &status) == 0 && status.st_size < offset_) {
+        Log::debug() << "Following '" << path_ << "' from the beginning, as it was truncated" << std::endl;
+        ::lseek(fd_, 0, SEEK_SET);
+        offset_ = 0;
+        partial_.clear();
+    }
+
+    read_all();
+
+    // ... and replacement (e.g. rotation), in which case the new file is read from the beginning
+    if (::stat(path_.c_str(), &status) == 0 && status.st_ino != inode_) {
+        Log::debug() << "Following '" << path_ << "' from the beginning, as it was replaced" << std::endl;
+        if (!partial_.empty()) {
+            match(partial_);
+        }
+        if (reopen()) {
+            read_all();
+        }
+    }
+
+    batch_.flush();
+}
+
+}  // namespace ecflow::light
@@ -0,0 +1,206 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#ifndef ECFLOW_LIGHT_LOGFOLLOWER_H
+#define ECFLOW_LIGHT_LOGFOLLOWER_H
+
+#include <sys/types.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ecflow/light/ClientAPI.h"
+#include "ecflow/light/CommandBatch.h"
+#include "ecflow/light/Exception.h"
+
+namespace ecflow::light {
+
+struct InvalidRule : public eckit::Exception {
+    InvalidRule(const std::string& msg, const eckit::CodeLocation& loc) : eckit::Exception(msg, loc) {}
+};
+
+// *** Pattern Set *************************************************************
+// *****************************************************************************
+
+/**
+ * PatternSet matches each line against several regular expressions at once.
+ *
+ * For each pattern, a literal that must be part of any matching line is extracted (e.g. "Step " for the pattern
+ * "Step (\d+) of \d+"). All literals are searched in a single pass over the line (using an Aho-Corasick automaton),
+ * and only the patterns whose literal is found (or that have no such literal) are then evaluated. As most lines of
+ * a typical log match none of the patterns, most lines are discarded without evaluating any regular expression.
+ *
+ * Notice: matching reuses internal buffers, and thus a PatternSet must not be used concurrently by several threads.
+ */
+class PatternSet {
+public:
+    using match_t = std::match_results<std::string_view::const_iterator>;
+
+    PatternSet();
+
+    /**
+     * Add the (ECMAScript) pattern to the set; throws InvalidRule if the pattern is invalid
+     *
+     * @return the index of the pattern
+     */
+    size_t add(const std::string& pattern);
+
+    /**
+     * Find the patterns that match the line, calling 'on_match(index, match)' for each, in order of the index
+     *
+     * @return the number of matching patterns
+     */
+    template <typename F>
+    size_t match(std::string_view line, F&& on_match) const {
+        size_t matches = 0;
+        for (size_t index : candidates(line)) {
+            match_t match;
+            if (std::regex_search(std::begin(line), std::end(line), match, patterns_[index])) {
+                on_match(index, match);
+                ++matches;
+            }
+        }
+        return matches;
+    }
+
+    [[nodiscard]] size_t size() const { return patterns_.size(); }
+
+    /**
+     * @return the longest literal that is part of any text matching the pattern; or empty, if none can be determined
+     */
+    static std::string required_literal(std::string_view pattern);
+
+private:
+    /**
+     * @return the indices (in order) of the patterns that might match the line
+     */
+    const std::vector<size_t>& candidates(std::string_view line) const;
+
+    void build() const;
+
+    struct Node {
+        std::array<uint32_t, 256> next;
+        uint32_t fail;
+        std::vector<size_t> outputs;
+    };
+
+    std::vector<std::regex> patterns_;
+    std::vector<std::string> literals_;
+    // Patterns without literal, which are always evaluated
+    std::vector<size_t> unconditional_;
+
+    // Notice: the automaton is built lazily, after all patterns have been added
+    mutable bool built_;
+    mutable std::vector<Node> nodes_;
+    mutable std::vector<uint8_t> found_;
+    mutable std::vector<size_t> candidates_;
+};
+
+// *** Log Follower ************************************************************
+// *****************************************************************************
+
+/**
+ * FollowRule maps the lines matching the pattern to an update of a meter, label or event.
+ *
+ * The value is expanded replacing '$N' by the N-th captured group ('$0' being the whole match), and '$$' by '$'.
+ */
+struct FollowRule {
+    std::string pattern;
+    std::string command;  // i.e. "meter", "label" or "event"
+    std::string name;
+    std::string value;
+
+    static FollowRule make_rule(std::string pattern, std::string command, std::string name, std::string value = {});
+
+    /**
+     * Load the rules from the YAML file, given as a list of entries with a 'pattern', one of 'meter', 'label' or
+     * 'event' (i.e. the attribute name), and optionally the 'value'
+     */
+    static std::vector<FollowRule> load(const std::string& path);
+};
+
+/**
+ * LogFollower reads a (growing) log file, and turns the lines matching the rules into attribute updates.
+ *
+ * The updates found in each chunk of the file are sent together, keeping only the latest value of each attribute.
+ * The file is followed until stopped, or until the parent process finishes. Changes are detected with inotify (when
+ * available), and the file is read again from the beginning when truncated or replaced (e.g. rotated).
+ */
+class LogFollower {
+public:
+    LogFollower(std::string path, const std::vector<FollowRule>& rules, const ClientAPI& target,
+                std::shared_ptr<const TaskContext> context);
+    ~LogFollower();
+
+    // LogFollower object cannot be copied!
+    LogFollower(const LogFollower&)            = delete;
+    LogFollower& operator=(const LogFollower&) = delete;
+
+    /**
+     * Follow the file, until stopped or the parent process finishes
+     */
+    void follow();
+
+    /**
+     * Request the follower to stop (notice: safe to call from a signal handler)
+     */
+    void stop() { stopping_.store(true, std::memory_order_relaxed); }
+
+    /**
+     * Consume a chunk of the file, matching all complete lines; an incomplete last line is kept until completed
+     */
+    void consume(std::string_view data);
+
+    /**
+     * Send the updates found since the last flush
+     */
+    void flush() { batch_.flush(); }
+
+    [[nodiscard]] uint64_t lines() const { return lines_; }
+    [[nodiscard]] uint64_t matches() const { return matches_; }
+    [[nodiscard]] size_t failed() const { return batch_.failed(); }
+
+    // The follower periodically checks the file, even when not notified of changes
+    static constexpr auto IdlePeriod = std::chrono::milliseconds(250);
+    static constexpr size_t ChunkSize = 64 * 1024;
+
+private:
+    void match(std::string_view line);
+    bool reopen();
+    void drain();
+
+    std::string path_;
+    std::vector<FollowRule> rules_;
+    PatternSet patterns_;
+    CommandBatch batch_;
+
+    int fd_;
+    int inotify_;
+    int watch_;
+    ino_t inode_;
+    off_t offset_;
+    pid_t parent_;
+    std::string partial_;
+
+    std::atomic<bool> stopping_;
+    uint64_t lines_;
+    uint64_t matches_;
+};
+
+}  // namespace ecflow::light
+
+#endif
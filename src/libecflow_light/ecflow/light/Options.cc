@@ -9,3 +9,63 @@
  */
 
 #include "ecflow/light/Options.h"
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+namespace ecflow::light {
+
+namespace {
+
+constexpr std::array<std::string_view, FieldCount> field_names = {
+    "command", "name", "value", "action", "abort_why", "wait_expression", "queue_action", "queue_step", "queue_path"};
+
+}  // namespace
+
+std::string_view field_name(Field field) {
+    return field_names[static_cast<size_t>(field)];
+}
+
+Field field_of(std::string_view name) {
+    auto found = std::find(std::begin(field_names), std::end(field_names), name);
+    if (found == std::end(field_names)) {
+        ECFLOW_LIGHT_THROW(OptionNotFound, Message("Option '", name, "' is not known"));
+    }
+    return static_cast<Field>(std::distance(std::begin(field_names), found));
+}
+
+Options& Options::with(Field field, std::string_view value) {
+    size_t required = used_ + value.size();
+    if (required > std::numeric_limits<uint16_t>::max()) {
+        ECFLOW_LIGHT_THROW(BadValue, Message("Option '", field_name(field), "' value is too large"));
+    }
+
+    if (!on_heap_ && required > InlineCapacity) {
+        // Notice: the values are moved to the heap, keeping the same offsets
+        heap_.reserve(required);
+        heap_.assign(inline_.data(), used_);
+        on_heap_ = true;
+    }
+
+    if (!on_heap_) {
+        std::copy(std::begin(value), std::end(value), inline_.data() + used_);
+    }
+    else {
+        heap_.append(value);
+    }
+
+    // Notice: a replaced value is not reclaimed, as options are typically assigned only once
+    slots_[index(field)] = Slot{used_, static_cast<uint16_t>(value.size()), true};
+    used_                = static_cast<uint16_t>(required);
+    return *this;
+}
+
+Options& Options::with(Field field, int value) {
+    std::array<char, 16> buffer{};
+    // Notice: the buffer always fits any int value, and thus the conversion never fails
+    auto result = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+    return with(field, std::string_view(buffer.data(), static_cast<size_t>(result.ptr - buffer.data())));
+}
+
+}  // namespace ecflow::light
@@ -11,9 +11,11 @@
 #ifndef ECFLOW_LIGHT_OPTIONS_H
 #define ECFLOW_LIGHT_OPTIONS_H
 
+#include <array>
+#include <cstdint>
 #include <optional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
 #include "ecflow/light/Exception.h"
 
@@ -23,51 +25,89 @@ struct OptionNotFound : public eckit::Exception {
     OptionNotFound(const std::string& msg, const eckit::CodeLocation& loc) : eckit::Exception(msg, loc) {}
 };
 
-struct Option {
-    using name_t  = std::string;
-    using value_t = std::string;
-
-    name_t name;
-    value_t value;
+/**
+ * Field identifies each of the (known) options of a request
+ */
+enum class Field : uint8_t
+{
+    Command,
+    Name,
+    Value,
+    Action,
+    AbortWhy,
+    WaitExpression,
+    QueueAction,
+    QueueStep,
+    QueuePath
 };
 
+constexpr size_t FieldCount = 9;
+
+/**
+ * @return the name of the field (e.g. "queue_action"), as used by the dispatchers
+ */
+std::string_view field_name(Field field);
+
+/**
+ * @return the field with the given name; throws OptionNotFound when the name is unknown
+ */
+Field field_of(std::string_view name);
+
 /**
  * Options stores the information collected from the program options (i.e. cli arguments)
+ *
+ * The values are kept in an inline buffer, so that creating (and copying) the options of a typical update
+ * requires no heap allocation; only when the values exceed the inline capacity are these moved to the heap.
  */
 class Options {
 public:
-    using dict_t = std::unordered_map<std::string, Option>;
+    static constexpr size_t InlineCapacity = 192;
 
     Options() = default;
 
     static Options options() { return {}; };
 
-    [[nodiscard]] Options& with(const Option::name_t& name, const Option::value_t& value) {
-        return this->with(Option{name, value});
-    }
+    [[nodiscard]] Options& with(Field field, std::string_view value);
 
-    [[nodiscard]] Options& with(const Option& option) {
-        options_.insert_or_assign(option.name, option);
-        return *this;
-    }
+    [[nodiscard]] Options& with(Field field, int value);
+
+    [[nodiscard]] Options& with(std::string_view name, std::string_view value) { return with(field_of(name), value); }
 
-    [[nodiscard]] const Option& get(const std::string& name) const {
-        auto found = options_.find(name);
-        if (found == std::end(options_)) {
-            ECFLOW_LIGHT_THROW(OptionNotFound, Message("Option '", name, "' not found"));
+    [[nodiscard]] bool has(Field field) const { return slots_[index(field)].present; }
+
+    [[nodiscard]] std::string_view get(Field field) const {
+        if (!has(field)) {
+            ECFLOW_LIGHT_THROW(OptionNotFound, Message("Option '", field_name(field), "' not found"));
         }
-        return found->second;
+        return view(slots_[index(field)]);
     }
 
-    [[nodiscard]] std::optional<Option> find_value(const std::string& name) const {
-        if (auto found = options_.find(name); found != std::end(options_)) {
-            return std::make_optional(found->second);
+    [[nodiscard]] std::string_view get(std::string_view name) const { return get(field_of(name)); }
+
+    [[nodiscard]] std::optional<std::string_view> find(Field field) const {
+        if (!has(field)) {
+            return std::nullopt;
         }
-        return std::nullopt;
+        return view(slots_[index(field)]);
     }
 
 private:
-    dict_t options_;
+    struct Slot {
+        uint16_t offset = 0;
+        uint16_t size   = 0;
+        bool present    = false;
+    };
+
+    static constexpr size_t index(Field field) { return static_cast<size_t>(field); }
+
+    [[nodiscard]] const char* data() const { return on_heap_ ? heap_.data() : inline_.data(); }
+    [[nodiscard]] std::string_view view(const Slot& slot) const { return {data() + slot.offset, slot.size}; }
+
+    std::array<Slot, FieldCount> slots_{};
+    uint16_t used_ = 0;
+    bool on_heap_  = false;  // Notice: explicit, as the heap storage might still be empty when first used
+    std::array<char, InlineCapacity> inline_{};
+    std::string heap_;
 };
 
 }  // namespace ecflow::light
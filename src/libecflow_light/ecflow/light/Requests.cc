@@ -12,17 +12,6 @@
 
 namespace ecflow::light {
 
-// *** Request(s) **************************************************************
-// *****************************************************************************
-
-void UpdateNodeStatus::call_dispatch(RequestDispatcher& dispatcher) const {
-    dispatcher.dispatch_request(*this);
-}
-
-void UpdateNodeAttribute::call_dispatch(RequestDispatcher& dispatcher) const {
-    dispatcher.dispatch_request(*this);
-}
-
 // *** Response(s) *************************************************************
 // *****************************************************************************
 
@@ -12,6 +12,9 @@
 #define ECFLOW_LIGHT_REQUESTS_H
 
 #include <memory>
+#include <string>
+#include <variant>
+#include <vector>
 
 #include "ecflow/light/Configuration.h"
 #include "ecflow/light/Environment.h"
@@ -20,105 +23,135 @@
 
 namespace ecflow::light {
 
-struct RequestDispatcher;
-
 // *** Request(s)***************************************************************
 // *****************************************************************************
 
-struct RequestMessage {
-    virtual ~RequestMessage() = default;
-
-    [[nodiscard]] virtual const Environment& environment() const = 0;
-    [[nodiscard]] virtual const Options& options() const         = 0;
+/**
+ * TaskRequest holds the information common to all requests: the (shared) task context, and the request options.
+ */
+class TaskRequest {
+public:
+    TaskRequest(std::shared_ptr<const TaskContext> context, Options options) :
+        context_{std::move(context)}, options_{std::move(options)} {}
 
-    virtual std::string description() = 0;
+    [[nodiscard]] const TaskContext& context() const { return *context_; }
+    [[nodiscard]] const std::shared_ptr<const TaskContext>& shared_context() const { return context_; }
+    [[nodiscard]] const Options& options() const { return options_; }
 
-    virtual void dispatch(RequestDispatcher& dispatcher) const = 0;
+private:
+    std::shared_ptr<const TaskContext> context_;
+    Options options_;
 };
 
-template <typename R>
-struct DefaultRequestMessage : public RequestMessage {
-
-    DefaultRequestMessage() : environment_{}, options_{} {}
-    DefaultRequestMessage(Environment environment, Options options) :
-        environment_{std::move(environment)}, options_{std::move(options)} {}
+struct UpdateNodeStatus : TaskRequest {
 
-    [[nodiscard]] const Environment& environment() const final { return environment_; };
-    [[nodiscard]] const Options& options() const final { return options_; };
+    UpdateNodeStatus(std::shared_ptr<const TaskContext> context, Options options) :
+        TaskRequest{std::move(context), std::move(options)} {}
+    UpdateNodeStatus(const Environment& environment, Options options) :
+        TaskRequest{TaskContext::make(environment), std::move(options)} {}
 
-    [[nodiscard]] std::string description() final { return static_cast<R*>(this)->as_string(); }
-
-    void dispatch(RequestDispatcher& dispatcher) const final {
-        return static_cast<const R*>(this)->call_dispatch(dispatcher);
+    [[nodiscard]] std::string as_string() const {
+        return Message("UpdateNodeStatus: new_status=?, at node=", context().name()).str();
     }
-
-private:
-    Environment environment_;
-    Options options_;
 };
 
-struct UpdateNodeStatus : DefaultRequestMessage<UpdateNodeStatus> {
+struct UpdateNodeAttribute : TaskRequest {
 
-    UpdateNodeStatus() : DefaultRequestMessage<UpdateNodeStatus>{} {}
-    UpdateNodeStatus(Environment environment, Options options) :
-        DefaultRequestMessage<UpdateNodeStatus>{std::move(environment), std::move(options)} {}
+    UpdateNodeAttribute(std::shared_ptr<const TaskContext> context, Options options) :
+        TaskRequest{std::move(context), std::move(options)} {}
+    UpdateNodeAttribute(const Environment& environment, Options options) :
+        TaskRequest{TaskContext::make(environment), std::move(options)} {}
 
     [[nodiscard]] std::string as_string() const {
-        return Message("UpdateNodeStatus: new_status=?, at node=", environment().get("ECF_NAME").value).str();
+        return Message("UpdateNodeAttribute: name=", options().get(Field::Name),
+                       ", value=", options().get(Field::Value), ", at node=", context().name())
+            .str();
     }
-
-    void call_dispatch(RequestDispatcher& dispatcher) const;
 };
 
-struct UpdateNodeAttribute : DefaultRequestMessage<UpdateNodeAttribute> {
+/**
+ * UpdateNodeAttributes represents a batch of attribute updates, all related to the same node.
+ *
+ * Each entry of the batch holds the same options that would be used to create an individual UpdateNodeAttribute.
+ */
+struct UpdateNodeAttributes : TaskRequest {
+    using attributes_t = std::vector<Options>;
+
+    UpdateNodeAttributes(std::shared_ptr<const TaskContext> context, attributes_t attributes) :
+        TaskRequest{std::move(context), Options::options()}, attributes_{std::move(attributes)} {}
+    UpdateNodeAttributes(const Environment& environment, attributes_t attributes) :
+        TaskRequest{TaskContext::make(environment), Options::options()}, attributes_{std::move(attributes)} {}
 
-    UpdateNodeAttribute() : DefaultRequestMessage<UpdateNodeAttribute>{} {}
-    UpdateNodeAttribute(Environment environment, Options options) :
-        DefaultRequestMessage<UpdateNodeAttribute>{std::move(environment), std::move(options)} {}
+    [[nodiscard]] const attributes_t& attributes() const { return attributes_; }
 
     [[nodiscard]] std::string as_string() const {
-        return Message("UpdateNodeAttribute: name=", options().get("name").value,
-                       ", value=", options().get("value").value, ", at node=", environment().get("ECF_NAME").value)
-            .str();
+        return Message("UpdateNodeAttributes: count=", attributes_.size(), ", at node=", context().name()).str();
     }
 
-    void call_dispatch(RequestDispatcher& dispatcher) const;
+private:
+    attributes_t attributes_;
 };
 
 struct RequestDispatcher {
     virtual ~RequestDispatcher() = default;
 
-    virtual void dispatch_request(const UpdateNodeStatus& request)    = 0;
-    virtual void dispatch_request(const UpdateNodeAttribute& request) = 0;
+    virtual void dispatch_request(const UpdateNodeStatus& request)     = 0;
+    virtual void dispatch_request(const UpdateNodeAttribute& request)  = 0;
+    virtual void dispatch_request(const UpdateNodeAttributes& request) = 0;
 };
 
+/**
+ * Request holds one of the typed requests by value, and thus creating (or copying) a Request requires no heap
+ * allocation besides the one eventually required by the options themselves.
+ */
 struct Request final {
 public:
+    using message_t = std::variant<UpdateNodeStatus, UpdateNodeAttribute, UpdateNodeAttributes>;
+
     template <typename M, typename... ARGS>
     static Request make_request(ARGS&&... args) {
-        return Request{std::make_unique<M>(std::forward<ARGS>(args)...)};
+        return Request{message_t{std::in_place_type<M>, std::forward<ARGS>(args)...}};
     }
 
-    [[nodiscard]] std::string description() const { return message_->description(); }
+    [[nodiscard]] std::string description() const {
+        return std::visit([](const auto& message) { return message.as_string(); }, message_);
+    }
 
-    [[nodiscard]] std::string get_environment(const std::string& name) const {
-        return message_->environment().get(name).value;
+    [[nodiscard]] const TaskContext& context() const {
+        return std::visit([](const auto& message) -> const TaskContext& { return message.context(); }, message_);
     }
-    [[nodiscard]] std::string get_option(const std::string& name) const { return message_->options().get(name).value; }
+    [[nodiscard]] const Options& options() const {
+        return std::visit([](const auto& message) -> const Options& { return message.options(); }, message_);
+    }
+    [[nodiscard]] std::string get_option(const std::string& name) const { return std::string(options().get(name)); }
 
-    void dispatch(RequestDispatcher& dispatcher) const { message_->dispatch(dispatcher); }
+    void dispatch(RequestDispatcher& dispatcher) const {
+        std::visit([&dispatcher](const auto& message) { dispatcher.dispatch_request(message); }, message_);
+    }
 
 private:
-    explicit Request(std::unique_ptr<RequestMessage>&& message) : message_{std::move(message)} {}
+    explicit Request(message_t&& message) : message_{std::move(message)} {}
 
-    std::unique_ptr<RequestMessage> message_;
+    message_t message_;
 };
 
 // *** Response(s) *************************************************************
 // *****************************************************************************
 
 struct Response final {
+    /**
+     * Outcome describes the delivery of the request, regardless of the contents of the response
+     */
+    enum class Outcome
+    {
+        Sent,     // i.e. delivered (or just sent, for unacknowledged datagrams)
+        Queued,   // i.e. submitted, with the response discarded
+        Dropped,  // i.e. not sent, and thus can be sent again later
+        Spooled   // i.e. kept in the spool, to be sent later
+    };
+
     std::string response;
+    Outcome outcome = Outcome::Sent;
 };
 
 std::ostream& operator<<(std::ostream& o, const Response& response);
@@ -0,0 +1,163 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include "ecflow/light/Spawner.h"
+
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#include "ecflow/light/Deadline.h"
+#include "ecflow/light/Log.h"
+
+extern char** environ;
+
+namespace ecflow::light {
+
+Spawner::Spawner(std::string executable, size_t max_children) :
+    executable_{std::move(executable)},
+    max_children_{std::max(max_children, size_t{1})},
+    lock_{},
+    children_{},
+    starting_{0},
+    spawned_{0},
+    failed_{0} {}
+
+Spawner::~Spawner() {
+    wait_all();
+}
+
+void Spawner::spawn(const std::vector<std::string>& arguments) {
+    std::vector<char*> argv;
+    argv.reserve(arguments.size() + 2);
+    argv.push_back(const_cast<char*>(executable_.c_str()));
+    for (const auto& argument : arguments) {
+        argv.push_back(const_cast<char*>(argument.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    {
+        std::unique_lock lock(lock_);
+        reap(false);
+        while (children_.size() + starting_ >= max_children_) {
+            if (children_.empty()) {
+                // All slots are taken by processes being launched by other threads
+                lock.unlock();
+                std::this_thread::yield();
+                lock.lock();
+            }
+            else if (auto remaining = Deadline::remaining(); remaining) {
+                // Notice: with a deadline, poll for finished children instead of blocking until one finishes
+                if (remaining->count() == 0) {
+                    ECFLOW_LIGHT_THROW(DeadlineExceeded,
+                                       Message("Deadline exceeded while waiting to spawn '", executable_, "'"));
+                }
+                lock.unlock();
+                std::this_thread::sleep_for(std::min(*remaining, PollPeriod));
+                lock.lock();
+                reap(false);
+            }
+            else {
+                reap(true);
+            }
+        }
+        ++starting_;
+    }
+
+    // Notice: the lock is not held while launching the process, so that several threads can spawn concurrently
+    pid_t pid = 0;
+    int error = ::posix_spawnp(&pid, executable_.c_str(), nullptr, nullptr, argv.data(), environ);
+
+    std::scoped_lock lock(lock_);
+    --starting_;
+    if (error != 0) {
+        ++failed_;
+        ECFLOW_LIGHT_THROW(UnableToSpawnProcess,
+                           Message("Unable to spawn '", executable_, "', due to: ", std::strerror(error)));
+    }
+
+    children_.push_back(pid);
+    ++spawned_;
+}
+
+void Spawner::wait_all() {
+    std::unique_lock lock(lock_);
+    while (!children_.empty() || starting_ > 0) {
+        if (children_.empty()) {
+            // Wait for the processes being launched by other threads
+            lock.unlock();
+            std::this_thread::yield();
+            lock.lock();
+        }
+        else {
+            reap(true);
+        }
+    }
+}
+
+size_t Spawner::running() const {
+    std::scoped_lock lock(lock_);
+    return children_.size();
+}
+
+uint64_t Spawner::spawned() const {
+    std::scoped_lock lock(lock_);
+    return spawned_;
+}
+
+uint64_t Spawner::failed() const {
+    std::scoped_lock lock(lock_);
+    return failed_;
+}
+
+void Spawner::reap(bool block_until_one) {
+    size_t before = children_.size();
+    auto finished = std::remove_if(std::begin(children_), std::end(children_), [this](pid_t pid) {
+        int status   = 0;
+        pid_t result = ::waitpid(pid, &status, WNOHANG);
+        if (result == pid) {
+            account(pid, status);
+            return true;
+        }
+        // The child is gone (e.g. reaped by someone else), so stop tracking it
+        return result < 0 && errno == ECHILD;
+    });
+    children_.erase(finished, std::end(children_));
+
+    if (block_until_one && children_.size() == before && !children_.empty()) {
+        // Nothing has finished yet, so wait for the oldest child
+        pid_t pid    = children_.front();
+        int status   = 0;
+        pid_t result = 0;
+        do {
+            result = ::waitpid(pid, &status, 0);
+        } while (result < 0 && errno == EINTR);
+        if (result == pid) {
+            account(pid, status);
+        }
+        children_.erase(std::begin(children_));
+    }
+}
+
+void Spawner::account(pid_t pid, int status) {
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+        return;
+    }
+    ++failed_;
+    Log::warning() << "Process '" << executable_ << "' (pid: " << pid << ") failed, with status: "
+                   << (WIFEXITED(status) ? WEXITSTATUS(status) : -1) << std::endl;
+}
+
+}  // namespace ecflow::light
@@ -0,0 +1,87 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#ifndef ECFLOW_LIGHT_SPAWNER_H
+#define ECFLOW_LIGHT_SPAWNER_H
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ecflow/light/Exception.h"
+
+namespace ecflow::light {
+
+struct UnableToSpawnProcess : public eckit::Exception {
+    UnableToSpawnProcess(const std::string& msg, const eckit::CodeLocation& loc) : eckit::Exception(msg, loc) {}
+};
+
+// *** Spawner *****************************************************************
+// *****************************************************************************
+
+/**
+ * Spawner launches an executable directly (i.e. using posix_spawn, without a shell), passing each argument
+ * as-is, and thus without any need for quoting.
+ *
+ * At most 'max_children' processes are allowed to run simultaneously; when the limit is reached, spawning waits
+ * for a previous child to finish (but never beyond the deadline of the calling thread, if any). Finished children are reaped on each spawn, and any remaining children are
+ * waited for when the Spawner is destroyed.
+ *
+ * Notice: only the children launched by the Spawner are ever waited for, so that the children of the
+ *         application remain untouched.
+ */
+class Spawner {
+public:
+    Spawner(std::string executable, size_t max_children);
+    ~Spawner();
+
+    // Spawner object cannot be copied!
+    Spawner(const Spawner&)            = delete;
+    Spawner& operator=(const Spawner&) = delete;
+
+    /**
+     * Launch the executable, with the given arguments (excluding the executable itself)
+     */
+    void spawn(const std::vector<std::string>& arguments);
+
+    /**
+     * Wait for all running children to finish
+     */
+    void wait_all();
+
+    [[nodiscard]] const std::string& executable() const { return executable_; }
+    [[nodiscard]] size_t running() const;
+    [[nodiscard]] uint64_t spawned() const;
+    [[nodiscard]] uint64_t failed() const;
+
+private:
+    // Period between checks for finished children, while waiting with a deadline
+    static constexpr std::chrono::milliseconds PollPeriod = std::chrono::milliseconds(1);
+
+    void reap(bool block_until_one);
+    void account(pid_t pid, int status);
+
+    std::string executable_;
+    size_t max_children_;
+
+    mutable std::mutex lock_;
+    std::vector<pid_t> children_;
+    size_t starting_;
+    uint64_t spawned_;
+    uint64_t failed_;
+};
+
+}  // namespace ecflow::light
+
+#endif
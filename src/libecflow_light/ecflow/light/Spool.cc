@@ -0,0 +1,415 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include "ecflow/light/Spool.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#include "ecflow/light/Log.h"
+#include "ecflow/light/StringUtils.h"
+#include "ecflow/light/WireFormat.h"
+
+namespace ecflow::light {
+
+// *** Spool Entry *************************************************************
+// *****************************************************************************
+
+namespace {
+
+bool is_spoolable_command(std::string_view command) {
+    return command == "meter" || command == "label" || command == "event";
+}
+
+bool is_spoolable_action(std::string_view action) {
+    // Notice: 'wait' blocks until the server evaluates the expression, and thus is never spooled
+    return action == "init" || action == "complete" || action == "abort";
+}
+
+struct SpoolEntries : public RequestDispatcher {
+    void dispatch_request(const UpdateNodeStatus& request) override {
+        if (!request.options().has(Field::Action) || !is_spoolable_action(request.options().get(Field::Action))) {
+            spoolable = false;
+            return;
+        }
+        entries.push_back(SpoolEntry{0, SpoolEntry::Kind::Status, request.shared_context(), request.options()});
+    }
+
+    void dispatch_request(const UpdateNodeAttribute& request) override {
+        collect(request.shared_context(), request.options());
+    }
+
+    void dispatch_request(const UpdateNodeAttributes& request) override {
+        for (const auto& attribute : request.attributes()) {
+            collect(request.shared_context(), attribute);
+        }
+    }
+
+    void collect(const std::shared_ptr<const TaskContext>& context, const Options& options) {
+        if (!options.has(Field::Command) || !is_spoolable_command(options.get(Field::Command))) {
+            spoolable = false;
+            return;
+        }
+        entries.push_back(SpoolEntry{0, SpoolEntry::Kind::Attribute, context, options});
+    }
+
+    bool spoolable = true;
+    std::vector<SpoolEntry> entries;
+};
+
+void write_text(std::string& buffer, std::string_view text) {
+    BinaryEncoder::write_varint(buffer, text.size());
+    buffer.append(text);
+}
+
+std::string_view read_text(std::string_view payload, size_t& position) {
+    uint64_t size = 0;
+    try {
+        size = BinaryDecoder::read_varint(payload, position);
+    }
+    catch (InvalidDatagram& e) {
+        ECFLOW_LIGHT_THROW(InvalidSpoolEntry, Message("Invalid spool entry, due to: ", e.what()));
+    }
+    if (size > payload.size() - position) {
+        ECFLOW_LIGHT_THROW(InvalidSpoolEntry, Message("Invalid spool entry. Unexpected end at position ", position));
+    }
+    auto text = payload.substr(position, size);
+    position += size;
+    return text;
+}
+
+}  // namespace
+
+std::optional<std::vector<SpoolEntry>> SpoolEntry::entries_of(const Request& request) {
+    SpoolEntries collector;
+    request.dispatch(collector);
+    if (!collector.spoolable) {
+        return std::nullopt;
+    }
+    return std::move(collector.entries);
+}
+
+std::string SpoolEntry::key() const {
+    return stringify(context->name(), ":", options.get(Field::Command), ":", options.get(Field::Name));
+}
+
+void SpoolEntry::encode(std::string& buffer) const {
+    buffer += static_cast<char>(kind);
+    write_text(buffer, context->name());
+    write_text(buffer, context->password());
+    write_text(buffer, context->rid());
+    write_text(buffer, context->try_no());
+    for (size_t index = 0; index != FieldCount; ++index) {
+        auto field = static_cast<Field>(index);
+        if (auto found = options.find(field); found) {
+            buffer += static_cast<char>(field);
+            write_text(buffer, found.value());
+        }
+    }
+}
+
+SpoolEntry SpoolEntry::decode(uint64_t sequence, std::string_view payload) {
+    if (payload.empty()) {
+        ECFLOW_LIGHT_THROW(InvalidSpoolEntry, Message("Invalid spool entry. Expected kind"));
+    }
+
+    SpoolEntry entry;
+    entry.sequence = sequence;
+    entry.kind     = static_cast<Kind>(payload[0]);
+
+    size_t position = 1;
+    auto name       = read_text(payload, position);
+    auto password   = read_text(payload, position);
+    auto rid        = read_text(payload, position);
+    auto try_no     = read_text(payload, position);
+    entry.context   = TaskContext::make(Environment::an_environment()
+                                          .with("ECF_NAME", std::string(name))
+                                          .with("ECF_PASS", std::string(password))
+                                          .with("ECF_RID", std::string(rid))
+                                          .with("ECF_TRYNO", std::string(try_no)));
+
+    while (position != payload.size()) {
+        auto field = static_cast<uint8_t>(payload[position++]);
+        if (field >= FieldCount) {
+            ECFLOW_LIGHT_THROW(InvalidSpoolEntry, Message("Invalid spool entry. Unknown field ", int(field)));
+        }
+        entry.options = entry.options.with(static_cast<Field>(field), read_text(payload, position));
+    }
+    return entry;
+}
+
+// *** Spool Journal ***********************************************************
+// *****************************************************************************
+
+namespace {
+
+constexpr std::array<char, 8> FileMagic = {'E', 'C', 'F', 'L', 'S', 'P', 'L', '1'};
+constexpr uint32_t RecordMagic          = 0xEC5F00D1;
+
+struct FileHeader {
+    std::array<char, 8> magic;
+    uint32_t slot_size;
+    uint32_t slot_count;
+    uint64_t replayed;
+    std::array<char, 40> reserved;
+};
+
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t length;
+    uint64_t sequence;
+    uint32_t checksum;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 64, "File header must fill exactly 64 bytes");
+static_assert(sizeof(RecordHeader) == 24, "Record header must fill exactly 24 bytes");
+
+constexpr std::array<uint32_t, 256> make_crc_table() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t index = 0; index != 256; ++index) {
+        uint32_t value = index;
+        for (int bit = 0; bit != 8; ++bit) {
+            value = (value & 1) ? (0xEDB88320 ^ (value >> 1)) : (value >> 1);
+        }
+        table[index] = value;
+    }
+    return table;
+}
+
+uint32_t crc32(uint32_t crc, const void* data, size_t size) {
+    static constexpr auto table = make_crc_table();
+
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    crc               = ~crc;
+    for (size_t index = 0; index != size; ++index) {
+        crc = table[(crc ^ bytes[index]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t checksum_of(uint64_t sequence, std::string_view payload) {
+    auto length = static_cast<uint32_t>(payload.size());
+    uint32_t crc = crc32(0, &sequence, sizeof(sequence));
+    crc          = crc32(crc, &length, sizeof(length));
+    return crc32(crc, payload.data(), payload.size());
+}
+
+size_t slots_for(size_t length) {
+    return (sizeof(RecordHeader) + length + SpoolJournal::SlotSize - 1) / SpoolJournal::SlotSize;
+}
+
+std::string_view system_error() {
+    return std::strerror(errno);
+}
+
+}  // namespace
+
+SpoolJournal::SpoolJournal(const fs::path& path, size_t capacity) :
+    path_{path},
+    fd_{-1},
+    size_{0},
+    slot_count_{std::max(capacity / SlotSize, size_t{1})},
+    memory_{nullptr},
+    next_slot_{0},
+    next_sequence_{1},
+    overwritten_{0} {
+
+    size_ = sizeof(FileHeader) + slot_count_ * SlotSize;
+
+    if (path_.has_parent_path()) {
+        std::error_code ignored;
+        fs::create_directories(path_.parent_path(), ignored);
+    }
+
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd_ < 0) {
+        ECFLOW_LIGHT_THROW(UnableToOpenSpool, Message("Unable to open spool '", path_.string(), "', due to: ",
+                                                      system_error()));
+    }
+    if (::flock(fd_, LOCK_EX | LOCK_NB) != 0) {
+        auto error = system_error();
+        ::close(fd_);
+        ECFLOW_LIGHT_THROW(UnableToOpenSpool, Message("Unable to lock spool '", path_.string(), "', due to: ", error));
+    }
+
+    struct stat status {};
+    ::fstat(fd_, &status);
+    bool reset = static_cast<size_t>(status.st_size) != size_;
+    if (reset && ::ftruncate(fd_, static_cast<off_t>(size_)) != 0) {
+        auto error = system_error();
+        ::close(fd_);
+        ECFLOW_LIGHT_THROW(UnableToOpenSpool, Message("Unable to resize spool '", path_.string(), "', due to: ",
+                                                      error));
+    }
+
+    void* memory = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (memory == MAP_FAILED) {
+        auto error = system_error();
+        ::close(fd_);
+        ECFLOW_LIGHT_THROW(UnableToOpenSpool, Message("Unable to map spool '", path_.string(), "', due to: ", error));
+    }
+    memory_ = static_cast<char*>(memory);
+
+    auto* header = reinterpret_cast<FileHeader*>(memory_);
+    if (!reset && (header->magic != FileMagic || header->slot_size != SlotSize || header->slot_count != slot_count_)) {
+        Log::warning() << "Spool '" << path_.string() << "' has an unexpected layout, and is thus discarded"
+                       << std::endl;
+        reset = true;
+    }
+
+    if (reset) {
+        std::memset(memory_, 0, size_);
+        header->magic      = FileMagic;
+        header->slot_size  = SlotSize;
+        header->slot_count = static_cast<uint32_t>(slot_count_);
+        header->replayed   = 0;
+    }
+    else {
+        recover();
+    }
+}
+
+SpoolJournal::~SpoolJournal() {
+    ::msync(memory_, size_, MS_ASYNC);
+    ::munmap(memory_, size_);
+    // Notice: closing the file releases the lock
+    ::close(fd_);
+}
+
+fs::path SpoolJournal::path_of(const fs::path& directory, std::string_view task) {
+    // Notice: the task path is flattened, so that each task has a single journal in the directory
+    std::string name;
+    for (char c : task) {
+        name += (c == '/') ? '_' : c;
+    }
+    if (name.empty()) {
+        name = "_";
+    }
+    return directory / (name + ".spool");
+}
+
+std::optional<uint64_t> SpoolJournal::append(std::string_view payload) {
+    size_t slots = slots_for(payload.size());
+    if (slots > slot_count_) {
+        Log::error() << "Unable to spool record of " << payload.size() << " bytes, as spool '" << path_.string()
+                     << "' is too small" << std::endl;
+        return std::nullopt;
+    }
+
+    if (next_slot_ + slots > slot_count_) {
+        next_slot_ = 0;
+    }
+
+    // Account for pending records about to be overwritten, as the journal is full
+    for (size_t slot = next_slot_; slot < next_slot_ + slots; ++slot) {
+        if (auto record = record_at(slot); record && record->sequence > replayed()) {
+            ++overwritten_;
+            Log::warning() << "Spool '" << path_.string() << "' is full, discarding record #" << record->sequence
+                           << std::endl;
+        }
+    }
+
+    uint64_t sequence = next_sequence_++;
+    char* slot        = memory_ + sizeof(FileHeader) + next_slot_ * SlotSize;
+
+    // Notice: the contents are written before the header, and any partial write is detected by the checksum
+    std::memcpy(slot + sizeof(RecordHeader), payload.data(), payload.size());
+    RecordHeader header{RecordMagic, static_cast<uint32_t>(payload.size()), sequence, checksum_of(sequence, payload),
+                        0};
+    std::memcpy(slot, &header, sizeof(header));
+
+    next_slot_ = (next_slot_ + slots) % slot_count_;
+    return sequence;
+}
+
+std::vector<SpoolJournal::Record> SpoolJournal::pending() const {
+    std::vector<Record> records;
+    auto mark = replayed();
+    for (size_t slot = 0; slot < slot_count_; /* ... */) {
+        if (auto record = record_at(slot); record) {
+            if (record->sequence > mark) {
+                records.push_back(Record{record->sequence, std::string(record->payload)});
+            }
+            slot += record->slots;
+        }
+        else {
+            ++slot;
+        }
+    }
+    std::sort(std::begin(records), std::end(records),
+              [](const Record& lhs, const Record& rhs) { return lhs.sequence < rhs.sequence; });
+    return records;
+}
+
+void SpoolJournal::mark_replayed(uint64_t sequence) {
+    auto* header = reinterpret_cast<FileHeader*>(memory_);
+    // Notice: the mark is a single aligned 64-bit store, and thus never partially written
+    header->replayed = std::max(header->replayed, std::min(sequence, next_sequence_ - 1));
+}
+
+uint64_t SpoolJournal::replayed() const {
+    return reinterpret_cast<const FileHeader*>(memory_)->replayed;
+}
+
+std::optional<SpoolJournal::RecordView> SpoolJournal::record_at(size_t slot) const {
+    const char* start = memory_ + sizeof(FileHeader) + slot * SlotSize;
+
+    RecordHeader header{};
+    std::memcpy(&header, start, sizeof(header));
+    if (header.magic != RecordMagic || header.sequence == 0) {
+        return std::nullopt;
+    }
+
+    size_t available = (slot_count_ - slot) * SlotSize - sizeof(RecordHeader);
+    if (header.length > available) {
+        return std::nullopt;
+    }
+
+    std::string_view payload(start + sizeof(RecordHeader), header.length);
+    if (checksum_of(header.sequence, payload) != header.checksum) {
+        return std::nullopt;
+    }
+    return RecordView{header.sequence, payload, slots_for(header.length)};
+}
+
+void SpoolJournal::recover() {
+    uint64_t newest = 0;
+    size_t pending  = 0;
+    for (size_t slot = 0; slot < slot_count_; /* ... */) {
+        if (auto record = record_at(slot); record) {
+            if (record->sequence > newest) {
+                newest     = record->sequence;
+                next_slot_ = (slot + record->slots) % slot_count_;
+            }
+            pending += record->sequence > replayed() ? 1 : 0;
+            slot += record->slots;
+        }
+        else {
+            ++slot;
+        }
+    }
+    next_sequence_ = std::max(newest, replayed()) + 1;
+
+    if (pending > 0) {
+        Log::info() << "Spool '" << path_.string() << "' recovered, with " << pending << " pending record(s)"
+                    << std::endl;
+    }
+}
+
+}  // namespace ecflow::light
@@ -0,0 +1,163 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#ifndef ECFLOW_LIGHT_SPOOL_H
+#define ECFLOW_LIGHT_SPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ecflow/light/Exception.h"
+#include "ecflow/light/Filesystem.h"
+#include "ecflow/light/Requests.h"
+
+namespace ecflow::light {
+
+struct UnableToOpenSpool : public eckit::Exception {
+    UnableToOpenSpool(const std::string& msg, const eckit::CodeLocation& loc) : eckit::Exception(msg, loc) {}
+};
+
+struct InvalidSpoolEntry : public eckit::Exception {
+    InvalidSpoolEntry(const std::string& msg, const eckit::CodeLocation& loc) : eckit::Exception(msg, loc) {}
+};
+
+// *** Spool Entry *************************************************************
+// *****************************************************************************
+
+/**
+ * SpoolEntry holds a single update (either a status update, or a meter, label or event update) kept in the spool,
+ * together with the task context required to send it again.
+ */
+struct SpoolEntry {
+    enum class Kind : uint8_t
+    {
+        Status    = 1,
+        Attribute = 2
+    };
+
+    uint64_t sequence = 0;
+    Kind kind         = Kind::Attribute;
+    std::shared_ptr<const TaskContext> context;
+    Options options;
+
+    /**
+     * @return the entries to be spooled for the given request; or nothing, if the request cannot be spooled (e.g.
+     *         a queue command, which requires the server response)
+     */
+    static std::optional<std::vector<SpoolEntry>> entries_of(const Request& request);
+
+    /**
+     * @return the key identifying the updated attribute, i.e. the task path, the attribute kind and name
+     */
+    [[nodiscard]] std::string key() const;
+
+    void encode(std::string& buffer) const;
+    /**
+     * @return the entry encoded by the given payload; throws InvalidSpoolEntry if the payload is malformed
+     */
+    static SpoolEntry decode(uint64_t sequence, std::string_view payload);
+};
+
+// *** Spool Journal ***********************************************************
+// *****************************************************************************
+
+/**
+ * SpoolJournal is an append-only ring journal, kept in a memory-mapped file of fixed size.
+ *
+ * The file starts with a header, followed by a number of fixed size slots. Each record occupies one or more
+ * consecutive slots, and starts with a header holding its sequence number, its size and a checksum (CRC-32) of the
+ * contents. When the end of the file is reached, records are appended again from the first slot, overwriting the
+ * oldest records (thus the journal is bounded in size).
+ *
+ * The file header holds the sequence number up to which the records were replayed, and only records beyond it
+ * are pending. Records are written directly to the mapped memory, and thus survive the process being killed; a
+ * record partially written (or partially overwritten) fails the checksum, and is ignored when the journal is
+ * opened again.
+ *
+ * Notice: the journal is not thread-safe, and the file is locked to be used by a single process at a time.
+ */
+class SpoolJournal {
+public:
+    struct Record {
+        uint64_t sequence;
+        std::string payload;
+    };
+
+    static constexpr size_t SlotSize        = 256;
+    static constexpr size_t DefaultCapacity = 1024 * 1024;
+
+    /**
+     * Opens (creating it, if necessary) the journal at the given path, recovering any records already stored.
+     * Throws UnableToOpenSpool if the file cannot be opened, mapped or locked.
+     */
+    SpoolJournal(const fs::path& path, size_t capacity = DefaultCapacity);
+    ~SpoolJournal();
+
+    // SpoolJournal object cannot be copied!
+    SpoolJournal(const SpoolJournal&)            = delete;
+    SpoolJournal& operator=(const SpoolJournal&) = delete;
+
+    /**
+     * @return the path of the journal of the given task, within the given directory
+     */
+    static fs::path path_of(const fs::path& directory, std::string_view task);
+
+    /**
+     * Appends the record, with the next sequence number
+     *
+     * @return the sequence number of the record; or nothing, if the record is larger than the journal
+     */
+    std::optional<uint64_t> append(std::string_view payload);
+
+    /**
+     * @return the records not yet replayed, ordered by sequence number
+     */
+    [[nodiscard]] std::vector<Record> pending() const;
+
+    /**
+     * Marks all records, up to the given sequence number, as replayed
+     */
+    void mark_replayed(uint64_t sequence);
+
+    [[nodiscard]] bool empty() const { return replayed() + 1 == next_sequence_; }
+    [[nodiscard]] uint64_t replayed() const;
+    // Number of pending records overwritten, due to the journal being full
+    [[nodiscard]] uint64_t overwritten() const { return overwritten_; }
+    [[nodiscard]] const fs::path& path() const { return path_; }
+
+private:
+    struct RecordView {
+        uint64_t sequence;
+        std::string_view payload;
+        size_t slots;
+    };
+
+    [[nodiscard]] std::optional<RecordView> record_at(size_t slot) const;
+    void recover();
+
+    fs::path path_;
+    int fd_;
+    size_t size_;
+    size_t slot_count_;
+    char* memory_;
+
+    size_t next_slot_;
+    uint64_t next_sequence_;
+    uint64_t overwritten_;
+};
+
+}  // namespace ecflow::light
+
+#endif
@@ -8,12 +8,27 @@
  * nor does it submit to any jurisdiction.
  */
 
+#include "ecflow/light/TinyREST.h"
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <curl/curl.h>
 
 #include <eckit/exception/Exceptions.h>
-#include <eckit/io/EasyCURL.h>
-#include <eckit/utils/StringTools.h>
 
-#include "ecflow/light/TinyREST.h"
+#include "ecflow/light/Deadline.h"
+#include "ecflow/light/Exception.h"
+#include "ecflow/light/Log.h"
 
 namespace ecflow::light {
 
@@ -40,132 +55,816 @@ std::vector<Status> Status::status_set_ = {
     Status{Code::BAD_REQUEST, "BAD_REQUEST"}, Status{Code::UNAUTHORIZED, "UNAUTHORIZED"},
     Status{Code::NOT_FOUND, "NOT_FOUND"},
     // Server Error responses
-    Status{Code::INTERNAL_SERVER_ERROR, "INTERNAL_SERVER_ERROR"}};
+    Status{Code::INTERNAL_SERVER_ERROR, "INTERNAL_SERVER_ERROR"},
+    Status{Code::SERVICE_UNAVAILABLE, "SERVICE_UNAVAILABLE"}};
+
+// *** Retry Policy & Circuit Breaker ******************************************
+// *****************************************************************************
+
+std::chrono::milliseconds RetryPolicy::backoff(int failed_attempts) const {
+    // Notice: the exponent is bounded, to avoid overflowing before applying the maximum backoff
+    auto exponent = std::clamp(failed_attempts - 1, 0, 30);
+    auto delay    = std::min(base_backoff * (int64_t{1} << exponent), max_backoff);
+    if (jitter <= 0.0 || delay.count() == 0) {
+        return delay;
+    }
+
+    thread_local std::mt19937 generator{std::random_device{}()};
+    std::uniform_real_distribution<double> fraction(0.0, std::min(jitter, 1.0));
+    auto reduction = static_cast<double>(delay.count()) * fraction(generator);
+    return delay - std::chrono::milliseconds(static_cast<std::chrono::milliseconds::rep>(reduction));
+}
+
+CircuitBreaker::Admission CircuitBreaker::admit(clock_t::time_point now) {
+    if (policy_.failure_threshold == 0) {
+        return Admission::Allowed;
+    }
+
+    switch (state_) {
+        case State::Closed:
+            return Admission::Allowed;
+        case State::Open:
+            if (now - opened_at_ < policy_.cooloff) {
+                return Admission::Rejected;
+            }
+            state_   = State::HalfOpen;
+            probing_ = true;
+            return Admission::Probe;
+        case State::HalfOpen:
+            if (probing_) {
+                return Admission::Rejected;
+            }
+            probing_ = true;
+            return Admission::Probe;
+    }
+    return Admission::Allowed;
+}
+
+void CircuitBreaker::record(bool success, clock_t::time_point now) {
+    if (policy_.failure_threshold == 0) {
+        return;
+    }
+
+    if (success) {
+        state_    = State::Closed;
+        failures_ = 0;
+        probing_  = false;
+        return;
+    }
+
+    // Notice: the failure of a request admitted before the circuit opened doesn't extend the cooling-off period
+    if (state_ == State::Open) {
+        return;
+    }
+    if (state_ == State::HalfOpen || ++failures_ >= policy_.failure_threshold) {
+        state_     = State::Open;
+        opened_at_ = now;
+        probing_   = false;
+    }
+}
+
+void CircuitBreaker::release() {
+    probing_ = false;
+}
 
 namespace detail {
 
-class Handle {
+// *** Circuit Breakers ********************************************************
+// *****************************************************************************
+
+/**
+ * CircuitBreakers keeps the circuit breaker of each host, allowing to use them concurrently.
+ */
+class CircuitBreakers {
 public:
-    Handle() : handle_{} {
-        set_verbose(false);
-        set_max_retries(3);
-        // TODO: Remove the following insecurities!
-        set_verify_host(false);
-        set_verify_peer(false);
+    explicit CircuitBreakers(CircuitBreakerPolicy policy) : policy_{policy}, lock_{}, breakers_{} {}
+
+    CircuitBreaker::Admission admit(const Host& host) {
+        std::scoped_lock lock(lock_);
+        return breaker(host).admit();
     }
 
-    // Handle object cannot be copied!
-    Handle(const Handle&)            = delete;
-    Handle& operator=(const Handle&) = delete;
+    void record(const Host& host, bool success) {
+        std::scoped_lock lock(lock_);
+        auto& found = breaker(host);
+        auto before = found.state();
+        found.record(success);
+        if (before != CircuitBreaker::State::Open && found.state() == CircuitBreaker::State::Open) {
+            Log::warning() << "Circuit opened for host: " << host.str() << ", requests are rejected for "
+                           << policy_.cooloff.count() << "ms" << std::endl;
+        }
+        if (before != CircuitBreaker::State::Closed && found.state() == CircuitBreaker::State::Closed) {
+            Log::info() << "Circuit closed for host: " << host.str() << std::endl;
+        }
+    }
 
-    ~Handle() = default;
+    void release(const Host& host) {
+        std::scoped_lock lock(lock_);
+        breaker(host).release();
+    }
 
-    Response perform(const URL& url, const Request<Method::GET>& request) {
-        // Set headers
-        const RequestHeader<Method::GET>& request_header = request.header();
-        set_headers(request_header.fields());
+    CircuitBreaker::State state(const Host& host) {
+        std::scoped_lock lock(lock_);
+        return breaker(host).state();
+    }
 
-        // No body content
+    /**
+     * @return the response of a request rejected (i.e. without contacting the host) due to the circuit being open
+     */
+    static Response rejected(const Host& host) {
+        return Response{ResponseHeader(Status::Code::SERVICE_UNAVAILABLE, Fields{}),
+                        Body{stringify("Circuit open for host ", host.str())}};
+    }
 
-        return try_perform_request([&]() { return handle_.GET(url.str()); });
+private:
+    CircuitBreaker& breaker(const Host& host) {
+        return breakers_.try_emplace(host.str(), CircuitBreaker{policy_}).first->second;
     }
 
-    Response perform(const URL& url, const Request<Method::POST>& request) {
-        // Set headers
-        const RequestHeader<Method::POST>& request_header = request.header();
-        set_headers(request_header.fields());
+    CircuitBreakerPolicy policy_;
+    std::mutex lock_;
+    std::unordered_map<std::string, CircuitBreaker> breakers_;
+};
 
-        // Set body
-        const Body& request_body = request.body();
-        const auto& request_data = request_body.value();
+// *** Handle Pool *************************************************************
+// *****************************************************************************
 
-        return try_perform_request([&]() { return handle_.POST(url.str(), request_data); });
+/**
+ * HandlePool keeps the idle curl handles of each host, allowing to reuse their (kept-alive) connections.
+ *
+ * All handles use the same curl share object, so that TLS sessions and DNS resolutions are cached only once.
+ */
+class HandlePool {
+public:
+    // Minimum number of idle handles kept per host; any surplus handle is simply discarded
+    static constexpr size_t MinimumIdleHandles = 8;
+
+    HandlePool(std::chrono::seconds idle_timeout, size_t max_in_flight) :
+        idle_timeout_{idle_timeout},
+        max_idle_handles_{std::max(MinimumIdleHandles, max_in_flight)},
+        share_{nullptr},
+        share_locks_{},
+        lock_{},
+        idle_{},
+        connections_{0} {
+        static const bool initialised = (curl_global_init(CURL_GLOBAL_DEFAULT) == CURLE_OK);
+        if (!initialised) {
+            ECFLOW_LIGHT_THROW(eckit::SeriousBug, Message("Unable to initialise libcurl"));
+        }
+
+        share_ = curl_share_init();
+        curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, &HandlePool::lock_share);
+        curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, &HandlePool::unlock_share);
+        curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
     }
 
-    Response perform(const URL& url, const Request<Method::PUT>& request) {
-        // Set headers
-        const RequestHeader<Method::PUT>& request_header = request.header();
-        set_headers(request_header.fields());
+    // HandlePool object cannot be copied!
+    HandlePool(const HandlePool&)            = delete;
+    HandlePool& operator=(const HandlePool&) = delete;
+
+    ~HandlePool() {
+        // Notice: all handles must be released before the share object
+        for (auto& [host, handles] : idle_) {
+            for (auto& entry : handles) {
+                curl_easy_cleanup(entry.handle);
+            }
+        }
+        curl_share_cleanup(share_);
+    }
 
-        // Set body
-        const Body& request_body = request.body();
-        const auto& request_data = request_body.value();
+    CURL* acquire(const Host& host) {
+        {
+            std::scoped_lock lock(lock_);
+            auto& handles = idle_[host.str()];
+            evict_expired(handles);
+            if (!handles.empty()) {
+                CURL* handle = handles.back().handle;
+                handles.pop_back();
+                return handle;
+            }
+        }
+        return make_handle();
+    }
 
-        return try_perform_request([&]() { return handle_.PUT(url.str(), request_data); });
+    void release(const Host& host, CURL* handle) {
+        {
+            std::scoped_lock lock(lock_);
+            auto& handles = idle_[host.str()];
+            if (handles.size() < max_idle_handles_) {
+                handles.push_back(Idle{handle, std::chrono::steady_clock::now()});
+                return;
+            }
+        }
+        curl_easy_cleanup(handle);
     }
 
+    void account_connections(long count) { connections_.fetch_add(static_cast<size_t>(count)); }
+    [[nodiscard]] size_t connections() const { return connections_.load(); }
+
 private:
-    void set_headers(const Fields& fields) {
-        eckit::EasyCURLHeaders fieldx;
-        for (const auto& field : fields) {
-            fieldx[field.name] = field.value;
+    struct Idle {
+        CURL* handle;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    CURL* make_handle() {
+        CURL* handle = curl_easy_init();
+        if (handle == nullptr) {
+            ECFLOW_LIGHT_THROW(eckit::SeriousBug, Message("Unable to create libcurl handle"));
         }
 
-        handle_.headers(fieldx);
-    }
+        curl_easy_setopt(handle, CURLOPT_SHARE, share_);
+        curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(handle, CURLOPT_MAXAGE_CONN, static_cast<long>(idle_timeout_.count()));
+        curl_easy_setopt(handle, CURLOPT_VERBOSE, 0L);
+        // TODO: Remove the following insecurities!
+        curl_easy_setopt(handle, CURLOPT_SSL_VERIFYHOST, 0L);
+        curl_easy_setopt(handle, CURLOPT_SSL_VERIFYPEER, 0L);
 
-    void set_max_retries(int max_retries) { max_retries_ = max_retries; }
-    void set_verbose(bool flag = true) { handle_.verbose(flag); }
-    void set_verify_host(bool flag = true) { handle_.sslVerifyHost(flag); }
-    void set_verify_peer(bool flag = true) { handle_.sslVerifyPeer(flag); }
+        return handle;
+    }
 
-    template <typename F>
-    Response try_perform_request(F exchange) {
-        std::string error_what;
-        for (int retry = 0; retry < max_retries_; ++retry) {
-            try {
-                // Make request
-                auto response = exchange();
-                // Handle response
-                return to_response(response);
-            }
-            catch (const eckit::Exception& e) {
-                // Handle 'Curl' error, by retrying...
-                error_what = e.what();
+    void evict_expired(std::vector<Idle>& handles) const {
+        auto now     = std::chrono::steady_clock::now();
+        auto expired = std::remove_if(std::begin(handles), std::end(handles), [&](const Idle& entry) {
+            if (now - entry.since > idle_timeout_) {
+                curl_easy_cleanup(entry.handle);
+                return true;
             }
+            return false;
+        });
+        handles.erase(expired, std::end(handles));
+    }
+
+    static void lock_share(CURL* handle [[maybe_unused]], curl_lock_data data,
+                           curl_lock_access access [[maybe_unused]], void* user) {
+        static_cast<HandlePool*>(user)->share_locks_[data].lock();
+    }
+
+    static void unlock_share(CURL* handle [[maybe_unused]], curl_lock_data data, void* user) {
+        static_cast<HandlePool*>(user)->share_locks_[data].unlock();
+    }
+
+    std::chrono::seconds idle_timeout_;
+    size_t max_idle_handles_;
+    CURLSH* share_;
+    std::array<std::mutex, CURL_LOCK_DATA_LAST> share_locks_;
+
+    std::mutex lock_;
+    std::unordered_map<std::string, std::vector<Idle>> idle_;
+
+    std::atomic<size_t> connections_;
+};
+
+// *** Transfer ****************************************************************
+// *****************************************************************************
+
+/**
+ * Transfer holds a single request, together with the curl handle (leased from the pool) used to perform it.
+ *
+ * All request data (i.e. URL, headers and body) is owned by the transfer, so that the transfer can be performed
+ * asynchronously, after the original request is gone. The transfer also keeps the deadline of the thread that
+ * created it, which bounds each attempt (i.e. connecting and exchanging data) and the retries.
+ */
+class Transfer {
+public:
+    template <Method METHOD>
+    Transfer(HandlePool& pool, const Host& host, const Request<METHOD>& request) :
+        pool_{pool},
+        host_{host},
+        handle_{pool.acquire(host)},
+        url_{URL{host, request.header().target()}.str()},
+        body_{request.body().value()},
+        headers_{nullptr},
+        deadline_{Deadline::current()},
+        collected_{} {
+        for (const auto& field : request.header().fields()) {
+            headers_ = curl_slist_append(headers_, stringify(field.name, ": ", field.value).c_str());
+        }
+
+        curl_easy_setopt(handle_, CURLOPT_URL, url_.c_str());
+        curl_easy_setopt(handle_, CURLOPT_HTTPHEADER, headers_);
+        if constexpr (METHOD == Method::GET) {
+            curl_easy_setopt(handle_, CURLOPT_HTTPGET, 1L);
+            curl_easy_setopt(handle_, CURLOPT_CUSTOMREQUEST, nullptr);
         }
-        auto empty_response_header = ResponseHeader(Status::Code::BAD_REQUEST, Fields{});
-        auto empty_response_body   = Body{error_what};
-        return Response{empty_response_header, empty_response_body};
+        else {
+            // Notice: the body of a PUT is sent as with POST, but using the PUT method
+            curl_easy_setopt(handle_, CURLOPT_POST, 1L);
+            curl_easy_setopt(handle_, CURLOPT_CUSTOMREQUEST, METHOD == Method::PUT ? "PUT" : nullptr);
+            curl_easy_setopt(handle_, CURLOPT_POSTFIELDS, body_.c_str());
+            curl_easy_setopt(handle_, CURLOPT_POSTFIELDSIZE, static_cast<long>(body_.size()));
+        }
+        curl_easy_setopt(handle_, CURLOPT_WRITEFUNCTION, &Transfer::collect_body);
+        curl_easy_setopt(handle_, CURLOPT_WRITEDATA, &collected_);
+        curl_easy_setopt(handle_, CURLOPT_HEADERFUNCTION, &Transfer::collect_header);
+        curl_easy_setopt(handle_, CURLOPT_HEADERDATA, &collected_);
     }
 
-    static Response to_response(const eckit::EasyCURLResponse& response) {
-        Fields fields;
-        for (const auto& [name, value] : response.headers()) {
-            fields.insert(Field{name, value});
+    // Transfer object cannot be copied!
+    Transfer(const Transfer&)            = delete;
+    Transfer& operator=(const Transfer&) = delete;
+
+    ~Transfer() {
+        // Notice: the handle is reused, so no references to request specific data can be kept
+        curl_easy_setopt(handle_, CURLOPT_HTTPHEADER, nullptr);
+        curl_easy_setopt(handle_, CURLOPT_POSTFIELDS, nullptr);
+        curl_easy_setopt(handle_, CURLOPT_WRITEDATA, nullptr);
+        curl_easy_setopt(handle_, CURLOPT_HEADERDATA, nullptr);
+        curl_easy_setopt(handle_, CURLOPT_PIPEWAIT, 0L);
+        curl_slist_free_all(headers_);
+        pool_.release(host_, handle_);
+    }
+
+    [[nodiscard]] CURL* handle() const { return handle_; }
+    [[nodiscard]] const Host& host() const { return host_; }
+
+    [[nodiscard]] bool expired() const { return Deadline::expired(deadline_); }
+    [[nodiscard]] std::optional<std::chrono::milliseconds> remaining() const {
+        return Deadline::remaining_until(deadline_);
+    }
+
+    /**
+     * Prepare the transfer to be performed in a multiplexed pipeline, preferring to wait for an existing (HTTP/2)
+     * connection rather than opening a new connection
+     */
+    void enable_multiplexing() {
+        curl_easy_setopt(handle_, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+        curl_easy_setopt(handle_, CURLOPT_PIPEWAIT, 1L);
+    }
+
+    /**
+     * Discard any response collected by a previous (failed) attempt, and bound the next attempt by the deadline
+     */
+    void reset() {
+        collected_ = Collected{};
+
+        // Notice: the handle is reused, so the timeouts are always set (where 0 means no timeout)
+        long timeout = 0;
+        if (auto left = remaining(); left) {
+            timeout = std::max(static_cast<long>(left->count()), 1L);
         }
-        auto response_header = ResponseHeader(Status::from_value(response.code()), fields);
-        auto response_body   = Body{response.body()};
+        curl_easy_setopt(handle_, CURLOPT_TIMEOUT_MS, timeout);
+        curl_easy_setopt(handle_, CURLOPT_CONNECTTIMEOUT_MS, timeout);
+    }
 
+    /**
+     * @return true, if the transfer failed and might succeed when retried (i.e. the server could not be reached,
+     *         or is temporarily unavailable)
+     */
+    [[nodiscard]] bool failed(CURLcode result) const {
+        if (result != CURLE_OK) {
+            return true;
+        }
+        long code = 0;
+        curl_easy_getinfo(handle_, CURLINFO_RESPONSE_CODE, &code);
+        return code == static_cast<long>(Status::Code::SERVICE_UNAVAILABLE);
+    }
+
+    /**
+     * Build the response, based on the result of performing the transfer
+     */
+    Response complete(CURLcode result) {
+        long connections = 0;
+        curl_easy_getinfo(handle_, CURLINFO_NUM_CONNECTS, &connections);
+        pool_.account_connections(connections);
+
+        if (result != CURLE_OK) {
+            // Notice: the server could not be reached (e.g. connection refused, or timeout)
+            auto empty_response_header = ResponseHeader(Status::Code::SERVICE_UNAVAILABLE, Fields{});
+            auto empty_response_body   = Body{curl_easy_strerror(result)};
+            return Response{empty_response_header, empty_response_body};
+        }
+
+        long code = 0;
+        curl_easy_getinfo(handle_, CURLINFO_RESPONSE_CODE, &code);
+
+        auto response_header = ResponseHeader(Status::from_value(code), collected_.fields);
+        auto response_body   = Body{collected_.body};
         return Response{response_header, response_body};
     }
 
 private:
-    eckit::EasyCURL handle_;
-    int max_retries_ = 1;
+    struct Collected {
+        Fields fields;
+        std::string body;
+    };
+
+    static size_t collect_body(char* data, size_t size, size_t count, void* user) {
+        auto* collected = static_cast<Collected*>(user);
+        collected->body.append(data, size * count);
+        return size * count;
+    }
+
+    static size_t collect_header(char* data, size_t size, size_t count, void* user) {
+        auto* collected = static_cast<Collected*>(user);
+        std::string_view line(data, size * count);
+        if (auto separator = line.find(':'); separator != std::string_view::npos) {
+            auto name  = trim(line.substr(0, separator));
+            auto value = trim(line.substr(separator + 1));
+            collected->fields.insert(Field{std::string(name), std::string(value)});
+        }
+        return size * count;
+    }
+
+    static std::string_view trim(std::string_view value) {
+        constexpr const char* whitespace = " \t\r\n";
+        auto first                       = value.find_first_not_of(whitespace);
+        if (first == std::string_view::npos) {
+            return {};
+        }
+        auto last = value.find_last_not_of(whitespace);
+        return value.substr(first, last - first + 1);
+    }
+
+    HandlePool& pool_;
+    Host host_;
+    CURL* handle_;
+    std::string url_;
+    std::string body_;
+    curl_slist* headers_;
+    std::optional<Deadline::time_point_t> deadline_;
+    Collected collected_;
 };
 
-template <Method METHOD>
-Response handle_request(const Host& host, const Request<METHOD>& request) {
-    detail::Handle curl;
-    auto url = URL{host, request.header().target()};
+/**
+ * @return true, if the response signals that the server could not be reached, or failed to handle the request
+ */
+bool is_failure(const Response& response) {
+    return static_cast<std::underlying_type_t<Status::Code>>(response.header().status()) >= 500;
+}
+
+/**
+ * @return true, if the transfer should be retried after the given delay (i.e. the retry would not exceed the deadline)
+ */
+bool can_retry(const Transfer& transfer, std::chrono::milliseconds delay) {
+    auto left = transfer.remaining();
+    return !left || *left > delay;
+}
+
+/**
+ * Record the outcome of the transfer in the circuit breaker of the host
+ *
+ * Notice: a transfer cut short by its deadline says nothing about the health of the host, so it is not recorded;
+ *         when the transfer was the probe, the probe is released so that the next request can probe the host
+ */
+void record_outcome(CircuitBreakers& breakers, const Transfer& transfer, const Response& response, bool probe) {
+    if (is_failure(response) && transfer.expired()) {
+        if (probe) {
+            breakers.release(transfer.host());
+        }
+        return;
+    }
+    breakers.record(transfer.host(), !is_failure(response));
+}
+
+Response perform(Transfer& transfer, const RetryPolicy& retry, CircuitBreakers& breakers) {
+    if (transfer.expired()) {
+        return transfer.complete(CURLE_OPERATION_TIMEDOUT);
+    }
+
+    auto admission = breakers.admit(transfer.host());
+    if (admission == CircuitBreaker::Admission::Rejected) {
+        return CircuitBreakers::rejected(transfer.host());
+    }
+
+    // Notice: the probe is attempted only once, as retrying would defeat the purpose of the cooling-off period
+    int attempts    = admission == CircuitBreaker::Admission::Probe ? 1 : std::max(retry.max_attempts, 1);
+    CURLcode result = CURLE_OK;
+    for (int attempt = 1;; ++attempt) {
+        transfer.reset();
+        result = curl_easy_perform(transfer.handle());
+        if (!transfer.failed(result) || attempt >= attempts) {
+            break;
+        }
+        auto delay = retry.backoff(attempt);
+        if (!can_retry(transfer, delay)) {
+            break;
+        }
+        std::this_thread::sleep_for(delay);
+    }
 
-    return curl.perform(url, request);
+    auto response = transfer.complete(result);
+    record_outcome(breakers, transfer, response, admission == CircuitBreaker::Admission::Probe);
+    return response;
 }
 
+template <Method METHOD>
+Response handle_request(HandlePool& pool, const RetryPolicy& retry, CircuitBreakers& breakers, const Host& host,
+                        const Request<METHOD>& request) {
+    Transfer transfer{pool, host, request};
+    return perform(transfer, retry, breakers);
+}
+
+// *** Pipeline ****************************************************************
+// *****************************************************************************
+
+/**
+ * Pipeline performs transfers concurrently, using an event loop (based on curl's multi interface) running on a
+ * dedicated thread.
+ *
+ * At most 'max_in_flight' transfers are performed simultaneously, and these are multiplexed over a single
+ * connection whenever the server supports HTTP/2 (otherwise, up to 'max_in_flight' connections are used).
+ *
+ * Transfers submitted with the same (non-empty) ordering key are performed one at a time, in the order of
+ * submission; a failed transfer is retried (after the backoff delay) before any subsequent transfer with the same
+ * key. Transfers to a host whose circuit is open are completed immediately, without being performed.
+ */
+class Pipeline {
+public:
+    // Period allowed to complete pending transfers, when the pipeline is destroyed
+    static constexpr auto DrainTimeout = std::chrono::seconds(5);
+
+    Pipeline(size_t max_in_flight, RetryPolicy retry, CircuitBreakers& breakers) :
+        max_in_flight_{max_in_flight},
+        retry_{retry},
+        breakers_{breakers},
+        multi_{curl_multi_init()},
+        lock_{},
+        submitted_{},
+        stopping_{false},
+        waiting_{},
+        running_{},
+        busy_{},
+        loop_{} {
+        if (multi_ == nullptr) {
+            ECFLOW_LIGHT_THROW(eckit::SeriousBug, Message("Unable to create libcurl multi handle"));
+        }
+        curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        curl_multi_setopt(multi_, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(max_in_flight_));
+
+        loop_ = std::thread([this]() { run(); });
+    }
+
+    // Pipeline object cannot be copied!
+    Pipeline(const Pipeline&)            = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    ~Pipeline() {
+        {
+            std::scoped_lock lock(lock_);
+            stopping_ = true;
+        }
+        curl_multi_wakeup(multi_);
+        if (loop_.joinable()) {
+            loop_.join();
+        }
+        curl_multi_cleanup(multi_);
+    }
+
+    std::future<Response> submit(std::unique_ptr<Transfer> transfer, std::string key) {
+        transfer->enable_multiplexing();
+
+        Entry entry{std::move(transfer), std::move(key), {}, 0, 0, false, {}};
+        auto response = entry.promise.get_future();
+        {
+            std::scoped_lock lock(lock_);
+            submitted_.push_back(std::move(entry));
+        }
+        curl_multi_wakeup(multi_);
+        return response;
+    }
+
+private:
+    struct Entry {
+        std::unique_ptr<Transfer> transfer;
+        std::string key;
+        std::promise<Response> promise;
+        int attempts;
+        int max_attempts;  // 0 until the transfer is admitted by the circuit breaker
+        bool probe;
+        std::chrono::steady_clock::time_point ready_at;
+    };
+
+    void run() {
+        std::optional<std::chrono::steady_clock::time_point> deadline;
+        for (;;) {
+            {
+                std::scoped_lock lock(lock_);
+                std::move(std::begin(submitted_), std::end(submitted_), std::back_inserter(waiting_));
+                submitted_.clear();
+                if (stopping_ && !deadline) {
+                    deadline = std::chrono::steady_clock::now() + DrainTimeout;
+                }
+            }
+
+            if (deadline && (idle() || std::chrono::steady_clock::now() > *deadline)) {
+                abort_all();
+                return;
+            }
+
+            start_ready();
+
+            int running = 0;
+            curl_multi_perform(multi_, &running);
+            if (collect_completed() > 0) {
+                // Completed transfers might allow waiting transfers to start, so skip waiting for activity
+                continue;
+            }
+
+            curl_multi_poll(multi_, nullptr, 0, next_timeout(), nullptr);
+        }
+    }
+
+    [[nodiscard]] bool idle() const { return waiting_.empty() && running_.empty(); }
+
+    /**
+     * @return the maximum period (in milliseconds) to wait for activity, so that retries are started on time
+     */
+    [[nodiscard]] int next_timeout() const {
+        auto timeout = std::chrono::milliseconds(100);
+        auto now     = std::chrono::steady_clock::now();
+        for (const auto& entry : waiting_) {
+            if (entry.ready_at > now) {
+                auto due = std::chrono::ceil<std::chrono::milliseconds>(entry.ready_at - now);
+                timeout  = std::min(due, timeout);
+            }
+        }
+        return static_cast<int>(timeout.count());
+    }
+
+    void start_ready() {
+        auto now = std::chrono::steady_clock::now();
+        // Keys of the transfers waiting to be retried, which hold back any subsequent transfer with the same key
+        std::unordered_set<std::string> delayed;
+        for (auto current = std::begin(waiting_); current != std::end(waiting_);) {
+            if (running_.size() >= max_in_flight_) {
+                return;
+            }
+            if (!current->key.empty() && (busy_.count(current->key) > 0 || delayed.count(current->key) > 0)) {
+                // Preserve the order of transfers with the same key
+                ++current;
+                continue;
+            }
+            if (current->ready_at > now) {
+                delayed.insert(current->key);
+                ++current;
+                continue;
+            }
+
+            if (current->transfer->expired()) {
+                current->promise.set_value(current->transfer->complete(CURLE_OPERATION_TIMEDOUT));
+                current = waiting_.erase(current);
+                continue;
+            }
+
+            if (current->max_attempts == 0) {
+                auto admission = breakers_.admit(current->transfer->host());
+                if (admission == CircuitBreaker::Admission::Rejected) {
+                    current->promise.set_value(CircuitBreakers::rejected(current->transfer->host()));
+                    current = waiting_.erase(current);
+                    continue;
+                }
+                current->probe        = admission == CircuitBreaker::Admission::Probe;
+                current->max_attempts = current->probe ? 1 : std::max(retry_.max_attempts, 1);
+            }
+
+            CURL* handle = current->transfer->handle();
+            current->transfer->reset();
+            current->attempts++;
+            if (!current->key.empty()) {
+                busy_.insert(current->key);
+            }
+            curl_multi_add_handle(multi_, handle);
+            running_.emplace(handle, std::move(*current));
+            current = waiting_.erase(current);
+        }
+    }
+
+    size_t collect_completed() {
+        size_t completed = 0;
+        int remaining    = 0;
+        while (CURLMsg* message = curl_multi_info_read(multi_, &remaining)) {
+            if (message->msg != CURLMSG_DONE) {
+                continue;
+            }
+
+            CURL* handle    = message->easy_handle;
+            CURLcode result = message->data.result;
+            curl_multi_remove_handle(multi_, handle);
+
+            auto found = running_.find(handle);
+            Entry entry{std::move(found->second)};
+            running_.erase(found);
+
+            busy_.erase(entry.key);
+            ++completed;
+
+            if (entry.transfer->failed(result) && entry.attempts < entry.max_attempts) {
+                if (auto delay = retry_.backoff(entry.attempts); can_retry(*entry.transfer, delay)) {
+                    // Retry (after the backoff delay), ahead of any other transfer with the same key
+                    entry.ready_at = std::chrono::steady_clock::now() + delay;
+                    waiting_.push_front(std::move(entry));
+                    continue;
+                }
+            }
+
+            auto response = entry.transfer->complete(result);
+            record_outcome(breakers_, *entry.transfer, response, entry.probe);
+            entry.promise.set_value(std::move(response));
+        }
+        return completed;
+    }
+
+    void abort_all() {
+        for (auto& [handle, entry] : running_) {
+            curl_multi_remove_handle(multi_, handle);
+            if (entry.probe) {
+                breakers_.release(entry.transfer->host());
+            }
+            entry.promise.set_value(entry.transfer->complete(CURLE_ABORTED_BY_CALLBACK));
+        }
+        running_.clear();
+        for (auto& entry : waiting_) {
+            entry.promise.set_value(entry.transfer->complete(CURLE_ABORTED_BY_CALLBACK));
+        }
+        waiting_.clear();
+    }
+
+    size_t max_in_flight_;
+    RetryPolicy retry_;
+    CircuitBreakers& breakers_;
+    CURLM* multi_;
+
+    // Notice: the lock protects only the submitted transfers, as all other state is managed by the loop thread
+    std::mutex lock_;
+    std::vector<Entry> submitted_;
+    bool stopping_;
+
+    std::deque<Entry> waiting_;
+    std::unordered_map<CURL*, Entry> running_;
+    std::unordered_set<std::string> busy_;
+
+    std::thread loop_;
+};
+
 }  // namespace detail
 
+// *** Tiny REST Client ********************************************************
+// *****************************************************************************
+
+TinyRESTClient::TinyRESTClient() : TinyRESTClient(DefaultIdleTimeout) {}
+
+TinyRESTClient::TinyRESTClient(std::chrono::seconds idle_timeout, size_t max_in_flight, RetryPolicy retry,
+                               CircuitBreakerPolicy breaker) :
+    pool_{std::make_unique<detail::HandlePool>(idle_timeout, max_in_flight)},
+    retry_{retry},
+    breakers_{std::make_unique<detail::CircuitBreakers>(breaker)},
+    pipeline_{max_in_flight > 1 ? std::make_unique<detail::Pipeline>(max_in_flight, retry_, *breakers_) : nullptr} {}
+
+TinyRESTClient::~TinyRESTClient() = default;
+
+TinyRESTClient::TinyRESTClient(TinyRESTClient&&) noexcept            = default;
+TinyRESTClient& TinyRESTClient::operator=(TinyRESTClient&&) noexcept = default;
 
 Response TinyRESTClient::handle(const Host& host, const Request<Method::GET>& request) const {
-    return detail::handle_request(host, request);
+    return detail::handle_request(*pool_, retry_, *breakers_, host, request);
 }
 
 Response TinyRESTClient::handle(const Host& host, const Request<Method::POST>& request) const {
-    return detail::handle_request(host, request);
+    return detail::handle_request(*pool_, retry_, *breakers_, host, request);
 }
 
 Response TinyRESTClient::handle(const Host& host, const Request<Method::PUT>& request) const {
-    return detail::handle_request(host, request);
+    return detail::handle_request(*pool_, retry_, *breakers_, host, request);
+}
+
+std::future<Response> TinyRESTClient::submit(const Host& host, const Request<Method::GET>& request,
+                                             std::string key) const {
+    return submit_transfer(std::make_unique<detail::Transfer>(*pool_, host, request), std::move(key));
+}
+
+std::future<Response> TinyRESTClient::submit(const Host& host, const Request<Method::POST>& request,
+                                             std::string key) const {
+    return submit_transfer(std::make_unique<detail::Transfer>(*pool_, host, request), std::move(key));
+}
+
+std::future<Response> TinyRESTClient::submit(const Host& host, const Request<Method::PUT>& request,
+                                             std::string key) const {
+    return submit_transfer(std::make_unique<detail::Transfer>(*pool_, host, request), std::move(key));
+}
+
+size_t TinyRESTClient::connections() const {
+    return pool_->connections();
+}
+
+CircuitBreaker::State TinyRESTClient::circuit_state(const Host& host) const {
+    return breakers_->state(host);
+}
+
+std::future<Response> TinyRESTClient::submit_transfer(std::unique_ptr<detail::Transfer> transfer,
+                                                      std::string key) const {
+    if (pipeline_) {
+        return pipeline_->submit(std::move(transfer), std::move(key));
+    }
+
+    // Without a pipeline, the transfer is performed immediately (i.e. on the caller thread)
+    std::promise<Response> response;
+    response.set_value(detail::perform(*transfer, retry_, *breakers_));
+    return response.get_future();
 }
 
 }  // namespace net
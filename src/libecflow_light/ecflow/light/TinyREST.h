@@ -12,7 +12,10 @@
 #define ECFLOW_LIGHT_TINYREST_H
 
 #include <algorithm>
+#include <chrono>
+#include <future>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -24,12 +27,24 @@ namespace net {
 
 class Host {
 public:
-    explicit Host(std::string host) : uri_host_{std::move(host)} {}
-    explicit Host(const std::string& host, const std::string& port) : uri_host_{stringify(host, ":", port)} {}
+    static constexpr const char* SchemeHTTPS = "https";
+    static constexpr const char* SchemeHTTP  = "http";
 
+    explicit Host(std::string host) : scheme_{SchemeHTTPS}, uri_host_{std::move(host)} {}
+    explicit Host(const std::string& host, const std::string& port) :
+        scheme_{SchemeHTTPS}, uri_host_{stringify(host, ":", port)} {}
+
+    [[nodiscard]] static Host with_scheme(std::string scheme, const std::string& host, const std::string& port) {
+        Host h{host, port};
+        h.scheme_ = std::move(scheme);
+        return h;
+    }
+
+    [[nodiscard]] const std::string& scheme() const { return scheme_; }
     [[nodiscard]] const std::string& str() const { return uri_host_; }
 
 private:
+    std::string scheme_;
     std::string uri_host_;
 };
 
@@ -50,7 +65,7 @@ public:
 
     [[nodiscard]] std::string str() const {
         // Notice: target is expected to start with "/", so no need to have a separator after host
-        return stringify("https://", host_.str(), target_.str());
+        return stringify(host_.scheme(), "://", host_.str(), target_.str());
     }
 
 private:
@@ -93,7 +108,8 @@ public:
         NOT_FOUND    = 404,
 
         // Server Error responses
-        INTERNAL_SERVER_ERROR = 500
+        INTERNAL_SERVER_ERROR = 500,
+        SERVICE_UNAVAILABLE   = 503
     };
 
     static const std::string& as_description(Code code) {
@@ -257,11 +273,179 @@ private:
     body_t body_;
 };
 
+// *** Retry Policy & Circuit Breaker ******************************************
+// *****************************************************************************
+
+/**
+ * RetryPolicy describes how a failed request (i.e. the server could not be reached, or is unavailable) is retried.
+ *
+ * The delay before each retry grows exponentially, starting at 'base_backoff' and bounded by 'max_backoff'. A random
+ * fraction (up to 'jitter') of each delay is subtracted, so that clients that failed together do not retry together.
+ */
+struct RetryPolicy {
+    static constexpr int DefaultMaxAttempts                      = 3;
+    static constexpr std::chrono::milliseconds DefaultBackoff    = std::chrono::milliseconds(100);
+    static constexpr std::chrono::milliseconds DefaultMaxBackoff = std::chrono::milliseconds(2000);
+    static constexpr double DefaultJitter                        = 0.5;
+
+    int max_attempts                       = DefaultMaxAttempts;
+    std::chrono::milliseconds base_backoff = DefaultBackoff;
+    std::chrono::milliseconds max_backoff  = DefaultMaxBackoff;
+    double jitter                          = DefaultJitter;
+
+    /**
+     * @return the delay to wait, after the given number of failed attempts, before attempting again
+     */
+    [[nodiscard]] std::chrono::milliseconds backoff(int failed_attempts) const;
+};
+
+/**
+ * CircuitBreakerPolicy describes when the requests to a host are stopped, after consecutive failures.
+ */
+struct CircuitBreakerPolicy {
+    static constexpr size_t DefaultFailureThreshold           = 5;
+    static constexpr std::chrono::milliseconds DefaultCooloff = std::chrono::milliseconds(10000);
+
+    // Number of consecutive failed requests that opens the circuit; 0 disables the circuit breaker
+    size_t failure_threshold = DefaultFailureThreshold;
+    // Period during which requests fail immediately, once the circuit is open
+    std::chrono::milliseconds cooloff = DefaultCooloff;
+};
+
+/**
+ * CircuitBreaker tracks the consecutive failures of the requests to a single host.
+ *
+ * While closed, all requests are allowed. Once 'failure_threshold' consecutive requests fail, the circuit opens
+ * and requests are rejected (i.e. fail fast, without contacting the host) for the cooling-off period. Afterwards,
+ * the circuit is half-open: a single probe request is allowed, and while it is in progress every other request is
+ * still rejected. A successful probe closes the circuit, while a failed probe opens it again.
+ *
+ * Notice: the circuit breaker is not thread-safe.
+ */
+class CircuitBreaker {
+public:
+    using clock_t = std::chrono::steady_clock;
+
+    enum class State
+    {
+        Closed,
+        Open,
+        HalfOpen
+    };
+
+    enum class Admission
+    {
+        Allowed,
+        Probe,
+        Rejected
+    };
+
+    explicit CircuitBreaker(CircuitBreakerPolicy policy) :
+        policy_{policy}, state_{State::Closed}, failures_{0}, opened_at_{}, probing_{false} {}
+
+    /**
+     * Decide if a request is allowed, and whether it is the probe that tests the recovery of the host
+     */
+    Admission admit(clock_t::time_point now = clock_t::now());
+
+    /**
+     * Record the outcome of a request previously admitted
+     */
+    void record(bool success, clock_t::time_point now = clock_t::now());
+
+    /**
+     * Release the probe previously admitted, without recording its outcome (e.g. cut short by its deadline), so that
+     * another probe can be admitted
+     */
+    void release();
+
+    [[nodiscard]] State state() const { return state_; }
+
+private:
+    CircuitBreakerPolicy policy_;
+    State state_;
+    size_t failures_;
+    clock_t::time_point opened_at_;
+    bool probing_;
+};
+
+namespace detail {
+class CircuitBreakers;
+class HandlePool;
+class Pipeline;
+class Transfer;
+}  // namespace detail
+
+/**
+ * TinyRESTClient performs HTTP requests, reusing connections across requests.
+ *
+ * The client owns a pool of handles for each host, and each handle keeps its connection alive after a request.
+ * TLS sessions and DNS resolutions are shared by all the handles of the client. Handles (and connections) that
+ * have been idle for longer than the given timeout are discarded.
+ *
+ * Besides the blocking `handle`, requests can be submitted to be performed concurrently. When allowed more
+ * than one request in flight, the client runs an event loop that performs up to 'max_in_flight' requests
+ * simultaneously (multiplexed over HTTP/2, when supported by the server). Requests submitted with the same
+ * (non-empty) key are performed in order, one at a time.
+ *
+ * Requests failing to reach a host are retried according to the retry policy. Each host has a circuit breaker,
+ * so that requests to a host that keeps failing are rejected immediately (with status SERVICE_UNAVAILABLE) until
+ * a probe request succeeds.
+ *
+ * Each request is bounded by the deadline (if any) of the thread issuing it: each attempt is given only the time
+ * remaining, and no retry is attempted when its backoff would exceed the deadline.
+ *
+ * The client can be used concurrently by several threads, as each request uses a handle exclusively.
+ */
 class TinyRESTClient {
 public:
+    static constexpr std::chrono::seconds DefaultIdleTimeout = std::chrono::seconds(60);
+
+    TinyRESTClient();
+    explicit TinyRESTClient(std::chrono::seconds idle_timeout, size_t max_in_flight = 1, RetryPolicy retry = {},
+                            CircuitBreakerPolicy breaker = {});
+    ~TinyRESTClient();
+
+    TinyRESTClient(TinyRESTClient&&) noexcept;
+    TinyRESTClient& operator=(TinyRESTClient&&) noexcept;
+
     [[nodiscard]] Response handle(const Host& host, const Request<Method::GET>& request) const;
     [[nodiscard]] Response handle(const Host& host, const Request<Method::POST>& request) const;
     [[nodiscard]] Response handle(const Host& host, const Request<Method::PUT>& request) const;
+
+    /**
+     * Submit a request, to be performed concurrently with other submitted requests.
+     *
+     * Notice: when allowed only one request in flight, the request is performed before returning.
+     *
+     * @param key requests with the same key are performed in the order of submission; empty means unordered
+     * @return the future response
+     */
+    std::future<Response> submit(const Host& host, const Request<Method::GET>& request, std::string key = {}) const;
+    std::future<Response> submit(const Host& host, const Request<Method::POST>& request, std::string key = {}) const;
+    std::future<Response> submit(const Host& host, const Request<Method::PUT>& request, std::string key = {}) const;
+
+    [[nodiscard]] bool is_pipelined() const { return pipeline_ != nullptr; }
+
+    /**
+     * @return the number of connections opened so far, by all handles in the pool
+     */
+    [[nodiscard]] size_t connections() const;
+
+    /**
+     * @return the state of the circuit breaker of the given host
+     */
+    [[nodiscard]] CircuitBreaker::State circuit_state(const Host& host) const;
+
+private:
+    std::future<Response> submit_transfer(std::unique_ptr<detail::Transfer> transfer, std::string key) const;
+
+    // Notice: the pipeline must be destroyed before the pool (and the circuit breakers), as the pending transfers
+    //         hold handles from the pool
+    std::unique_ptr<detail::HandlePool> pool_;
+    RetryPolicy retry_;
+    std::unique_ptr<detail::CircuitBreakers> breakers_;
+    std::unique_ptr<detail::Pipeline> pipeline_;
 };
 
 }  // namespace net
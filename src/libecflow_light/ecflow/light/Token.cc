@@ -9,3 +9,74 @@
  */
 
 #include "ecflow/light/Token.h"
+
+#include <sys/stat.h>
+
+namespace ecflow::light {
+
+TokenCache::TokenCache(std::optional<fs::path> path, std::chrono::milliseconds check_period) :
+    path_{std::move(path)}, check_period_{check_period}, lock_{}, version_{}, checked_at_{}, authorizations_{} {}
+
+TokenCache& TokenCache::instance() {
+    static TokenCache theInstance = []() {
+        try {
+            return TokenCache{Tokens::default_path()};
+        }
+        catch (const eckit::Exception& e) {
+            Log::warning() << "Unable to locate secret tokens, due to: " << e.what() << std::endl;
+            return TokenCache{std::nullopt};
+        }
+    }();
+    return theInstance;
+}
+
+std::optional<std::string> TokenCache::authorization(const std::string& url) {
+    std::scoped_lock lock(lock_);
+
+    auto now = std::chrono::steady_clock::now();
+    if (!version_ || now - checked_at_ >= check_period_) {
+        checked_at_ = now;
+        if (auto version = probe(); !version_ || version != *version_) {
+            reload(version);
+        }
+    }
+
+    if (auto found = authorizations_.find(url); found != std::end(authorizations_)) {
+        return found->second;
+    }
+    return std::nullopt;
+}
+
+TokenCache::Version TokenCache::probe() const {
+    struct stat status {};
+    if (!path_ || ::stat(path_->c_str(), &status) != 0) {
+        return Version{false, 0, 0, 0};
+    }
+    return Version{true, static_cast<uint64_t>(status.st_ino), static_cast<uint64_t>(status.st_size),
+                   static_cast<int64_t>(status.st_mtim.tv_sec) * 1'000'000'000 + status.st_mtim.tv_nsec};
+}
+
+void TokenCache::reload(const Version& version) {
+    version_ = version;
+    authorizations_.clear();
+
+    if (!version.present) {
+        Log::warning() << "No secret tokens available, as file '" << (path_ ? path_->string() : std::string())
+                       << "' not found" << std::endl;
+        return;
+    }
+
+    try {
+        auto tokens = Tokens::load(*path_);
+        for (const auto& token : tokens.tokens()) {
+            authorizations_.emplace(token.url, "Bearer " + token.key);
+        }
+        Log::debug() << "Loaded " << authorizations_.size() << " secret token(s) from '" << path_->string() << "'"
+                     << std::endl;
+    }
+    catch (const eckit::Exception& e) {
+        Log::error() << "Unable to load secret tokens, due to: " << e.what() << std::endl;
+    }
+}
+
+}  // namespace ecflow::light
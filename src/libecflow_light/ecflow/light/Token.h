@@ -11,8 +11,12 @@
 #ifndef ECFLOW_LIGHT_TOKEN_H
 #define ECFLOW_LIGHT_TOKEN_H
 
+#include <chrono>
 #include <fstream>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <unordered_map>
 
 #include "ecflow/light/Environment.h"
 #include "ecflow/light/Filesystem.h"
@@ -59,27 +63,36 @@ public:
         }
     }
 
-private:
-    static storage_t load() {
+    [[nodiscard]] const storage_t& tokens() const { return tokens_; }
+
+    /**
+     * @return the default location of the tokens file, i.e. $HOME/.ecflowrc/ssl/api-tokens.json
+     */
+    static fs::path default_path() {
         auto environment = Environment().from_environment("HOME");
 
         auto home = environment.get_optional("HOME");
         if (home) {
             auto home_var      = home.value();
             fs::path home_path = home_var.value;
-            auto cfg_path      = home_path / ".ecflowrc" / "ssl" / "api-tokens.json";
+            return home_path / ".ecflowrc" / "ssl" / "api-tokens.json";
+        }
 
-            std::ifstream ifs(cfg_path);
-            if (!ifs.is_open()) {
-                ECFLOW_LIGHT_THROW(UnableToLoadSecretToken, Message("Unable to open file: '", cfg_path, "'"));
-            }
+        ECFLOW_LIGHT_THROW(EnvironmentVariableNotFound, Message("Unable to find environment variable 'HOME'"));
+    }
 
-            return Tokens::read(ifs);
+    static Tokens load(const fs::path& cfg_path) {
+        std::ifstream ifs(cfg_path);
+        if (!ifs.is_open()) {
+            ECFLOW_LIGHT_THROW(UnableToLoadSecretToken, Message("Unable to open file: '", cfg_path, "'"));
         }
 
-        ECFLOW_LIGHT_THROW(EnvironmentVariableNotFound, Message("Unable to find environment variable 'HOME'"));
+        return Tokens{Tokens::read(ifs)};
     }
 
+private:
+    static storage_t load() { return Tokens::load(default_path()).tokens_; }
+
     static storage_t read(std::ifstream& ifs) {
         auto parser      = eckit::JSONParser(ifs);
         auto token_array = parser.parse();
@@ -101,6 +114,59 @@ private:
     storage_t tokens_;
 };
 
+// *** Token Cache *************************************************************
+// *****************************************************************************
+
+/**
+ * TokenCache keeps, for the whole process, the Authorization header value (i.e. "Bearer <key>") for each URL.
+ *
+ * The tokens file is loaded only once, and loaded again only when the file is modified. To avoid any file system
+ * access on each request, the file is checked for modifications at most once per check period. A missing (or
+ * invalid) file is cached as well, resulting in no Authorization for any URL until the file becomes available.
+ */
+class TokenCache {
+public:
+    static constexpr auto DefaultCheckPeriod = std::chrono::milliseconds(1000);
+
+    explicit TokenCache(std::optional<fs::path> path, std::chrono::milliseconds check_period = DefaultCheckPeriod);
+
+    /**
+     * @return the process-wide cache, based on the default location of the tokens file
+     */
+    static TokenCache& instance();
+
+    /**
+     * @return the ready-to-use Authorization header value for the given URL, if any token is available
+     */
+    std::optional<std::string> authorization(const std::string& url);
+
+private:
+    // Identifies a particular version of the file; all zero (and not present) when the file is missing
+    struct Version {
+        bool present;
+        uint64_t inode;
+        uint64_t size;
+        int64_t modified_ns;
+
+        bool operator==(const Version& other) const {
+            return present == other.present && inode == other.inode && size == other.size &&
+                   modified_ns == other.modified_ns;
+        }
+        bool operator!=(const Version& other) const { return !(*this == other); }
+    };
+
+    [[nodiscard]] Version probe() const;
+    void reload(const Version& version);
+
+    std::optional<fs::path> path_;
+    std::chrono::milliseconds check_period_;
+
+    std::mutex lock_;
+    std::optional<Version> version_;
+    std::chrono::steady_clock::time_point checked_at_;
+    std::unordered_map<std::string, std::string> authorizations_;
+};
+
 }  // namespace ecflow::light
 
 #endif
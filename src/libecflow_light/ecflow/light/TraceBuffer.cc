@@ -0,0 +1,360 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include "ecflow/light/TraceBuffer.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <type_traits>
+
+#include "ecflow/light/Log.h"
+
+namespace ecflow::light {
+
+static_assert(std::is_trivially_copyable_v<TraceRecord>, "TraceRecord must be trivially copyable");
+static_assert(sizeof(TraceRecord) == 88, "TraceRecord layout must not change");
+
+// *** Trace Record ************************************************************
+// *****************************************************************************
+
+namespace {
+
+/**
+ * Describer fills in the record, according to the kind of request
+ */
+struct Describer : public RequestDispatcher {
+    explicit Describer(TraceRecord& record) : record_{record} {}
+
+    void dispatch_request(const UpdateNodeStatus& request) override {
+        record_.kind  = TraceRecord::Kind::Status;
+        record_.count = 0;
+        record_.set_command(request.options().find(Field::Action).value_or(""));
+    }
+    void dispatch_request(const UpdateNodeAttribute& request) override {
+        record_.kind  = TraceRecord::Kind::Attribute;
+        record_.count = 1;
+        describe(request.options());
+    }
+    void dispatch_request(const UpdateNodeAttributes& request) override {
+        record_.kind  = TraceRecord::Kind::Attributes;
+        record_.count = static_cast<uint32_t>(request.attributes().size());
+        if (!request.attributes().empty()) {
+            describe(request.attributes().front());
+        }
+    }
+
+private:
+    void describe(const Options& options) {
+        record_.set_command(options.find(Field::Command).value_or(""));
+        record_.set_name(options.find(Field::Name).value_or(""));
+    }
+
+    TraceRecord& record_;
+};
+
+template <size_t N>
+void copy_truncated(char (&target)[N], std::string_view source) {
+    // Notice: the null terminator is always kept
+    size_t size = std::min(source.size(), N - 1);
+    std::memcpy(target, source.data(), size);
+    std::memset(target + size, 0, N - size);
+}
+
+template <size_t N>
+std::string_view view_of(const char (&source)[N]) {
+    return std::string_view(source, ::strnlen(source, N));
+}
+
+}  // namespace
+
+TraceRecord TraceRecord::make_record(const Request& request) {
+    TraceRecord record;
+    Describer describer{record};
+    request.dispatch(describer);
+    return record;
+}
+
+TraceRecord::Outcome TraceRecord::outcome_of(const Response& response) {
+    switch (response.outcome) {
+        case Response::Outcome::Queued:
+            return Outcome::Queued;
+        case Response::Outcome::Dropped:
+            return Outcome::Dropped;
+        case Response::Outcome::Spooled:
+            return Outcome::Spooled;
+        default:
+            return Outcome::Sent;
+    }
+}
+
+void TraceRecord::set_command(std::string_view command) {
+    copy_truncated(this->command, command);
+}
+
+void TraceRecord::set_name(std::string_view name) {
+    copy_truncated(this->name, name);
+}
+
+std::ostream& operator<<(std::ostream& o, const TraceRecord& record) {
+    // Timestamp, as ISO 8601 (UTC) with microseconds
+    std::time_t seconds = static_cast<std::time_t>(record.timestamp_us / 1000000);
+    std::tm time{};
+    ::gmtime_r(&seconds, &time);
+    char formatted[32];
+    std::strftime(formatted, sizeof(formatted), "%Y-%m-%dT%H:%M:%S", &time);
+    o << formatted << "." << std::setw(6) << std::setfill('0') << record.timestamp_us % 1000000 << std::setfill(' ')
+      << "Z";
+
+    switch (record.transport) {
+        case TraceRecord::Transport::UDP:
+            o << " UDP";
+            break;
+        case TraceRecord::Transport::HTTP:
+            o << " HTTP";
+            break;
+        case TraceRecord::Transport::CLI:
+            o << " CLI";
+            break;
+        default:
+            o << " ???";
+            break;
+    }
+
+    switch (record.kind) {
+        case TraceRecord::Kind::Status:
+            o << " status " << view_of(record.command);
+            break;
+        case TraceRecord::Kind::Attribute:
+            o << " " << view_of(record.command) << " '" << view_of(record.name) << "'";
+            break;
+        case TraceRecord::Kind::Attributes:
+            o << " batch of " << record.count << ", first " << view_of(record.command) << " '"
+              << view_of(record.name) << "'";
+            break;
+    }
+
+    o << ", " << record.bytes << " bytes, in " << record.latency_us << "us: ";
+    switch (record.outcome) {
+        case TraceRecord::Outcome::Sent:
+            o << "sent";
+            break;
+        case TraceRecord::Outcome::Queued:
+            o << "queued";
+            break;
+        case TraceRecord::Outcome::Dropped:
+            o << "dropped";
+            break;
+        case TraceRecord::Outcome::Failed:
+            o << "failed";
+            break;
+        case TraceRecord::Outcome::Spooled:
+            o << "spooled";
+            break;
+    }
+    return o;
+}
+
+// *** Trace Buffer ************************************************************
+// *****************************************************************************
+
+namespace {
+
+/**
+ * TraceHeader precedes the records of each block of the dump
+ */
+struct TraceHeader {
+    uint32_t marker      = Marker;
+    uint32_t version     = Version;
+    uint32_t record_size = sizeof(TraceRecord);
+    uint32_t pid         = 0;
+    uint64_t count       = 0;
+    uint64_t lost        = 0;
+
+    static constexpr uint32_t Marker  = 0x45'43'4C'54;  // i.e. "ECLT"
+    static constexpr uint32_t Version = 1;
+};
+
+static_assert(sizeof(TraceHeader) == 32, "TraceHeader layout must not change");
+
+size_t round_up_to_power_of_two(size_t value) {
+    size_t rounded = 1;
+    while (rounded < value) {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+}  // namespace
+
+TraceBuffer::TraceBuffer(size_t capacity, std::string dump_path) :
+    slots_{},
+    mask_{round_up_to_power_of_two(std::max(capacity, size_t{1})) - 1},
+    head_{0},
+    dump_path_{std::move(dump_path)} {
+    slots_ = std::make_unique<Slot[]>(mask_ + 1);
+}
+
+TraceBuffer::~TraceBuffer() {
+    if (installed() == this) {
+        install(nullptr);
+    }
+
+    if (!dump_path_.empty()) {
+        try {
+            dump(dump_path_);
+        }
+        catch (eckit::Exception& e) {
+            Log::error() << "Error detected: " << e.what() << std::endl;
+        }
+    }
+}
+
+void TraceBuffer::record(const TraceRecord& record) noexcept {
+    uint64_t position = head_.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot        = slots_[position & mask_];
+
+    slot.sequence.store(2 * position + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&slot.record, &record, sizeof(TraceRecord));
+    slot.sequence.store(2 * position + 2, std::memory_order_release);
+}
+
+std::vector<TraceRecord> TraceBuffer::snapshot() const {
+    uint64_t head  = head_.load(std::memory_order_acquire);
+    uint64_t first = head > capacity() ? head - capacity() : 0;
+
+    std::vector<TraceRecord> records;
+    records.reserve(head - first);
+    for (uint64_t position = first; position != head; ++position) {
+        const Slot& slot = slots_[position & mask_];
+
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before != 2 * position + 2) {
+            // Notice: the record is still being written, or has already been overwritten
+            continue;
+        }
+        TraceRecord record;
+        std::memcpy(&record, &slot.record, sizeof(TraceRecord));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != before) {
+            continue;
+        }
+        records.push_back(record);
+    }
+    return records;
+}
+
+void TraceBuffer::dump(const std::string& path) const {
+    auto records = snapshot();
+
+    TraceHeader header;
+    header.pid   = static_cast<uint32_t>(::getpid());
+    header.count = records.size();
+    header.lost  = recorded() - records.size();
+
+    std::string block(sizeof(header) + records.size() * sizeof(TraceRecord), '\0');
+    std::memcpy(block.data(), &header, sizeof(header));
+    if (!records.empty()) {
+        std::memcpy(block.data() + sizeof(header), records.data(), records.size() * sizeof(TraceRecord));
+    }
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        ECFLOW_LIGHT_THROW(TraceError, Message("Unable to open trace dump '", path, "', due to: ",
+                                               std::strerror(errno)));
+    }
+
+    // Notice: the block is appended with a single write (whenever possible), so that blocks are never interleaved
+    size_t written = 0;
+    while (written < block.size()) {
+        ssize_t size = ::write(fd, block.data() + written, block.size() - written);
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size <= 0) {
+            int error = errno;
+            ::close(fd);
+            ECFLOW_LIGHT_THROW(TraceError, Message("Unable to write trace dump '", path, "', due to: ",
+                                                   std::strerror(error)));
+        }
+        written += static_cast<size_t>(size);
+    }
+    ::close(fd);
+
+    Log::debug() << "Trace dumped to '" << path << "', with " << records.size() << " record(s)" << std::endl;
+}
+
+// *** Trace Dump **************************************************************
+// *****************************************************************************
+
+std::vector<TraceDump> TraceDump::load(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        ECFLOW_LIGHT_THROW(TraceError, Message("Unable to open trace dump '", path, "'"));
+    }
+    std::string contents{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+
+    std::vector<TraceDump> dumps;
+    size_t offset = 0;
+    while (offset < contents.size()) {
+        TraceHeader header;
+        if (contents.size() - offset < sizeof(header)) {
+            ECFLOW_LIGHT_THROW(TraceError, Message("Truncated trace dump '", path, "', at offset ", offset));
+        }
+        std::memcpy(&header, contents.data() + offset, sizeof(header));
+        offset += sizeof(header);
+
+        if (header.marker != TraceHeader::Marker || header.version != TraceHeader::Version ||
+            header.record_size != sizeof(TraceRecord)) {
+            ECFLOW_LIGHT_THROW(TraceError, Message("Invalid trace dump '", path, "', at offset ", offset,
+                                                   ". Expected version ", TraceHeader::Version));
+        }
+        if ((contents.size() - offset) / sizeof(TraceRecord) < header.count) {
+            ECFLOW_LIGHT_THROW(TraceError, Message("Truncated trace dump '", path, "', at offset ", offset));
+        }
+
+        TraceDump& dump = dumps.emplace_back();
+        dump.pid        = header.pid;
+        dump.lost       = header.lost;
+        dump.records.resize(header.count);
+        if (header.count > 0) {
+            std::memcpy(dump.records.data(), contents.data() + offset, header.count * sizeof(TraceRecord));
+        }
+        offset += header.count * sizeof(TraceRecord);
+    }
+    return dumps;
+}
+
+size_t decode_trace(const std::string& path, std::ostream& output) {
+    size_t decoded = 0;
+    for (const auto& dump : TraceDump::load(path)) {
+        output << "# Process " << dump.pid << ": " << dump.records.size() << " record(s)";
+        if (dump.lost > 0) {
+            output << ", " << dump.lost << " older record(s) overwritten";
+        }
+        output << "\n";
+        for (const auto& record : dump.records) {
+            output << record << "\n";
+        }
+        decoded += dump.records.size();
+    }
+    output.flush();
+    return decoded;
+}
+
+}  // namespace ecflow::light
@@ -0,0 +1,184 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#ifndef ECFLOW_LIGHT_TRACEBUFFER_H
+#define ECFLOW_LIGHT_TRACEBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ecflow/light/Exception.h"
+#include "ecflow/light/Requests.h"
+
+namespace ecflow::light {
+
+struct TraceError : public eckit::Exception {
+    TraceError(const std::string& msg, const eckit::CodeLocation& loc) : eckit::Exception(msg, loc) {}
+};
+
+// *** Trace Record ************************************************************
+// *****************************************************************************
+
+/**
+ * TraceRecord describes a single request sent by one of the (library) clients, as a fixed size binary record.
+ *
+ * Notice: the records are written to the trace dump as-is, and thus the layout must not change without also
+ *         changing the version of the dump.
+ */
+struct TraceRecord {
+    enum class Transport : uint8_t
+    {
+        Unknown = 0,
+        UDP     = 1,
+        HTTP    = 2,
+        CLI     = 3
+    };
+
+    enum class Kind : uint8_t
+    {
+        Status     = 1,
+        Attribute  = 2,
+        Attributes = 3
+    };
+
+    enum class Outcome : uint8_t
+    {
+        Sent    = 1,
+        Queued  = 2,
+        Dropped = 3,
+        Failed  = 4,
+        Spooled = 5
+    };
+
+    uint64_t timestamp_us = 0;  // since the epoch
+    uint32_t latency_us   = 0;
+    uint32_t bytes        = 0;
+    uint32_t count        = 0;  // i.e. number of attributes updated
+    Transport transport   = Transport::Unknown;
+    Kind kind             = Kind::Attribute;
+    Outcome outcome       = Outcome::Sent;
+    uint8_t reserved      = 0;
+    char command[12]      = {};  // e.g. "meter", or the action of a status update (e.g. "complete")
+    char name[52]         = {};  // i.e. the name of the (first) attribute, truncated if necessary
+
+    /**
+     * @return the record describing the request (i.e. its kind, command, name and count)
+     */
+    static TraceRecord make_record(const Request& request);
+
+    /**
+     * @return the outcome corresponding to the response of a request that was dispatched without errors
+     */
+    static Outcome outcome_of(const Response& response);
+
+    void set_command(std::string_view command);
+    void set_name(std::string_view name);
+};
+
+std::ostream& operator<<(std::ostream& o, const TraceRecord& record);
+
+// *** Trace Buffer ************************************************************
+// *****************************************************************************
+
+/**
+ * TraceBuffer keeps the most recent trace records in memory, in a fixed size ring.
+ *
+ * Recording is lock-free, and never blocks nor allocates: each record claims the next slot (overwriting the oldest
+ * record, when the ring is full), and publishes it with a sequence number. Taking a snapshot discards the slots
+ * being written, or overwritten, while being read.
+ *
+ * The records are only turned into text when decoding the dump, thus keeping the cost of tracing to a copy of a
+ * few bytes per request.
+ */
+class TraceBuffer {
+public:
+    /**
+     * Creates the buffer, holding (at least) the given number of records.
+     *
+     * When the dump path is given, the records are appended to the dump on destruction (i.e. at exit, for the
+     * buffer of the configured client).
+     */
+    explicit TraceBuffer(size_t capacity, std::string dump_path = {});
+    ~TraceBuffer();
+
+    // TraceBuffer object cannot be copied!
+    TraceBuffer(const TraceBuffer&)            = delete;
+    TraceBuffer& operator=(const TraceBuffer&) = delete;
+
+    void record(const TraceRecord& record) noexcept;
+
+    /**
+     * @return the records currently held, from the oldest to the most recent
+     */
+    [[nodiscard]] std::vector<TraceRecord> snapshot() const;
+
+    [[nodiscard]] size_t capacity() const { return mask_ + 1; }
+    [[nodiscard]] uint64_t recorded() const { return head_.load(std::memory_order_relaxed); }
+
+    /**
+     * Append the records currently held to the dump, as a single block (so that several processes can share the
+     * same dump); throws TraceError if the dump cannot be written
+     */
+    void dump(const std::string& path) const;
+
+    /**
+     * @return the buffer used by the clients to trace requests; or nullptr, if tracing is disabled
+     */
+    static TraceBuffer* installed() { return installed_.load(std::memory_order_acquire); }
+    static void install(TraceBuffer* buffer) { installed_.store(buffer, std::memory_order_release); }
+
+private:
+    struct Slot {
+        // Notice: odd while the record is being written, and 2 * (position + 1) once published
+        std::atomic<uint64_t> sequence{0};
+        TraceRecord record;
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+    std::atomic<uint64_t> head_;
+    std::string dump_path_;
+
+    static inline std::atomic<TraceBuffer*> installed_{nullptr};
+};
+
+// *** Trace Dump **************************************************************
+// *****************************************************************************
+
+/**
+ * TraceDump holds the records of a single block of the dump, as written by a single process.
+ */
+struct TraceDump {
+    uint32_t pid  = 0;
+    uint64_t lost = 0;  // i.e. records overwritten before being dumped
+    std::vector<TraceRecord> records;
+
+    /**
+     * Load all blocks from the dump; throws TraceError if the dump cannot be read, or is invalid
+     */
+    static std::vector<TraceDump> load(const std::string& path);
+};
+
+/**
+ * Decode the dump into text, one record per line
+ *
+ * @return the number of records decoded
+ */
+size_t decode_trace(const std::string& path, std::ostream& output);
+
+}  // namespace ecflow::light
+
+#endif
@@ -0,0 +1,479 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include "ecflow/light/UDPSocket.h"
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "ecflow/light/Log.h"
+
+#if defined(__linux__) && !defined(UDP_SEGMENT)
+// Notice: UDP_SEGMENT is supported since Linux 4.18, but might be missing from older system headers
+#define UDP_SEGMENT 103
+#endif
+
+namespace ecflow::light::net {
+
+namespace {
+
+bool is_transient(int error) {
+    // The socket buffer is (momentarily) full, thus the datagram is dropped instead of blocking the caller
+    return error == EAGAIN || error == EWOULDBLOCK || error == ENOBUFS;
+}
+
+bool is_same_address(const sockaddr_storage& lhs, const sockaddr_storage& rhs) {
+    if (lhs.ss_family != rhs.ss_family) {
+        return false;
+    }
+    if (lhs.ss_family == AF_INET) {
+        const auto& l = reinterpret_cast<const sockaddr_in&>(lhs);
+        const auto& r = reinterpret_cast<const sockaddr_in&>(rhs);
+        return l.sin_port == r.sin_port && l.sin_addr.s_addr == r.sin_addr.s_addr;
+    }
+    if (lhs.ss_family == AF_INET6) {
+        const auto& l = reinterpret_cast<const sockaddr_in6&>(lhs);
+        const auto& r = reinterpret_cast<const sockaddr_in6&>(rhs);
+        return l.sin6_port == r.sin6_port && std::memcmp(&l.sin6_addr, &r.sin6_addr, sizeof(l.sin6_addr)) == 0;
+    }
+    return false;
+}
+
+bool is_power_of_two(uint64_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+// Maximum number of messages passed to a single sendmmsg (i.e. UIO_MAXIOV)
+constexpr size_t MaximumMessages = 1024;
+// Maximum size of a segmented message (i.e. the maximum UDP payload)
+constexpr size_t MaximumMessageSize = 65'507;
+// Maximum number of datagrams deferred by a burst, before being sent
+constexpr size_t MaximumDeferred = 1024;
+
+// *** Burst (State) ***********************************************************
+// *****************************************************************************
+
+struct Deferred {
+    UDPSocket* socket;
+    std::string datagram;
+};
+
+struct BurstState {
+    size_t depth = 0;
+    // Notice: only the first 'size' entries are in use; the others are kept to reuse their capacity
+    size_t size = 0;
+    std::vector<Deferred> deferred;
+};
+
+thread_local BurstState burst;
+
+void defer(UDPSocket* socket, const void* data, size_t size);
+
+void flush_burst() {
+    const size_t size = burst.size;
+
+    std::vector<std::string_view> datagrams;
+    for (size_t first = 0; first != size; ++first) {
+        UDPSocket* socket = burst.deferred[first].socket;
+        if (socket == nullptr) {
+            continue;
+        }
+
+        // Send all datagrams of the same socket together, keeping their order
+        datagrams.clear();
+        for (size_t i = first; i != size; ++i) {
+            if (burst.deferred[i].socket == socket) {
+                datagrams.emplace_back(burst.deferred[i].datagram);
+                burst.deferred[i].socket = nullptr;
+            }
+        }
+        try {
+            socket->send(datagrams);
+        }
+        catch (eckit::Exception& e) {
+            Log::error() << "Unable to send deferred UDP datagrams, due to: " << e.what() << std::endl;
+        }
+    }
+    burst.size = 0;
+}
+
+void defer(UDPSocket* socket, const void* data, size_t size) {
+    if (burst.size == burst.deferred.size()) {
+        burst.deferred.emplace_back();
+    }
+    auto& entry  = burst.deferred[burst.size++];
+    entry.socket = socket;
+    entry.datagram.assign(static_cast<const char*>(data), size);
+
+    if (burst.size == MaximumDeferred) {
+        flush_burst();
+    }
+}
+
+void discard_deferred(const UDPSocket* socket) {
+    for (size_t i = 0; i != burst.size; ++i) {
+        if (burst.deferred[i].socket == socket) {
+            burst.deferred[i].socket = nullptr;
+        }
+    }
+}
+
+}  // namespace
+
+// *** Burst *******************************************************************
+// *****************************************************************************
+
+UDPSocket::Burst::Burst() {
+    ++burst.depth;
+}
+
+UDPSocket::Burst::~Burst() {
+    if (--burst.depth == 0) {
+        flush_burst();
+    }
+}
+
+// *** UDP Socket **************************************************************
+// *****************************************************************************
+
+UDPSocket::UDPSocket(std::string host, std::string port, std::chrono::seconds resolve_ttl, Batching batching) :
+    host_{std::move(host)},
+    port_{std::move(port)},
+    resolve_ttl_{resolve_ttl},
+    fd_{-1},
+    pid_{0},
+    address_{},
+    address_size_{0},
+    resolved_at_{},
+    sent_{0},
+    dropped_{0},
+    syscalls_{0},
+#if defined(__linux__)
+    batching_{batching},
+#else
+    batching_{Batching::None},
+#endif
+    lock_{} {}
+
+UDPSocket::~UDPSocket() {
+    // Notice: datagrams deferred by the current thread can no longer be sent
+    discard_deferred(this);
+    close();
+}
+
+bool UDPSocket::send(const void* data, size_t size) {
+    if (burst.depth > 0) {
+        defer(this, data, size);
+        return true;
+    }
+
+    bool stale = true;
+    int error  = 0;
+    {
+        std::shared_lock lock(lock_);
+        stale = is_stale();
+        if (!stale) {
+            error = send_once(data, size);
+        }
+    }
+
+    if (stale || (error != 0 && !is_transient(error))) {
+        std::unique_lock lock(lock_);
+        if (!stale) {
+            // The address might have changed (or the network is being reconfigured), so re-resolve and retry once
+            Log::debug() << "Unable to send UDP datagram to " << host_ << ":" << port_
+                         << ", due to: " << std::strerror(error) << ". Retrying..." << std::endl;
+        }
+        // Notice: another thread might have already (re)opened the socket, while waiting for exclusive access
+        if (!stale || is_stale()) {
+            close();
+            open();
+        }
+        error = send_once(data, size);
+    }
+
+    if (error != 0) {
+        account_dropped(1, error);
+        return false;
+    }
+
+    sent_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+size_t UDPSocket::send(const std::vector<std::string_view>& datagrams) {
+    size_t next = 0;
+    bool stale  = true;
+    int error   = 0;
+    {
+        std::shared_lock lock(lock_);
+        stale = is_stale();
+        if (!stale) {
+            error = send_many(datagrams, next);
+        }
+    }
+
+    if (stale || (error != 0 && !is_transient(error))) {
+        std::unique_lock lock(lock_);
+        if (!stale) {
+            Log::debug() << "Unable to send UDP datagrams to " << host_ << ":" << port_
+                         << ", due to: " << std::strerror(error) << ". Retrying..." << std::endl;
+        }
+        if (!stale || is_stale()) {
+            close();
+            open();
+        }
+        error = send_many(datagrams, next);
+    }
+
+    sent_.fetch_add(next, std::memory_order_relaxed);
+    if (next != datagrams.size()) {
+        account_dropped(datagrams.size() - next, error);
+    }
+    return next;
+}
+
+std::optional<size_t> UDPSocket::receive(void* buffer, size_t size) {
+    std::shared_lock lock(lock_);
+    if (is_stale()) {
+        return std::nullopt;
+    }
+    for (;;) {
+        sockaddr_storage source{};
+        socklen_t source_size = sizeof(source);
+        ssize_t result = ::recvfrom(fd_, buffer, size, MSG_DONTWAIT, reinterpret_cast<sockaddr*>(&source), &source_size);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return std::nullopt;
+        }
+        if (is_same_address(source, address_)) {
+            return static_cast<size_t>(result);
+        }
+        // Notice: datagrams from other sources are discarded
+    }
+}
+
+bool UDPSocket::wait_readable(std::chrono::milliseconds timeout) {
+    {
+        std::shared_lock lock(lock_);
+        if (!is_stale()) {
+            pollfd fd{fd_, POLLIN, 0};
+            return ::poll(&fd, 1, static_cast<int>(timeout.count())) > 0;
+        }
+    }
+    // Notice: nothing can be received before the socket is (re)opened, which only happens when sending
+    std::this_thread::sleep_for(timeout);
+    return false;
+}
+
+void UDPSocket::account_dropped(size_t count, int error) {
+    auto before = dropped_.fetch_add(count, std::memory_order_relaxed);
+    // Notice: warn only when the total crosses a power of two, to avoid flooding the log
+    for (auto dropped = before + 1; dropped <= before + count; ++dropped) {
+        if (is_power_of_two(dropped)) {
+            Log::warning() << "UDP datagram to " << host_ << ":" << port_
+                           << " dropped, due to: " << std::strerror(error) << " (total dropped: " << before + count
+                           << ")" << std::endl;
+            break;
+        }
+    }
+}
+
+bool UDPSocket::is_stale() const {
+    if (fd_ < 0) {
+        return true;
+    }
+    if (pid_ != ::getpid()) {
+        // The process was forked, and the socket must not be shared with the parent
+        return true;
+    }
+    if (resolve_ttl_.count() > 0 && std::chrono::steady_clock::now() - resolved_at_ > resolve_ttl_) {
+        return true;
+    }
+    return false;
+}
+
+void UDPSocket::open() {
+    addrinfo hints{};
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    addrinfo* addresses = nullptr;
+    if (int error = ::getaddrinfo(host_.c_str(), port_.c_str(), &hints, &addresses); error != 0) {
+        ECFLOW_LIGHT_THROW(UDPSocketError,
+                           Message("Unable to resolve '", host_, ":", port_, "', due to: ", ::gai_strerror(error)));
+    }
+
+    int fd = -1;
+    for (addrinfo* address = addresses; address != nullptr; address = address->ai_next) {
+        fd = ::socket(address->ai_family, address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, address->ai_protocol);
+        if (fd >= 0) {
+            std::memcpy(&address_, address->ai_addr, address->ai_addrlen);
+            address_size_ = address->ai_addrlen;
+            break;
+        }
+    }
+    ::freeaddrinfo(addresses);
+
+    if (fd < 0) {
+        ECFLOW_LIGHT_THROW(UDPSocketError, Message("Unable to create UDP socket for '", host_, ":", port_,
+                                                   "', due to: ", std::strerror(errno)));
+    }
+
+    fd_          = fd;
+    pid_         = ::getpid();
+    resolved_at_ = std::chrono::steady_clock::now();
+
+    Log::debug() << "UDP socket opened for " << host_ << ":" << port_ << std::endl;
+}
+
+void UDPSocket::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+int UDPSocket::send_once(const void* data, size_t size) const {
+    for (;;) {
+        syscalls_.fetch_add(1, std::memory_order_relaxed);
+        ssize_t result = ::sendto(fd_, data, size, MSG_DONTWAIT | MSG_NOSIGNAL,
+                                  reinterpret_cast<const sockaddr*>(&address_), address_size_);
+        if (result >= 0) {
+            return 0;
+        }
+        if (errno != EINTR) {
+            return errno;
+        }
+    }
+}
+
+int UDPSocket::send_many(const std::vector<std::string_view>& datagrams, size_t& next) const {
+#if defined(__linux__)
+    union Control {
+        cmsghdr header;
+        char buffer[CMSG_SPACE(sizeof(uint16_t))];
+    };
+
+    std::vector<iovec> iovecs;
+    std::vector<mmsghdr> messages;
+    std::vector<Control> controls;
+    std::vector<size_t> counts;
+
+    while (next != datagrams.size()) {
+        auto batching = batching_.load(std::memory_order_relaxed);
+        if (batching == Batching::None) {
+            break;
+        }
+
+        // Notice: the containers are sized upfront, as messages refer to their elements
+        iovecs.assign(datagrams.size() - next, iovec{});
+        messages.assign(std::min(datagrams.size() - next, MaximumMessages), mmsghdr{});
+        controls.assign(messages.size(), Control{});
+        counts.clear();
+
+        size_t position = next;
+        while (position != datagrams.size() && counts.size() != messages.size()) {
+            const size_t segment = datagrams[position].size();
+
+            size_t end = position + 1;
+            if (batching == Batching::Segments && segment > 0 && segment <= MaximumSegmentSize) {
+                size_t total = segment;
+                while (end != datagrams.size() && end - position < MaximumSegments &&
+                       datagrams[end].size() == segment && total + segment <= MaximumMessageSize) {
+                    total += segment;
+                    ++end;
+                }
+                // Notice: the last segment of a message is allowed to be shorter
+                if (end != datagrams.size() && end - position < MaximumSegments && datagrams[end].size() > 0 &&
+                    datagrams[end].size() < segment && total + datagrams[end].size() <= MaximumMessageSize) {
+                    ++end;
+                }
+            }
+
+            const size_t index = counts.size();
+            const size_t first = position - next;
+            for (size_t i = position; i != end; ++i) {
+                iovecs[i - next].iov_base = const_cast<char*>(datagrams[i].data());
+                iovecs[i - next].iov_len  = datagrams[i].size();
+            }
+
+            msghdr& message    = messages[index].msg_hdr;
+            message.msg_name    = const_cast<sockaddr_storage*>(&address_);
+            message.msg_namelen = address_size_;
+            message.msg_iov     = &iovecs[first];
+            message.msg_iovlen  = end - position;
+
+            if (end - position > 1) {
+                message.msg_control    = controls[index].buffer;
+                message.msg_controllen = sizeof(controls[index].buffer);
+
+                cmsghdr* control    = CMSG_FIRSTHDR(&message);
+                control->cmsg_level = SOL_UDP;
+                control->cmsg_type  = UDP_SEGMENT;
+                control->cmsg_len   = CMSG_LEN(sizeof(uint16_t));
+                auto segment_size   = static_cast<uint16_t>(segment);
+                std::memcpy(CMSG_DATA(control), &segment_size, sizeof(segment_size));
+            }
+
+            counts.push_back(end - position);
+            position = end;
+        }
+
+        syscalls_.fetch_add(1, std::memory_order_relaxed);
+        int result = ::sendmmsg(fd_, messages.data(), static_cast<unsigned int>(counts.size()),
+                                MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (result < 0) {
+            int error = errno;
+            if (error == EINTR) {
+                continue;
+            }
+            if (error == ENOSYS) {
+                Log::debug() << "UDP sendmmsg not supported. Falling back to sendto" << std::endl;
+                batching_.store(Batching::None, std::memory_order_relaxed);
+                continue;
+            }
+            if (counts.front() > 1 &&
+                (error == EINVAL || error == EIO || error == ENOPROTOOPT || error == EOPNOTSUPP)) {
+                Log::debug() << "UDP segmentation not supported, due to: " << std::strerror(error)
+                             << ". Falling back to sendmmsg" << std::endl;
+                batching_.store(Batching::Messages, std::memory_order_relaxed);
+                continue;
+            }
+            return error;
+        }
+
+        for (int i = 0; i != result; ++i) {
+            next += counts[i];
+        }
+    }
+#endif
+
+    for (; next != datagrams.size(); ++next) {
+        if (int error = send_once(datagrams[next].data(), datagrams[next].size()); error != 0) {
+            return error;
+        }
+    }
+    return 0;
+}
+
+}  // namespace ecflow::light::net
@@ -0,0 +1,170 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#ifndef ECFLOW_LIGHT_UDPSOCKET_H
+#define ECFLOW_LIGHT_UDPSOCKET_H
+
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ecflow/light/Exception.h"
+
+namespace ecflow::light::net {
+
+struct UDPSocketError : public eckit::Exception {
+    UDPSocketError(const std::string& msg, const eckit::CodeLocation& loc) : eckit::Exception(msg, loc) {}
+};
+
+// *** UDP Socket **************************************************************
+// *****************************************************************************
+
+/**
+ * UDPSocket is a long-lived, non-blocking, UDP socket connected to a single destination.
+ *
+ * The destination host is resolved only once, and both the resolved address and the socket are reused for all
+ * datagrams. The host is resolved again when a send fails, or after the given time-to-live expires (a zero TTL
+ * means the resolved address never expires). Detecting a change of PID (i.e. after fork()), the socket is
+ * reopened so that parent and child processes never share the same socket.
+ *
+ * Datagrams that cannot be sent immediately (i.e. socket buffer is full) are dropped, and accounted for.
+ *
+ * Multiple threads can send concurrently using the same socket; only (re)opening the socket requires exclusive
+ * access.
+ *
+ * Several datagrams can be sent together, using as few system calls as possible: with sendmmsg, and grouping
+ * consecutive datagrams of the same size into a single segmented (GSO) message. When the kernel does not support
+ * these, the socket permanently falls back to the next simpler mechanism (i.e. eventually, to one sendto per
+ * datagram).
+ */
+class UDPSocket {
+public:
+    /**
+     * Mechanism used to send several datagrams together, from the simplest to the most efficient
+     */
+    enum class Batching : uint8_t
+    {
+        None,      // one sendto per datagram
+        Messages,  // one sendmmsg for all datagrams
+        Segments   // one sendmmsg, with consecutive datagrams of the same size sent as a single segmented message
+    };
+
+    /**
+     * Burst defers all datagrams sent by the current thread, while in scope, so that these are sent together when
+     * the (outermost) burst ends.
+     *
+     * Notice: while deferred, send() always reports the datagram as sent; errors found when the burst ends are
+     *         only logged. Bursts must thus not be used when the outcome of each datagram is acted upon (e.g. to
+     *         spool, or to send to another client, the dropped datagrams).
+     */
+    class Burst {
+    public:
+        Burst();
+        ~Burst();
+
+        // Burst object cannot be copied!
+        Burst(const Burst&)            = delete;
+        Burst& operator=(const Burst&) = delete;
+    };
+
+    UDPSocket(std::string host, std::string port, std::chrono::seconds resolve_ttl,
+              Batching batching = Batching::Segments);
+    ~UDPSocket();
+
+    // UDPSocket object cannot be copied!
+    UDPSocket(const UDPSocket&)            = delete;
+    UDPSocket& operator=(const UDPSocket&) = delete;
+
+    /**
+     * Send a single datagram.
+     *
+     * @return true if the datagram was sent; false if it was dropped
+     */
+    bool send(const void* data, size_t size);
+
+    /**
+     * Send several datagrams together, in order.
+     *
+     * @return the number of datagrams sent; the remaining datagrams were dropped
+     */
+    size_t send(const std::vector<std::string_view>& datagrams);
+
+    /**
+     * Receive a single datagram, sent back by the destination (e.g. an acknowledgement), without blocking.
+     *
+     * Datagrams from any other source are discarded.
+     *
+     * @return the size of the received datagram; or nothing, if no datagram is available
+     */
+    std::optional<size_t> receive(void* buffer, size_t size);
+
+    /**
+     * Wait until a datagram is available to be received, or the timeout expires
+     *
+     * @return true, if a datagram is available
+     */
+    bool wait_readable(std::chrono::milliseconds timeout);
+
+    [[nodiscard]] uint64_t sent() const { return sent_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    // Number of system calls used to send datagrams
+    [[nodiscard]] uint64_t syscalls() const { return syscalls_.load(std::memory_order_relaxed); }
+    [[nodiscard]] Batching batching() const { return batching_.load(std::memory_order_relaxed); }
+
+    // Maximum size of each datagram sent as part of a segmented message (i.e. kept under the typical MTU)
+    static constexpr size_t MaximumSegmentSize = 1400;
+    // Maximum number of datagrams sent as a single segmented message
+    static constexpr size_t MaximumSegments = 64;
+
+private:
+    [[nodiscard]] bool is_stale() const;
+    void open();
+    void close();
+
+    void account_dropped(size_t count, int error);
+
+    [[nodiscard]] int send_once(const void* data, size_t size) const;
+    /**
+     * Send the datagrams, starting at (and advancing) 'next', until all are sent or an error occurs
+     *
+     * @return 0 if all datagrams were sent; otherwise, the error preventing datagram 'next' to be sent
+     */
+    [[nodiscard]] int send_many(const std::vector<std::string_view>& datagrams, size_t& next) const;
+
+    std::string host_;
+    std::string port_;
+    std::chrono::seconds resolve_ttl_;
+
+    int fd_;
+    pid_t pid_;
+    sockaddr_storage address_;
+    socklen_t address_size_;
+    std::chrono::steady_clock::time_point resolved_at_;
+
+    std::atomic<uint64_t> sent_;
+    std::atomic<uint64_t> dropped_;
+    mutable std::atomic<uint64_t> syscalls_;
+    mutable std::atomic<Batching> batching_;
+
+    // Notice: the lock is held shared while sending, and exclusively while (re)opening the socket
+    mutable std::shared_mutex lock_;
+};
+
+}  // namespace ecflow::light::net
+
+#endif
@@ -0,0 +1,325 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include "ecflow/light/WireFormat.h"
+
+#include <charconv>
+
+#include <eckit/exception/Exceptions.h>
+
+namespace ecflow::light {
+
+// *** Wire Format *************************************************************
+// *****************************************************************************
+
+WireFormat wire_format_of(std::string_view version) {
+    auto major = version.substr(0, version.find('.'));
+    // Notice: an unspecified version uses the original (JSON) format
+    if (major.empty() || major == "1") {
+        return WireFormat::JSON;
+    }
+    if (major == "2") {
+        return WireFormat::Binary;
+    }
+    ECFLOW_LIGHT_THROW(BadValue, Message("Invalid UDP version '", version, "'. Expected '1' (JSON) or '2' (binary)"));
+}
+
+// *** Acknowledgements ********************************************************
+// *****************************************************************************
+
+void write_sequenced(std::string& buffer, std::string_view datagram, Sequence sequence) {
+    if (BinaryDecoder::is_binary(datagram)) {
+        buffer.append(datagram.substr(0, BinaryEncoder::HeaderSize));
+        buffer.back() = static_cast<char>(static_cast<uint8_t>(buffer.back()) | BinaryEncoder::FlagSequenced);
+        BinaryEncoder::write_varint(buffer, sequence.sequence);
+        BinaryEncoder::write_varint(buffer, sequence.base);
+        buffer.append(datagram.substr(BinaryEncoder::HeaderSize));
+        return;
+    }
+
+    if (datagram.empty() || datagram.front() != '{') {
+        ECFLOW_LIGHT_THROW(InvalidDatagram, Message("Unable to sequence datagram. Expected JSON object"));
+    }
+    char number[24];
+    buffer += R"({"sequence":)";
+    buffer.append(number, std::to_chars(std::begin(number), std::end(number), sequence.sequence).ptr);
+    buffer += R"(,"base":)";
+    buffer.append(number, std::to_chars(std::begin(number), std::end(number), sequence.base).ptr);
+    buffer += ',';
+    buffer.append(datagram.substr(1));
+}
+
+void write_acknowledgement(std::string& buffer, WireFormat format, uint64_t sequence) {
+    if (format == WireFormat::Binary) {
+        buffer += static_cast<char>(BinaryEncoder::Magic0);
+        buffer += static_cast<char>(BinaryEncoder::Magic1);
+        buffer += static_cast<char>(BinaryEncoder::Version);
+        buffer += static_cast<char>(BinaryEncoder::FlagAcknowledgement);
+        BinaryEncoder::write_varint(buffer, sequence);
+        return;
+    }
+    buffer += R"({"method":"ack","sequence":)";
+    buffer += std::to_string(sequence);
+    buffer += '}';
+}
+
+std::optional<uint64_t> parse_acknowledgement(std::string_view datagram) {
+    try {
+        if (BinaryDecoder::is_binary(datagram)) {
+            if ((static_cast<uint8_t>(datagram[3]) & BinaryEncoder::FlagAcknowledgement) == 0) {
+                return std::nullopt;
+            }
+            size_t position = BinaryEncoder::HeaderSize;
+            return BinaryDecoder::read_varint(datagram, position);
+        }
+    }
+    catch (InvalidDatagram&) {
+        return std::nullopt;
+    }
+
+    if (datagram.find(R"("method":"ack")") == std::string_view::npos) {
+        return std::nullopt;
+    }
+    constexpr std::string_view member = R"("sequence":)";
+    auto found                        = datagram.find(member);
+    if (found == std::string_view::npos) {
+        return std::nullopt;
+    }
+    auto digits     = datagram.substr(found + member.size());
+    uint64_t number = 0;
+    if (auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), number);
+        error != std::errc{} || end == digits.data()) {
+        return std::nullopt;
+    }
+    return number;
+}
+
+// *** Binary Encoder **********************************************************
+// *****************************************************************************
+
+namespace {
+
+// Integers up to 18 digits always fit, after zigzag encoding and shifting by 1, in an unsigned 64-bit value
+constexpr size_t MaximumIntegerDigits = 18;
+
+/**
+ * @return true, if the text is a canonical decimal integer (i.e. without sign '+', leading zeros, or '-0')
+ */
+bool is_canonical_integer(std::string_view text) {
+    auto digits = text.substr(!text.empty() && text.front() == '-' ? 1 : 0);
+    if (digits.empty() || digits.size() > MaximumIntegerDigits) {
+        return false;
+    }
+    if (digits.front() == '0' && (digits.size() > 1 || digits.size() != text.size())) {
+        return false;
+    }
+    for (char c : digits) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void write_fixed(std::string& buffer, uint64_t value, size_t size) {
+    for (size_t i = 0; i != size; ++i) {
+        buffer += static_cast<char>(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+}  // namespace
+
+BinaryEncoder::Kind BinaryEncoder::kind_of(std::string_view command) {
+    if (command == "meter") {
+        return Kind::Meter;
+    }
+    if (command == "label") {
+        return Kind::Label;
+    }
+    if (command == "event") {
+        return Kind::Event;
+    }
+    ECFLOW_LIGHT_THROW(BadValue, Message("Unable to encode command '", command, "'. Expected meter, label or event"));
+}
+
+std::string_view BinaryEncoder::command_of(Kind kind) {
+    switch (kind) {
+        case Kind::Meter:
+            return "meter";
+        case Kind::Label:
+            return "label";
+        case Kind::Event:
+            return "event";
+    }
+    return "";
+}
+
+uint64_t BinaryEncoder::hash_path(std::string_view path) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char c : path) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+uint32_t BinaryEncoder::hash_name(std::string_view name) {
+    uint32_t hash = 0x811c9dc5U;
+    for (char c : name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x01000193U;
+    }
+    return hash;
+}
+
+void BinaryEncoder::write_task(std::string& buffer, std::string_view rid, std::string_view password,
+                               std::string_view try_no, std::string_view path) {
+    buffer += static_cast<char>(Magic0);
+    buffer += static_cast<char>(Magic1);
+    buffer += static_cast<char>(Version);
+    buffer += static_cast<char>(0);  // flags (reserved)
+    write_text(buffer, rid);
+    write_text(buffer, password);
+    write_text(buffer, try_no);
+    write_fixed(buffer, hash_path(path), sizeof(uint64_t));
+}
+
+void BinaryEncoder::write_update(std::string& buffer, std::string_view command, std::string_view name,
+                                 std::string_view value) {
+    buffer += static_cast<char>(kind_of(command));
+    write_fixed(buffer, hash_name(name), sizeof(uint32_t));
+    write_text(buffer, value);
+}
+
+void BinaryEncoder::write_varint(std::string& buffer, uint64_t value) {
+    while (value >= 0x80) {
+        buffer += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    buffer += static_cast<char>(value);
+}
+
+void BinaryEncoder::write_text(std::string& buffer, std::string_view text) {
+    if (is_canonical_integer(text)) {
+        int64_t number = 0;
+        std::from_chars(text.data(), text.data() + text.size(), number);
+        write_varint(buffer, (zigzag(number) << 1) | 1);
+    }
+    else {
+        write_varint(buffer, static_cast<uint64_t>(text.size()) << 1);
+        buffer.append(text);
+    }
+}
+
+// *** Binary Decoder **********************************************************
+// *****************************************************************************
+
+BinaryDatagram BinaryDecoder::decode(std::string_view datagram) {
+    if (!is_binary(datagram)) {
+        ECFLOW_LIGHT_THROW(InvalidDatagram, Message("Invalid datagram. Expected binary (version 2) header"));
+    }
+
+    const auto flags = static_cast<uint8_t>(datagram[3]);
+    if (flags & BinaryEncoder::FlagAcknowledgement) {
+        ECFLOW_LIGHT_THROW(InvalidDatagram, Message("Invalid datagram. Expected updates, but found acknowledgement"));
+    }
+
+    BinaryDecoder decoder(datagram);
+    decoder.position_ = BinaryEncoder::HeaderSize;
+
+    BinaryDatagram decoded;
+    if (flags & BinaryEncoder::FlagSequenced) {
+        auto sequence    = decoder.read_varint();
+        auto base        = decoder.read_varint();
+        decoded.sequence = Sequence{sequence, base};
+    }
+    decoded.rid      = decoder.read_text();
+    decoded.password = decoder.read_text();
+    decoded.try_no   = decoder.read_text();
+    decoded.path     = decoder.read_fixed(sizeof(uint64_t));
+
+    while (!decoder.at_end()) {
+        auto kind = decoder.read_byte();
+        if (kind < static_cast<uint8_t>(BinaryEncoder::Kind::Meter) ||
+            kind > static_cast<uint8_t>(BinaryEncoder::Kind::Event)) {
+            ECFLOW_LIGHT_THROW(InvalidDatagram, Message("Invalid datagram. Unknown update kind: ", int{kind}));
+        }
+        auto name  = static_cast<uint32_t>(decoder.read_fixed(sizeof(uint32_t)));
+        auto value = decoder.read_text();
+        decoded.updates.push_back(BinaryDatagram::Update{static_cast<BinaryEncoder::Kind>(kind), name, value});
+    }
+    return decoded;
+}
+
+bool BinaryDecoder::is_binary(std::string_view datagram) {
+    return datagram.size() >= BinaryEncoder::HeaderSize &&
+           static_cast<uint8_t>(datagram[0]) == BinaryEncoder::Magic0 &&
+           static_cast<uint8_t>(datagram[1]) == BinaryEncoder::Magic1 &&
+           static_cast<uint8_t>(datagram[2]) == BinaryEncoder::Version;
+}
+
+uint8_t BinaryDecoder::read_byte() {
+    if (at_end()) {
+        ECFLOW_LIGHT_THROW(InvalidDatagram, Message("Invalid datagram. Unexpected end at position ", position_));
+    }
+    return static_cast<uint8_t>(datagram_[position_++]);
+}
+
+uint64_t BinaryDecoder::read_fixed(size_t size) {
+    uint64_t value = 0;
+    for (size_t i = 0; i != size; ++i) {
+        value |= static_cast<uint64_t>(read_byte()) << (8 * i);
+    }
+    return value;
+}
+
+uint64_t BinaryDecoder::read_varint() {
+    return read_varint(datagram_, position_);
+}
+
+uint64_t BinaryDecoder::read_varint(std::string_view data, size_t& position) {
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (position == data.size()) {
+            ECFLOW_LIGHT_THROW(InvalidDatagram, Message("Invalid datagram. Unexpected end at position ", position));
+        }
+        auto byte = static_cast<uint8_t>(data[position++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    ECFLOW_LIGHT_THROW(InvalidDatagram, Message("Invalid datagram. Varint too long at position ", position));
+}
+
+std::string BinaryDecoder::read_text() {
+    uint64_t header = read_varint();
+    if (header & 1) {
+        return std::to_string(unzigzag(header >> 1));
+    }
+    uint64_t size = header >> 1;
+    if (size > datagram_.size() - position_) {
+        ECFLOW_LIGHT_THROW(InvalidDatagram, Message("Invalid datagram. Text of size ", size, " exceeds datagram"));
+    }
+    std::string text(datagram_.substr(position_, size));
+    position_ += size;
+    return text;
+}
+
+}  // namespace ecflow::light
@@ -0,0 +1,197 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#ifndef ECFLOW_LIGHT_WIREFORMAT_H
+#define ECFLOW_LIGHT_WIREFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ecflow/light/Exception.h"
+
+namespace ecflow::light {
+
+struct InvalidDatagram : public eckit::Exception {
+    InvalidDatagram(const std::string& msg, const eckit::CodeLocation& loc) : eckit::Exception(msg, loc) {}
+};
+
+// *** Wire Format *************************************************************
+// *****************************************************************************
+
+/**
+ * WireFormat identifies the encoding of UDP datagrams, selected by the (major) version of the client configuration:
+ *  - version 1 (e.g. "1", "1.0", or unspecified), each datagram is a (null-terminated) JSON document
+ *  - version 2 (e.g. "2", "2.0"), each datagram is binary encoded, as described by BinaryEncoder
+ */
+enum class WireFormat : uint8_t
+{
+    JSON   = 1,
+    Binary = 2
+};
+
+/**
+ * @return the wire format for the given configuration version; throws BadValue if the version is not supported
+ */
+WireFormat wire_format_of(std::string_view version);
+
+// *** Acknowledgements ********************************************************
+// *****************************************************************************
+
+/**
+ * In acknowledged mode, each datagram carries a (per-process) sequence number, and a base sequence number (i.e.
+ * all datagrams below the base were either acknowledged or superseded, and must no longer be waited for):
+ *  - in JSON, as the leading members: {"sequence":7,"base":5,"method":"put",...}
+ *  - in binary, by setting the 'sequenced' flag, and adding both as varints right after the 4 bytes header
+ *
+ * The receiver acknowledges cumulatively (i.e. the highest sequence number up to which all datagrams were either
+ * received, or are below the base), replying to the sender with:
+ *  - in JSON, {"method":"ack","sequence":7}
+ *  - in binary, the 4 bytes header with the 'acknowledgement' flag, followed by the sequence number as varint
+ */
+struct Sequence {
+    uint64_t sequence;
+    uint64_t base;
+};
+
+/**
+ * Appends the given datagram (either JSON or binary), adding the given sequence numbers
+ */
+void write_sequenced(std::string& buffer, std::string_view datagram, Sequence sequence);
+
+void write_acknowledgement(std::string& buffer, WireFormat format, uint64_t sequence);
+
+/**
+ * @return the (cumulative) sequence number acknowledged by the datagram; or nothing, if not an acknowledgement
+ */
+std::optional<uint64_t> parse_acknowledgement(std::string_view datagram);
+
+// *** Binary Encoder **********************************************************
+// *****************************************************************************
+
+/**
+ * BinaryEncoder appends the binary (version 2) encoding of UDP datagrams to a (caller provided) buffer.
+ *
+ * Each datagram consists of a fixed header, followed by the task fields and any number of updates:
+ *
+ *   magic (2 bytes: 0xEC 0xF1) | version (1 byte: 2) | flags (1 byte)
+ *   [ sequence (varint) | base (varint) ], only if flags has FlagSequenced
+ *   task_rid (text) | task_password (text) | task_try_no (text) | path (8 bytes, hash)
+ *   { kind (1 byte) | name (4 bytes, hash) | value (text) }*
+ *
+ * Variable length integers (varint) use 7 bits per byte, least significant group first, with the high bit set on
+ * all but the last byte. A text is encoded as a single varint 'h', when the text is a canonical decimal integer
+ * (i.e. 'h' is the zigzag encoded integer, shifted left by 1, with the low bit set), and otherwise as varint 'h'
+ * (i.e. the length of the text, shifted left by 1) followed by the characters.
+ *
+ * Hashes are FNV-1a (64 bits for the task path, 32 bits for the attribute name), stored as little-endian, so that
+ * the server resolves these against the paths and attribute names of its known nodes.
+ */
+class BinaryEncoder {
+public:
+    static constexpr uint8_t Magic0  = 0xEC;
+    static constexpr uint8_t Magic1  = 0xF1;
+    static constexpr uint8_t Version = 2;
+
+    static constexpr size_t HeaderSize = 4;
+
+    static constexpr uint8_t FlagSequenced       = 0x01;
+    static constexpr uint8_t FlagAcknowledgement = 0x02;
+
+    enum class Kind : uint8_t
+    {
+        Meter = 1,
+        Label = 2,
+        Event = 3
+    };
+
+    /**
+     * @return the kind of attribute, for the given command; throws BadValue if the command is not supported
+     */
+    static Kind kind_of(std::string_view command);
+    static std::string_view command_of(Kind kind);
+
+    static uint64_t hash_path(std::string_view path);
+    static uint32_t hash_name(std::string_view name);
+
+    /**
+     * Appends the datagram header, and the task fields (i.e. the prefix common to all datagrams of the task)
+     */
+    static void write_task(std::string& buffer, std::string_view rid, std::string_view password,
+                           std::string_view try_no, std::string_view path);
+
+    static void write_update(std::string& buffer, std::string_view command, std::string_view name,
+                             std::string_view value);
+
+    static void write_varint(std::string& buffer, uint64_t value);
+    static void write_text(std::string& buffer, std::string_view text);
+};
+
+// *** Binary Decoder **********************************************************
+// *****************************************************************************
+
+struct BinaryDatagram {
+    struct Update {
+        BinaryEncoder::Kind kind;
+        uint32_t name;
+        std::string value;
+    };
+
+    std::optional<Sequence> sequence;
+    std::string rid;
+    std::string password;
+    std::string try_no;
+    uint64_t path;
+    std::vector<Update> updates;
+};
+
+/**
+ * BinaryDecoder decodes binary (version 2) datagrams, as produced by BinaryEncoder.
+ *
+ * Integer texts are decoded back to their canonical decimal representation. Hashes are left as-is, and must be
+ * resolved by the caller (e.g. comparing with BinaryEncoder::hash_path of known paths).
+ */
+class BinaryDecoder {
+public:
+    /**
+     * @return the decoded datagram; throws InvalidDatagram if the datagram is malformed
+     */
+    static BinaryDatagram decode(std::string_view datagram);
+
+    /**
+     * @return true, if the datagram starts with the binary (version 2) header
+     */
+    static bool is_binary(std::string_view datagram);
+
+    /**
+     * @return the varint at the start of the given data; throws InvalidDatagram if the data is malformed
+     */
+    static uint64_t read_varint(std::string_view data, size_t& position);
+
+private:
+    explicit BinaryDecoder(std::string_view datagram) : datagram_{datagram}, position_{0} {}
+
+    [[nodiscard]] bool at_end() const { return position_ == datagram_.size(); }
+
+    uint8_t read_byte();
+    uint64_t read_fixed(size_t size);
+    uint64_t read_varint();
+    std::string read_text();
+
+    std::string_view datagram_;
+    size_t position_;
+};
+
+}  // namespace ecflow::light
+
+#endif
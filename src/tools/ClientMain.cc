@@ -9,18 +9,28 @@
  */
 
 #include <algorithm>
+#include <atomic>
+#include <csignal>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <optional>
+#include <string>
 #include <thread>
+#include <vector>
 
+#include "ecflow/light/Agent.h"
+#include "ecflow/light/AsyncSender.h"
 #include "ecflow/light/ClientAPI.h"
+#include "ecflow/light/CommandBatch.h"
 #include "ecflow/light/Conversion.h"
 #include "ecflow/light/Environment.h"
 #include "ecflow/light/InternalAPI.h"
 #include "ecflow/light/Log.h"
+#include "ecflow/light/LogFollower.h"
 #include "ecflow/light/Options.h"
 #include "ecflow/light/Requests.h"
+#include "ecflow/light/TraceBuffer.h"
 #include "ecflow/light/Version.h"
 
 #include <eckit/option/CmdArgs.h>
@@ -32,6 +42,71 @@
 
 namespace ecfl = ecflow::light;
 
+namespace {
+
+// The agent currently serving (if any), to be stopped when a termination signal is received
+std::atomic<ecfl::Agent*> serving_agent{nullptr};
+
+void stop_agent(int /* signal */) {
+    if (ecfl::Agent* agent = serving_agent.load(); agent) {
+        agent->stop();
+    }
+}
+
+// The follower currently running (if any), to be stopped when a termination signal is received
+std::atomic<ecfl::LogFollower*> running_follower{nullptr};
+
+void stop_follower(int /* signal */) {
+    if (ecfl::LogFollower* follower = running_follower.load(); follower) {
+        follower->stop();
+    }
+}
+
+/**
+ * Hand over a single update (i.e. --meter, --label or --event) to the agent of the job, if one is running.
+ *
+ * Notice: this happens before the tool (and thus the configuration) is initialised, which is precisely the cost
+ *         avoided by using the agent. Any other invocation, or any failure, falls back to the regular path.
+ *
+ * @return true, if the update was handed over to the agent
+ */
+bool handover_to_agent(int argc, char* argv[]) {
+    auto path = ecfl::Environment::environment().get_optional("ECFLOW_LIGHT_AGENT");
+    if (!path || argc < 2) {
+        return false;
+    }
+
+    // Accept both '--option=first second' and '--option first second'
+    std::string option = argv[1];
+    std::vector<std::string> arguments(argv + 2, argv + argc);
+    if (auto separator = option.find('='); separator != std::string::npos) {
+        arguments.insert(std::begin(arguments), option.substr(separator + 1));
+        option.resize(separator);
+    }
+
+    try {
+        std::optional<ecfl::UpdateRecord> record;
+        if (option == "--meter" && arguments.size() == 2) {
+            record = ecfl::UpdateRecord::make_meter(arguments[0], ecfl::convert_to<int>(arguments[1]));
+        }
+        else if (option == "--label" && arguments.size() == 2) {
+            record = ecfl::UpdateRecord::make_label(arguments[0], arguments[1]);
+        }
+        else if (option == "--event" && (arguments.size() == 1 || arguments.size() == 2)) {
+            std::string value = arguments.size() == 2 ? arguments[1] : "set";
+            if (value == "set" || value == "clear") {
+                record = ecfl::UpdateRecord::make_event(arguments[0], value == "set");
+            }
+        }
+        return record && ecfl::Agent::handover(path->value, *record);
+    }
+    catch (...) {
+        return false;
+    }
+}
+
+}  // namespace
+
 class ClientTool final : public eckit::Tool {
 public:
     using options_t = std::vector<eckit::option::Option*>;
@@ -53,6 +128,15 @@ public:
         //
         options_t options = {
             new eckit::option::SimpleOption<bool>("version", "Display version information"),
+            new eckit::option::SimpleOption<bool>(
+                "serve", "Run as agent of the job, forwarding the updates handed over by other invocations"),
+            new eckit::option::SimpleOption<std::string>(
+                "batch", "Process the commands, one per line, read from a file or stdin [path: string, or '-']"),
+            new eckit::option::SimpleOption<std::string>(
+                "follow", "Follow the log file, updating attributes for the lines matching the rules [path: string]"),
+            new eckit::option::SimpleOption<std::string>("rules", "Rules used to follow the log file [path: string]"),
+            new eckit::option::SimpleOption<std::string>(
+                "decode-trace", "Decode the trace dump, printing one line per request [path: string]"),
             new eckit::option::MultiValueOption("label", "Update label [label name: string] [label value: string]", 2),
             new eckit::option::MultiValueOption("meter", "Update meter [meter name: string] [meter value: integer]", 2),
             new eckit::option::MultiValueOption(
@@ -73,6 +157,10 @@ public:
             return;
         }
 
+        handle_decode_trace_option(args);
+        handle_serve_option(args);
+        handle_batch_option(args);
+        handle_follow_option(args);
         handle_meter_option(args);
         handle_label_option(args);
         handle_event_option(args);
@@ -84,6 +172,119 @@ public:
     }
 
 private:
+    static void handle_decode_trace_option(const eckit::option::CmdArgs& args) {
+        auto option = get_option<std::string>(args, "decode-trace");
+        if (option) {
+            try {
+                size_t decoded = ecfl::decode_trace(option.value(), std::cout);
+                ecfl::Log::debug() << "Trace decoded: " << decoded << " record(s)" << std::endl;
+            }
+            catch (eckit::Exception& e) {
+                ecfl::Log::error() << "Error detected: " << e.what() << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            exit(EXIT_SUCCESS);
+        }
+    }
+
+    static void handle_serve_option(const eckit::option::CmdArgs& args) {
+        auto option = get_option<bool>(args, "serve");
+        if (option && option.value()) {
+            try {
+                const ecfl::Environment& environment = ecfl::Environment::environment();
+
+                ecfl::Agent agent{environment.get("ECFLOW_LIGHT_AGENT").value, ecfl::ConfiguredClient::instance()};
+
+                serving_agent = &agent;
+                std::signal(SIGTERM, stop_agent);
+                std::signal(SIGINT, stop_agent);
+
+                agent.serve();
+
+                serving_agent = nullptr;
+            }
+            catch (eckit::Exception& e) {
+                ecfl::Log::error() << "Error detected: " << e.what() << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            catch (...) {
+                ecfl::Log::error() << "Unknown error detected" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            exit(EXIT_SUCCESS);
+        }
+    }
+
+    static void handle_batch_option(const eckit::option::CmdArgs& args) {
+        auto option = get_option<std::string>(args, "batch");
+        if (option) {
+            size_t failed = 0;
+            try {
+                ecfl::CommandBatch batch{ecfl::ConfiguredClient::instance(), ecfl::TaskContext::current(), std::cout};
+
+                if (option.value() == "-") {
+                    failed = batch.process(std::cin);
+                }
+                else {
+                    std::ifstream input(option.value());
+                    if (!input) {
+                        ecfl::Log::error() << "Unable to open batch file '" << option.value() << "'" << std::endl;
+                        exit(EXIT_FAILURE);
+                    }
+                    failed = batch.process(input);
+                }
+
+                ecfl::Log::debug() << "Batch processed: " << batch.processed() << " command(s), " << failed
+                                   << " failed" << std::endl;
+            }
+            catch (eckit::Exception& e) {
+                ecfl::Log::error() << "Error detected: " << e.what() << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            catch (...) {
+                ecfl::Log::error() << "Unknown error detected" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            exit(failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+    }
+
+    static void handle_follow_option(const eckit::option::CmdArgs& args) {
+        auto option = get_option<std::string>(args, "follow");
+        if (option) {
+            size_t failed = 0;
+            try {
+                auto rules = get_option<std::string>(args, "rules");
+                if (!rules) {
+                    ecfl::Log::error() << "Unable to follow '" << option.value() << "', as no --rules are given"
+                                       << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+
+                ecfl::LogFollower follower{option.value(), ecfl::FollowRule::load(rules.value()),
+                                           ecfl::ConfiguredClient::instance(), ecfl::TaskContext::current()};
+
+                running_follower = &follower;
+                std::signal(SIGTERM, stop_follower);
+                std::signal(SIGINT, stop_follower);
+
+                follower.follow();
+
+                running_follower = nullptr;
+                failed           = follower.failed();
+            }
+            catch (eckit::Exception& e) {
+                ecfl::Log::error() << "Error detected: " << e.what() << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            catch (...) {
+                ecfl::Log::error() << "Unknown error detected" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            exit(failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+    }
+
     static void handle_meter_option(const eckit::option::CmdArgs& args) {
         using option_t = std::vector<std::string>;
         auto option    = get_option<option_t>(args, "meter");
@@ -333,6 +534,10 @@ private:
 };
 
 int main(int argc, char* argv[]) {
+    if (handover_to_agent(argc, argv)) {
+        return EXIT_SUCCESS;
+    }
+
     try {
         ClientTool client(argc, argv);
         return client.start();
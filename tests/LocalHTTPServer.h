@@ -0,0 +1,214 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#ifndef ECFLOW_LIGHT_TESTS_LOCALHTTPSERVER_H
+#define ECFLOW_LIGHT_TESTS_LOCALHTTPSERVER_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ecflow::light::testing {
+
+/**
+ * LocalHTTPServer is a minimal HTTP/1.1 server, bound to an ephemeral port on the loopback interface.
+ *
+ * All connections are served by a single thread, and kept alive until closed by the client. Every request is
+ * answered with '200 OK', echoing the request body, after the configured delay (simulating the server latency).
+ */
+class LocalHTTPServer {
+public:
+    explicit LocalHTTPServer(std::chrono::microseconds delay = std::chrono::microseconds(0)) :
+        socket_{::socket(AF_INET, SOCK_STREAM, 0)},
+        port_{0},
+        delay_{delay},
+        accepted_{0},
+        pending_{0},
+        max_pending_{0},
+        stopping_{false},
+        lock_{},
+        bodies_{},
+        server_{} {
+        int enable = 1;
+        ::setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+        sockaddr_in address{};
+        address.sin_family      = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port        = 0;
+        ::bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        ::listen(socket_, 128);
+
+        socklen_t length = sizeof(address);
+        ::getsockname(socket_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+
+        server_ = std::thread([this]() { run(); });
+    }
+
+    ~LocalHTTPServer() {
+        stopping_ = true;
+        server_.join();
+        ::close(socket_);
+    }
+
+    [[nodiscard]] std::string port() const { return std::to_string(port_); }
+
+    // Number of accepted connections
+    [[nodiscard]] size_t accepted() const { return accepted_.load(); }
+    // Maximum number of requests received, but still not answered, at any given time
+    [[nodiscard]] size_t max_pending() const { return max_pending_.load(); }
+
+    // Bodies of all received requests, in order of arrival
+    [[nodiscard]] std::vector<std::string> bodies() const {
+        std::scoped_lock lock(lock_);
+        return bodies_;
+    }
+
+private:
+    using clock_t = std::chrono::steady_clock;
+
+    struct Connection {
+        int fd;
+        std::string input;
+        std::deque<std::pair<clock_t::time_point, std::string>> output;
+        bool closed;
+    };
+
+    void run() {
+        std::vector<Connection> connections;
+        while (!stopping_) {
+            std::vector<pollfd> fds;
+            fds.push_back(pollfd{socket_, POLLIN, 0});
+            for (const auto& connection : connections) {
+                fds.push_back(pollfd{connection.fd, POLLIN, 0});
+            }
+
+            ::poll(fds.data(), fds.size(), next_timeout(connections));
+
+            if (fds[0].revents & POLLIN) {
+                if (int fd = ::accept(socket_, nullptr, nullptr); fd >= 0) {
+                    ++accepted_;
+                    connections.push_back(Connection{fd, {}, {}, false});
+                }
+            }
+            for (size_t i = 1; i < fds.size(); ++i) {
+                if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                    receive(connections[i - 1]);
+                }
+            }
+            for (auto& connection : connections) {
+                respond(connection);
+            }
+
+            auto closed = std::remove_if(std::begin(connections), std::end(connections), [](const Connection& c) {
+                if (c.closed) {
+                    ::close(c.fd);
+                }
+                return c.closed;
+            });
+            connections.erase(closed, std::end(connections));
+        }
+        for (auto& connection : connections) {
+            ::close(connection.fd);
+        }
+    }
+
+    int next_timeout(const std::vector<Connection>& connections) const {
+        auto timeout = std::chrono::milliseconds(20);
+        auto now     = clock_t::now();
+        for (const auto& connection : connections) {
+            if (!connection.output.empty()) {
+                auto due = std::chrono::ceil<std::chrono::milliseconds>(connection.output.front().first - now);
+                timeout  = std::clamp(due, std::chrono::milliseconds(0), timeout);
+            }
+        }
+        return static_cast<int>(timeout.count());
+    }
+
+    void receive(Connection& connection) {
+        char chunk[16 * 1024];
+        auto received = ::recv(connection.fd, chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            connection.closed = true;
+            return;
+        }
+        connection.input.append(chunk, static_cast<size_t>(received));
+
+        // Schedule the answer to all complete requests
+        for (;;) {
+            auto end_of_header = connection.input.find("\r\n\r\n");
+            if (end_of_header == std::string::npos) {
+                return;
+            }
+            size_t content_length = 0;
+            if (auto found = connection.input.find("Content-Length: ");
+                found != std::string::npos && found < end_of_header) {
+                content_length = std::stoul(connection.input.substr(found + 16));
+            }
+            size_t request_size = end_of_header + 4 + content_length;
+            if (connection.input.size() < request_size) {
+                return;
+            }
+
+            std::string body = connection.input.substr(end_of_header + 4, content_length);
+            connection.input.erase(0, request_size);
+            {
+                std::scoped_lock lock(lock_);
+                bodies_.push_back(body);
+            }
+            auto pending = ++pending_;
+            max_pending_ = std::max(max_pending_.load(), pending);
+
+            std::string response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: " +
+                                   std::to_string(body.size()) + "\r\n\r\n" + body;
+            connection.output.emplace_back(clock_t::now() + delay_, std::move(response));
+        }
+    }
+
+    void respond(Connection& connection) {
+        auto now = clock_t::now();
+        while (!connection.output.empty() && connection.output.front().first <= now) {
+            const auto& response = connection.output.front().second;
+            ::send(connection.fd, response.data(), response.size(), MSG_NOSIGNAL);
+            connection.output.pop_front();
+            --pending_;
+        }
+    }
+
+    int socket_;
+    uint16_t port_;
+    std::chrono::microseconds delay_;
+
+    std::atomic<size_t> accepted_;
+    std::atomic<size_t> pending_;
+    std::atomic<size_t> max_pending_;
+    std::atomic<bool> stopping_;
+
+    mutable std::mutex lock_;
+    std::vector<std::string> bodies_;
+
+    std::thread server_;
+};
+
+}  // namespace ecflow::light::testing
+
+#endif
@@ -0,0 +1,117 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#ifndef ECFLOW_LIGHT_TESTS_LOCALUDPDECODER_H
+#define ECFLOW_LIGHT_TESTS_LOCALUDPDECODER_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ecflow/light/WireFormat.h"
+
+namespace ecflow::light::testing {
+
+/**
+ * LocalUDPDecoder stands in for the server side of the binary (version 2) UDP protocol.
+ *
+ * The decoder is bound to an ephemeral port on the loopback interface, and decodes the received datagrams. As done
+ * by the server, the hashed task paths and attribute names are resolved against the known (i.e. registered) paths
+ * and names; unknown hashes are reported as '?'.
+ */
+class LocalUDPDecoder {
+public:
+    struct Update {
+        std::string rid;
+        std::string password;
+        std::string try_no;
+        std::string path;
+        std::string command;
+        std::string name;
+        std::string value;
+    };
+
+    LocalUDPDecoder(const std::vector<std::string>& paths, const std::vector<std::string>& names) :
+        socket_{::socket(AF_INET, SOCK_DGRAM, 0)}, port_{0}, paths_{}, names_{}, invalid_{0} {
+        for (const auto& path : paths) {
+            paths_[BinaryEncoder::hash_path(path)] = path;
+        }
+        for (const auto& name : names) {
+            names_[BinaryEncoder::hash_name(name)] = name;
+        }
+
+        sockaddr_in address{};
+        address.sin_family      = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port        = 0;
+        ::bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+
+        socklen_t length = sizeof(address);
+        ::getsockname(socket_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+    }
+    ~LocalUDPDecoder() { ::close(socket_); }
+
+    [[nodiscard]] std::string port() const { return std::to_string(port_); }
+
+    // Number of received datagrams that could not be decoded
+    [[nodiscard]] size_t invalid() const { return invalid_; }
+
+    /**
+     * @return the updates carried by all datagrams received until no more datagrams arrive, in order of arrival
+     */
+    std::vector<Update> collect() {
+        std::vector<Update> updates;
+        std::vector<char> buffer(65'536);
+        pollfd fd{socket_, POLLIN, 0};
+        while (::poll(&fd, 1, 200) > 0) {
+            auto received = ::recv(socket_, buffer.data(), buffer.size(), 0);
+            if (received <= 0) {
+                break;
+            }
+            try {
+                auto datagram = BinaryDecoder::decode(std::string_view(buffer.data(), static_cast<size_t>(received)));
+                for (const auto& update : datagram.updates) {
+                    updates.push_back(Update{datagram.rid, datagram.password, datagram.try_no,
+                                             resolve(paths_, datagram.path),
+                                             std::string(BinaryEncoder::command_of(update.kind)),
+                                             resolve(names_, update.name), update.value});
+                }
+            }
+            catch (InvalidDatagram&) {
+                ++invalid_;
+            }
+        }
+        return updates;
+    }
+
+private:
+    template <typename K>
+    static std::string resolve(const std::unordered_map<K, std::string>& known, K hash) {
+        auto found = known.find(hash);
+        return found == known.end() ? "?" : found->second;
+    }
+
+    int socket_;
+    uint16_t port_;
+    std::unordered_map<uint64_t, std::string> paths_;
+    std::unordered_map<uint32_t, std::string> names_;
+    size_t invalid_;
+};
+
+}  // namespace ecflow::light::testing
+
+#endif
@@ -0,0 +1,215 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#ifndef ECFLOW_LIGHT_TESTS_LOSSYUDPRECEIVER_H
+#define ECFLOW_LIGHT_TESTS_LOSSYUDPRECEIVER_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <charconv>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ecflow/light/WireFormat.h"
+
+namespace ecflow::light::testing {
+
+/**
+ * LossyUDPReceiver stands in for the server side of the acknowledged UDP mode.
+ *
+ * The receiver is bound to an ephemeral port on the loopback interface, and (on a dedicated thread) drops the
+ * datagrams selected by the given pattern, based on the sequence number and the number of times the same sequence
+ * number arrived before (i.e. 0 for the original transmission), so that drops do not depend on timing. Each
+ * datagram kept is recorded by sequence number, and acknowledged cumulatively, in the same wire format.
+ */
+class LossyUDPReceiver {
+public:
+    using pattern_t = std::function<bool(uint64_t sequence, size_t attempt)>;
+
+    explicit LossyUDPReceiver(pattern_t drop) :
+        socket_{::socket(AF_INET, SOCK_DGRAM, 0)},
+        port_{0},
+        drop_{std::move(drop)},
+        lock_{},
+        received_{},
+        attempts_{},
+        arrivals_{0},
+        dropped_{0},
+        duplicates_{0},
+        cumulative_{0},
+        stopping_{false},
+        thread_{} {
+        sockaddr_in address{};
+        address.sin_family      = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port        = 0;
+        ::bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+
+        socklen_t length = sizeof(address);
+        ::getsockname(socket_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+
+        thread_ = std::thread([this]() { run(); });
+    }
+    ~LossyUDPReceiver() {
+        stopping_ = true;
+        thread_.join();
+        ::close(socket_);
+    }
+
+    [[nodiscard]] std::string port() const { return std::to_string(port_); }
+
+    [[nodiscard]] size_t arrivals() const { return arrivals_; }
+    [[nodiscard]] size_t dropped() const { return dropped_; }
+    [[nodiscard]] size_t duplicates() const { return duplicates_; }
+
+    // Highest sequence number acknowledged (cumulatively)
+    [[nodiscard]] uint64_t acknowledged() const { return cumulative_; }
+
+    /**
+     * @return the (distinct) datagrams received, without sequence numbers, ordered by sequence number
+     */
+    std::vector<std::string> received() const {
+        std::scoped_lock lock(lock_);
+        std::vector<std::string> datagrams;
+        for (const auto& [sequence, datagram] : received_) {
+            datagrams.push_back(datagram);
+        }
+        return datagrams;
+    }
+
+private:
+    void run() {
+        std::vector<char> buffer(65'536);
+        pollfd fd{socket_, POLLIN, 0};
+        while (!stopping_) {
+            if (::poll(&fd, 1, 20) <= 0) {
+                continue;
+            }
+            sockaddr_in sender{};
+            socklen_t length = sizeof(sender);
+            auto received    = ::recvfrom(socket_, buffer.data(), buffer.size(), 0,
+                                          reinterpret_cast<sockaddr*>(&sender), &length);
+            if (received <= 0) {
+                continue;
+            }
+            ++arrivals_;
+
+            std::string_view datagram(buffer.data(), static_cast<size_t>(received));
+            auto sequence = sequence_of(datagram);
+            if (!sequence) {
+                continue;
+            }
+            if (drop_(sequence->sequence, attempts_[sequence->sequence]++)) {
+                ++dropped_;
+                continue;
+            }
+
+            std::string acknowledgement;
+            {
+                std::scoped_lock lock(lock_);
+                if (!received_.emplace(sequence->sequence, strip(datagram)).second) {
+                    ++duplicates_;
+                }
+                // All datagrams below the base are no longer to be waited for
+                uint64_t cumulative = std::max(cumulative_.load(), sequence->base - 1);
+                while (received_.count(cumulative + 1) > 0) {
+                    ++cumulative;
+                }
+                cumulative_ = cumulative;
+                write_acknowledgement(acknowledgement,
+                                      BinaryDecoder::is_binary(datagram) ? WireFormat::Binary : WireFormat::JSON,
+                                      cumulative);
+            }
+            ::sendto(socket_, acknowledgement.data(), acknowledgement.size(), 0,
+                     reinterpret_cast<sockaddr*>(&sender), length);
+        }
+    }
+
+    static std::optional<Sequence> sequence_of(std::string_view datagram) {
+        if (BinaryDecoder::is_binary(datagram)) {
+            try {
+                return BinaryDecoder::decode(datagram).sequence;
+            }
+            catch (InvalidDatagram&) {
+                return std::nullopt;
+            }
+        }
+        auto sequence = number_of(datagram, R"("sequence":)");
+        auto base     = number_of(datagram, R"("base":)");
+        if (!sequence || !base) {
+            return std::nullopt;
+        }
+        return Sequence{sequence.value(), base.value()};
+    }
+
+    static std::optional<uint64_t> number_of(std::string_view datagram, std::string_view member) {
+        auto found = datagram.find(member);
+        if (found == std::string_view::npos) {
+            return std::nullopt;
+        }
+        auto digits     = datagram.substr(found + member.size());
+        uint64_t number = 0;
+        if (std::from_chars(digits.data(), digits.data() + digits.size(), number).ec != std::errc{}) {
+            return std::nullopt;
+        }
+        return number;
+    }
+
+    /**
+     * @return the datagram, as sent by the client before adding the sequence numbers
+     */
+    static std::string strip(std::string_view datagram) {
+        if (BinaryDecoder::is_binary(datagram)) {
+            std::string stripped(datagram.substr(0, BinaryEncoder::HeaderSize));
+            stripped.back() = static_cast<char>(static_cast<uint8_t>(stripped.back()) & ~BinaryEncoder::FlagSequenced);
+            size_t position = BinaryEncoder::HeaderSize;
+            BinaryDecoder::read_varint(datagram, position);
+            BinaryDecoder::read_varint(datagram, position);
+            stripped.append(datagram.substr(position));
+            return stripped;
+        }
+        auto members = datagram.find(R"("method")");
+        std::string stripped("{");
+        // Notice: the null terminator of JSON datagrams is dropped
+        stripped.append(datagram.substr(members, datagram.find('\0') - members));
+        return stripped;
+    }
+
+    int socket_;
+    uint16_t port_;
+    pattern_t drop_;
+
+    mutable std::mutex lock_;
+    std::map<uint64_t, std::string> received_;
+    std::map<uint64_t, size_t> attempts_;
+
+    std::atomic<size_t> arrivals_;
+    std::atomic<size_t> dropped_;
+    std::atomic<size_t> duplicates_;
+    std::atomic<uint64_t> cumulative_;
+    std::atomic<bool> stopping_;
+
+    std::thread thread_;
+};
+
+}  // namespace ecflow::light::testing
+
+#endif
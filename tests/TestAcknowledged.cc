@@ -0,0 +1,234 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <eckit/testing/Test.h>
+
+#include "LossyUDPReceiver.h"
+#include "TestFixtures.h"
+#include "ecflow/light/Acknowledged.h"
+#include "ecflow/light/ClientAPI.h"
+
+namespace ecflow::light::testing {
+
+using namespace std::chrono_literals;
+
+ClientCfg make_cfg(const std::string& port, const std::string& version) {
+    auto cfg         = make_udp_cfg(port, version);
+    cfg.acknowledged = true;
+    return cfg;
+}
+
+std::string make_meter(const std::string& value) {
+    return R"({"method":"put","payload":{"command":"meter","name":"progress","value":")" + value + R"("}})";
+}
+
+CASE("test_acknowledged__rto_follows_measured_round_trip") {
+    RTOEstimator estimator;
+    EXPECT(estimator.rto() == RTOEstimator::InitialRTO);
+
+    // i.e. the first sample sets RTT variation to half the RTT, and thus RTO = RTT + 4 * RTT / 2
+    estimator.sample(10ms);
+    EXPECT(estimator.srtt() == 10ms);
+    EXPECT(estimator.rto() == 30ms);
+
+    for (int i = 0; i != 100; ++i) {
+        estimator.sample(10ms);
+    }
+    EXPECT(estimator.rto() < 15ms);
+    EXPECT(estimator.rto() >= RTOEstimator::MinimumRTO);
+
+    estimator.sample(10s);
+    EXPECT(estimator.rto() == RTOEstimator::MaximumRTO);
+}
+
+CASE("test_acknowledged__window_acknowledges_cumulatively") {
+    auto now = RetransmitWindow::clock_t::now();
+    RTOEstimator estimator;
+    RetransmitWindow window(8);
+
+    for (uint64_t expected = 1; expected != 6; ++expected) {
+        auto sequence = window.open("");
+        EXPECT(sequence == expected);
+        window.record(sequence, "", "datagram", now, estimator.rto());
+    }
+    EXPECT(window.pending() == 5);
+    EXPECT(window.base() == 1);
+
+    EXPECT(window.acknowledge(3, now + 1ms, estimator) == 3);
+    EXPECT(window.pending() == 2);
+    EXPECT(window.base() == 4);
+    // Notice: the acknowledged entry was sent only once, and thus the RTT is sampled
+    EXPECT(estimator.srtt() == 1ms);
+
+    EXPECT(window.acknowledge(3, now + 2ms, estimator) == 0);
+    EXPECT(window.acknowledge(99, now + 2ms, estimator) == 2);
+    EXPECT(window.pending() == 0);
+    EXPECT(window.base() == 6);
+}
+
+CASE("test_acknowledged__window_keeps_only_newest_value_per_key") {
+    auto now = RetransmitWindow::clock_t::now();
+    RetransmitWindow window(8);
+
+    window.record(window.open("progress"), "progress", "1", now, 10ms);
+    window.record(window.open("event"), "", "event", now, 10ms);
+    window.record(window.open("progress"), "progress", "2", now, 10ms);
+    window.record(window.open("progress"), "progress", "3", now, 10ms);
+
+    EXPECT(window.pending() == 2);
+    EXPECT(window.superseded() == 2);
+    EXPECT(window.base() == 2);
+
+    auto due = window.due(now + 10ms, 10ms);
+    EXPECT(due.size() == 2);
+    EXPECT(due[0]->packet == "event");
+    EXPECT(due[1]->packet == "3");
+    EXPECT(due[1]->sequence == 4);
+}
+
+CASE("test_acknowledged__window_backs_off_and_abandons") {
+    auto now = RetransmitWindow::clock_t::now();
+    RetransmitWindow window(2);
+
+    window.record(window.open(""), "", "1", now, 10ms);
+    window.record(window.open(""), "", "2", now, 10ms);
+    window.record(window.open(""), "", "3", now, 10ms);
+    // i.e. the oldest entry is abandoned, when the window is full
+    EXPECT(window.pending() == 2);
+    EXPECT(window.abandoned() == 1);
+    EXPECT(window.base() == 2);
+
+    EXPECT(window.due(now + 9ms, 10ms).empty());
+    EXPECT(window.due(now + 10ms, 10ms).size() == 2);
+    // Notice: after the first retransmission, the timeout doubles
+    EXPECT(window.due(now + 29ms, 10ms).empty());
+    EXPECT(window.due(now + 30ms, 10ms).size() == 2);
+
+    auto time = now + 30ms;
+    for (uint32_t transmission = 4; transmission <= RetransmitWindow::MaximumTransmissions; ++transmission) {
+        time += RTOEstimator::MaximumRTO;
+        EXPECT(window.due(time, 10ms).size() == 2);
+    }
+    time += RTOEstimator::MaximumRTO;
+    EXPECT(window.due(time, 10ms).empty());
+    EXPECT(window.pending() == 0);
+    EXPECT(window.abandoned() == 3);
+}
+
+CASE("test_acknowledged__all_datagrams_are_delivered_despite_drops") {
+    // Drop every third datagram twice, and every fifth datagram once (including some retransmissions)
+    LossyUDPReceiver receiver([](uint64_t sequence, size_t attempt) {
+        return (sequence % 3 == 0 && attempt < 2) || (sequence % 5 == 0 && attempt == 0);
+    });
+
+    net::UDPSocket socket("127.0.0.1", receiver.port(), 60s);
+    AcknowledgedSender sender(socket, 64);
+
+    for (int i = 0; i != 30; ++i) {
+        auto datagram = R"({"method":"put","payload":{"command":"event","name":"e)" + std::to_string(i) +
+                        R"(","value":"1"}})";
+        EXPECT(sender.send("", datagram));
+    }
+    EXPECT(sender.wait_acknowledged(10s));
+
+    auto received = receiver.received();
+    EXPECT(received.size() == 30);
+    EXPECT(received[7].find(R"("name":"e7")") != std::string::npos);
+    EXPECT(receiver.dropped() == 2 * 10 + 4);
+    EXPECT(receiver.acknowledged() == 30);
+    EXPECT(sender.acknowledged() == 30);
+    EXPECT(sender.retransmitted() >= receiver.dropped());
+    EXPECT(sender.abandoned() == 0);
+}
+
+CASE("test_acknowledged__only_newest_meter_value_is_retransmitted") {
+    // Drop all datagrams sent right away, so that only retransmissions get through
+    LossyUDPReceiver receiver([](uint64_t sequence, size_t attempt) { return attempt == 0; });
+
+    net::UDPSocket socket("127.0.0.1", receiver.port(), 60s);
+    AcknowledgedSender sender(socket, 64);
+
+    for (int i = 1; i <= 10; ++i) {
+        EXPECT(sender.send("/suite/family/task:meter:progress", make_meter(std::to_string(i))));
+    }
+    EXPECT(sender.wait_acknowledged(10s));
+
+    auto received = receiver.received();
+    EXPECT(sender.superseded() == 9);
+    EXPECT(received.size() == 1);
+    EXPECT(received[0] == make_meter("10"));
+    // Notice: the base carried by the newest value allows the receiver to skip all superseded values
+    EXPECT(receiver.acknowledged() == 10);
+}
+
+CASE("test_acknowledged__library_client_sends_json_datagrams") {
+    LossyUDPReceiver receiver([](uint64_t sequence, size_t attempt) { return sequence % 2 == 0 && attempt == 0; });
+
+    auto environment = make_environment();
+    {
+        auto cfg = make_cfg(receiver.port(), "1.0");
+        LibraryUDPClientAPI client(cfg, environment);
+
+        for (int i = 1; i <= 5; ++i) {
+            auto options = Options::options().with("command", "event").with("name", "e" + std::to_string(i)).with("value", "1");
+            EXPECT(client.process(Request::make_request<UpdateNodeAttribute>(environment, options)).response == "OK");
+        }
+        // Notice: the client waits for the pending datagrams to be acknowledged, when destroyed
+    }
+
+    auto received = receiver.received();
+    EXPECT(received.size() == 5);
+    EXPECT(received[0].rfind(R"({"method":"put")", 0) == 0);
+    EXPECT(received[4].find(R"("name":"e5")") != std::string::npos);
+    EXPECT(receiver.acknowledged() == 5);
+}
+
+CASE("test_acknowledged__library_client_sends_binary_datagrams") {
+    // Drop the original transmission of all meter values
+    LossyUDPReceiver receiver([](uint64_t sequence, size_t attempt) { return sequence > 1 && attempt == 0; });
+
+    auto environment = make_environment();
+    {
+        auto cfg = make_cfg(receiver.port(), "2.0");
+        LibraryUDPClientAPI client(cfg, environment);
+
+        auto label = Options::options().with("command", "label").with("name", "message").with("value", "done");
+        EXPECT(client.process(Request::make_request<UpdateNodeAttribute>(environment, label)).response == "OK");
+        for (int i = 1; i <= 5; ++i) {
+            auto meter =
+                Options::options().with("command", "meter").with("name", "progress").with("value", std::to_string(i));
+            EXPECT(client.process(Request::make_request<UpdateNodeAttribute>(environment, meter)).response == "OK");
+        }
+    }
+
+    std::vector<BinaryDatagram::Update> updates;
+    for (const auto& datagram : receiver.received()) {
+        auto decoded = BinaryDecoder::decode(datagram);
+        EXPECT(!decoded.sequence);
+        EXPECT(decoded.path == BinaryEncoder::hash_path("/suite/family/task"));
+        updates.insert(std::end(updates), std::begin(decoded.updates), std::end(decoded.updates));
+    }
+    EXPECT(!updates.empty());
+    EXPECT(updates.front().kind == BinaryEncoder::Kind::Label);
+    EXPECT(updates.front().value == "done");
+    EXPECT(updates.back().kind == BinaryEncoder::Kind::Meter);
+    EXPECT(updates.back().value == "5");
+    EXPECT(receiver.acknowledged() == 6);
+}
+
+}  // namespace ecflow::light::testing
+
+int main(int argc, char** argv) {
+    return eckit::testing::run_tests(argc, argv);
+}
@@ -0,0 +1,131 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <eckit/testing/Test.h>
+
+#include "ecflow/light/Agent.h"
+
+namespace ecflow::light::testing {
+
+using namespace std::chrono_literals;
+
+/**
+ * Counter counts the updates carried by each request
+ */
+struct Counter : public RequestDispatcher {
+    void dispatch_request(const UpdateNodeStatus& request [[maybe_unused]]) override {}
+    void dispatch_request(const UpdateNodeAttribute& request [[maybe_unused]]) override { updates += 1; }
+    void dispatch_request(const UpdateNodeAttributes& request) override {
+        updates += static_cast<int>(request.attributes().size());
+    }
+
+    int updates = 0;
+};
+
+/**
+ * CountingClientAPI counts the requests, and the updates they carry
+ */
+class CountingClientAPI : public ClientAPI {
+public:
+    [[nodiscard]] Response process(const Request& request) const override {
+        Counter counter;
+        request.dispatch(counter);
+        requests += 1;
+        updates += counter.updates;
+        return Response{"OK"};
+    }
+
+    mutable std::atomic<int> requests{0};
+    mutable std::atomic<int> updates{0};
+};
+
+std::string make_path() {
+    return "/tmp/ecflow_light_agent_test." + std::to_string(::getpid());
+}
+
+template <typename P>
+bool wait_for(P&& predicate) {
+    for (int i = 0; i < 200 && !predicate(); ++i) {
+        std::this_thread::sleep_for(10ms);
+    }
+    return predicate();
+}
+
+CASE("test_agent__handover_fails_when_no_agent_is_running") {
+    auto record = UpdateRecord::make_meter("progress", 1);
+    EXPECT(!Agent::handover(make_path(), *record));
+    EXPECT(!Agent::handover("", *record));
+}
+
+CASE("test_agent__updates_handed_over_are_forwarded_to_the_target") {
+    CountingClientAPI target;
+    auto path = make_path();
+    {
+        Agent agent{path, target};
+        EXPECT(::access(path.c_str(), F_OK) == 0);
+
+        // Notice: updates handed over before serving are queued, and forwarded together
+        for (int i = 0; i < 10; ++i) {
+            EXPECT(Agent::handover(path, *UpdateRecord::make_meter("progress", i)));
+        }
+
+        std::thread server([&agent]() { agent.serve(); });
+
+        EXPECT(wait_for([&target]() { return target.updates == 10; }));
+        EXPECT(target.requests == 1);
+
+        EXPECT(Agent::handover(path, *UpdateRecord::make_label("status", "running")));
+        EXPECT(Agent::handover(path, *UpdateRecord::make_event("done", true)));
+        EXPECT(wait_for([&target]() { return target.updates == 12; }));
+        EXPECT(agent.received() == 12);
+        EXPECT(agent.failed() == 0);
+
+        agent.stop();
+        server.join();
+    }
+    EXPECT(::access(path.c_str(), F_OK) != 0);
+}
+
+CASE("test_agent__only_one_agent_listens_on_each_path") {
+    CountingClientAPI target;
+    auto path = make_path();
+
+    Agent agent{path, target};
+    EXPECT_THROWS_AS(Agent(path, target), AgentError);
+}
+
+CASE("test_agent__stale_socket_is_replaced") {
+    CountingClientAPI target;
+    auto path = make_path();
+    {
+        Agent agent{path, target};
+        // Simulate an agent that was killed, leaving its socket behind
+        ::link(path.c_str(), (path + ".stale").c_str());
+    }
+    ::rename((path + ".stale").c_str(), path.c_str());
+    EXPECT(::access(path.c_str(), F_OK) == 0);
+    EXPECT(!Agent::handover(path, *UpdateRecord::make_meter("progress", 1)));
+
+    Agent agent{path, target};
+    EXPECT(Agent::handover(path, *UpdateRecord::make_meter("progress", 1)));
+}
+
+}  // namespace ecflow::light::testing
+
+int main(int argc, char** argv) {
+    return eckit::testing::run_tests(argc, argv);
+}
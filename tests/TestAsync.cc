@@ -0,0 +1,263 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <eckit/testing/Test.h>
+
+#include "ecflow/light/AsyncSender.h"
+#include "ecflow/light/BoundedQueue.h"
+#include "ecflow/light/Deadline.h"
+#include "ecflow/light/UDPSocket.h"
+
+namespace ecflow::light::testing {
+
+struct MockClientAPI : public ClientAPI {
+    Response process(const Request& request) const override {
+        std::scoped_lock lock(lock_);
+        values.push_back(request.get_option("value"));
+        return Response{"OK"};
+    }
+
+    mutable std::mutex lock_;
+    mutable std::vector<std::string> values;
+};
+
+/**
+ * GatedClientAPI holds the sender thread on the first request, until opened, so that the queue can be filled
+ */
+struct GatedClientAPI : public MockClientAPI {
+    Response process(const Request& request) const override {
+        {
+            std::unique_lock lock(gate_lock_);
+            entered_ = true;
+            gate_changed_.notify_all();
+            gate_changed_.wait(lock, [this]() { return open_; });
+        }
+        return MockClientAPI::process(request);
+    }
+
+    void wait_entered() const {
+        std::unique_lock lock(gate_lock_);
+        gate_changed_.wait(lock, [this]() { return entered_; });
+    }
+
+    void open() const {
+        std::scoped_lock lock(gate_lock_);
+        open_ = true;
+        gate_changed_.notify_all();
+    }
+
+    mutable std::mutex gate_lock_;
+    mutable std::condition_variable gate_changed_;
+    mutable bool entered_ = false;
+    mutable bool open_    = false;
+};
+
+CASE("test_async__bounded_queue_rounds_capacity_and_rejects_when_full") {
+    BoundedQueue<int> queue(3);
+    EXPECT(queue.capacity() == 4);
+
+    for (int i = 0; i != 4; ++i) {
+        EXPECT(queue.try_push(i));
+    }
+    EXPECT(!queue.try_push(4));
+
+    int value = -1;
+    EXPECT(queue.try_pop(value) && value == 0);
+    EXPECT(queue.try_push(4));
+    for (int expected = 1; expected != 5; ++expected) {
+        EXPECT(queue.try_pop(value) && value == expected);
+    }
+    EXPECT(!queue.try_pop(value));
+}
+
+CASE("test_async__bounded_queue_handles_multiple_producers") {
+    BoundedQueue<int> queue(1024);
+
+    constexpr int producers = 4;
+    constexpr int items     = 200;
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p != producers; ++p) {
+        threads.emplace_back([&queue, p]() {
+            for (int i = 0; i != items; ++i) {
+                while (!queue.try_push(p * items + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<bool> seen(producers * items, false);
+    int value = 0;
+    while (queue.try_pop(value)) {
+        EXPECT(!seen[value]);
+        seen[value] = true;
+    }
+    EXPECT(std::all_of(std::begin(seen), std::end(seen), [](bool s) { return s; }));
+}
+
+CASE("test_async__records_reject_oversized_contents") {
+    EXPECT(UpdateRecord::make_meter("meter", 42).has_value());
+    EXPECT(!UpdateRecord::make_meter(std::string(UpdateRecord::MaxNameSize + 1, 'x'), 42).has_value());
+    EXPECT(!UpdateRecord::make_label("label", std::string(UpdateRecord::MaxTextSize + 1, 'x')).has_value());
+
+    auto record = UpdateRecord::make_label("label", "some text");
+    EXPECT(record->name() == "label");
+    EXPECT(record->text() == "some text");
+}
+
+CASE("test_async__sender_delivers_all_records_on_flush") {
+    MockClientAPI target;
+    AsyncCfg cfg;
+    cfg.enabled  = true;
+    cfg.overflow = AsyncCfg::OverflowBlock;
+    cfg.capacity = 8;
+
+    {
+        AsyncSender sender(cfg, target);
+        for (int i = 0; i != 100; ++i) {
+            EXPECT(sender.submit(UpdateRecord::make_meter("meter", i).value()));
+        }
+        EXPECT(sender.flush(std::chrono::seconds(10)));
+        EXPECT(sender.dropped() == 0);
+    }
+
+    EXPECT(target.values.size() == 100);
+    EXPECT(target.values.back() == "99");
+}
+
+CASE("test_async__sender_flushes_pending_records_on_destruction") {
+    MockClientAPI target;
+    AsyncCfg cfg;
+    cfg.enabled = true;
+
+    {
+        AsyncSender sender(cfg, target);
+        sender.submit(UpdateRecord::make_label("label", "last words").value());
+    }
+
+    EXPECT(target.values.size() == 1);
+    EXPECT(target.values.front() == "last words");
+}
+
+CASE("test_async__sender_drops_oldest_records_when_full") {
+    GatedClientAPI target;
+    AsyncCfg cfg;
+    cfg.enabled  = true;
+    cfg.overflow = AsyncCfg::OverflowDropOldest;
+    cfg.capacity = 4;
+
+    {
+        AsyncSender sender(cfg, target);
+        EXPECT(sender.submit(UpdateRecord::make_meter("meter", 0).value()));
+        target.wait_entered();
+
+        // The sender thread holds record 0, and thus only the 4 most recent of the following remain queued
+        for (int i = 1; i != 11; ++i) {
+            EXPECT(sender.submit(UpdateRecord::make_meter("meter", i).value()));
+        }
+        EXPECT(sender.dropped() == 6);
+
+        target.open();
+        EXPECT(sender.flush(std::chrono::seconds(10)));
+    }
+
+    EXPECT(target.values == (std::vector<std::string>{"0", "7", "8", "9", "10"}));
+}
+
+CASE("test_async__sender_blocks_callers_until_space_is_available") {
+    GatedClientAPI target;
+    AsyncCfg cfg;
+    cfg.enabled  = true;
+    cfg.overflow = AsyncCfg::OverflowBlock;
+    cfg.capacity = 4;
+
+    {
+        AsyncSender sender(cfg, target);
+        EXPECT(sender.submit(UpdateRecord::make_meter("meter", 0).value()));
+        target.wait_entered();
+        for (int i = 1; i != 5; ++i) {
+            EXPECT(sender.submit(UpdateRecord::make_meter("meter", i).value()));
+        }
+
+        // With the queue full, the caller waits only until its deadline
+        {
+            Deadline::Scope scope{std::chrono::milliseconds(20)};
+            EXPECT_THROWS_AS(sender.submit(UpdateRecord::make_meter("meter", -1).value()), DeadlineExceeded);
+        }
+
+        std::atomic<bool> submitted{false};
+        std::thread caller([&sender, &submitted]() {
+            EXPECT(sender.submit(UpdateRecord::make_meter("meter", 5).value()));
+            submitted = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EXPECT(!submitted);
+
+        target.open();
+        caller.join();
+        EXPECT(submitted);
+        EXPECT(sender.flush(std::chrono::seconds(10)));
+        EXPECT(sender.dropped() == 0);
+    }
+
+    EXPECT(target.values == (std::vector<std::string>{"0", "1", "2", "3", "4", "5"}));
+}
+
+/**
+ * OversizedClientAPI sends a datagram too large to ever be sent, and records whether the socket reported it as sent
+ */
+struct OversizedClientAPI : public MockClientAPI {
+    Response process(const Request& request) const override {
+        std::string datagram(70'000, 'x');
+        bool sent = socket.send(datagram.data(), datagram.size());
+        {
+            std::scoped_lock lock(lock_);
+            outcomes.push_back(sent);
+        }
+        return sent ? Response{"OK"} : Response{"DROPPED", Response::Outcome::Dropped};
+    }
+
+    mutable net::UDPSocket socket{"127.0.0.1", "9", std::chrono::seconds(0)};
+    mutable std::vector<bool> outcomes;
+};
+
+CASE("test_async__sender_reports_dropped_datagrams_unless_bursts_are_used") {
+    AsyncCfg cfg;
+    cfg.enabled = true;
+
+    for (bool bursts : {false, true}) {
+        OversizedClientAPI target;
+        {
+            AsyncSender sender(cfg, target, bursts);
+            EXPECT(sender.submit(UpdateRecord::make_meter("meter", 1).value()));
+            EXPECT(sender.flush(std::chrono::seconds(10)));
+        }
+        // Notice: while deferred, the datagram is reported as sent, and the error is only found when the burst ends
+        EXPECT(target.outcomes == std::vector<bool>{bursts});
+        EXPECT(target.socket.dropped() == 1);
+    }
+}
+
+}  // namespace ecflow::light::testing
+
+int main(int argc, char** argv) {
+    return eckit::testing::run_tests(argc, argv);
+}
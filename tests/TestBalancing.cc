@@ -0,0 +1,175 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <eckit/testing/Test.h>
+
+#include "ecflow/light/ClientAPI.h"
+
+namespace ecflow::light::testing {
+
+using namespace std::chrono_literals;
+
+struct ClientFailure : public eckit::Exception {
+    ClientFailure(const std::string& msg, const eckit::CodeLocation& loc) : eckit::Exception(msg, loc) {}
+};
+
+/**
+ * MockClientAPI responds with its name, unless (externally) set to fail or to drop the requests
+ */
+class MockClientAPI : public ClientAPI {
+public:
+    MockClientAPI(std::string name, std::shared_ptr<std::atomic<bool>> fail, std::shared_ptr<std::atomic<bool>> drop) :
+        name_{std::move(name)}, fail_{std::move(fail)}, drop_{std::move(drop)} {}
+
+    [[nodiscard]] Response process(const Request& request [[maybe_unused]]) const override {
+        if (*fail_) {
+            ECFLOW_LIGHT_THROW(ClientFailure, Message("Endpoint '", name_, "' failed"));
+        }
+        return Response{name_, *drop_ ? Response::Outcome::Dropped : Response::Outcome::Sent};
+    }
+
+private:
+    std::string name_;
+    std::shared_ptr<std::atomic<bool>> fail_;
+    std::shared_ptr<std::atomic<bool>> drop_;
+};
+
+ClientCfg make_cfg(const std::string& protocol) {
+    auto cfg           = ClientCfg::make_cfg(ClientCfg::KindLibrary, protocol, "localhost", "8080", "1.0");
+    cfg.eject_failures = 1;
+    cfg.eject_ms       = 100;
+    return cfg;
+}
+
+struct Balancing {
+    Balancing() : router{make_cfg(ClientCfg::ProtocolUDP)}, failures{}, drops{} {
+        for (const auto* name : {"relay-a:8080", "relay-b:8080", "relay-c:8080"}) {
+            failures[name] = std::make_shared<std::atomic<bool>>(false);
+            drops[name]    = std::make_shared<std::atomic<bool>>(false);
+            router.add(name, std::make_unique<MockClientAPI>(name, failures[name], drops[name]));
+        }
+    }
+
+    std::string send(const std::string& task) { return router.process(make_update(task)).response; }
+
+    std::map<std::string, std::string> send_all() {
+        std::map<std::string, std::string> assigned;
+        for (int i = 0; i < 100; ++i) {
+            auto task      = "/suite/family/task_" + std::to_string(i);
+            assigned[task] = send(task);
+        }
+        return assigned;
+    }
+
+    static Request make_update(const std::string& task) {
+        auto environment = Environment::an_environment().with("ECF_NAME", task);
+        auto options     = Options::options().with("command", "meter").with("name", "progress").with("value", "1");
+        return Request::make_request<UpdateNodeAttribute>(environment, options);
+    }
+
+    BalancingClientAPI router;
+    std::map<std::string, std::shared_ptr<std::atomic<bool>>> failures;
+    std::map<std::string, std::shared_ptr<std::atomic<bool>>> drops;
+};
+
+CASE("test_balancing__endpoints_are_expanded_from_the_configuration") {
+    auto cfg      = make_cfg(ClientCfg::ProtocolHTTP);
+    cfg.endpoints = {"gateway-a:8443", "gateway-b", "[::1]:9443"};
+
+    auto endpoints = BalancingClientAPI::endpoints_of(cfg);
+    EXPECT(endpoints.size() == 3);
+    EXPECT(endpoints[0].host == "gateway-a" && endpoints[0].port == "8443");
+    EXPECT(endpoints[1].host == "gateway-b" && endpoints[1].port == "8080");
+    EXPECT(endpoints[2].host == "[::1]" && endpoints[2].port == "9443");
+    for (const auto& endpoint : endpoints) {
+        EXPECT(endpoint.endpoints.empty());
+    }
+
+    // Without alternative endpoints, the configuration is used as is
+    EXPECT(BalancingClientAPI::endpoints_of(make_cfg(ClientCfg::ProtocolHTTP)).size() == 1);
+}
+
+CASE("test_balancing__host_is_expanded_into_its_resolved_addresses") {
+    auto cfg        = make_cfg(ClientCfg::ProtocolUDP);
+    cfg.host        = "127.0.0.1";
+    cfg.resolve_all = true;
+
+    auto endpoints = BalancingClientAPI::endpoints_of(cfg);
+    EXPECT(endpoints.size() == 1);
+    EXPECT(endpoints[0].host == "127.0.0.1");
+    EXPECT(!endpoints[0].resolve_all);
+}
+
+CASE("test_balancing__requests_of_each_task_are_sent_to_the_same_endpoint") {
+    Balancing balancing;
+
+    auto assigned = balancing.send_all();
+    EXPECT(assigned == balancing.send_all());
+
+    std::map<std::string, int> load;
+    for (const auto& [task, endpoint] : assigned) {
+        load[endpoint] += 1;
+    }
+    EXPECT(load.size() == 3);
+    for (const auto& [endpoint, count] : load) {
+        EXPECT(count > 15);
+    }
+}
+
+CASE("test_balancing__failed_endpoint_is_ejected_and_brought_back_after_recovery") {
+    Balancing balancing;
+    auto assigned = balancing.send_all();
+
+    *balancing.failures["relay-b:8080"] = true;
+    auto failover                       = balancing.send_all();
+    EXPECT(balancing.router.ejected() == std::vector<std::string>{"relay-b:8080"});
+    for (const auto& [task, endpoint] : assigned) {
+        // Notice: only the tasks of the ejected endpoint are moved
+        EXPECT(failover[task] != "relay-b:8080");
+        EXPECT(endpoint == "relay-b:8080" || failover[task] == endpoint);
+    }
+
+    *balancing.failures["relay-b:8080"] = false;
+    std::this_thread::sleep_for(150ms);
+    EXPECT(balancing.send_all() == assigned);
+    EXPECT(balancing.router.ejected().empty());
+}
+
+CASE("test_balancing__dropped_requests_are_sent_to_the_next_endpoint") {
+    Balancing balancing;
+    auto task     = "/suite/family/task";
+    auto endpoint = balancing.send(task);
+
+    *balancing.drops[endpoint] = true;
+    auto next                  = balancing.send(task);
+    EXPECT(next != endpoint);
+    EXPECT(balancing.router.ejected() == std::vector<std::string>{endpoint});
+}
+
+CASE("test_balancing__score_is_stable") {
+    EXPECT(BalancingClientAPI::score("/suite/task", "relay-a:8080") ==
+           BalancingClientAPI::score("/suite/task", "relay-a:8080"));
+    EXPECT(BalancingClientAPI::score("/suite/task", "relay-a:8080") !=
+           BalancingClientAPI::score("/suite/task", "relay-b:8080"));
+}
+
+}  // namespace ecflow::light::testing
+
+int main(int argc, char** argv) {
+    return eckit::testing::run_tests(argc, argv);
+}
@@ -0,0 +1,165 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <eckit/parser/JSONParser.h>
+#include <eckit/testing/Test.h>
+
+#include "TestFixtures.h"
+#include "ecflow/light/API.h"
+#include "ecflow/light/Dispatcher.h"
+
+namespace ecflow::light::testing {
+
+/**
+ * LocalReceiver is a UDP socket, bound to an ephemeral port on the loopback interface,
+ * used to collect the datagrams actually sent by the dispatcher.
+ */
+class LocalReceiver {
+public:
+    LocalReceiver() : socket_{::socket(AF_INET, SOCK_DGRAM, 0)}, port_{0} {
+        sockaddr_in address{};
+        address.sin_family      = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port        = 0;
+        ::bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+
+        socklen_t length = sizeof(address);
+        ::getsockname(socket_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+
+        int buffer_size = 8 * 1024 * 1024;
+        ::setsockopt(socket_, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+    }
+    ~LocalReceiver() { ::close(socket_); }
+
+    [[nodiscard]] std::string port() const { return std::to_string(port_); }
+
+    std::vector<std::string> collect() {
+        std::vector<std::string> datagrams;
+        std::vector<char> buffer(UDPDispatcher::UDPPacketMaximumSize + 1);
+        pollfd fd{socket_, POLLIN, 0};
+        while (::poll(&fd, 1, 200) > 0) {
+            auto received = ::recv(socket_, buffer.data(), buffer.size(), 0);
+            if (received <= 0) {
+                break;
+            }
+            // Notice: each datagram includes the terminating '\0'
+            datagrams.emplace_back(buffer.data(), static_cast<size_t>(received) - 1);
+        }
+        return datagrams;
+    }
+
+private:
+    int socket_;
+    uint16_t port_;
+};
+
+Options make_label(size_t i, size_t size = 8) {
+    return Options::options()
+        .with("command", "label")
+        .with("name", "label_" + std::to_string(i))
+        .with("value", std::string(size, 'x'));
+}
+
+CASE("test_batch__single_datagram_is_sent_for_batch_of_updates") {
+    LocalReceiver receiver;
+    ClientCfg cfg = make_udp_cfg(receiver.port(), "1");
+
+    constexpr size_t count = 10;
+
+    // Individual updates: one datagram (i.e. one send syscall) per update
+    {
+        for (size_t i = 0; i != count; ++i) {
+            UDPDispatcher dispatcher(cfg);
+            auto request  = Request::make_request<UpdateNodeAttribute>(make_environment(), make_label(i));
+            auto response = dispatcher.call_dispatch(request);
+        }
+        EXPECT(receiver.collect().size() == count);
+    }
+
+    // Batched updates: all updates packed in a single datagram (i.e. a single send syscall)
+    {
+        UpdateNodeAttributes::attributes_t attributes;
+        for (size_t i = 0; i != count; ++i) {
+            attributes.push_back(make_label(i));
+        }
+
+        UDPDispatcher dispatcher(cfg);
+        auto request  = Request::make_request<UpdateNodeAttributes>(make_environment(), attributes);
+        auto response = dispatcher.call_dispatch(request);
+
+        auto datagrams = receiver.collect();
+        EXPECT(datagrams.size() == 1);
+
+        eckit::Value value = eckit::JSONParser::decodeString(datagrams.front());
+        EXPECT(value["payload"].size() == count);
+        EXPECT(value["payload"][0]["name"].as<std::string>() == "label_0");
+        EXPECT(value["payload"][count - 1]["name"].as<std::string>() == "label_9");
+    }
+}
+
+CASE("test_batch__datagrams_are_kept_under_maximum_packet_size") {
+    ClientCfg cfg = ClientCfg::make_empty();
+    UDPDispatcher dispatcher(cfg);
+
+    constexpr size_t count = 50;
+    constexpr size_t size  = 4'000;
+
+    UpdateNodeAttributes::attributes_t attributes;
+    for (size_t i = 0; i != count; ++i) {
+        attributes.push_back(make_label(i, size));
+    }
+
+    auto datagrams = dispatcher.format_request(UpdateNodeAttributes(make_environment(), attributes));
+    EXPECT(datagrams.size() == 4);
+
+    size_t total = 0;
+    for (const auto& datagram : datagrams) {
+        EXPECT(datagram.size() + 1 <= UDPDispatcher::UDPPacketMaximumSize);
+        total += eckit::JSONParser::decodeString(datagram)["payload"].size();
+    }
+    EXPECT(total == count);
+}
+
+CASE("test_batch__single_update_batch_uses_individual_format") {
+    ClientCfg cfg = ClientCfg::make_empty();
+    UDPDispatcher dispatcher(cfg);
+
+    auto datagrams = dispatcher.format_request(UpdateNodeAttributes(make_environment(), {make_label(0)}));
+    EXPECT(datagrams.size() == 1);
+    EXPECT(datagrams.front() == dispatcher.format_request(UpdateNodeAttribute(make_environment(), make_label(0))));
+}
+
+CASE("test_batch__commit_fails_without_begin") {
+    EXPECT(ecflow_light_batch_commit() == EXIT_FAILURE);
+
+    EXPECT(ecflow_light_batch_begin() == EXIT_SUCCESS);
+    EXPECT(ecflow_light_batch_begin() == EXIT_SUCCESS);
+    // Nested commit, with no updates collected
+    EXPECT(ecflow_light_batch_commit() == EXIT_SUCCESS);
+    EXPECT(ecflow_light_batch_commit() == EXIT_SUCCESS);
+
+    EXPECT(ecflow_light_batch_commit() == EXIT_FAILURE);
+}
+
+}  // namespace ecflow::light::testing
+
+int main(int argc, char** argv) {
+    return eckit::testing::run_tests(argc, argv);
+}
@@ -0,0 +1,138 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <eckit/testing/Test.h>
+
+#include "TestFixtures.h"
+#include "ecflow/light/ClientAPI.h"
+#include "ecflow/light/Filesystem.h"
+
+namespace ecflow::light::testing {
+
+/**
+ * FakeClient is a shell script, standing in for ecflow_client, that records each invocation (i.e. the
+ * arguments, separated by '|') as a line in a log file.
+ */
+class FakeClient {
+public:
+    explicit FakeClient(const std::string& delay = "0") : directory_{make_directory()} {
+        std::ofstream ofs(executable());
+        ofs << "#!/bin/sh\n";
+        ofs << "printf '%s|%s\\n' \"$1\" \"$2\" >> '" << log().string() << "'\n";
+        ofs << "sleep " << delay << "\n";
+        ofs.close();
+        fs::permissions(executable(), fs::perms::owner_all);
+    }
+    ~FakeClient() { fs::remove_all(directory_); }
+
+    [[nodiscard]] fs::path executable() const { return directory_ / "ecflow_client"; }
+    [[nodiscard]] fs::path log() const { return directory_ / "invocations.log"; }
+
+    [[nodiscard]] std::vector<std::string> invocations() const {
+        std::vector<std::string> lines;
+        std::ifstream ifs(log());
+        for (std::string line; std::getline(ifs, line);) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+private:
+    static fs::path make_directory() {
+        std::string pattern = (fs::temp_directory_path() / "ecflow_light_cli_XXXXXX").string();
+        return fs::path{::mkdtemp(pattern.data())};
+    }
+
+    fs::path directory_;
+};
+
+ClientCfg make_cfg(const FakeClient& fake, size_t max_children) {
+    ClientCfg cfg    = ClientCfg::make_cfg(ClientCfg::KindCLI, ClientCfg::ProtocolTCP, "", "", "1.0");
+    cfg.executable   = fake.executable().string();
+    cfg.max_children = max_children;
+    return cfg;
+}
+
+Request make_update(const std::string& command, const std::string& name, const std::string& value) {
+    auto options = Options::options().with("command", command).with("name", name).with("value", value);
+    return Request::make_request<UpdateNodeAttribute>(make_environment(), options);
+}
+
+CASE("test_cli_client__arguments_are_passed_without_shell_interpretation") {
+    FakeClient fake;
+    {
+        CommandLineTCPClientAPI client(make_cfg(fake, 4), make_environment());
+        auto response = client.process(make_update("label", "message", R"(it's "quoted" & $(not) expanded)"));
+        EXPECT(response.response == "OK");
+    }
+
+    auto invocations = fake.invocations();
+    EXPECT(invocations.size() == 1);
+    EXPECT(invocations.front() == R"(--label=message|it's "quoted" & $(not) expanded)");
+}
+
+CASE("test_cli_client__running_children_are_capped_and_reaped") {
+    FakeClient fake("0.05");
+
+    constexpr size_t count        = 12;
+    constexpr size_t max_children = 3;
+    {
+        Spawner spawner(fake.executable().string(), max_children);
+        for (size_t i = 0; i != count; ++i) {
+            spawner.spawn({"--meter=progress", std::to_string(i)});
+            EXPECT(spawner.running() <= max_children);
+        }
+        spawner.wait_all();
+        EXPECT(spawner.running() == 0);
+        EXPECT(spawner.spawned() == count);
+        EXPECT(spawner.failed() == 0);
+    }
+
+    EXPECT(fake.invocations().size() == count);
+}
+
+CASE("test_cli_client__batch_only_sends_latest_value_of_each_attribute") {
+    FakeClient fake;
+
+    UpdateNodeAttributes::attributes_t attributes;
+    for (int i = 0; i != 10; ++i) {
+        attributes.push_back(
+            Options::options().with("command", "meter").with("name", "progress").with("value", std::to_string(i)));
+    }
+    attributes.push_back(Options::options().with("command", "label").with("name", "message").with("value", "done"));
+
+    {
+        CommandLineTCPClientAPI client(make_cfg(fake, 4), make_environment());
+        auto response = client.process(Request::make_request<UpdateNodeAttributes>(make_environment(), attributes));
+        EXPECT(response.response == "OK");
+    }
+
+    auto invocations = fake.invocations();
+    EXPECT(invocations.size() == 2);
+    EXPECT(std::find(std::begin(invocations), std::end(invocations), "--meter=progress|9") != std::end(invocations));
+    EXPECT(std::find(std::begin(invocations), std::end(invocations), "--label=message|done") != std::end(invocations));
+}
+
+CASE("test_cli_client__missing_executable_is_reported") {
+    Spawner spawner("/path/to/nowhere/ecflow_client", 1);
+    EXPECT_THROWS_AS(spawner.spawn({"--meter=progress", "1"}), UnableToSpawnProcess);
+}
+
+}  // namespace ecflow::light::testing
+
+int main(int argc, char** argv) {
+    return eckit::testing::run_tests(argc, argv);
+}
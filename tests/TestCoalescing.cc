@@ -0,0 +1,162 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <eckit/testing/Test.h>
+
+#include "LocalUDPDecoder.h"
+#include "TestFixtures.h"
+#include "ecflow/light/ClientAPI.h"
+
+namespace ecflow::light::testing {
+
+struct RecordingClientAPI : public ClientAPI {
+    // Flattens batches, so that each update is recorded individually
+    struct Recorder : public RequestDispatcher {
+        void dispatch_request(const UpdateNodeStatus& request) override { updates.push_back(request.as_string()); }
+        void dispatch_request(const UpdateNodeAttribute& request) override { updates.push_back(request.as_string()); }
+        void dispatch_request(const UpdateNodeAttributes& request) override {
+            for (const auto& attribute : request.attributes()) {
+                updates.push_back(UpdateNodeAttribute(request.shared_context(), attribute).as_string());
+            }
+        }
+
+        std::vector<std::string> updates;
+    };
+
+    Response process(const Request& request) const override {
+        std::scoped_lock lock(lock_);
+        ++requests;
+        request.dispatch(recorder);
+        return Response{"OK"};
+    }
+
+    std::vector<std::string> collected() const {
+        std::scoped_lock lock(lock_);
+        return recorder.updates;
+    }
+
+    mutable std::mutex lock_;
+    mutable size_t requests = 0;
+    mutable Recorder recorder;
+};
+
+Request make_attribute(const std::string& path, const std::string& command, const std::string& name,
+                       const std::string& value) {
+    Options options = Options::options().with("command", command).with("name", name).with("value", value);
+    return Request::make_request<UpdateNodeAttribute>(make_environment(path), options);
+}
+
+Request make_status(const std::string& path, const std::string& action) {
+    Options options = Options::options().with("action", action);
+    return Request::make_request<UpdateNodeStatus>(make_environment(path), options);
+}
+
+CASE("test_coalescing__keeps_only_newest_value_per_attribute") {
+    RecordingClientAPI target;
+    CoalescingCfg cfg{60'000};
+
+    {
+        CoalescingClientAPI client(cfg, target);
+        for (int i = 0; i != 100; ++i) {
+            auto response = client.process(make_attribute("/s/t", "meter", "step", std::to_string(i)));
+            EXPECT(response.response == "OK");
+        }
+        auto label = client.process(make_attribute("/s/t", "label", "step", "text"));
+        auto other = client.process(make_attribute("/s/u", "meter", "step", "7"));
+
+        EXPECT(target.collected().empty());
+        client.flush();
+
+        // Updates to the same node are forwarded in a single batch
+        EXPECT(target.requests == 2);
+
+        auto collected = target.collected();
+        EXPECT(collected.size() == 3);
+        EXPECT(collected[0] == make_attribute("/s/t", "meter", "step", "99").description());
+        EXPECT(collected[1] == make_attribute("/s/t", "label", "step", "text").description());
+        EXPECT(collected[2] == make_attribute("/s/u", "meter", "step", "7").description());
+    }
+}
+
+CASE("test_coalescing__status_acts_as_barrier") {
+    RecordingClientAPI target;
+    CoalescingCfg cfg{60'000};
+
+    CoalescingClientAPI client(cfg, target);
+    auto meter    = client.process(make_attribute("/s/t", "meter", "step", "1"));
+    auto complete = client.process(make_status("/s/t", "complete"));
+
+    EXPECT(target.requests == 2);
+
+    auto collected = target.collected();
+    EXPECT(collected.size() == 2);
+    EXPECT(collected[0] == make_attribute("/s/t", "meter", "step", "1").description());
+    EXPECT(collected[1] == make_status("/s/t", "complete").description());
+}
+
+CASE("test_coalescing__flushes_when_window_expires") {
+    RecordingClientAPI target;
+    CoalescingCfg cfg{10};
+
+    CoalescingClientAPI client(cfg, target);
+    auto meter = client.process(make_attribute("/s/t", "meter", "step", "1"));
+
+    for (int attempt = 0; attempt != 500 && target.collected().empty(); ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT(target.collected().size() == 1);
+}
+
+CASE("test_coalescing__flushes_pending_updates_on_destruction") {
+    RecordingClientAPI target;
+    CoalescingCfg cfg{60'000};
+
+    {
+        CoalescingClientAPI client(cfg, target);
+        auto event = client.process(make_attribute("/s/t", "event", "done", "1"));
+    }
+    EXPECT(target.collected().size() == 1);
+}
+
+CASE("test_coalescing__pending_updates_are_delivered_when_client_is_destroyed") {
+    LocalUDPDecoder decoder({"/s/t"}, {"step", "message"});
+    auto cfg = ClientCfg::make_cfg(ClientCfg::KindLibrary, ClientCfg::ProtocolUDP, "127.0.0.1", decoder.port(), "2.0");
+
+    {
+        LibraryUDPClientAPI target(cfg, make_environment("/s/t"));
+        CoalescingClientAPI client(CoalescingCfg{60'000}, target);
+        // Notice: the requests (and thus the contexts of the task) are released as soon as processed, and only the
+        //         pending updates keep the contexts (and their serialised fragments) alive until the final flush
+        for (int i = 1; i <= 5; ++i) {
+            auto meter = client.process(make_attribute("/s/t", "meter", "step", std::to_string(i)));
+        }
+        auto label = client.process(make_attribute("/s/t", "label", "message", "done"));
+    }
+
+    auto updates = decoder.collect();
+    EXPECT(decoder.invalid() == 0);
+    EXPECT(updates.size() == 2);
+    EXPECT(updates[0].path == "/s/t");
+    EXPECT(updates[0].rid == "12345");
+    EXPECT(updates[0].name == "step");
+    EXPECT(updates[0].value == "5");
+    EXPECT(updates[1].name == "message");
+    EXPECT(updates[1].value == "done");
+}
+
+}  // namespace ecflow::light::testing
+
+int main(int argc, char** argv) {
+    return eckit::testing::run_tests(argc, argv);
+}
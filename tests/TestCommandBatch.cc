@@ -0,0 +1,151 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <eckit/testing/Test.h>
+
+#include "ecflow/light/CommandBatch.h"
+
+namespace ecflow::light::testing {
+
+struct ClientFailure : public eckit::Exception {
+    ClientFailure(const std::string& msg, const eckit::CodeLocation& loc) : eckit::Exception(msg, loc) {}
+};
+
+/**
+ * Recorder describes each request, as "<action>" for status updates, or "<command>:<name>=<value>" for each
+ * attribute (with the attributes of a batch separated by ',')
+ */
+struct Recorder : public RequestDispatcher {
+    void dispatch_request(const UpdateNodeStatus& request) override {
+        description = std::string(request.options().get(Field::Action));
+    }
+    void dispatch_request(const UpdateNodeAttribute& request) override { description = describe(request.options()); }
+    void dispatch_request(const UpdateNodeAttributes& request) override {
+        for (const auto& options : request.attributes()) {
+            description += (description.empty() ? "" : ",") + describe(options);
+        }
+    }
+
+    static std::string describe(const Options& options) {
+        auto value = options.find(Field::Value);
+        if (!value) {
+            value = options.find(Field::QueueAction);
+        }
+        return std::string(options.get(Field::Command)) + ":" + std::string(options.get(Field::Name)) + "=" +
+               std::string(value.value_or(""));
+    }
+
+    std::string description;
+};
+
+/**
+ * RecordingClientAPI records the description of each request, and fails requests updating the 'broken' attribute
+ */
+class RecordingClientAPI : public ClientAPI {
+public:
+    [[nodiscard]] Response process(const Request& request) const override {
+        Recorder recorder;
+        request.dispatch(recorder);
+        requests.push_back(recorder.description);
+        if (recorder.description.find(":broken=") != std::string::npos) {
+            ECFLOW_LIGHT_THROW(ClientFailure, Message("Unable to update 'broken'"));
+        }
+        return Response{"OK"};
+    }
+
+    mutable std::vector<std::string> requests;
+};
+
+std::shared_ptr<const TaskContext> make_context() {
+    return TaskContext::make(Environment::an_environment().with("ECF_NAME", "/path/to/task"));
+}
+
+CASE("test_command_batch__lines_are_tokenized") {
+    EXPECT(tokenize("meter progress 10") == (std::vector<std::string>{"meter", "progress", "10"}));
+    EXPECT(tokenize("  label  info \"two words\"  ") == (std::vector<std::string>{"label", "info", "two words"}));
+    EXPECT(tokenize(R"(label info "say \"hi\"")") == (std::vector<std::string>{"label", "info", R"(say "hi")"}));
+    EXPECT(tokenize("label info 'a \\ b'") == (std::vector<std::string>{"label", "info", "a \\ b"}));
+    EXPECT(tokenize("label info pre\"fix\"") == (std::vector<std::string>{"label", "info", "prefix"}));
+    EXPECT(tokenize("event done # a comment") == (std::vector<std::string>{"event", "done"}));
+    EXPECT(tokenize("label info \"#not a comment\"") ==
+           (std::vector<std::string>{"label", "info", "#not a comment"}));
+    EXPECT(tokenize("   ").empty());
+    EXPECT(tokenize("# only a comment").empty());
+    EXPECT_THROWS_AS(tokenize("label info \"unterminated"), InvalidCommand);
+}
+
+CASE("test_command_batch__attribute_updates_are_sent_together_and_coalesced") {
+    RecordingClientAPI client;
+    std::ostringstream output;
+    CommandBatch batch{client, make_context(), output};
+
+    std::istringstream input(
+        "meter progress 1\n"
+        "label info \"step one\"\n"
+        "\n"
+        "# comment\n"
+        "meter progress 2\n"
+        "--event done\n"
+        "complete\n"
+        "event done clear\n");
+
+    EXPECT(batch.process(input) == 0);
+    EXPECT(batch.processed() == 6);
+    EXPECT(client.requests == (std::vector<std::string>{
+                                  "meter:progress=2,label:info=step one,event:done=1",
+                                  "complete",
+                                  "event:done=0",
+                              }));
+}
+
+CASE("test_command_batch__failures_are_reported_per_line") {
+    RecordingClientAPI client;
+    std::ostringstream output;
+    CommandBatch batch{client, make_context(), output};
+
+    std::istringstream input(
+        "meter progress ten\n"
+        "unknown command\n"
+        "event done maybe\n"
+        "label broken value\n"
+        "meter progress 1\n"
+        "init\n"
+        "abort \"out of memory\"\n");
+
+    // Notice: the label and meter updates are sent (and fail) together
+    EXPECT(batch.process(input) == 6);
+    EXPECT(batch.processed() == 7);
+    EXPECT(client.requests == (std::vector<std::string>{"label:broken=value,meter:progress=1", "abort"}));
+}
+
+CASE("test_command_batch__large_batches_are_split") {
+    RecordingClientAPI client;
+    std::ostringstream output;
+    CommandBatch batch{client, make_context(), output};
+
+    std::ostringstream commands;
+    for (size_t i = 0; i < CommandBatch::MaximumBatch + 1; ++i) {
+        commands << "meter meter_" << i << " " << i << "\n";
+    }
+    std::istringstream input(commands.str());
+
+    EXPECT(batch.process(input) == 0);
+    EXPECT(client.requests.size() == 2);
+}
+
+}  // namespace ecflow::light::testing
+
+int main(int argc, char** argv) {
+    return eckit::testing::run_tests(argc, argv);
+}
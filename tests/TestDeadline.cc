@@ -0,0 +1,137 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+
+#include <eckit/testing/Test.h>
+
+#include "LocalHTTPServer.h"
+#include "ecflow/light/ClientAPI.h"
+#include "ecflow/light/Deadline.h"
+#include "ecflow/light/Spawner.h"
+#include "ecflow/light/TinyREST.h"
+
+namespace ecflow::light::testing {
+
+using namespace std::chrono_literals;
+
+template <typename F>
+std::chrono::milliseconds measure(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+}
+
+/**
+ * SlowClientAPI takes 'delay' to process each request, and then either responds or fails
+ */
+class SlowClientAPI : public ClientAPI {
+public:
+    SlowClientAPI(std::chrono::milliseconds delay, bool fail) : delay_{delay}, fail_{fail} {}
+
+    [[nodiscard]] Response process(const Request& request [[maybe_unused]]) const override {
+        std::this_thread::sleep_for(delay_);
+        if (fail_) {
+            ECFLOW_LIGHT_THROW(UnreachableServer, Message("Server is down"));
+        }
+        return Response{"OK"};
+    }
+
+private:
+    std::chrono::milliseconds delay_;
+    bool fail_;
+};
+
+Request make_update(const std::string& value) {
+    auto environment = Environment::an_environment().with("ECF_NAME", "/path/to/task");
+    auto options     = Options::options().with("command", "meter").with("name", "progress").with("value", value);
+    return Request::make_request<UpdateNodeAttribute>(environment, options);
+}
+
+net::Request<net::Method::PUT> make_request(const std::string& body) {
+    net::Request<net::Method::PUT> request{net::Target{"/v1/suites/path/to/task/attributes"}};
+    request.add_body(net::Body{body});
+    return request;
+}
+
+CASE("test_deadline__nested_scopes_only_bring_the_deadline_closer") {
+    EXPECT(!Deadline::current());
+    EXPECT(!Deadline::remaining());
+    {
+        Deadline::Scope outer{100ms};
+        auto deadline = Deadline::current();
+        EXPECT(deadline.has_value());
+        {
+            Deadline::Scope inner{10s};
+            EXPECT(Deadline::current() == deadline);
+        }
+        {
+            Deadline::Scope inner{0ms};
+            EXPECT(Deadline::expired());
+            EXPECT(Deadline::remaining() == 0ms);
+            EXPECT_THROWS_AS(Deadline::check("testing"), DeadlineExceeded);
+        }
+        EXPECT(Deadline::current() == deadline);
+        EXPECT(!Deadline::expired());
+    }
+    EXPECT(!Deadline::current());
+}
+
+CASE("test_deadline__http_request_and_retries_are_bounded_by_the_deadline") {
+    LocalHTTPServer server(1s);
+    auto host = net::Host::with_scheme(net::Host::SchemeHTTP, "127.0.0.1", server.port());
+
+    net::TinyRESTClient client;
+    auto elapsed = measure([&]() {
+        Deadline::Scope deadline{100ms};
+        auto response = client.handle(host, make_request("{}"));
+        EXPECT(response.header().status() == net::Status::Code::SERVICE_UNAVAILABLE);
+    });
+    EXPECT(elapsed >= 100ms);
+    EXPECT(elapsed < 800ms);
+
+    // Notice: a request cut short by its deadline doesn't count against the circuit breaker of the host
+    EXPECT(client.circuit_state(host) == net::CircuitBreaker::State::Closed);
+}
+
+CASE("test_deadline__fanout_waits_for_secondary_clients_only_until_the_deadline") {
+    CompositeClientAPI composite{FanOutCfg::CompletionWaitAll};
+    composite.add(std::make_unique<SlowClientAPI>(0ms, true));
+    composite.add(std::make_unique<SlowClientAPI>(500ms, false));
+
+    auto elapsed = measure([&]() {
+        Deadline::Scope deadline{50ms};
+        EXPECT_THROWS_AS(std::ignore = composite.process(make_update("1")), DeadlineExceeded);
+    });
+    EXPECT(elapsed < 400ms);
+}
+
+CASE("test_deadline__spawning_waits_for_a_running_child_only_until_the_deadline") {
+    Spawner spawner{"sleep", 1};
+    spawner.spawn({"1"});
+
+    auto elapsed = measure([&]() {
+        Deadline::Scope deadline{50ms};
+        EXPECT_THROWS_AS(spawner.spawn({"1"}), DeadlineExceeded);
+    });
+    EXPECT(elapsed >= 50ms);
+    EXPECT(elapsed < 500ms);
+    EXPECT(spawner.spawned() == 1);
+}
+
+}  // namespace ecflow::light::testing
+
+int main(int argc, char** argv) {
+    return eckit::testing::run_tests(argc, argv);
+}
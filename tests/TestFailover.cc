@@ -0,0 +1,173 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+
+#include <eckit/testing/Test.h>
+
+#include "ecflow/light/ClientAPI.h"
+
+namespace ecflow::light::testing {
+
+using namespace std::chrono_literals;
+
+struct ClientFailure : public eckit::Exception {
+    ClientFailure(const std::string& msg, const eckit::CodeLocation& loc) : eckit::Exception(msg, loc) {}
+};
+
+/**
+ * State allows to control the behaviour of a mock client, after it has been handed over to the router
+ */
+struct State {
+    std::atomic<bool> fail{false};
+    std::atomic<bool> drop{false};
+    std::atomic<int> delay_ms{0};
+    std::atomic<int> processed{0};
+};
+
+/**
+ * MockClientAPI processes each request according to the shared state, and responds with its name
+ */
+class MockClientAPI : public ClientAPI {
+public:
+    MockClientAPI(std::string name, std::shared_ptr<State> state) : name_{std::move(name)}, state_{std::move(state)} {}
+
+    [[nodiscard]] Response process(const Request& request [[maybe_unused]]) const override {
+        state_->processed += 1;
+        std::this_thread::sleep_for(std::chrono::milliseconds(state_->delay_ms.load()));
+        if (state_->fail) {
+            ECFLOW_LIGHT_THROW(ClientFailure, Message("Client '", name_, "' failed"));
+        }
+        if (state_->drop) {
+            return Response{"DROPPED", Response::Outcome::Dropped};
+        }
+        return Response{name_};
+    }
+
+private:
+    std::string name_;
+    std::shared_ptr<State> state_;
+};
+
+struct Failover {
+    explicit Failover(uint32_t slow_ms = 0, uint32_t probe_ms = 5000) : router{make_cfg(slow_ms, probe_ms)}, states{} {}
+
+    Failover& with(std::string name) {
+        auto state = std::make_shared<State>();
+        states.push_back(state);
+        router.add(std::make_unique<MockClientAPI>(std::move(name), std::move(state)));
+        return *this;
+    }
+
+    std::string send() { return router.process(make_update()).response; }
+
+    static RoutingCfg make_cfg(uint32_t slow_ms, uint32_t probe_ms) {
+        RoutingCfg cfg;
+        cfg.mode     = RoutingCfg::ModeFailover;
+        cfg.slow_ms  = slow_ms;
+        cfg.probe_ms = probe_ms;
+        return cfg;
+    }
+
+    static Request make_update() {
+        auto environment = Environment::an_environment().with("ECF_NAME", "/path/to/task");
+        auto options     = Options::options().with("command", "meter").with("name", "progress").with("value", "1");
+        return Request::make_request<UpdateNodeAttribute>(environment, options);
+    }
+
+    FailoverClientAPI router;
+    std::vector<std::shared_ptr<State>> states;
+};
+
+CASE("test_failover__healthy_primary_handles_all_requests") {
+    Failover failover;
+    failover.with("primary").with("secondary");
+
+    for (int i = 0; i < 10; ++i) {
+        EXPECT(failover.send() == "primary");
+    }
+    EXPECT(failover.states[0]->processed == 10);
+    EXPECT(failover.states[1]->processed == 0);
+}
+
+CASE("test_failover__failed_or_dropped_requests_are_sent_to_the_secondary") {
+    Failover failover;
+    failover.with("primary").with("secondary");
+
+    failover.states[0]->drop = true;
+    EXPECT(failover.send() == "secondary");
+
+    failover.states[1]->drop = true;
+    EXPECT(failover.send() == "DROPPED");
+
+    failover.states[1]->fail = true;
+    EXPECT_THROWS_AS(std::ignore = failover.send(), ClientFailure);
+}
+
+CASE("test_failover__only_the_dropped_outcome_moves_requests_to_the_secondary") {
+    Failover failover;
+    failover.with("DROPPED").with("secondary");
+
+    // Notice: the contents of the response are never interpreted as the outcome of the delivery
+    EXPECT(failover.send() == "DROPPED");
+    EXPECT(failover.states[1]->processed == 0);
+}
+
+CASE("test_failover__unhealthy_primary_is_skipped_until_successfully_probed") {
+    Failover failover(0, 100);
+    failover.with("primary").with("secondary");
+
+    failover.states[0]->fail = true;
+    while (failover.router.health()[0].healthy(Failover::make_cfg(0, 100))) {
+        EXPECT(failover.send() == "secondary");
+    }
+    int attempts = failover.states[0]->processed;
+
+    // While unhealthy, the primary is not tried (until the probe is due)
+    EXPECT(failover.send() == "secondary");
+    EXPECT(failover.states[0]->processed == attempts);
+
+    // Once recovered, the next probe restores the primary
+    failover.states[0]->fail = false;
+    std::this_thread::sleep_for(150ms);
+    EXPECT(failover.send() == "primary");
+    EXPECT(failover.router.health()[0].success_rate == 1.0);
+    EXPECT(failover.send() == "primary");
+}
+
+CASE("test_failover__slow_primary_is_replaced_by_faster_secondary") {
+    Failover failover(50, 60000);
+    failover.with("primary").with("secondary");
+
+    failover.states[0]->delay_ms = 100;
+    for (int i = 0; i < 10; ++i) {
+        std::ignore = failover.send();
+    }
+    int attempts = failover.states[0]->processed;
+    EXPECT(attempts < 10);
+
+    EXPECT(failover.send() == "secondary");
+    EXPECT(failover.states[0]->processed == attempts);
+
+    auto health = failover.router.health();
+    EXPECT(health[0].latency_ms > 50);
+    EXPECT(health[1].latency_ms < 50);
+}
+
+}  // namespace ecflow::light::testing
+
+int main(int argc, char** argv) {
+    return eckit::testing::run_tests(argc, argv);
+}
@@ -0,0 +1,198 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <eckit/testing/Test.h>
+
+#include "ecflow/light/ClientAPI.h"
+
+namespace ecflow::light::testing {
+
+struct ClientFailure : public eckit::Exception {
+    ClientFailure(const std::string& msg, const eckit::CodeLocation& loc) : eckit::Exception(msg, loc) {}
+};
+
+/**
+ * Record keeps the values received by a client, and can outlive the client itself
+ */
+class Record {
+public:
+    void add(const std::string& value) {
+        std::scoped_lock lock(lock_);
+        values_.push_back(value);
+    }
+
+    [[nodiscard]] std::vector<std::string> values() const {
+        std::scoped_lock lock(lock_);
+        return values_;
+    }
+
+private:
+    mutable std::mutex lock_;
+    std::vector<std::string> values_;
+};
+
+/**
+ * MockClientAPI takes 'delay' to process each request, and then either responds with its name or fails
+ */
+class MockClientAPI : public ClientAPI {
+public:
+    MockClientAPI(std::string name, std::chrono::milliseconds delay, bool fail) :
+        name_{std::move(name)}, delay_{delay}, fail_{fail}, record_{std::make_shared<Record>()} {}
+
+    [[nodiscard]] Response process(const Request& request) const override {
+        std::this_thread::sleep_for(delay_);
+        record_->add(request.get_option("value"));
+        if (fail_) {
+            ECFLOW_LIGHT_THROW(ClientFailure, Message("Client '", name_, "' failed"));
+        }
+        return Response{name_};
+    }
+
+    [[nodiscard]] std::shared_ptr<const Record> record() const { return record_; }
+
+private:
+    std::string name_;
+    std::chrono::milliseconds delay_;
+    bool fail_;
+    std::shared_ptr<Record> record_;
+};
+
+struct FanOut {
+    explicit FanOut(const std::string& completion) : composite{completion}, clients{} {}
+
+    FanOut& with(std::string name, std::chrono::milliseconds delay, bool fail = false) {
+        auto client = std::make_unique<MockClientAPI>(std::move(name), delay, fail);
+        clients.push_back(client->record());
+        composite.add(std::move(client));
+        return *this;
+    }
+
+    CompositeClientAPI composite;
+    std::vector<std::shared_ptr<const Record>> clients;
+};
+
+Request make_update(const std::string& value) {
+    auto environment = Environment::an_environment().with("ECF_NAME", "/path/to/task");
+    auto options     = Options::options().with("command", "meter").with("name", "progress").with("value", value);
+    return Request::make_request<UpdateNodeAttribute>(environment, options);
+}
+
+template <typename F>
+std::chrono::milliseconds measure(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+}
+
+using namespace std::chrono_literals;
+
+CASE("test_fanout__wait_all_processes_clients_concurrently") {
+    FanOut fanout(FanOutCfg::CompletionWaitAll);
+    fanout.with("udp", 0ms).with("cli_1", 200ms).with("cli_2", 200ms);
+
+    Response response;
+    auto elapsed = measure([&]() { response = fanout.composite.process(make_update("1")); });
+
+    EXPECT(response.response == "udp");
+    EXPECT(elapsed >= 200ms);
+    EXPECT(elapsed < 390ms);
+    for (const auto& client : fanout.clients) {
+        EXPECT(client->values().size() == 1);
+    }
+}
+
+CASE("test_fanout__fire_and_forget_is_not_delayed_by_secondary_clients") {
+    FanOut fanout(FanOutCfg::CompletionFireAndForget);
+    fanout.with("udp", 0ms).with("cli", 200ms);
+
+    Response response;
+    auto elapsed = measure([&]() { response = fanout.composite.process(make_update("1")); });
+
+    EXPECT(response.response == "udp");
+    EXPECT(elapsed < 150ms);
+}
+
+CASE("test_fanout__fire_and_forget_requests_are_processed_before_destruction") {
+    std::shared_ptr<const Record> secondary;
+    {
+        FanOut fanout(FanOutCfg::CompletionFireAndForget);
+        fanout.with("udp", 0ms).with("cli", 20ms);
+        secondary = fanout.clients.back();
+
+        for (int i = 0; i != 5; ++i) {
+            std::ignore = fanout.composite.process(make_update(std::to_string(i)));
+        }
+        EXPECT(secondary->values().size() < 5);
+    }
+    EXPECT(secondary->values() == std::vector<std::string>({"0", "1", "2", "3", "4"}));
+}
+
+CASE("test_fanout__first_success_returns_earliest_success") {
+    FanOut fanout(FanOutCfg::CompletionFirstSuccess);
+    fanout.with("http", 0ms, true).with("udp", 10ms).with("cli", 300ms);
+
+    Response response;
+    auto elapsed = measure([&]() { response = fanout.composite.process(make_update("1")); });
+
+    EXPECT(response.response == "udp");
+    EXPECT(elapsed < 250ms);
+}
+
+CASE("test_fanout__response_merges_outcomes_of_all_clients") {
+    {
+        FanOut fanout(FanOutCfg::CompletionWaitAll);
+        fanout.with("http", 0ms, true).with("udp", 10ms).with("cli", 20ms);
+        // The first successful client, in configuration order, provides the response
+        EXPECT(fanout.composite.process(make_update("1")).response == "udp");
+    }
+    {
+        FanOut fanout(FanOutCfg::CompletionWaitAll);
+        fanout.with("http", 0ms, true).with("udp", 10ms, true);
+        EXPECT_THROWS_AS(std::ignore = fanout.composite.process(make_update("1")), ClientFailure);
+    }
+    {
+        FanOut fanout(FanOutCfg::CompletionFirstSuccess);
+        fanout.with("http", 0ms, true).with("udp", 10ms, true);
+        EXPECT_THROWS_AS(std::ignore = fanout.composite.process(make_update("1")), ClientFailure);
+    }
+}
+
+CASE("test_fanout__each_client_receives_requests_in_order") {
+    FanOut fanout(FanOutCfg::CompletionFirstSuccess);
+    fanout.with("udp", 0ms).with("cli", 1ms);
+
+    std::vector<std::string> expected;
+    for (int i = 0; i != 50; ++i) {
+        expected.push_back(std::to_string(i));
+        std::ignore = fanout.composite.process(make_update(expected.back()));
+    }
+    EXPECT(fanout.clients.front()->values() == expected);
+
+    // Wait for the secondary client to catch up
+    auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (fanout.clients.back()->values().size() < expected.size() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(5ms);
+    }
+    EXPECT(fanout.clients.back()->values() == expected);
+}
+
+}  // namespace ecflow::light::testing
+
+int main(int argc, char** argv) {
+    return eckit::testing::run_tests(argc, argv);
+}
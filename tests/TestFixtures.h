@@ -0,0 +1,41 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#ifndef ECFLOW_LIGHT_TESTS_TESTFIXTURES_H
+#define ECFLOW_LIGHT_TESTS_TESTFIXTURES_H
+
+#include <string>
+
+#include "ecflow/light/Configuration.h"
+#include "ecflow/light/Environment.h"
+
+namespace ecflow::light::testing {
+
+/**
+ * Create the environment of a task, with all the variables required to send updates
+ */
+inline Environment make_environment(const std::string& path = "/suite/family/task") {
+    return Environment::an_environment()
+        .with("ECF_NAME", path)
+        .with("ECF_PASS", "qwerty")
+        .with("ECF_TRYNO", "1")
+        .with("ECF_RID", "12345");
+}
+
+/**
+ * Create the configuration of a library client, sending datagrams to the given port on the loopback interface
+ */
+inline ClientCfg make_udp_cfg(const std::string& port, const std::string& version) {
+    return ClientCfg::make_cfg(ClientCfg::KindLibrary, ClientCfg::ProtocolUDP, "127.0.0.1", port, version);
+}
+
+}  // namespace ecflow::light::testing
+
+#endif
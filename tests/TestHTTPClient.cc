@@ -0,0 +1,313 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <eckit/testing/Test.h>
+
+#include "LocalHTTPServer.h"
+#include "ecflow/light/Deadline.h"
+#include "ecflow/light/TinyREST.h"
+
+namespace ecflow::light::testing {
+
+net::Request<net::Method::PUT> make_request(const std::string& body) {
+    net::Request<net::Method::PUT> request{net::Target{"/v1/suites/path/to/task/attributes"}};
+    request.add_header_field(net::Field{"Content-Type", "application/json"});
+    request.add_body(net::Body{body});
+    return request;
+}
+
+CASE("test_http_client__connection_is_reused_across_requests") {
+    LocalHTTPServer server;
+    auto host = net::Host::with_scheme(net::Host::SchemeHTTP, "127.0.0.1", server.port());
+
+    net::TinyRESTClient client;
+    for (int i = 0; i != 10; ++i) {
+        std::string body = R"({"value":")" + std::to_string(i) + R"("})";
+        auto response    = client.handle(host, make_request(body));
+        EXPECT(response.header().status() == net::Status::Code::OK);
+        EXPECT(response.body().value() == body);
+    }
+
+    EXPECT(client.connections() == 1);
+    EXPECT(server.accepted() == 1);
+}
+
+CASE("test_http_client__response_headers_are_collected") {
+    LocalHTTPServer server;
+    auto host = net::Host::with_scheme(net::Host::SchemeHTTP, "127.0.0.1", server.port());
+
+    net::TinyRESTClient client;
+    auto response = client.handle(host, make_request("{}"));
+
+    const auto& fields = response.header().fields();
+    auto found         = std::find_if(std::begin(fields), std::end(fields),
+                                      [](const net::Field& field) { return field.name == "Content-Type"; });
+    EXPECT(found != std::end(fields));
+    EXPECT(found->value == "text/plain");
+}
+
+CASE("test_http_client__idle_connections_are_discarded_after_timeout") {
+    LocalHTTPServer server;
+    auto host = net::Host::with_scheme(net::Host::SchemeHTTP, "127.0.0.1", server.port());
+
+    net::TinyRESTClient client(std::chrono::seconds(0));
+    for (int i = 0; i != 3; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        auto response = client.handle(host, make_request("{}"));
+        EXPECT(response.header().status() == net::Status::Code::OK);
+    }
+
+    EXPECT(client.connections() == 3);
+}
+
+CASE("test_http_client__pipelined_requests_are_performed_concurrently") {
+    LocalHTTPServer server(std::chrono::milliseconds(50));
+    auto host = net::Host::with_scheme(net::Host::SchemeHTTP, "127.0.0.1", server.port());
+
+    constexpr size_t in_flight = 8;
+    net::TinyRESTClient client(net::TinyRESTClient::DefaultIdleTimeout, in_flight);
+    EXPECT(client.is_pipelined());
+
+    std::vector<std::future<net::Response>> responses;
+    for (size_t i = 0; i != in_flight; ++i) {
+        // Notice: each request uses a different key, thus no ordering is imposed
+        responses.push_back(client.submit(host, make_request(std::to_string(i)), "/path/to/task_" + std::to_string(i)));
+    }
+    for (size_t i = 0; i != in_flight; ++i) {
+        auto response = responses[i].get();
+        EXPECT(response.header().status() == net::Status::Code::OK);
+        EXPECT(response.body().value() == std::to_string(i));
+    }
+
+    EXPECT(server.max_pending() > 1);
+    EXPECT(server.max_pending() <= in_flight);
+}
+
+CASE("test_http_client__pipelined_requests_with_same_key_are_ordered") {
+    LocalHTTPServer server(std::chrono::milliseconds(5));
+    auto host = net::Host::with_scheme(net::Host::SchemeHTTP, "127.0.0.1", server.port());
+
+    net::TinyRESTClient client(net::TinyRESTClient::DefaultIdleTimeout, 8);
+
+    constexpr size_t count = 20;
+    std::vector<std::future<net::Response>> responses;
+    for (size_t i = 0; i != count; ++i) {
+        responses.push_back(client.submit(host, make_request(std::to_string(i)), "/path/to/task"));
+    }
+    responses.back().wait();
+
+    auto bodies = server.bodies();
+    EXPECT(bodies.size() == count);
+    for (size_t i = 0; i != bodies.size(); ++i) {
+        EXPECT(bodies[i] == std::to_string(i));
+    }
+    EXPECT(server.max_pending() == 1);
+}
+
+CASE("test_http_client__pending_requests_are_completed_on_destruction") {
+    LocalHTTPServer server(std::chrono::milliseconds(20));
+    auto host = net::Host::with_scheme(net::Host::SchemeHTTP, "127.0.0.1", server.port());
+
+    std::vector<std::future<net::Response>> responses;
+    {
+        net::TinyRESTClient client(net::TinyRESTClient::DefaultIdleTimeout, 4);
+        for (size_t i = 0; i != 10; ++i) {
+            responses.push_back(client.submit(host, make_request(std::to_string(i)), "/path/to/task"));
+        }
+    }
+
+    for (auto& response : responses) {
+        EXPECT(response.get().header().status() == net::Status::Code::OK);
+    }
+    EXPECT(server.bodies().size() == 10);
+}
+
+CASE("test_http_client__retry_backoff_grows_exponentially_with_jitter") {
+    net::RetryPolicy retry;
+    retry.base_backoff = std::chrono::milliseconds(100);
+    retry.max_backoff  = std::chrono::milliseconds(1000);
+    retry.jitter       = 0.0;
+
+    EXPECT(retry.backoff(1) == std::chrono::milliseconds(100));
+    EXPECT(retry.backoff(2) == std::chrono::milliseconds(200));
+    EXPECT(retry.backoff(3) == std::chrono::milliseconds(400));
+    EXPECT(retry.backoff(5) == std::chrono::milliseconds(1000));
+    EXPECT(retry.backoff(100) == std::chrono::milliseconds(1000));
+
+    retry.jitter = 0.5;
+    for (int i = 0; i != 100; ++i) {
+        auto delay = retry.backoff(2);
+        EXPECT(delay >= std::chrono::milliseconds(100));
+        EXPECT(delay <= std::chrono::milliseconds(200));
+    }
+}
+
+CASE("test_http_client__circuit_breaker_opens_after_consecutive_failures_and_probes_recovery") {
+    using State     = net::CircuitBreaker::State;
+    using Admission = net::CircuitBreaker::Admission;
+
+    net::CircuitBreakerPolicy policy;
+    policy.failure_threshold = 3;
+    policy.cooloff           = std::chrono::milliseconds(1000);
+    net::CircuitBreaker breaker(policy);
+
+    auto now = net::CircuitBreaker::clock_t::now();
+    breaker.record(false, now);
+    breaker.record(false, now);
+    breaker.record(true, now);
+    breaker.record(false, now);
+    breaker.record(false, now);
+    EXPECT(breaker.state() == State::Closed);
+    breaker.record(false, now);
+    EXPECT(breaker.state() == State::Open);
+
+    // While cooling off, requests are rejected
+    EXPECT(breaker.admit(now + std::chrono::milliseconds(999)) == Admission::Rejected);
+
+    // Afterwards, a single probe is allowed; a failed probe opens the circuit again
+    now += std::chrono::milliseconds(1000);
+    EXPECT(breaker.admit(now) == Admission::Probe);
+    EXPECT(breaker.admit(now) == Admission::Rejected);
+    breaker.record(false, now);
+    EXPECT(breaker.state() == State::Open);
+    EXPECT(breaker.admit(now + std::chrono::milliseconds(500)) == Admission::Rejected);
+
+    // ... while a successful probe closes the circuit
+    now += std::chrono::milliseconds(1000);
+    EXPECT(breaker.admit(now) == Admission::Probe);
+    breaker.record(true, now);
+    EXPECT(breaker.state() == State::Closed);
+    EXPECT(breaker.admit(now) == Admission::Allowed);
+}
+
+CASE("test_http_client__circuit_breaker_admits_another_probe_once_released") {
+    using Admission = net::CircuitBreaker::Admission;
+
+    net::CircuitBreakerPolicy policy;
+    policy.failure_threshold = 1;
+    policy.cooloff           = std::chrono::milliseconds(1000);
+    net::CircuitBreaker breaker(policy);
+
+    auto now = net::CircuitBreaker::clock_t::now();
+    breaker.record(false, now);
+
+    now += std::chrono::milliseconds(1000);
+    EXPECT(breaker.admit(now) == Admission::Probe);
+    EXPECT(breaker.admit(now) == Admission::Rejected);
+    breaker.release();
+    EXPECT(breaker.admit(now) == Admission::Probe);
+}
+
+/**
+ * SilentListener accepts connections on the given port (i.e. these are completed by the kernel), but never responds
+ */
+struct SilentListener {
+    explicit SilentListener(uint16_t port) : socket_{::socket(AF_INET, SOCK_STREAM, 0)} {
+        int enable = 1;
+        ::setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        sockaddr_in address{};
+        address.sin_family      = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port        = htons(port);
+        listening_ = ::bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 &&
+                     ::listen(socket_, 16) == 0;
+    }
+    ~SilentListener() { ::close(socket_); }
+
+    int socket_;
+    bool listening_ = false;
+};
+
+CASE("test_http_client__expired_probe_does_not_keep_circuit_open") {
+    for (size_t max_in_flight : {1, 4}) {
+        std::string port;
+        {
+            LocalHTTPServer server;
+            port = server.port();
+        }
+        auto host = net::Host::with_scheme(net::Host::SchemeHTTP, "127.0.0.1", port);
+
+        net::RetryPolicy retry;
+        retry.max_attempts = 1;
+        net::CircuitBreakerPolicy breaker;
+        breaker.failure_threshold = 1;
+        breaker.cooloff           = std::chrono::milliseconds(50);
+        net::TinyRESTClient client(net::TinyRESTClient::DefaultIdleTimeout, max_in_flight, retry, breaker);
+
+        auto perform = [&client, &host]() {
+            // Notice: requests are bounded by the deadline of the calling thread
+            Deadline::Scope scope{std::chrono::milliseconds(100)};
+            return client.submit(host, make_request("{}")).get();
+        };
+
+        // Connection refused, and thus the circuit opens
+        perform();
+        EXPECT(client.circuit_state(host) == net::CircuitBreaker::State::Open);
+
+        // Once cooled off, the probe is cut short by its deadline, as the host never responds
+        SilentListener listener{static_cast<uint16_t>(std::stoi(port))};
+        EXPECT(listener.listening_);
+        std::this_thread::sleep_for(std::chrono::milliseconds(60));
+        auto probe = perform();
+        EXPECT(probe.body().value().find("Circuit open") == std::string::npos);
+
+        // ... and yet, the next request is admitted to probe the host again
+        auto next = perform();
+        EXPECT(next.body().value().find("Circuit open") == std::string::npos);
+        EXPECT(client.circuit_state(host) == net::CircuitBreaker::State::HalfOpen);
+    }
+}
+
+CASE("test_http_client__requests_fail_fast_while_circuit_is_open") {
+    std::string port;
+    {
+        // Notice: once the server is gone, connections to its port are refused
+        LocalHTTPServer server;
+        port = server.port();
+    }
+    auto host = net::Host::with_scheme(net::Host::SchemeHTTP, "127.0.0.1", port);
+
+    net::RetryPolicy retry;
+    retry.max_attempts = 2;
+    retry.base_backoff = std::chrono::milliseconds(1);
+    net::CircuitBreakerPolicy breaker;
+    breaker.failure_threshold = 2;
+    breaker.cooloff           = std::chrono::milliseconds(60000);
+    net::TinyRESTClient client(net::TinyRESTClient::DefaultIdleTimeout, 1, retry, breaker);
+
+    for (int i = 0; i != 2; ++i) {
+        auto response = client.handle(host, make_request("{}"));
+        EXPECT(response.header().status() == net::Status::Code::SERVICE_UNAVAILABLE);
+    }
+    EXPECT(client.circuit_state(host) == net::CircuitBreaker::State::Open);
+    auto connections = client.connections();
+
+    auto response = client.handle(host, make_request("{}"));
+    EXPECT(response.header().status() == net::Status::Code::SERVICE_UNAVAILABLE);
+    EXPECT(response.body().value().find("Circuit open") != std::string::npos);
+    EXPECT(client.connections() == connections);
+}
+
+}  // namespace ecflow::light::testing
+
+int main(int argc, char** argv) {
+    return eckit::testing::run_tests(argc, argv);
+}
@@ -0,0 +1,128 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include <eckit/testing/Test.h>
+
+#include "ecflow/light/Dispatcher.h"
+#include "ecflow/light/JSON.h"
+
+namespace ecflow::light::testing {
+
+std::string as_json(std::string_view text) {
+    std::string buffer;
+    JSONWriter::append_string(buffer, text);
+    return buffer;
+}
+
+CASE("test_json__strings_are_escaped") {
+    EXPECT(as_json("") == R"("")");
+    EXPECT(as_json("plain text") == R"("plain text")");
+    EXPECT(as_json(R"(say "hello")") == R"("say \"hello\"")");
+    EXPECT(as_json(R"(C:\path)") == R"("C:\\path")");
+    EXPECT(as_json("line\nbreak\ttab\rreturn") == R"("line\nbreak\ttab\rreturn")");
+    EXPECT(as_json(std::string("\x01\x1f", 2)) == R"("\u0001\u001f")");
+    EXPECT(as_json(std::string("nul\0", 4)) == R"("nul\u0000")");
+    // Non-ASCII (i.e. UTF-8) characters are kept as-is
+    EXPECT(as_json("température: 20°C") == R"("température: 20°C")");
+}
+
+CASE("test_json__escapes_are_found_at_any_position") {
+    // Cover both the vectorised (16 characters at a time) and the remaining characters
+    for (size_t size : {1, 15, 16, 17, 31, 32, 33, 100}) {
+        for (size_t position = 0; position < size; ++position) {
+            std::string text(size, 'x');
+            text[position] = '"';
+            EXPECT(JSONWriter::find_escape(text) == position);
+
+            std::string expected = "\"" + std::string(position, 'x') + "\\\"" + std::string(size - position - 1, 'x') + "\"";
+            EXPECT(as_json(text) == expected);
+        }
+        EXPECT(JSONWriter::find_escape(std::string(size, 'x')) == size);
+        EXPECT(JSONWriter::find_escape(std::string(size, '\xC3')) == size);
+    }
+}
+
+CASE("test_json__values_are_separated") {
+    std::string buffer;
+    JSONWriter json(buffer);
+    json.begin_object()
+        .member("name", "value")
+        .member("number", int64_t{-42})
+        .key("array")
+        .begin_array()
+        .value(std::numeric_limits<int64_t>::max())
+        .value("text")
+        .begin_object()
+        .end_object()
+        .end_array()
+        .key("fragment")
+        .raw(R"({"a":1})")
+        .end_object();
+
+    EXPECT(buffer == R"({"name":"value","number":-42,"array":[9223372036854775807,"text",{}],"fragment":{"a":1}})");
+}
+
+CASE("test_json__thread_buffer_is_reused") {
+    std::string& buffer = JSONWriter::thread_buffer();
+    JSONWriter(buffer).begin_object().member("name", std::string(1024, 'x')).end_object();
+    const char* data = buffer.data();
+
+    std::string& reused = JSONWriter::thread_buffer();
+    EXPECT(&reused == &buffer);
+    EXPECT(reused.empty());
+    JSONWriter(reused).begin_object().member("name", "value").end_object();
+    EXPECT(reused.data() == data);
+}
+
+CASE("test_json__udp_request_with_special_characters_is_valid") {
+    auto environment = Environment::an_environment()
+                           .with("ECF_NAME", "/path/to/task")
+                           .with("ECF_PASS", "qw\"erty")
+                           .with("ECF_TRYNO", "1")
+                           .with("ECF_RID", "12345");
+    auto options =
+        Options::options().with("command", "label").with("name", "message").with("value", "line 1\nline \"2\"");
+
+    ClientCfg cfg = ClientCfg::make_cfg(ClientCfg::KindLibrary, ClientCfg::ProtocolUDP, "localhost", "0", "1.0");
+    UDPDispatcher dispatcher(cfg);
+    auto contents = dispatcher.format_request(UpdateNodeAttribute(environment, options));
+
+    EXPECT(
+        contents ==
+        R"({"method":"put","version":"1.0","header":{"task_rid":"12345","task_password":"qw\"erty","task_try_no":1},"payload":{"command":"label","path":"/path/to/task","name":"message","value":"line 1\nline \"2\""}})");
+}
+
+CASE("test_json__non_numeric_try_number_is_written_as_string") {
+    // Notice: characters beyond ASCII (i.e. negative, when char is signed) are never taken as digits
+    for (std::string try_no : {"1a", "\xE9", "1\xB2"}) {
+        auto environment = Environment::an_environment()
+                               .with("ECF_NAME", "/path/to/task")
+                               .with("ECF_PASS", "qwerty")
+                               .with("ECF_TRYNO", try_no)
+                               .with("ECF_RID", "12345");
+        auto options = Options::options().with("command", "event").with("name", "done").with("value", "1");
+
+        ClientCfg cfg = ClientCfg::make_cfg(ClientCfg::KindLibrary, ClientCfg::ProtocolUDP, "localhost", "0", "1.0");
+        UDPDispatcher dispatcher(cfg);
+        auto contents = dispatcher.format_request(UpdateNodeAttribute(environment, options));
+
+        EXPECT(contents.find(R"("task_try_no":")" + try_no + "\"") != std::string::npos);
+    }
+}
+
+}  // namespace ecflow::light::testing
+
+int main(int argc, char** argv) {
+    return eckit::testing::run_tests(argc, argv);
+}
@@ -0,0 +1,150 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <eckit/testing/Test.h>
+
+#include "ecflow/light/LogFollower.h"
+
+namespace ecflow::light::testing {
+
+/**
+ * Recorder describes each request, as "<command>:<name>=<value>" for each attribute (with the attributes of a batch
+ * separated by ',')
+ */
+struct Recorder : public RequestDispatcher {
+    void dispatch_request(const UpdateNodeStatus& request) override {}
+    void dispatch_request(const UpdateNodeAttribute& request) override { description = describe(request.options()); }
+    void dispatch_request(const UpdateNodeAttributes& request) override {
+        for (const auto& options : request.attributes()) {
+            description += (description.empty() ? "" : ",") + describe(options);
+        }
+    }
+
+    static std::string describe(const Options& options) {
+        return std::string(options.get(Field::Command)) + ":" + std::string(options.get(Field::Name)) + "=" +
+               std::string(options.get(Field::Value));
+    }
+
+    std::string description;
+};
+
+class RecordingClientAPI : public ClientAPI {
+public:
+    [[nodiscard]] Response process(const Request& request) const override {
+        Recorder recorder;
+        request.dispatch(recorder);
+        requests.push_back(recorder.description);
+        return Response{"OK"};
+    }
+
+    mutable std::vector<std::string> requests;
+};
+
+std::shared_ptr<const TaskContext> make_context() {
+    return TaskContext::make(Environment::an_environment().with("ECF_NAME", "/path/to/task"));
+}
+
+std::vector<FollowRule> make_rules() {
+    return {
+        FollowRule::make_rule(R"(Step (\d+) of \d+)", "meter", "step"),
+        FollowRule::make_rule(R"(Writing (\S+)\.grib)", "label", "output", "file $1 ($$)"),
+        FollowRule::make_rule(R"(^ERROR)", "event", "failed"),
+        FollowRule::make_rule(R"(Step|Stage)", "label", "phase", "$0"),
+    };
+}
+
+CASE("test_log_follower__required_literals_are_extracted") {
+    EXPECT(PatternSet::required_literal("Step (\\d+) of \\d+") == "Step ");
+    EXPECT(PatternSet::required_literal("^ERROR: .*") == "ERROR: ");
+    EXPECT(PatternSet::required_literal("file\\.grib") == "file.grib");
+    EXPECT(PatternSet::required_literal("colou?r") == "colo");
+    EXPECT(PatternSet::required_literal("ab+cdef") == "cdef");
+    EXPECT(PatternSet::required_literal("x{0,2}yz") == "yz");
+    EXPECT(PatternSet::required_literal("[abc]def(g|h)") == "def");
+    EXPECT(PatternSet::required_literal("\\d+\\s\\w") == "");
+    EXPECT(PatternSet::required_literal("Step|Stage") == "");
+    EXPECT(PatternSet::required_literal("(Step|Stage) done") == " done");
+}
+
+CASE("test_log_follower__patterns_are_matched_in_order") {
+    PatternSet patterns;
+    EXPECT(patterns.add("Step (\\d+)") == 0);
+    EXPECT(patterns.add("step") == 1);
+    EXPECT(patterns.add("p \\d") == 2);
+    EXPECT(patterns.add("\\d\\d\\d") == 3);
+    EXPECT_THROWS_AS(patterns.add("(unbalanced"), InvalidRule);
+
+    auto matching = [&patterns](std::string_view line) {
+        std::vector<size_t> indices;
+        patterns.match(line, [&indices](size_t index, const PatternSet::match_t&) { indices.push_back(index); });
+        return indices;
+    };
+
+    EXPECT(matching("Step 42") == (std::vector<size_t>{0, 2}));
+    EXPECT(matching("next step 100") == (std::vector<size_t>{1, 2, 3}));
+    EXPECT(matching("nothing to see here").empty());
+
+    // Patterns added after matching are also considered
+    EXPECT(patterns.add("see") == 4);
+    EXPECT(matching("nothing to see here") == (std::vector<size_t>{4}));
+}
+
+CASE("test_log_follower__matching_lines_are_sent_together_and_coalesced") {
+    RecordingClientAPI client;
+    LogFollower follower{"/dev/null", make_rules(), client, make_context()};
+
+    // Notice: lines might be split across chunks
+    follower.consume("Stage 1\nStep 1 of 3\nWriting out");
+    follower.consume("put.grib\r\nnothing\nStep 2 of 3\n");
+    follower.consume("ERROR: something failed");
+    follower.flush();
+
+    EXPECT(follower.lines() == 5);
+    EXPECT(follower.matches() == 6);
+    EXPECT(client.requests == (std::vector<std::string>{"label:phase=Step,meter:step=2,label:output=file output ($)"}));
+
+    follower.consume("\n");
+    follower.flush();
+    EXPECT(follower.lines() == 6);
+    EXPECT(client.requests.back() == "event:failed=1");
+}
+
+CASE("test_log_follower__file_is_read_again_when_truncated") {
+    RecordingClientAPI client;
+    std::string path = "/tmp/ecflow_light_follower_test." + std::to_string(::getpid());
+    std::ofstream(path) << "Step 1 of 3\nStep 2 of 3\n";
+
+    LogFollower follower{path, make_rules(), client, make_context()};
+
+    // Notice: once stopped, following reads the whole file and returns
+    follower.stop();
+    follower.follow();
+    EXPECT(client.requests == (std::vector<std::string>{"meter:step=2,label:phase=Step"}));
+
+    std::ofstream(path, std::ios::trunc) << "Step 3\n";
+    follower.follow();
+    EXPECT(follower.lines() == 3);
+    EXPECT(client.requests.back() == "label:phase=Step");
+
+    std::remove(path.c_str());
+}
+
+}  // namespace ecflow::light::testing
+
+int main(int argc, char** argv) {
+    return eckit::testing::run_tests(argc, argv);
+}
@@ -0,0 +1,188 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include <eckit/testing/Test.h>
+
+#include "LocalUDPDecoder.h"
+#include "TestFixtures.h"
+#include "ecflow/light/ClientAPI.h"
+#include "ecflow/light/Requests.h"
+
+// *** Counting Allocator ******************************************************
+// *****************************************************************************
+
+namespace {
+
+// Notice: only the allocations performed by the current thread are accounted for
+thread_local size_t allocations = 0;
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* pointer = std::malloc(size == 0 ? 1 : size); pointer) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+// Notice: GCC wrongly reports freeing the memory obtained by the replaced operator new as a mismatch
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+void operator delete(void* pointer, std::size_t size [[maybe_unused]]) noexcept {
+    ::operator delete(pointer);
+}
+
+namespace ecflow::light::testing {
+
+/**
+ * Counts the heap allocations performed by the current thread while executing the given function
+ */
+template <typename F>
+size_t count_allocations(F&& f) {
+    size_t before = allocations;
+    f();
+    return allocations - before;
+}
+
+/**
+ * Collects the request fields, as done by the dispatchers, without any allocation
+ */
+struct FieldReader : public RequestDispatcher {
+    void dispatch_request(const UpdateNodeStatus& request) override { size += request.context().name().size(); }
+    void dispatch_request(const UpdateNodeAttribute& request) override {
+        size += request.context().name().size() + request.context().password().size();
+        size += request.options().get(Field::Command).size() + request.options().get(Field::Name).size();
+        size += request.options().get(Field::Value).size();
+    }
+    void dispatch_request(const UpdateNodeAttributes& request) override { size += request.attributes().size(); }
+
+    size_t size = 0;
+};
+
+std::shared_ptr<const TaskContext> make_context() {
+    return TaskContext::make(Environment::an_environment()
+                                 .with("ECF_NAME", "/a/rather/long/path/to/the/family/and/task")
+                                 .with("ECF_PASS", "a_rather_long_password")
+                                 .with("ECF_RID", "1234567890123456789")
+                                 .with("ECF_TRYNO", "1"));
+}
+
+CASE("test_requests__meter_update_requires_no_allocation") {
+    auto context = make_context();
+
+    // Ensure the allocations are actually being accounted for
+    EXPECT(count_allocations([]() { std::string text(64, 'x'); }) > 0);
+
+    size_t count = count_allocations([&context]() {
+        Options options = Options::options()
+                              .with(Field::Command, "meter")
+                              .with(Field::Name, "a_rather_long_meter_name_for_a_progress_meter")
+                              .with(Field::Value, 123456789);
+        Request request = Request::make_request<UpdateNodeAttribute>(context, options);
+        Request copy    = request;
+
+        FieldReader reader;
+        copy.dispatch(reader);
+        EXPECT(reader.size > 0);
+    });
+
+    EXPECT(count == 0);
+}
+
+CASE("test_requests__meter_update_dispatch_requires_no_allocation") {
+    LocalUDPDecoder decoder{{}, {}};
+    ClientCfg cfg = make_udp_cfg(decoder.port(), "2.0");
+    LibraryUDPClientAPI client(cfg, Environment::an_environment());
+    auto context = make_context();
+
+    auto update = [&client, &context]() {
+        Options options = Options::options()
+                              .with(Field::Command, "meter")
+                              .with(Field::Name, "a_rather_long_meter_name_for_a_progress_meter")
+                              .with(Field::Value, 123456789);
+        Response response = client.process(Request::make_request<UpdateNodeAttribute>(context, options));
+        EXPECT(response.outcome == Response::Outcome::Sent);
+    };
+
+    // Notice: the first update warms up the client (e.g. resolving the host, and sizing the thread buffers)
+    update();
+
+    // The whole dispatch, including formatting and sending the datagram, requires no allocation
+    EXPECT(count_allocations(update) == 0);
+    EXPECT(count_allocations(update) == 0);
+
+    auto updates = decoder.collect();
+    EXPECT(updates.size() == 3);
+    EXPECT(updates.back().value == "123456789");
+}
+
+CASE("test_requests__options_are_kept_by_field") {
+    auto options = Options::options().with("command", "meter").with(Field::Name, "progress").with(Field::Value, -42);
+
+    EXPECT(options.get(Field::Command) == "meter");
+    EXPECT(options.get("name") == "progress");
+    EXPECT(options.get(Field::Value) == "-42");
+    EXPECT(!options.find(Field::QueuePath).has_value());
+    EXPECT_THROWS_AS(std::ignore = options.get(Field::AbortWhy), OptionNotFound);
+    EXPECT_THROWS_AS(std::ignore = options.with("unknown", "value"), OptionNotFound);
+}
+
+CASE("test_requests__large_options_are_moved_to_heap") {
+    std::string text(Options::InlineCapacity, 'x');
+
+    auto options = Options::options().with(Field::Command, "label").with(Field::Name, "message");
+    auto copy    = options;
+    options      = options.with(Field::Value, text);
+
+    EXPECT(options.get(Field::Command) == "label");
+    EXPECT(options.get(Field::Name) == "message");
+    EXPECT(options.get(Field::Value) == text);
+    EXPECT(!copy.find(Field::Value).has_value());
+}
+
+CASE("test_requests__large_first_option_is_stored_on_heap") {
+    std::string text(Options::InlineCapacity + 1, 'x');
+
+    auto options = Options::options().with(Field::Value, text).with(Field::Name, "message");
+    auto copy    = options;
+
+    EXPECT(options.get(Field::Value) == text);
+    EXPECT(options.get(Field::Name) == "message");
+    EXPECT(copy.get(Field::Value) == text);
+    EXPECT(copy.get(Field::Name) == "message");
+}
+
+CASE("test_requests__missing_task_context_is_reported_on_use") {
+    auto context = TaskContext::make(Environment::an_environment().with("ECF_NAME", "/path/to/task"));
+
+    EXPECT(context->name() == "/path/to/task");
+    EXPECT_THROWS_AS(std::ignore = context->password(), EnvironmentVariableNotFound);
+}
+
+}  // namespace ecflow::light::testing
+
+int main(int argc, char** argv) {
+    return eckit::testing::run_tests(argc, argv);
+}
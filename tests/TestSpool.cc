@@ -0,0 +1,366 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <eckit/testing/Test.h>
+
+#include "LocalHTTPServer.h"
+#include "TestFixtures.h"
+#include "ecflow/light/ClientAPI.h"
+#include "ecflow/light/Filesystem.h"
+#include "ecflow/light/Spool.h"
+
+namespace ecflow::light::testing {
+
+using namespace std::chrono_literals;
+
+class TemporaryDirectory {
+public:
+    TemporaryDirectory() : directory_{make_directory()} {}
+    ~TemporaryDirectory() { fs::remove_all(directory_); }
+
+    [[nodiscard]] const fs::path& path() const { return directory_; }
+
+private:
+    static fs::path make_directory() {
+        std::string pattern = (fs::temp_directory_path() / "ecflow_light_spool_XXXXXX").string();
+        return fs::path{::mkdtemp(pattern.data())};
+    }
+
+    fs::path directory_;
+};
+
+/**
+ * UnreliableClientAPI records each update it delivers, and fails (as if the server is down) while unavailable
+ */
+struct UnreliableClientAPI : public ClientAPI {
+    struct Recorder : public RequestDispatcher {
+        void dispatch_request(const UpdateNodeStatus& request) override {
+            updates.push_back(std::string(request.options().get(Field::Action)));
+        }
+        void dispatch_request(const UpdateNodeAttribute& request) override { record(request.options()); }
+        void dispatch_request(const UpdateNodeAttributes& request) override {
+            for (const auto& attribute : request.attributes()) {
+                record(attribute);
+            }
+        }
+        void record(const Options& options) {
+            updates.push_back(std::string(options.get(Field::Name)) + "=" + std::string(options.get(Field::Value)));
+        }
+
+        std::vector<std::string> updates;
+    };
+
+    Response process(const Request& request) const override {
+        std::unique_lock lock(lock_);
+        ++attempts;
+        if (!available) {
+            // Notice: the failure is only detected after the delay (e.g. a connection timeout)
+            lock.unlock();
+            std::this_thread::sleep_for(failure_delay);
+            ECFLOW_LIGHT_THROW(UnreachableServer, Message("Server is down"));
+        }
+        if (dropping) {
+            return Response{"DROPPED", Response::Outcome::Dropped};
+        }
+        request.dispatch(recorder);
+        return Response{"OK"};
+    }
+
+    void set_available(bool value) {
+        std::scoped_lock lock(lock_);
+        available = value;
+    }
+
+    std::vector<std::string> collected() const {
+        std::scoped_lock lock(lock_);
+        return recorder.updates;
+    }
+
+    mutable std::mutex lock_;
+    mutable size_t attempts = 0;
+    mutable Recorder recorder;
+    bool available = true;
+    bool dropping  = false;
+    std::chrono::milliseconds failure_delay{0};
+};
+
+Request make_attribute(const std::string& command, const std::string& name, const std::string& value) {
+    Options options = Options::options().with("command", command).with("name", name).with("value", value);
+    return Request::make_request<UpdateNodeAttribute>(make_environment(), options);
+}
+
+Request make_status(const std::string& action) {
+    Options options = Options::options().with("action", action);
+    return Request::make_request<UpdateNodeStatus>(make_environment(), options);
+}
+
+SpoolCfg make_cfg(const TemporaryDirectory& directory) {
+    SpoolCfg cfg;
+    cfg.directory = directory.path().string();
+    cfg.retry_ms  = 10;
+    return cfg;
+}
+
+CASE("test_spool__entry_is_encoded_and_decoded") {
+    auto entries = SpoolEntry::entries_of(make_attribute("label", "message", "hello, world"));
+    EXPECT(entries.has_value());
+    EXPECT(entries->size() == 1);
+
+    std::string payload;
+    entries->front().encode(payload);
+    auto decoded = SpoolEntry::decode(7, payload);
+
+    EXPECT(decoded.sequence == 7);
+    EXPECT(decoded.kind == SpoolEntry::Kind::Attribute);
+    EXPECT(decoded.context->name() == "/suite/family/task");
+    EXPECT(decoded.context->password() == "qwerty");
+    EXPECT(decoded.options.get(Field::Value) == "hello, world");
+    EXPECT(decoded.key() == "/suite/family/task:label:message");
+
+    EXPECT_THROWS_AS(SpoolEntry::decode(7, payload.substr(0, payload.size() - 3)), InvalidSpoolEntry);
+}
+
+CASE("test_spool__queue_commands_are_not_spoolable") {
+    Options options = Options::options().with("command", "queue").with("name", "q").with("queue_action", "active");
+    EXPECT(!SpoolEntry::entries_of(Request::make_request<UpdateNodeAttribute>(make_environment(), options)));
+    EXPECT(!SpoolEntry::entries_of(make_status("wait")));
+    EXPECT(SpoolEntry::entries_of(make_status("complete")));
+}
+
+CASE("test_spool__journal_recovers_pending_records") {
+    TemporaryDirectory directory;
+    auto path = SpoolJournal::path_of(directory.path(), "/suite/family/task");
+    EXPECT(path.filename() == "_suite_family_task.spool");
+
+    {
+        SpoolJournal journal(path);
+        EXPECT(journal.empty());
+        for (int i = 1; i <= 5; ++i) {
+            EXPECT(journal.append("record " + std::to_string(i)) == uint64_t(i));
+        }
+        journal.mark_replayed(2);
+        // Notice: the journal is not closed cleanly, as if the process was killed
+    }
+
+    SpoolJournal journal(path);
+    auto pending = journal.pending();
+    EXPECT(pending.size() == 3);
+    EXPECT(pending.front().sequence == 3);
+    EXPECT(pending.front().payload == "record 3");
+    EXPECT(journal.append("record 6") == uint64_t(6));
+}
+
+CASE("test_spool__journal_ignores_corrupted_records") {
+    TemporaryDirectory directory;
+    auto path = SpoolJournal::path_of(directory.path(), "/suite/family/task");
+
+    {
+        SpoolJournal journal(path);
+        journal.append("first");
+        journal.append("second");
+        journal.append("third");
+    }
+
+    {
+        // Corrupt the contents of the second record (i.e. as if partially written)
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(64 + SpoolJournal::SlotSize + 24);
+        file.put('X');
+    }
+
+    SpoolJournal journal(path);
+    auto pending = journal.pending();
+    EXPECT(pending.size() == 2);
+    EXPECT(pending[0].payload == "first");
+    EXPECT(pending[1].payload == "third");
+}
+
+CASE("test_spool__journal_is_bounded") {
+    TemporaryDirectory directory;
+    auto path = SpoolJournal::path_of(directory.path(), "/suite/family/task");
+
+    SpoolJournal journal(path, 4 * SpoolJournal::SlotSize);
+    for (int i = 1; i <= 10; ++i) {
+        journal.append("record " + std::to_string(i));
+    }
+    EXPECT(fs::file_size(path) == 64 + 4 * SpoolJournal::SlotSize);
+    EXPECT(journal.overwritten() == 6);
+
+    auto pending = journal.pending();
+    EXPECT(pending.size() == 4);
+    EXPECT(pending.front().payload == "record 7");
+    EXPECT(pending.back().payload == "record 10");
+
+    // Notice: records larger than the journal are rejected
+    EXPECT(!journal.append(std::string(5 * SpoolJournal::SlotSize, 'x')));
+}
+
+CASE("test_spool__undelivered_updates_are_compacted_and_replayed_in_order") {
+    TemporaryDirectory directory;
+    auto cfg = make_cfg(directory);
+    UnreliableClientAPI target;
+    target.set_available(false);
+
+    auto journal = std::make_unique<SpoolJournal>(SpoolJournal::path_of(cfg.directory, "/suite/family/task"));
+    SpoolingClientAPI client(cfg, std::move(journal), target);
+
+    for (int i = 1; i <= 5; ++i) {
+        auto response = client.process(make_attribute("meter", "step", std::to_string(i)));
+        EXPECT(response.outcome == Response::Outcome::Spooled);
+    }
+    EXPECT(client.process(make_attribute("label", "message", "done")).outcome == Response::Outcome::Spooled);
+    EXPECT(client.process(make_status("complete")).outcome == Response::Outcome::Spooled);
+    EXPECT(client.process(make_attribute("meter", "step", "6")).outcome == Response::Outcome::Spooled);
+    EXPECT(!client.empty());
+
+    target.set_available(true);
+    for (int attempt = 0; attempt != 500 && !client.empty(); ++attempt) {
+        std::this_thread::sleep_for(10ms);
+    }
+    EXPECT(client.empty());
+
+    auto collected = target.collected();
+    EXPECT(collected.size() == 4);
+    EXPECT(collected[0] == "step=5");
+    EXPECT(collected[1] == "message=done");
+    EXPECT(collected[2] == "complete");
+    EXPECT(collected[3] == "step=6");
+
+    // Once the journal is empty, updates are delivered directly
+    EXPECT(client.process(make_attribute("meter", "step", "7")).outcome == Response::Outcome::Sent);
+    EXPECT(target.collected().back() == "step=7");
+}
+
+CASE("test_spool__pending_updates_survive_the_process") {
+    TemporaryDirectory directory;
+    auto cfg  = make_cfg(directory);
+    auto path = SpoolJournal::path_of(cfg.directory, "/suite/family/task");
+
+    {
+        UnreliableClientAPI target;
+        target.set_available(false);
+        SpoolingClientAPI client(cfg, std::make_unique<SpoolJournal>(path), target);
+        EXPECT(client.process(make_status("init")).outcome == Response::Outcome::Spooled);
+        EXPECT(client.process(make_attribute("event", "ready", "1")).outcome == Response::Outcome::Spooled);
+    }
+
+    UnreliableClientAPI target;
+    {
+        SpoolingClientAPI client(cfg, std::make_unique<SpoolJournal>(path), target);
+        for (int attempt = 0; attempt != 500 && !client.empty(); ++attempt) {
+            std::this_thread::sleep_for(10ms);
+        }
+        EXPECT(client.empty());
+    }
+
+    auto collected = target.collected();
+    EXPECT(collected.size() == 2);
+    EXPECT(collected[0] == "init");
+    EXPECT(collected[1] == "ready=1");
+}
+
+CASE("test_spool__dropped_updates_are_spooled") {
+    TemporaryDirectory directory;
+    auto cfg = make_cfg(directory);
+
+    UnreliableClientAPI target;
+    target.dropping = true;
+    {
+        auto journal = std::make_unique<SpoolJournal>(SpoolJournal::path_of(cfg.directory, "/suite/family/task"));
+        SpoolingClientAPI client(cfg, std::move(journal), target);
+        EXPECT(client.process(make_attribute("meter", "step", "1")).outcome == Response::Outcome::Spooled);
+        EXPECT(!client.empty());
+    }
+    EXPECT(target.collected().empty());
+}
+
+CASE("test_spool__newer_updates_are_never_overwritten_by_older_undelivered_updates") {
+    TemporaryDirectory directory;
+    auto cfg = make_cfg(directory);
+    UnreliableClientAPI target;
+    target.set_available(false);
+    target.failure_delay = 100ms;
+
+    auto journal = std::make_unique<SpoolJournal>(SpoolJournal::path_of(cfg.directory, "/suite/family/task"));
+    SpoolingClientAPI client(cfg, std::move(journal), target);
+
+    Response::Outcome older = Response::Outcome::Sent;
+    std::thread sender([&client, &older]() { older = client.process(make_attribute("meter", "step", "1")).outcome; });
+
+    // The server recovers while the delivery of the older update is still failing
+    std::this_thread::sleep_for(20ms);
+    target.set_available(true);
+    auto newer = client.process(make_attribute("meter", "step", "2")).outcome;
+    sender.join();
+
+    // Notice: the newer update is either spooled behind the older one, or delivered once the older one is replayed
+    EXPECT(older == Response::Outcome::Spooled);
+    EXPECT(newer != Response::Outcome::Dropped);
+    for (int attempt = 0; attempt != 500 && !client.empty(); ++attempt) {
+        std::this_thread::sleep_for(10ms);
+    }
+    EXPECT(client.empty());
+    EXPECT(target.collected().back() == "step=2");
+}
+
+CASE("test_spool__undelivered_pipelined_http_updates_are_spooled") {
+    TemporaryDirectory directory;
+    auto cfg = make_cfg(directory);
+
+    // Notice: the server is stopped, and thus its port refuses any connection
+    std::string port;
+    {
+        LocalHTTPServer server;
+        port = server.port();
+    }
+
+    auto client_cfg = ClientCfg::make_cfg(ClientCfg::KindLibrary, ClientCfg::ProtocolHTTP, "127.0.0.1", port, "1");
+    client_cfg.max_in_flight    = 4;
+    client_cfg.retry_attempts   = 1;
+    client_cfg.breaker_failures = 0;
+
+    // Without awaiting the outcome, pipelined updates are only queued (and the failure goes unnoticed)
+    {
+        LibraryHTTPClientAPI target(client_cfg, make_environment());
+        EXPECT(target.process(make_attribute("meter", "step", "1")).outcome == Response::Outcome::Queued);
+    }
+
+    client_cfg.await_outcome = true;
+    LibraryHTTPClientAPI target(client_cfg, make_environment());
+    {
+        auto journal = std::make_unique<SpoolJournal>(SpoolJournal::path_of(cfg.directory, "/suite/family/task"));
+        SpoolingClientAPI client(cfg, std::move(journal), target);
+        EXPECT(client.process(make_attribute("meter", "step", "1")).outcome == Response::Outcome::Spooled);
+        EXPECT(client.process(make_attribute("label", "message", "done")).outcome == Response::Outcome::Spooled);
+        EXPECT(!client.empty());
+    }
+}
+
+CASE("test_spool__journal_is_used_by_single_process") {
+    TemporaryDirectory directory;
+    auto path = SpoolJournal::path_of(directory.path(), "/suite/family/task");
+
+    SpoolJournal journal(path);
+    EXPECT_THROWS_AS(SpoolJournal{path}, UnableToOpenSpool);
+}
+
+}  // namespace ecflow::light::testing
+
+int main(int argc, char** argv) {
+    return eckit::testing::run_tests(argc, argv);
+}
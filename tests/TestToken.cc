@@ -0,0 +1,102 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <eckit/testing/Test.h>
+
+#include "ecflow/light/Token.h"
+
+namespace ecflow::light::testing {
+
+/**
+ * TokensFile is a temporary tokens file, removed (together with its directory) on destruction
+ */
+class TokensFile {
+public:
+    TokensFile() : directory_{make_directory()}, path_{directory_ / "api-tokens.json"} {}
+    ~TokensFile() { fs::remove_all(directory_); }
+
+    [[nodiscard]] const fs::path& path() const { return path_; }
+
+    void write(const std::string& url, const std::string& key) const {
+        // Notice: write to a temporary file and rename, as done by tools that atomically update the file
+        auto temporary = directory_ / "api-tokens.json.tmp";
+        std::ofstream ofs(temporary);
+        ofs << R"([{"url":")" << url << R"(","key":")" << key << R"(","email":"someone@somewhere.int"}])";
+        ofs.close();
+        fs::rename(temporary, path_);
+    }
+
+private:
+    static fs::path make_directory() {
+        std::string pattern = (fs::temp_directory_path() / "ecflow_light_tokens_XXXXXX").string();
+        return fs::path{::mkdtemp(pattern.data())};
+    }
+
+    fs::path directory_;
+    fs::path path_;
+};
+
+const std::string url = "https://somehost:8443/v1";
+
+CASE("test_token__provides_ready_authorization_for_known_url") {
+    TokensFile file;
+    file.write(url, "secret");
+
+    TokenCache cache(file.path());
+
+    auto authorization = cache.authorization(url);
+    EXPECT(authorization.has_value());
+    EXPECT(authorization.value() == "Bearer secret");
+
+    EXPECT(!cache.authorization("https://otherhost:8443/v1").has_value());
+}
+
+CASE("test_token__missing_file_is_cached_until_available") {
+    TokensFile file;
+
+    TokenCache cache(file.path(), std::chrono::milliseconds(0));
+    EXPECT(!cache.authorization(url).has_value());
+    EXPECT(!cache.authorization(url).has_value());
+
+    file.write(url, "secret");
+    EXPECT(cache.authorization(url).value() == "Bearer secret");
+}
+
+CASE("test_token__modified_file_is_reloaded") {
+    TokensFile file;
+    file.write(url, "old_secret");
+
+    TokenCache cache(file.path(), std::chrono::milliseconds(0));
+    EXPECT(cache.authorization(url).value() == "Bearer old_secret");
+
+    file.write(url, "new_secret");
+    EXPECT(cache.authorization(url).value() == "Bearer new_secret");
+}
+
+CASE("test_token__file_is_checked_at_most_once_per_check_period") {
+    TokensFile file;
+    file.write(url, "old_secret");
+
+    TokenCache cache(file.path(), std::chrono::hours(1));
+    EXPECT(cache.authorization(url).value() == "Bearer old_secret");
+
+    file.write(url, "new_secret");
+    EXPECT(cache.authorization(url).value() == "Bearer old_secret");
+}
+
+}  // namespace ecflow::light::testing
+
+int main(int argc, char** argv) {
+    return eckit::testing::run_tests(argc, argv);
+}
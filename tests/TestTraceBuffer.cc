@@ -0,0 +1,179 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <eckit/testing/Test.h>
+
+#include "LocalUDPDecoder.h"
+#include "TestFixtures.h"
+#include "ecflow/light/ClientAPI.h"
+#include "ecflow/light/TraceBuffer.h"
+
+namespace ecflow::light::testing {
+
+TraceRecord make_record(uint32_t count) {
+    TraceRecord record;
+    record.count = count;
+    record.bytes = count * 2;
+    record.set_command("meter");
+    record.set_name("meter_" + std::to_string(count));
+    return record;
+}
+
+std::string make_path() {
+    return "/tmp/ecflow_light_trace_test." + std::to_string(::getpid());
+}
+
+CASE("test_trace_buffer__records_describe_requests") {
+    auto environment = make_environment();
+
+    auto single = TraceRecord::make_record(Request::make_request<UpdateNodeAttribute>(
+        environment, Options::options().with("command", "label").with("name", "info").with("value", "text")));
+    EXPECT(single.kind == TraceRecord::Kind::Attribute);
+    EXPECT(single.count == 1);
+    EXPECT(std::string(single.command) == "label");
+    EXPECT(std::string(single.name) == "info");
+
+    UpdateNodeAttributes::attributes_t attributes{
+        Options::options().with("command", "meter").with("name", "progress").with("value", "1"),
+        Options::options().with("command", "event").with("name", "done").with("value", "1")};
+    auto batch = TraceRecord::make_record(Request::make_request<UpdateNodeAttributes>(environment, attributes));
+    EXPECT(batch.kind == TraceRecord::Kind::Attributes);
+    EXPECT(batch.count == 2);
+    EXPECT(std::string(batch.name) == "progress");
+
+    auto status = TraceRecord::make_record(
+        Request::make_request<UpdateNodeStatus>(environment, Options::options().with(Field::Action, "complete")));
+    EXPECT(status.kind == TraceRecord::Kind::Status);
+    EXPECT(std::string(status.command) == "complete");
+
+    // Notice: long names are truncated, always keeping the null terminator
+    TraceRecord truncated;
+    truncated.set_name(std::string(100, 'x'));
+    EXPECT(std::string(truncated.name) == std::string(sizeof(truncated.name) - 1, 'x'));
+}
+
+CASE("test_trace_buffer__most_recent_records_are_kept") {
+    TraceBuffer buffer{5};
+    EXPECT(buffer.capacity() == 8);
+    EXPECT(buffer.snapshot().empty());
+
+    for (uint32_t i = 0; i != 20; ++i) {
+        buffer.record(make_record(i));
+    }
+
+    auto records = buffer.snapshot();
+    EXPECT(buffer.recorded() == 20);
+    EXPECT(records.size() == 8);
+    for (size_t i = 0; i != records.size(); ++i) {
+        EXPECT(records[i].count == 12 + i);
+    }
+}
+
+CASE("test_trace_buffer__concurrent_records_are_consistent") {
+    TraceBuffer buffer{1024};
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t != 4; ++t) {
+        threads.emplace_back([&buffer, t]() {
+            for (uint32_t i = 0; i != 10000; ++i) {
+                buffer.record(make_record(t * 10000 + i));
+            }
+        });
+    }
+
+    // Notice: snapshots taken while recording only hold complete records
+    for (int i = 0; i != 100; ++i) {
+        for (const auto& record : buffer.snapshot()) {
+            EXPECT(record.bytes == record.count * 2);
+            EXPECT(std::string(record.name) == "meter_" + std::to_string(record.count));
+        }
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT(buffer.recorded() == 40000);
+    EXPECT(buffer.snapshot().size() == 1024);
+}
+
+CASE("test_trace_buffer__dumps_are_appended_and_decoded") {
+    auto path = make_path();
+    std::remove(path.c_str());
+
+    {
+        TraceBuffer buffer{4, path};
+        for (uint32_t i = 0; i != 6; ++i) {
+            buffer.record(make_record(i));
+        }
+        buffer.dump(path);
+    }
+    // Notice: the buffer was dumped explicitly, and again on destruction
+
+    auto dumps = TraceDump::load(path);
+    EXPECT(dumps.size() == 2);
+    EXPECT(dumps[0].pid == static_cast<uint32_t>(::getpid()));
+    EXPECT(dumps[0].lost == 2);
+    EXPECT(dumps[0].records.size() == 4);
+    EXPECT(dumps[0].records.front().count == 2);
+
+    std::ostringstream output;
+    EXPECT(decode_trace(path, output) == 8);
+    EXPECT(output.str().find("meter 'meter_5', 10 bytes") != std::string::npos);
+
+    // Invalid (or truncated) dumps are rejected
+    std::ofstream(path, std::ios::app) << "garbage";
+    EXPECT_THROWS_AS(TraceDump::load(path), TraceError);
+    EXPECT_THROWS_AS(TraceDump::load(path + ".missing"), TraceError);
+
+    std::remove(path.c_str());
+}
+
+CASE("test_trace_buffer__library_client_records_requests") {
+    LocalUDPDecoder decoder{{}, {}};
+    ClientCfg cfg    = make_udp_cfg(decoder.port(), "1.0");
+    auto environment = make_environment();
+    LibraryUDPClientAPI client(cfg, environment);
+
+    TraceBuffer buffer{16};
+    TraceBuffer::install(&buffer);
+
+    auto options = Options::options().with("command", "meter").with("name", "progress").with("value", "42");
+    auto response = client.process(Request::make_request<UpdateNodeAttribute>(environment, options));
+    EXPECT(response.response == "OK");
+
+    TraceBuffer::install(nullptr);
+
+    // Notice: requests are no longer traced, once the buffer is uninstalled
+    response = client.process(Request::make_request<UpdateNodeAttribute>(environment, options));
+
+    auto records = buffer.snapshot();
+    EXPECT(records.size() == 1);
+    EXPECT(records[0].transport == TraceRecord::Transport::UDP);
+    EXPECT(records[0].outcome == TraceRecord::Outcome::Sent);
+    EXPECT(std::string(records[0].name) == "progress");
+    EXPECT(records[0].bytes > 0);
+    EXPECT(records[0].timestamp_us > 0);
+}
+
+}  // namespace ecflow::light::testing
+
+int main(int argc, char** argv) {
+    return eckit::testing::run_tests(argc, argv);
+}
@@ -8,9 +8,21 @@
  * nor does it submit to any jurisdiction.
  */
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
 #include <eckit/testing/Test.h>
 
 #include "ecflow/light/ClientAPI.h"
+#include "ecflow/light/UDPSocket.h"
 
 namespace ecfl = ecflow::light;
 
@@ -105,6 +117,192 @@ CASE("test_udp_client__uses_provided_configuration_to_build_request") {
 //    }
 }
 
+/**
+ * Receiver is a UDP socket, bound to an ephemeral port on the loopback interface
+ */
+class Receiver {
+public:
+    Receiver() : socket_{::socket(AF_INET, SOCK_DGRAM, 0)}, port_{0} {
+        sockaddr_in address{};
+        address.sin_family      = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port        = 0;
+        ::bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+
+        socklen_t length = sizeof(address);
+        ::getsockname(socket_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+    }
+    ~Receiver() { ::close(socket_); }
+
+    [[nodiscard]] std::string port() const { return std::to_string(port_); }
+
+    std::vector<std::string> collect() {
+        std::vector<std::string> datagrams;
+        char buffer[1024];
+        pollfd fd{socket_, POLLIN, 0};
+        while (::poll(&fd, 1, 200) > 0) {
+            auto received = ::recv(socket_, buffer, sizeof(buffer), 0);
+            if (received <= 0) {
+                break;
+            }
+            datagrams.emplace_back(buffer, static_cast<size_t>(received));
+        }
+        return datagrams;
+    }
+
+private:
+    int socket_;
+    uint16_t port_;
+};
+
+CASE("test_udp_client__socket_is_reused_for_all_datagrams") {
+    Receiver receiver;
+    net::UDPSocket socket("127.0.0.1", receiver.port(), std::chrono::seconds(0));
+
+    for (int i = 0; i != 20; ++i) {
+        std::string datagram = "datagram_" + std::to_string(i);
+        EXPECT(socket.send(datagram.data(), datagram.size()));
+    }
+
+    auto datagrams = receiver.collect();
+    EXPECT(datagrams.size() == 20);
+    EXPECT(datagrams.back() == "datagram_19");
+    EXPECT(socket.sent() == 20);
+    EXPECT(socket.dropped() == 0);
+}
+
+CASE("test_udp_client__socket_is_shared_by_concurrent_senders") {
+    Receiver receiver;
+    net::UDPSocket socket("127.0.0.1", receiver.port(), std::chrono::seconds(0));
+
+    constexpr size_t threads = 4;
+    constexpr size_t count   = 25;
+
+    std::vector<std::thread> senders;
+    for (size_t t = 0; t != threads; ++t) {
+        senders.emplace_back([&socket, t]() {
+            for (size_t i = 0; i != count; ++i) {
+                std::string datagram = "datagram_" + std::to_string(t) + "_" + std::to_string(i);
+                socket.send(datagram.data(), datagram.size());
+            }
+        });
+    }
+    for (auto& sender : senders) {
+        sender.join();
+    }
+
+    EXPECT(socket.sent() + socket.dropped() == threads * count);
+    EXPECT(receiver.collect().size() == socket.sent());
+}
+
+std::vector<std::string> make_datagrams(size_t count, bool same_size) {
+    std::vector<std::string> datagrams;
+    for (size_t i = 0; i != count; ++i) {
+        std::string datagram = "datagram_" + std::to_string(i);
+        if (same_size) {
+            datagram.resize(16, '.');
+        }
+        datagrams.push_back(datagram);
+    }
+    return datagrams;
+}
+
+CASE("test_udp_client__socket_sends_datagrams_together") {
+    using Batching = net::UDPSocket::Batching;
+
+    for (auto batching : {Batching::None, Batching::Messages, Batching::Segments}) {
+        for (bool same_size : {false, true}) {
+            Receiver receiver;
+            net::UDPSocket socket("127.0.0.1", receiver.port(), std::chrono::seconds(0), batching);
+
+            auto datagrams = make_datagrams(100, same_size);
+            std::vector<std::string_view> views(std::begin(datagrams), std::end(datagrams));
+            EXPECT(socket.send(views) == datagrams.size());
+
+            // Notice: segmented messages are split by the kernel, and thus arrive as individual datagrams
+            EXPECT(receiver.collect() == datagrams);
+            EXPECT(socket.sent() == datagrams.size());
+            EXPECT(socket.dropped() == 0);
+            if (batching == Batching::None) {
+                EXPECT(socket.syscalls() == datagrams.size());
+            }
+            else {
+                EXPECT(socket.syscalls() <= 2);
+            }
+        }
+    }
+}
+
+CASE("test_udp_client__burst_defers_datagrams_until_the_end") {
+    Receiver receiver;
+    net::UDPSocket socket("127.0.0.1", receiver.port(), std::chrono::seconds(0));
+
+    auto datagrams = make_datagrams(50, false);
+    {
+        net::UDPSocket::Burst burst;
+        {
+            net::UDPSocket::Burst nested;
+            for (const auto& datagram : datagrams) {
+                EXPECT(socket.send(datagram.data(), datagram.size()));
+            }
+        }
+        EXPECT(socket.sent() == 0);
+    }
+    EXPECT(socket.sent() == datagrams.size());
+    EXPECT(socket.syscalls() <= 2);
+    EXPECT(receiver.collect() == datagrams);
+}
+
+CASE("test_udp_client__socket_is_reopened_after_fork") {
+    Receiver receiver;
+    net::UDPSocket socket("127.0.0.1", receiver.port(), std::chrono::seconds(0));
+
+    EXPECT(socket.send("parent", 6));
+
+    pid_t child = ::fork();
+    if (child == 0) {
+        bool sent = socket.send("child", 5);
+        ::_exit(sent ? 0 : 1);
+    }
+
+    int status = -1;
+    ::waitpid(child, &status, 0);
+    EXPECT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    EXPECT(socket.send("parent", 6));
+
+    auto datagrams = receiver.collect();
+    EXPECT(datagrams.size() == 3);
+}
+
+CASE("test_udp_client__socket_reports_unresolvable_host") {
+    net::UDPSocket socket("invalid.host.ecflow-light.invalid", "8080", std::chrono::seconds(0));
+
+    EXPECT_THROWS_AS(socket.send("datagram", 8), net::UDPSocketError);
+}
+
+CASE("test_udp_client__library_client_reuses_socket") {
+    Receiver receiver;
+    ClientCfg cfg = ClientCfg::make_cfg(ClientCfg::KindLibrary, ClientCfg::ProtocolUDP, "127.0.0.1", receiver.port(),
+                                        "1.0");
+    Environment environment = Environment::an_environment()
+                                  .with("ECF_RID", "12345")
+                                  .with("ECF_NAME", "/path/to/task")
+                                  .with("ECF_PASS", "custom_password")
+                                  .with("ECF_TRYNO", "2");
+
+    LibraryUDPClientAPI client(cfg, environment);
+    for (int i = 0; i != 10; ++i) {
+        Options options =
+            Options::options().with("command", "meter").with("name", "meter_name").with("value", std::to_string(i));
+        auto response = client.process(Request::make_request<UpdateNodeAttribute>(environment, options));
+        EXPECT(response.response == "OK");
+    }
+
+    EXPECT(receiver.collect().size() == 10);
+}
+
 }  // namespace ecflow::light::testing
 
 int main(int argc, char** argv) {
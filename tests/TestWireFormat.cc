@@ -0,0 +1,187 @@
+/*
+ * (C) Copyright 2023- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+#include <string>
+#include <vector>
+
+#include <eckit/testing/Test.h>
+
+#include "LocalUDPDecoder.h"
+#include "TestFixtures.h"
+#include "ecflow/light/ClientAPI.h"
+#include "ecflow/light/WireFormat.h"
+
+namespace ecflow::light::testing {
+
+std::string as_text(std::string_view text) {
+    std::string buffer;
+    BinaryEncoder::write_text(buffer, text);
+    return buffer;
+}
+
+CASE("test_wire_format__is_selected_by_version") {
+    EXPECT(wire_format_of("") == WireFormat::JSON);
+    EXPECT(wire_format_of("1") == WireFormat::JSON);
+    EXPECT(wire_format_of("1.0") == WireFormat::JSON);
+    EXPECT(wire_format_of("2") == WireFormat::Binary);
+    EXPECT(wire_format_of("2.0") == WireFormat::Binary);
+    EXPECT_THROWS_AS(wire_format_of("3.0"), eckit::BadValue);
+    EXPECT_THROWS_AS(wire_format_of("99.0"), eckit::BadValue);
+}
+
+CASE("test_wire_format__texts_are_encoded_compactly") {
+    // Canonical integers are encoded as a single varint, with the low bit set
+    EXPECT(as_text("0") == std::string("\x01", 1));
+    EXPECT(as_text("-1") == std::string("\x03", 1));
+    EXPECT(as_text("42") == std::string("\xA9\x01", 2));
+    EXPECT(as_text("100").size() == 2);
+
+    // Other texts are encoded as length, followed by the characters
+    EXPECT(as_text("") == std::string("\x00", 1));
+    EXPECT(as_text("abc") == std::string("\x06" "abc", 4));
+    EXPECT(as_text("007") == std::string("\x06" "007", 4));
+    EXPECT(as_text("-0") == std::string("\x04" "-0", 3));
+    EXPECT(as_text("+1") == std::string("\x04" "+1", 3));
+    EXPECT(as_text("1234567890123456789").size() == 20);
+}
+
+CASE("test_wire_format__encoded_datagram_is_decoded") {
+    std::string datagram;
+    BinaryEncoder::write_task(datagram, "12345", "qwerty", "1", "/suite/family/task");
+    BinaryEncoder::write_update(datagram, "meter", "progress", "-42");
+    BinaryEncoder::write_update(datagram, "label", "message", std::string("with\0nul", 8));
+    BinaryEncoder::write_update(datagram, "event", "done", "1");
+
+    auto decoded = BinaryDecoder::decode(datagram);
+    EXPECT(decoded.rid == "12345");
+    EXPECT(decoded.password == "qwerty");
+    EXPECT(decoded.try_no == "1");
+    EXPECT(decoded.path == BinaryEncoder::hash_path("/suite/family/task"));
+    EXPECT(decoded.updates.size() == 3);
+    EXPECT(decoded.updates[0].kind == BinaryEncoder::Kind::Meter);
+    EXPECT(decoded.updates[0].name == BinaryEncoder::hash_name("progress"));
+    EXPECT(decoded.updates[0].value == "-42");
+    EXPECT(decoded.updates[1].kind == BinaryEncoder::Kind::Label);
+    EXPECT(decoded.updates[1].value == std::string("with\0nul", 8));
+    EXPECT(decoded.updates[2].kind == BinaryEncoder::Kind::Event);
+    EXPECT(decoded.updates[2].value == "1");
+}
+
+CASE("test_wire_format__malformed_datagram_is_rejected") {
+    std::string datagram;
+    BinaryEncoder::write_task(datagram, "12345", "qwerty", "1", "/suite/family/task");
+    BinaryEncoder::write_update(datagram, "label", "message", "some text");
+
+    EXPECT_THROWS_AS(BinaryDecoder::decode(R"({"method":"put"})"), InvalidDatagram);
+    for (size_t size = BinaryEncoder::HeaderSize; size != datagram.size(); ++size) {
+        // Notice: the datagram truncated right after the task fields (i.e. without updates) is valid
+        if (size != datagram.size() - 1 - 4 - as_text("some text").size()) {
+            EXPECT_THROWS_AS(BinaryDecoder::decode(datagram.substr(0, size)), InvalidDatagram);
+        }
+    }
+
+    std::string unknown = datagram;
+    unknown[unknown.size() - 1 - 4 - as_text("some text").size()] = '\x09';
+    EXPECT_THROWS_AS(BinaryDecoder::decode(unknown), InvalidDatagram);
+
+    EXPECT_THROWS_AS(BinaryEncoder::write_update(datagram, "complete", "", ""), eckit::BadValue);
+}
+
+CASE("test_wire_format__binary_datagram_is_much_smaller_than_json") {
+    auto environment = make_environment();
+    auto options     = Options::options().with("command", "meter").with("name", "progress").with("value", "42");
+    UpdateNodeAttribute request(environment, options);
+
+    auto cfg_v1 = make_udp_cfg("0", "1.0");
+    auto cfg_v2 = make_udp_cfg("0", "2.0");
+    auto json   = UDPDispatcher(cfg_v1).format_request(request);
+    auto binary = UDPDispatcher(cfg_v2).format_request(request);
+
+    EXPECT(BinaryDecoder::is_binary(binary));
+    EXPECT(!BinaryDecoder::is_binary(json));
+    // i.e. 4 (header) + 3 (rid) + 7 (password) + 1 (try_no) + 8 (path) + 1 (kind) + 4 (name) + 2 (value)
+    EXPECT(binary.size() == 30);
+    EXPECT(binary.size() * 5 < json.size());
+}
+
+CASE("test_wire_format__batch_is_packed_into_few_datagrams") {
+    auto environment = make_environment();
+
+    UpdateNodeAttributes::attributes_t attributes;
+    for (int i = 0; i != 10'000; ++i) {
+        attributes.push_back(Options::options()
+                                 .with("command", "label")
+                                 .with("name", "message")
+                                 .with("value", "some text to be packed " + std::to_string(i)));
+    }
+
+    auto cfg        = make_udp_cfg("0", "2.0");
+    auto datagrams  = UDPDispatcher(cfg).format_request(UpdateNodeAttributes(environment, attributes));
+    size_t received = 0;
+    EXPECT(datagrams.size() > 1);
+    for (const auto& datagram : datagrams) {
+        EXPECT(datagram.size() <= UDPDispatcher::UDPPacketMaximumSize);
+        received += BinaryDecoder::decode(datagram).updates.size();
+    }
+    EXPECT(received == attributes.size());
+}
+
+CASE("test_wire_format__library_client_sends_binary_datagrams") {
+    LocalUDPDecoder decoder({"/suite/family/task"}, {"progress", "message"});
+
+    auto environment = make_environment();
+    auto cfg         = make_udp_cfg(decoder.port(), "2.0");
+    LibraryUDPClientAPI client(cfg, environment);
+
+    auto meter = Options::options().with("command", "meter").with("name", "progress").with("value", "42");
+    EXPECT(client.process(Request::make_request<UpdateNodeAttribute>(environment, meter)).response == "OK");
+
+    UpdateNodeAttributes::attributes_t attributes{
+        Options::options().with("command", "label").with("name", "message").with("value", "step \"1\"\n"),
+        Options::options().with("command", "event").with("name", "unknown").with("value", "1")};
+    EXPECT(client.process(Request::make_request<UpdateNodeAttributes>(environment, attributes)).response == "OK");
+
+    auto updates = decoder.collect();
+    EXPECT(decoder.invalid() == 0);
+    EXPECT(updates.size() == 3);
+    EXPECT(updates[0].rid == "12345");
+    EXPECT(updates[0].password == "qwerty");
+    EXPECT(updates[0].try_no == "1");
+    EXPECT(updates[0].path == "/suite/family/task");
+    EXPECT(updates[0].command == "meter");
+    EXPECT(updates[0].name == "progress");
+    EXPECT(updates[0].value == "42");
+    EXPECT(updates[1].command == "label");
+    EXPECT(updates[1].name == "message");
+    EXPECT(updates[1].value == "step \"1\"\n");
+    EXPECT(updates[2].command == "event");
+    EXPECT(updates[2].name == "?");
+    EXPECT(updates[2].value == "1");
+}
+
+CASE("test_wire_format__json_datagrams_are_not_decoded") {
+    LocalUDPDecoder decoder({"/suite/family/task"}, {"progress"});
+
+    auto environment = make_environment();
+    auto cfg         = make_udp_cfg(decoder.port(), "1.0");
+    LibraryUDPClientAPI client(cfg, environment);
+
+    auto meter = Options::options().with("command", "meter").with("name", "progress").with("value", "42");
+    EXPECT(client.process(Request::make_request<UpdateNodeAttribute>(environment, meter)).response == "OK");
+
+    EXPECT(decoder.collect().empty());
+    EXPECT(decoder.invalid() == 1);
+}
+
+}  // namespace ecflow::light::testing
+
+int main(int argc, char** argv) {
+    return eckit::testing::run_tests(argc, argv);
+}